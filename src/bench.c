@@ -0,0 +1,245 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "cull.h"
+#include "transform.h"
+
+#include <math.h>
+#include <time.h>
+
+/* =============================================
+ *        CPU MICRO-BENCHMARKS (make bench)
+ * ============================================= */
+
+#define BENCH_REPEATS 7
+
+static double
+nowSeconds ( void )
+{
+    struct timespec ts;
+    clock_gettime ( CLOCK_MONOTONIC, &ts );
+    return ( double ) ts.tv_sec + ( double ) ts.tv_nsec * 1e-9;
+}
+
+static float
+randRange ( float lo, float hi )
+{
+    return lo + ( hi - lo ) * ( ( float ) rand () / ( float ) RAND_MAX );
+}
+
+static void
+fillRandomTransforms ( CringedTransforms * t, uint32_t count )
+{
+    t->count = 0;
+    for ( uint32_t i = 0; i < count; i++ )
+    {
+        vec3   p = { randRange ( -100.0f, 100.0f ),
+                     randRange ( -100.0f, 100.0f ),
+                     randRange ( -100.0f, 100.0f ) };
+        vec3   s = { randRange ( 0.5f, 2.0f ),
+                     randRange ( 0.5f, 2.0f ),
+                     randRange ( 0.5f, 2.0f ) };
+        vec3   axis = { randRange ( -1.0f, 1.0f ),
+                        randRange ( -1.0f, 1.0f ),
+                        randRange ( -1.0f, 1.0f ) };
+        versor q;
+        glm_vec3_normalize ( axis );
+        glm_quatv ( q, randRange ( 0.0f, 6.28f ), axis );
+        cringedTransformsAdd ( t, p, q, s );
+    }
+}
+
+/* Best-of-N wall time for one kernel over `t`, seconds */
+static double
+benchKernel ( CringedTransformKernel     kernel,
+              const CringedTransforms * t,
+              mat4                      viewProj,
+              CringedInstance *         dst,
+              uint32_t                  iterations )
+{
+    double best = 1e30;
+    for ( uint32_t r = 0; r < BENCH_REPEATS; r++ )
+    {
+        double start = nowSeconds ();
+        for ( uint32_t it = 0; it < iterations; it++ )
+            kernel ( t, 0, t->count, viewProj, dst );
+        double elapsed = ( nowSeconds () - start ) / iterations;
+        if ( elapsed < best ) best = elapsed;
+    }
+    return best;
+}
+
+static float
+maxAbsDiff ( const CringedInstance * a,
+             const CringedInstance * b,
+             uint32_t                count )
+{
+    const float * fa   = ( const float * ) a;
+    const float * fb   = ( const float * ) b;
+    float         diff = 0.0f;
+    for ( size_t i = 0; i < ( size_t ) count * 32; i++ )
+    {
+        float d = fabsf ( fa[ i ] - fb[ i ] );
+        if ( d > diff ) diff = d;
+    }
+    return diff;
+}
+
+static int
+benchTransforms ( void )
+{
+    const uint32_t sizes[] = { 1000, 10000, 100000 };
+
+    CringedSimdLevel detected = cringedDetectSimd ();
+    printf ( "== transforms: world + MVP, detected %s\n",
+             cringedSimdLevelName ( detected ) );
+
+    mat4 proj, view, viewProj;
+    glm_perspective ( glm_rad ( 60.0f ), 16.0f / 9.0f, 0.1f, 500.0f, proj );
+    glm_lookat ( ( vec3 ) { 0.0f, 50.0f, 150.0f },
+                 ( vec3 ) { 0.0f, 0.0f, 0.0f },
+                 ( vec3 ) { 0.0f, 1.0f, 0.0f },
+                 view );
+    glm_mat4_mul ( proj, view, viewProj );
+
+    for ( uint32_t s = 0; s < sizeof ( sizes ) / sizeof ( sizes[ 0 ] ); s++ )
+    {
+        uint32_t            count = sizes[ s ];
+        CringedTransforms * t     = cringedCreateTransforms ( count );
+        size_t              dstSize =
+            ( ( count * sizeof ( CringedInstance ) + 63 ) / 64 ) * 64;
+        CringedInstance * ref = aligned_alloc ( 64, dstSize );
+        CringedInstance * dst = aligned_alloc ( 64, dstSize );
+        if ( ! t || ! ref || ! dst )
+        {
+            printf ( "error: bench allocation of %u instances\n", count );
+            return 1;
+        }
+        fillRandomTransforms ( t, count );
+
+        /* Keep every run at roughly 2M instances of work */
+        uint32_t iterations = 2000000 / count;
+
+        CringedTransformKernel scalar =
+            cringedTransformKernel ( CRINGED_SIMD_SCALAR );
+        scalar ( t, 0, count, viewProj, ref );
+        double scalarTime =
+            benchKernel ( scalar, t, viewProj, ref, iterations );
+
+        for ( int level = CRINGED_SIMD_SCALAR; level <= ( int ) detected;
+              level++ )
+        {
+            CringedTransformKernel kernel = cringedTransformKernel ( level );
+            double                 time   = scalarTime;
+            float                  err    = 0.0f;
+            if ( level != CRINGED_SIMD_SCALAR )
+            {
+                time = benchKernel ( kernel, t, viewProj, dst, iterations );
+                err  = maxAbsDiff ( ref, dst, count );
+            }
+
+            printf ( "  %7u x %-9s %9.3f us  %6.2f ns/obj  x%5.2f  "
+                     "max err %.2e\n",
+                     count,
+                     cringedSimdLevelName ( level ),
+                     time * 1e6,
+                     time * 1e9 / count,
+                     scalarTime / time,
+                     err );
+        }
+
+        free ( dst );
+        free ( ref );
+        cringedDestroyTransforms ( t );
+    }
+    return 0;
+}
+
+static int
+benchCulling ( void )
+{
+    const uint32_t sizes[]   = { 10000, 100000, 1000000 };
+    const uint32_t workers[] = { 0, 3, 7 };
+
+    printf ( "== culling: spheres vs 6 frustum planes\n" );
+
+    mat4 proj, view, viewProj;
+    glm_perspective ( glm_rad ( 60.0f ), 16.0f / 9.0f, 0.1f, 500.0f, proj );
+    glm_lookat ( ( vec3 ) { 0.0f, 0.0f, 0.0f },
+                 ( vec3 ) { 0.0f, 0.0f, -1.0f },
+                 ( vec3 ) { 0.0f, 1.0f, 0.0f },
+                 view );
+    glm_mat4_mul ( proj, view, viewProj );
+
+    CringedFrustum frustum;
+    cringedFrustumFromMatrix ( viewProj, &frustum );
+
+    for ( uint32_t s = 0; s < sizeof ( sizes ) / sizeof ( sizes[ 0 ] ); s++ )
+    {
+        uint32_t            count = sizes[ s ];
+        CringedTransforms * t     = cringedCreateTransforms ( count );
+        if ( ! t )
+        {
+            printf ( "error: bench allocation of %u spheres\n", count );
+            return 1;
+        }
+        fillRandomTransforms ( t, count );
+        for ( uint32_t i = 0; i < count; i++ )
+        {
+            t->pz[ i ] *= 2.5f;
+            cringedTransformsSetRadius ( t, i, randRange ( 0.5f, 3.0f ) );
+        }
+        CringedSpheres spheres = { t->px, t->py, t->pz, t->br, count };
+
+        uint32_t reference  = 0;
+        uint32_t iterations = 20000000 / count;
+        uint32_t workerRuns = sizeof ( workers ) / sizeof ( workers[ 0 ] );
+        for ( uint32_t w = 0; w < workerRuns; w++ )
+        {
+            CringedCuller * culler =
+                cringedCreateCuller ( count, workers[ w ] );
+            if ( ! culler ) return 1;
+
+            for ( int simd = 0; simd < 2; simd++ )
+            {
+                if ( simd && cringedDetectSimd () != CRINGED_SIMD_AVX2 )
+                    break;
+                culler->useAVX2 = simd;
+
+                uint32_t visible = 0;
+                double   best    = 1e30;
+                for ( uint32_t r = 0; r < BENCH_REPEATS; r++ )
+                {
+                    double start = nowSeconds ();
+                    for ( uint32_t it = 0; it < iterations; it++ )
+                        visible =
+                            cringedCullSpheres ( culler, &frustum, &spheres );
+                    double elapsed = ( nowSeconds () - start ) / iterations;
+                    if ( elapsed < best ) best = elapsed;
+                }
+                if ( ! reference ) reference = visible;
+
+                printf ( "  %7u x %-6s %u+1 thr %9.3f us  %6.3f ns/obj  "
+                         "visible %u%s\n",
+                         count,
+                         simd ? "avx2" : "scalar",
+                         culler->threadCount,
+                         best * 1e6,
+                         best * 1e9 / count,
+                         visible,
+                         visible == reference ? "" : "  MISMATCH" );
+            }
+            cringedDestroyCuller ( culler );
+        }
+        cringedDestroyTransforms ( t );
+    }
+    return 0;
+}
+
+int
+main ()
+{
+    srand ( 1337 );
+    if ( benchTransforms () ) return 1;
+    if ( benchCulling () ) return 1;
+    return 0;
+}
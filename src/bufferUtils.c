@@ -0,0 +1,188 @@
+#include "bufferUtils.h"
+
+atomic_ullong cringedBufferMemory = 0;
+
+int32_t
+cringedFindMemoryType ( VkPhysicalDevice      physicalDevice,
+                        uint32_t              typeBits,
+                        VkMemoryPropertyFlags properties )
+{
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties ( physicalDevice, &memProperties );
+
+    for ( uint32_t i = 0; i < memProperties.memoryTypeCount; i++ )
+    {
+        if ( ( typeBits & ( 1u << i ) ) &&
+             ( memProperties.memoryTypes[ i ].propertyFlags & properties ) ==
+                 properties )
+            return i;
+    }
+    return -1;
+}
+
+VkResult
+cringedCreateBuffer ( VkPhysicalDevice      physicalDevice,
+                      VkDevice              device,
+                      VkDeviceSize          size,
+                      VkBufferUsageFlags    usage,
+                      VkMemoryPropertyFlags properties,
+                      BasedBuffer *         buffer )
+{
+    VkResult opResult, rcode = VK_INCOMPLETE;
+
+    buffer->buffer = VK_NULL_HANDLE;
+    buffer->memory = VK_NULL_HANDLE;
+    buffer->mapped = NULL;
+    buffer->size   = size;
+
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size               = size;
+    bufferInfo.usage              = usage;
+    bufferInfo.sharingMode        = VK_SHARING_MODE_EXCLUSIVE;
+
+    if ( ( opResult = vkCreateBuffer (
+               device, &bufferInfo, NULL, &buffer->buffer ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: creating buffer: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements ( device, buffer->buffer, &memRequirements );
+
+    int32_t memoryType = cringedFindMemoryType (
+        physicalDevice, memRequirements.memoryTypeBits, properties );
+    if ( memoryType < 0 )
+    {
+        _DEBUG_P ( "error: no memory type for properties 0x%x\n",
+                   properties );
+        goto defer_cleanup;
+    }
+
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType                = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize       = memRequirements.size;
+    allocInfo.memoryTypeIndex      = memoryType;
+
+    if ( ( opResult = vkAllocateMemory (
+               device, &allocInfo, NULL, &buffer->memory ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: allocating buffer memory: %d\n", opResult );
+        goto defer_cleanup;
+    }
+    atomic_fetch_add_explicit (
+        &cringedBufferMemory, size, memory_order_relaxed );
+
+    if ( ( opResult = vkBindBufferMemory (
+               device, buffer->buffer, buffer->memory, 0 ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: binding buffer memory: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    /* Host visible buffers stay mapped for their whole lifetime */
+    if ( properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT )
+    {
+        if ( ( opResult = vkMapMemory ( device,
+                                        buffer->memory,
+                                        0,
+                                        VK_WHOLE_SIZE,
+                                        0,
+                                        &buffer->mapped ) ) != VK_SUCCESS )
+        {
+            _DEBUG_P ( "error: mapping buffer memory: %d\n", opResult );
+            goto defer_cleanup;
+        }
+    }
+
+    rcode = VK_SUCCESS;
+
+defer_cleanup:
+    if ( rcode ) cringedDestroyBuffer ( device, buffer );
+    return rcode;
+}
+
+void
+cringedDestroyBuffer ( VkDevice device, BasedBuffer * buffer )
+{
+    if ( buffer->mapped )
+    {
+        vkUnmapMemory ( device, buffer->memory );
+        buffer->mapped = NULL;
+    }
+    if ( buffer->buffer )
+    {
+        vkDestroyBuffer ( device, buffer->buffer, NULL );
+        buffer->buffer = VK_NULL_HANDLE;
+    }
+    if ( buffer->memory )
+    {
+        atomic_fetch_sub_explicit (
+            &cringedBufferMemory, buffer->size, memory_order_relaxed );
+        vkFreeMemory ( device, buffer->memory, NULL );
+        buffer->memory = VK_NULL_HANDLE;
+    }
+}
+
+VkResult
+cringedCreateRingBuffer ( VkPhysicalDevice  physicalDevice,
+                          VkDevice          device,
+                          VkDeviceSize      frameSize,
+                          uint32_t          frameCount,
+                          VkDeviceSize      tailSize,
+                          BasedRingBuffer * ring )
+{
+    VkResult opResult;
+
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties ( physicalDevice, &deviceProperties );
+
+    /* Both limits are powers of two: the larger one satisfies both */
+    VkDeviceSize alignment =
+        deviceProperties.limits.minUniformBufferOffsetAlignment;
+    if ( deviceProperties.limits.minStorageBufferOffsetAlignment > alignment )
+        alignment = deviceProperties.limits.minStorageBufferOffsetAlignment;
+    if ( alignment < 16 ) alignment = 16;
+
+    ring->alignment  = alignment;
+    ring->frameSize  = ( frameSize + alignment - 1 ) & ~( alignment - 1 );
+    ring->frameCount = frameCount;
+    ring->frame      = 0;
+    ring->head       = 0;
+
+    VkDeviceSize totalSize = ring->frameSize * frameCount + tailSize;
+
+    VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+                               VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                               VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                               VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                               VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    /* Prefer device local + host visible (ReBAR / UMA), then plain host */
+    if ( ( opResult = cringedCreateBuffer (
+               physicalDevice,
+               device,
+               totalSize,
+               usage,
+               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+               &ring->buffer ) ) == VK_SUCCESS )
+        return VK_SUCCESS;
+
+    return cringedCreateBuffer ( physicalDevice,
+                                 device,
+                                 totalSize,
+                                 usage,
+                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                 &ring->buffer );
+}
+
+void
+cringedDestroyRingBuffer ( VkDevice device, BasedRingBuffer * ring )
+{
+    cringedDestroyBuffer ( device, &ring->buffer );
+    ring->head = 0;
+}
@@ -0,0 +1,135 @@
+#pragma once
+#ifndef CRINGED_BUFFER_UTILS_H
+#define CRINGED_BUFFER_UTILS_H
+
+#ifndef NDEBUG
+#define _DEBUG_P( ... ) printf ( __VA_ARGS__ )
+#else
+#define _DEBUG_P( ... ) ( ( void ) 0 )
+#endif
+
+#include <cglm/cglm.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vulkan/vulkan.h>
+
+typedef struct
+{
+    VkBuffer       buffer;
+    VkDeviceMemory memory;
+    VkDeviceSize   size;
+    void *         mapped; /* NULL unless host visible */
+} BasedBuffer;
+
+/* Ring buffer in persistently mapped memory:
+ *   [ frame 0 | frame 1 | ... | frame N-1 | tail ]
+ * Every frame in flight owns one partition, reset by `cringedRingBegin`
+ * once the frame fence has been waited. Allocations are bump-pointer only,
+ * the memory is never unmapped until the ring is destroyed.
+ * NOTE: `tail` is never allocated from: it keeps fixed-range dynamic
+ * descriptors in bounds for offsets near the end of the last partition. */
+typedef struct
+{
+    BasedBuffer  buffer;
+    VkDeviceSize frameSize;
+    VkDeviceSize alignment;
+    VkDeviceSize head;
+    uint32_t     frameCount;
+    uint32_t     frame;
+} BasedRingBuffer;
+
+/* std140 layout, set 0 binding 0: updated once per frame */
+typedef struct
+{
+    mat4 view;
+    mat4 proj;
+    mat4 viewProj;
+    vec4 time; /* x: seconds, y: delta seconds, z: frame number */
+} CringedFrameConstants;
+
+/* Where the vertex shader takes the per-instance world matrix from,
+ * baked into each pipeline variant, see variants.h */
+#define CRINGED_DRAW_INSTANCES    0 /* ring instances, binding 2 */
+#define CRINGED_DRAW_SCENE        1 /* scene world matrices, binding 3 */
+#define CRINGED_DRAW_CULLED       2 /* ring instances listed at binding 4 */
+#define CRINGED_DRAW_SOURCE_COUNT 3
+
+/* std140 layout, set 0 binding 1: updated per draw */
+typedef struct
+{
+    mat4 model;
+    mat4 mvp;
+} CringedDrawConstants;
+
+/* Bytes currently held by cringedCreateBuffer allocations (HUD) */
+extern atomic_ullong cringedBufferMemory;
+
+int32_t
+cringedFindMemoryType ( VkPhysicalDevice      physicalDevice,
+                        uint32_t              typeBits,
+                        VkMemoryPropertyFlags properties );
+
+VkResult
+cringedCreateBuffer ( VkPhysicalDevice      physicalDevice,
+                      VkDevice              device,
+                      VkDeviceSize          size,
+                      VkBufferUsageFlags    usage,
+                      VkMemoryPropertyFlags properties,
+                      BasedBuffer *         buffer );
+
+void
+cringedDestroyBuffer ( VkDevice device, BasedBuffer * buffer );
+
+VkResult
+cringedCreateRingBuffer ( VkPhysicalDevice  physicalDevice,
+                          VkDevice          device,
+                          VkDeviceSize      frameSize,
+                          uint32_t          frameCount,
+                          VkDeviceSize      tailSize,
+                          BasedRingBuffer * ring );
+
+void
+cringedDestroyRingBuffer ( VkDevice device, BasedRingBuffer * ring );
+
+/* Switch to partition of `frame`: safe only after its fence signaled */
+static inline void
+cringedRingBegin ( BasedRingBuffer * ring, uint32_t frame )
+{
+    ring->frame = frame % ring->frameCount;
+    ring->head  = 0;
+}
+
+/* Bump allocation: returns mapped pointer and absolute offset usable as
+ * a dynamic offset, or NULL when the frame partition is exhausted. */
+static inline void *
+cringedRingAlloc ( BasedRingBuffer * ring,
+                   VkDeviceSize      size,
+                   uint32_t *        offset )
+{
+    VkDeviceSize start =
+        ( ring->head + ring->alignment - 1 ) & ~( ring->alignment - 1 );
+    if ( start + size > ring->frameSize ) return NULL;
+
+    ring->head          = start + size;
+    VkDeviceSize absOff = ring->frame * ring->frameSize + start;
+    *offset             = ( uint32_t ) absOff;
+    return ( uint8_t * ) ring->buffer.mapped + absOff;
+}
+
+/* Single memcpy into the ring, no allocation/map/unmap */
+static inline int
+cringedRingPush ( BasedRingBuffer * ring,
+                  const void *      data,
+                  VkDeviceSize      size,
+                  uint32_t *        offset )
+{
+    void * dst = cringedRingAlloc ( ring, size, offset );
+    if ( ! dst ) return 0;
+    memcpy ( dst, data, size );
+    return 1;
+}
+
+#endif /* CRINGED_BUFFER_UTILS_H */
@@ -0,0 +1,317 @@
+#include "cull.h"
+#include "trace.h"
+#include "transform.h"
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define CRINGED_X86
+#include <immintrin.h>
+#endif
+
+/* compressLut[ mask ]: lane numbers of set bits, packed to the front */
+static uint8_t compressLut[ 256 ][ 8 ];
+
+static void
+buildCompressLut ( void )
+{
+    for ( uint32_t mask = 0; mask < 256; mask++ )
+    {
+        uint32_t n = 0;
+        for ( uint32_t lane = 0; lane < 8; lane++ )
+            if ( mask & ( 1u << lane ) ) compressLut[ mask ][ n++ ] = lane;
+        while ( n < 8 ) compressLut[ mask ][ n++ ] = 0;
+    }
+}
+
+void
+cringedFrustumFromMatrix ( mat4 viewProj, CringedFrustum * frustum )
+{
+    /* row( i ) = ( m[ 0 ][ i ], m[ 1 ][ i ], m[ 2 ][ i ], m[ 3 ][ i ] ) */
+    for ( uint32_t c = 0; c < 4; c++ )
+    {
+        float r0 = viewProj[ c ][ 0 ], r1 = viewProj[ c ][ 1 ],
+              r2 = viewProj[ c ][ 2 ], r3 = viewProj[ c ][ 3 ];
+        frustum->planes[ 0 ][ c ] = r3 + r0; /* left */
+        frustum->planes[ 1 ][ c ] = r3 - r0; /* right */
+        frustum->planes[ 2 ][ c ] = r3 + r1; /* bottom */
+        frustum->planes[ 3 ][ c ] = r3 - r1; /* top */
+        frustum->planes[ 4 ][ c ] = r2;      /* near, z >= 0 */
+        frustum->planes[ 5 ][ c ] = r3 - r2; /* far */
+    }
+
+    for ( uint32_t p = 0; p < 6; p++ )
+    {
+        float * pl  = frustum->planes[ p ];
+        float   len = sqrtf ( pl[ 0 ] * pl[ 0 ] + pl[ 1 ] * pl[ 1 ] +
+                              pl[ 2 ] * pl[ 2 ] );
+        if ( len > 0.0f )
+            for ( uint32_t c = 0; c < 4; c++ ) pl[ c ] /= len;
+    }
+}
+
+/* =============================================
+ *            CULL KERNELS
+ * =============================================
+ * Both write visible indices to `out`, which is the chunk's own slice of
+ * the output: AVX2 stores a full 8 lanes per batch, but never past the
+ * batch it has just tested, so chunks never overlap. */
+
+static uint32_t
+cullChunkScalar ( const CringedSpheres * s,
+                  const CringedFrustum * f,
+                  uint32_t               first,
+                  uint32_t               count,
+                  uint32_t *             out )
+{
+    uint32_t n = 0;
+    for ( uint32_t i = 0; i < count; i++ )
+    {
+        uint32_t j      = first + i;
+        uint8_t  inside = 1;
+        for ( uint32_t p = 0; p < 6 && inside; p++ )
+        {
+            const float * pl = f->planes[ p ];
+            float d = pl[ 0 ] * s->x[ j ] + pl[ 1 ] * s->y[ j ] +
+                      pl[ 2 ] * s->z[ j ] + pl[ 3 ];
+            inside = d >= -s->r[ j ];
+        }
+        if ( inside ) out[ n++ ] = j;
+    }
+    return n;
+}
+
+#ifdef CRINGED_X86
+__attribute__ ( ( target ( "avx2,fma" ) ) ) static uint32_t
+cullChunkAVX2 ( const CringedSpheres * s,
+                const CringedFrustum * f,
+                uint32_t               first,
+                uint32_t               count,
+                uint32_t *             out )
+{
+    __m256 nx[ 6 ], ny[ 6 ], nz[ 6 ], nd[ 6 ];
+    for ( uint32_t p = 0; p < 6; p++ )
+    {
+        nx[ p ] = _mm256_set1_ps ( f->planes[ p ][ 0 ] );
+        ny[ p ] = _mm256_set1_ps ( f->planes[ p ][ 1 ] );
+        nz[ p ] = _mm256_set1_ps ( f->planes[ p ][ 2 ] );
+        nd[ p ] = _mm256_set1_ps ( f->planes[ p ][ 3 ] );
+    }
+    const __m256 zero = _mm256_setzero_ps ();
+
+    uint32_t n = 0, i = 0;
+    for ( ; i + 8 <= count; i += 8 )
+    {
+        uint32_t j    = first + i;
+        __m256   x    = _mm256_loadu_ps ( s->x + j );
+        __m256   y    = _mm256_loadu_ps ( s->y + j );
+        __m256   z    = _mm256_loadu_ps ( s->z + j );
+        __m256   negR = _mm256_sub_ps ( zero, _mm256_loadu_ps ( s->r + j ) );
+
+        __m256 inside = _mm256_cmp_ps ( zero, zero, _CMP_EQ_OQ );
+        for ( uint32_t p = 0; p < 6; p++ )
+        {
+            __m256 d = _mm256_fmadd_ps (
+                nx[ p ],
+                x,
+                _mm256_fmadd_ps (
+                    ny[ p ], y, _mm256_fmadd_ps ( nz[ p ], z, nd[ p ] ) ) );
+            inside = _mm256_and_ps ( inside,
+                                     _mm256_cmp_ps ( d, negR, _CMP_GE_OQ ) );
+        }
+
+        /* Left-pack visible lane indices with a single store */
+        uint32_t mask   = ( uint32_t ) _mm256_movemask_ps ( inside );
+        __m128i  packed =
+            _mm_loadl_epi64 ( ( const __m128i * ) compressLut[ mask ] );
+        __m256i  lanes  = _mm256_cvtepu8_epi32 ( packed );
+        _mm256_storeu_si256 (
+            ( __m256i * ) ( out + n ),
+            _mm256_add_epi32 ( _mm256_set1_epi32 ( ( int ) j ), lanes ) );
+        n += __builtin_popcount ( mask );
+    }
+
+    if ( i < count )
+        n += cullChunkScalar ( s, f, first + i, count - i, out + n );
+    return n;
+}
+#endif /* CRINGED_X86 */
+
+typedef uint32_t ( *CullKernel ) ( const CringedSpheres * s,
+                                   const CringedFrustum * f,
+                                   uint32_t               first,
+                                   uint32_t               count,
+                                   uint32_t *             out );
+
+static void
+cullRunChunks ( CringedCuller * culler )
+{
+    CRINGED_ZONE ( "cull-chunks" );
+    CullKernel kernel = cullChunkScalar;
+#ifdef CRINGED_X86
+    if ( culler->useAVX2 ) kernel = cullChunkAVX2;
+#endif
+
+    uint32_t k;
+    while ( ( k = atomic_fetch_add ( &culler->nextChunk, 1 ) ) <
+            culler->chunkCount )
+    {
+        uint32_t first = k * culler->chunkSize;
+        uint32_t count = culler->spheres->count - first;
+        if ( count > culler->chunkSize ) count = culler->chunkSize;
+
+        culler->chunkVisible[ k ] = kernel ( culler->spheres,
+                                             &culler->frustum,
+                                             first,
+                                             count,
+                                             culler->visible + first );
+    }
+}
+
+static void *
+cullWorker ( void * arg )
+{
+    CringedCuller * culler = ( CringedCuller * ) arg;
+    uint64_t        seen   = 0;
+    cringedTraceThreadName ( "cull worker" );
+
+    pthread_mutex_lock ( &culler->lock );
+    for ( ;; )
+    {
+        while ( ! culler->quit && culler->generation == seen )
+            pthread_cond_wait ( &culler->wake, &culler->lock );
+        if ( culler->quit ) break;
+        seen = culler->generation;
+        pthread_mutex_unlock ( &culler->lock );
+
+        cullRunChunks ( culler );
+
+        pthread_mutex_lock ( &culler->lock );
+        if ( --culler->pending == 0 ) pthread_cond_signal ( &culler->done );
+    }
+    pthread_mutex_unlock ( &culler->lock );
+    return NULL;
+}
+
+CringedCuller *
+cringedCreateCuller ( uint32_t capacity, uint32_t threadCount )
+{
+    CringedCuller * culler =
+        ( CringedCuller * ) calloc ( 1, sizeof ( CringedCuller ) );
+    if ( ! culler ) return NULL;
+
+    buildCompressLut ();
+
+    culler->capacity     = capacity;
+    culler->visible      = ( uint32_t * ) malloc (
+        ( ( size_t ) capacity + 8 ) * sizeof ( uint32_t ) );
+    culler->chunkVisible = ( uint32_t * ) malloc (
+        ( ( size_t ) threadCount + 1 ) * sizeof ( uint32_t ) );
+    culler->threads =
+        ( pthread_t * ) malloc ( ( threadCount + 1 ) * sizeof ( pthread_t ) );
+    if ( ! culler->visible || ! culler->chunkVisible || ! culler->threads )
+    {
+        free ( culler->threads );
+        free ( culler->chunkVisible );
+        free ( culler->visible );
+        free ( culler );
+        return NULL;
+    }
+
+    culler->useAVX2 = cringedDetectSimd () == CRINGED_SIMD_AVX2;
+    atomic_init ( &culler->nextChunk, 0 );
+
+    pthread_mutex_init ( &culler->lock, NULL );
+    pthread_cond_init ( &culler->wake, NULL );
+    pthread_cond_init ( &culler->done, NULL );
+
+    for ( uint32_t i = 0; i < threadCount; i++ )
+    {
+        if ( pthread_create (
+                 &culler->threads[ i ], NULL, cullWorker, culler ) )
+            break; /* run with whatever workers we got */
+        culler->threadCount++;
+    }
+    return culler;
+}
+
+void
+cringedDestroyCuller ( CringedCuller * culler )
+{
+    if ( ! culler ) return;
+
+    pthread_mutex_lock ( &culler->lock );
+    culler->quit = 1;
+    pthread_cond_broadcast ( &culler->wake );
+    pthread_mutex_unlock ( &culler->lock );
+    for ( uint32_t i = 0; i < culler->threadCount; i++ )
+        pthread_join ( culler->threads[ i ], NULL );
+
+    pthread_cond_destroy ( &culler->done );
+    pthread_cond_destroy ( &culler->wake );
+    pthread_mutex_destroy ( &culler->lock );
+    free ( culler->threads );
+    free ( culler->chunkVisible );
+    free ( culler->visible );
+    free ( culler );
+}
+
+uint32_t
+cringedCullSpheres ( CringedCuller *        culler,
+                     const CringedFrustum * frustum,
+                     const CringedSpheres * spheres )
+{
+    uint32_t count = spheres->count;
+    if ( count > culler->capacity ) count = culler->capacity;
+    culler->visibleCount = 0;
+    if ( ! count ) return 0;
+
+    /* Chunks are multiples of 8 so only the last one has a scalar tail */
+    uint32_t parts     = culler->threadCount + 1;
+    uint32_t chunkSize = ( count + parts - 1 ) / parts;
+    if ( chunkSize < CRINGED_CULL_MIN_CHUNK ) chunkSize = CRINGED_CULL_MIN_CHUNK;
+    chunkSize = ( chunkSize + 7 ) & ~7u;
+
+    CringedSpheres clamped = *spheres;
+    clamped.count          = count;
+
+    culler->spheres    = &clamped;
+    culler->frustum    = *frustum;
+    culler->chunkSize  = chunkSize;
+    culler->chunkCount = ( count + chunkSize - 1 ) / chunkSize;
+    atomic_store ( &culler->nextChunk, 0 );
+
+    if ( culler->chunkCount == 1 || ! culler->threadCount )
+        cullRunChunks ( culler );
+    else
+    {
+        /* NOTE: every worker wakes, surplus ones find no chunk left */
+        pthread_mutex_lock ( &culler->lock );
+        culler->pending = culler->threadCount;
+        culler->generation++;
+        pthread_cond_broadcast ( &culler->wake );
+        pthread_mutex_unlock ( &culler->lock );
+
+        cullRunChunks ( culler );
+
+        pthread_mutex_lock ( &culler->lock );
+        while ( culler->pending )
+            pthread_cond_wait ( &culler->done, &culler->lock );
+        pthread_mutex_unlock ( &culler->lock );
+    }
+
+    /* Compact chunk slices in order: output stays sorted ascending */
+    uint32_t visible = 0;
+    for ( uint32_t k = 0; k < culler->chunkCount; k++ )
+    {
+        uint32_t first = k * chunkSize;
+        uint32_t n     = culler->chunkVisible[ k ];
+        if ( visible != first )
+            memmove ( culler->visible + visible,
+                      culler->visible + first,
+                      n * sizeof ( uint32_t ) );
+        visible += n;
+    }
+
+    culler->spheres      = NULL;
+    culler->visibleCount = visible;
+    return visible;
+}
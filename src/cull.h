@@ -0,0 +1,74 @@
+#pragma once
+#ifndef CRINGED_CULL_H
+#define CRINGED_CULL_H
+
+#include <cglm/cglm.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Minimum spheres per job before work is split across threads */
+#define CRINGED_CULL_MIN_CHUNK 4096
+
+/* Planes as (nx, ny, nz, d), normalized: inside when n.p + d >= -r */
+typedef struct
+{
+    vec4 planes[ 6 ];
+} CringedFrustum;
+
+/* SoA view over bounding spheres, arrays are not owned */
+typedef struct
+{
+    const float * x;
+    const float * y;
+    const float * z;
+    const float * r;
+    uint32_t      count;
+} CringedSpheres;
+
+typedef struct
+{
+    /* Job (valid while a cull is running) */
+    const CringedSpheres * spheres;
+    CringedFrustum         frustum;
+    uint32_t               chunkSize;
+    uint32_t               chunkCount;
+    atomic_uint            nextChunk;
+    uint32_t *             chunkVisible;
+    /* Output: ascending visible indices, compacted */
+    uint32_t * visible;
+    uint32_t   visibleCount;
+    uint32_t   capacity;
+    /* Worker pool */
+    uint32_t        threadCount;
+    pthread_t *     threads;
+    pthread_mutex_t lock;
+    pthread_cond_t  wake;
+    pthread_cond_t  done;
+    uint64_t        generation;
+    uint32_t        pending;
+    uint8_t         quit;
+    uint8_t         useAVX2;
+} CringedCuller;
+
+/* `threadCount` workers are spawned besides the calling thread */
+CringedCuller *
+cringedCreateCuller ( uint32_t capacity, uint32_t threadCount );
+
+void
+cringedDestroyCuller ( CringedCuller * culler );
+
+/* Gribb-Hartmann extraction for Vulkan clip space (0 <= z <= w) */
+void
+cringedFrustumFromMatrix ( mat4 viewProj, CringedFrustum * frustum );
+
+/* Returns number of visible spheres; indices in `culler->visible` */
+uint32_t
+cringedCullSpheres ( CringedCuller *        culler,
+                     const CringedFrustum * frustum,
+                     const CringedSpheres * spheres );
+
+#endif /* CRINGED_CULL_H */
@@ -0,0 +1,143 @@
+#include "deletionQueue.h"
+
+static void
+execute ( VkDevice device, const CringedDeletion * d )
+{
+    switch ( d->kind )
+    {
+        case CRINGED_DELETE_BUFFER:
+            vkDestroyBuffer ( device, d->buffer, NULL );
+            break;
+        case CRINGED_DELETE_MEMORY:
+            vkFreeMemory ( device, d->memory, NULL );
+            break;
+        case CRINGED_DELETE_IMAGE:
+            vkDestroyImage ( device, d->image, NULL );
+            break;
+        case CRINGED_DELETE_IMAGE_VIEW:
+            vkDestroyImageView ( device, d->imageView, NULL );
+            break;
+        case CRINGED_DELETE_FRAMEBUFFER:
+            vkDestroyFramebuffer ( device, d->framebuffer, NULL );
+            break;
+        case CRINGED_DELETE_RENDER_PASS:
+            vkDestroyRenderPass ( device, d->renderPass, NULL );
+            break;
+        case CRINGED_DELETE_PIPELINE:
+            vkDestroyPipeline ( device, d->pipeline, NULL );
+            break;
+        case CRINGED_DELETE_PIPELINE_LAYOUT:
+            vkDestroyPipelineLayout ( device, d->pipelineLayout, NULL );
+            break;
+        case CRINGED_DELETE_SHADER_MODULE:
+            vkDestroyShaderModule ( device, d->shaderModule, NULL );
+            break;
+        case CRINGED_DELETE_SWAPCHAIN:
+            vkDestroySwapchainKHR ( device, d->swapChain, NULL );
+            break;
+        case CRINGED_DELETE_HOST:
+            free ( d->host );
+            break;
+    }
+}
+
+/* Runs the first `count` requests, keeps the rest in order */
+static void
+executePrefix ( CringedDeletionQueue * queue, uint32_t count )
+{
+    if ( ! count ) return;
+    for ( uint32_t i = 0; i < count; i++ )
+        execute ( queue->device, &queue->items[ i ] );
+    queue->count -= count;
+    memmove ( queue->items,
+              queue->items + count,
+              queue->count * sizeof ( CringedDeletion ) );
+}
+
+CringedDeletionQueue *
+cringedCreateDeletionQueue ( uint32_t capacity )
+{
+    CringedDeletionQueue * queue = ( CringedDeletionQueue * ) calloc (
+        1, sizeof ( CringedDeletionQueue ) );
+    if ( ! queue ) return NULL;
+
+    queue->capacity = capacity ? capacity : 64;
+    queue->items    = ( CringedDeletion * ) malloc (
+        queue->capacity * sizeof ( CringedDeletion ) );
+    if ( ! queue->items )
+    {
+        free ( queue );
+        return NULL;
+    }
+    return queue;
+}
+
+void
+cringedDestroyDeletionQueue ( CringedDeletionQueue * queue )
+{
+    if ( ! queue ) return;
+    if ( queue->count )
+        _DEBUG_P ( "error: %u deferred deletions leaked\n", queue->count );
+    free ( queue->items );
+    free ( queue );
+}
+
+void
+cringedDeletionBeginFrame ( CringedDeletionQueue * queue,
+                            uint64_t               frame,
+                            uint64_t               safeFrame )
+{
+    queue->frame = frame;
+
+    uint32_t ready = 0;
+    while ( ready < queue->count && queue->items[ ready ].frame < safeFrame )
+        ready++;
+    executePrefix ( queue, ready );
+}
+
+void
+cringedDefer ( CringedDeletionQueue * queue, CringedDeletion deletion )
+{
+    if ( queue->count == queue->capacity )
+    {
+        CringedDeletion * items = ( CringedDeletion * ) realloc (
+            queue->items, 2 * queue->capacity * sizeof ( CringedDeletion ) );
+        if ( ! items )
+        {
+            /* NOTE: out of host memory, fall back to a full stall */
+            _DEBUG_P ( "error: deletion queue growth, waiting for idle\n" );
+            vkDeviceWaitIdle ( queue->device );
+            cringedDeletionFlush ( queue );
+            execute ( queue->device, &deletion );
+            return;
+        }
+        queue->items = items;
+        queue->capacity *= 2;
+    }
+
+    deletion.frame                 = queue->frame;
+    queue->items[ queue->count++ ] = deletion;
+}
+
+void
+cringedDeferBuffer ( CringedDeletionQueue * queue, BasedBuffer * buffer )
+{
+    /* NOTE: freeing the memory unmaps it */
+    if ( buffer->buffer )
+        cringedDefer ( queue,
+                       ( CringedDeletion ) { CRINGED_DELETE_BUFFER,
+                                             .buffer = buffer->buffer } );
+    if ( buffer->memory )
+        cringedDefer ( queue,
+                       ( CringedDeletion ) { CRINGED_DELETE_MEMORY,
+                                             .memory = buffer->memory } );
+    buffer->buffer = VK_NULL_HANDLE;
+    buffer->memory = VK_NULL_HANDLE;
+    buffer->mapped = NULL;
+}
+
+void
+cringedDeletionFlush ( CringedDeletionQueue * queue )
+{
+    executePrefix ( queue, queue->count );
+}
@@ -0,0 +1,88 @@
+#pragma once
+#ifndef CRINGED_DELETION_QUEUE_H
+#define CRINGED_DELETION_QUEUE_H
+
+#include "bufferUtils.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vulkan/vulkan.h>
+
+typedef enum
+{
+    CRINGED_DELETE_BUFFER,
+    CRINGED_DELETE_MEMORY,
+    CRINGED_DELETE_IMAGE,
+    CRINGED_DELETE_IMAGE_VIEW,
+    CRINGED_DELETE_FRAMEBUFFER,
+    CRINGED_DELETE_RENDER_PASS,
+    CRINGED_DELETE_PIPELINE,
+    CRINGED_DELETE_PIPELINE_LAYOUT,
+    CRINGED_DELETE_SHADER_MODULE,
+    CRINGED_DELETE_SWAPCHAIN,
+    CRINGED_DELETE_HOST, /* free (), for memory the GPU reads via mapping */
+} CringedDeletionKind;
+
+/* One destroy request:
+ *   cringedDefer ( q, ( CringedDeletion ) { CRINGED_DELETE_IMAGE,
+ *                                           .image = image } ); */
+typedef struct
+{
+    CringedDeletionKind kind;
+    union
+    {
+        VkBuffer         buffer;
+        VkDeviceMemory   memory;
+        VkImage          image;
+        VkImageView      imageView;
+        VkFramebuffer    framebuffer;
+        VkRenderPass     renderPass;
+        VkPipeline       pipeline;
+        VkPipelineLayout pipelineLayout;
+        VkShaderModule   shaderModule;
+        VkSwapchainKHR   swapChain;
+        void *           host;
+    };
+    uint64_t frame; /* set by cringedDefer */
+} CringedDeletion;
+
+/* Destroy requests tagged with the frame being recorded, executed once the
+ * GPU completed that frame. Tags never decrease, so the executable ones are
+ * always a prefix and go in one sweep at frame start. */
+typedef struct
+{
+    VkDevice          device;
+    uint64_t          frame; /* being recorded */
+    uint32_t          count;
+    uint32_t          capacity;
+    CringedDeletion * items;
+} CringedDeletionQueue;
+
+CringedDeletionQueue *
+cringedCreateDeletionQueue ( uint32_t capacity );
+
+/* Pending requests must have been flushed */
+void
+cringedDestroyDeletionQueue ( CringedDeletionQueue * queue );
+
+/* `frame` is about to be recorded, every frame before `safeFrame` has
+ * completed on the GPU (its fence was waited) */
+void
+cringedDeletionBeginFrame ( CringedDeletionQueue * queue,
+                            uint64_t               frame,
+                            uint64_t               safeFrame );
+
+void
+cringedDefer ( CringedDeletionQueue * queue, CringedDeletion deletion );
+
+/* Buffer + memory of `buffer`, which is reset for reuse */
+void
+cringedDeferBuffer ( CringedDeletionQueue * queue, BasedBuffer * buffer );
+
+/* Executes everything now; the device must be idle (shutdown) */
+void
+cringedDeletionFlush ( CringedDeletionQueue * queue );
+
+#endif /* CRINGED_DELETION_QUEUE_H */
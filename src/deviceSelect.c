@@ -0,0 +1,458 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "deviceSelect.h"
+#include "bufferUtils.h"
+
+#include <time.h>
+
+#define DEVICE_CACHE_MAX 16
+
+static double
+nowSeconds ( void )
+{
+    struct timespec ts;
+    clock_gettime ( CLOCK_MONOTONIC, &ts );
+    return ( double ) ts.tv_sec + ( double ) ts.tv_nsec * 1e-9;
+}
+
+/* =============================================
+ *            RATING
+ * ============================================= */
+
+VkFormat
+cringedFindDepthFormat ( VkPhysicalDevice physicalDevice )
+{
+    const VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT,
+                                    VK_FORMAT_X8_D24_UNORM_PACK32,
+                                    VK_FORMAT_D24_UNORM_S8_UINT,
+                                    VK_FORMAT_D16_UNORM };
+    const uint32_t count = sizeof ( candidates ) / sizeof ( candidates[ 0 ] );
+    for ( uint32_t i = 0; i < count; i++ )
+    {
+        VkFormatProperties props;
+        vkGetPhysicalDeviceFormatProperties (
+            physicalDevice, candidates[ i ], &props );
+        if ( props.optimalTilingFeatures &
+             VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT )
+            return candidates[ i ];
+    }
+    return VK_FORMAT_UNDEFINED;
+}
+
+uint8_t
+cringedDeviceHasExtensions ( VkPhysicalDevice     device,
+                             const char * const * extensions,
+                             uint32_t             extensionCount )
+{
+    uint32_t availableCount = 0;
+    if ( vkEnumerateDeviceExtensionProperties (
+             device, NULL, &availableCount, NULL ) )
+        return 0;
+    VkExtensionProperties * available = ( VkExtensionProperties * ) malloc (
+        availableCount * sizeof ( VkExtensionProperties ) + 1 );
+    if ( ! available ) return 0;
+    if ( vkEnumerateDeviceExtensionProperties (
+             device, NULL, &availableCount, available ) )
+    {
+        free ( available );
+        return 0;
+    }
+
+    uint8_t found = 1;
+    for ( uint32_t i = 0; i < extensionCount && found; i++ )
+    {
+        found = 0;
+        for ( uint32_t j = 0; j < availableCount && ! found; j++ )
+            found = ! strcmp ( extensions[ i ], available[ j ].extensionName );
+    }
+    free ( available );
+    return found;
+}
+
+/* Graphics + present family into `candidate`, bonus for async families */
+static int64_t
+rateQueueFamilies ( VkSurfaceKHR surface, CringedDeviceCandidate * candidate )
+{
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties (
+        candidate->device, &familyCount, NULL );
+    VkQueueFamilyProperties * families = ( VkQueueFamilyProperties * ) malloc (
+        familyCount * sizeof ( VkQueueFamilyProperties ) + 1 );
+    if ( ! families ) return 0;
+    vkGetPhysicalDeviceQueueFamilyProperties (
+        candidate->device, &familyCount, families );
+
+    int64_t score        = 0;
+    uint8_t computeOnly  = 0;
+    uint8_t transferOnly = 0;
+    for ( uint32_t i = 0; i < familyCount; i++ )
+    {
+        VkQueueFlags flags   = families[ i ].queueFlags;
+        VkBool32     present = VK_FALSE;
+        if ( ( flags & VK_QUEUE_GRAPHICS_BIT ) &&
+             candidate->graphicsFamily == CRINGED_DEVICE_NONE &&
+             ! vkGetPhysicalDeviceSurfaceSupportKHR (
+                 candidate->device, i, surface, &present ) &&
+             present )
+            candidate->graphicsFamily = i;
+        if ( ( flags & VK_QUEUE_COMPUTE_BIT ) &&
+             ! ( flags & VK_QUEUE_GRAPHICS_BIT ) )
+            computeOnly = 1;
+        if ( ( flags & VK_QUEUE_TRANSFER_BIT ) &&
+             ! ( flags & ( VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT ) ) )
+            transferOnly = 1;
+    }
+    free ( families );
+
+    /* NOTE: async compute and DMA engines hint at a real GPU */
+    if ( computeOnly ) score += 100;
+    if ( transferOnly ) score += 100;
+    return score;
+}
+
+uint8_t
+cringedRateDevice ( VkPhysicalDevice         device,
+                    VkSurfaceKHR             surface,
+                    const char * const *     extensions,
+                    uint32_t                 extensionCount,
+                    CringedDeviceCandidate * candidate )
+{
+    memset ( candidate, 0, sizeof ( *candidate ) );
+    candidate->device         = device;
+    candidate->graphicsFamily = CRINGED_DEVICE_NONE;
+    candidate->bandwidth      = -1.0;
+
+    VkPhysicalDeviceProperties * props = &candidate->properties;
+    vkGetPhysicalDeviceProperties ( device, props );
+
+    /* Stable identity for the cache: core 1.1 device UUID, otherwise the
+     * pipeline cache UUID (changes with the driver build, which is fine) */
+    memcpy ( candidate->uuid, props->pipelineCacheUUID, VK_UUID_SIZE );
+    if ( props->apiVersion >= VK_API_VERSION_1_1 )
+    {
+        VkPhysicalDeviceIDProperties idProps = {};
+        idProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+        VkPhysicalDeviceProperties2 props2 = {};
+        props2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        props2.pNext = &idProps;
+        vkGetPhysicalDeviceProperties2 ( device, &props2 );
+        memcpy ( candidate->uuid, idProps.deviceUUID, VK_UUID_SIZE );
+    }
+
+    /* Hard requirements */
+    if ( ! cringedDeviceHasExtensions ( device, extensions, extensionCount ) )
+    {
+        candidate->reason = "missing device extensions";
+        return 0;
+    }
+    int64_t queueScore = rateQueueFamilies ( surface, candidate );
+    if ( candidate->graphicsFamily == CRINGED_DEVICE_NONE )
+    {
+        candidate->reason = "no graphics queue that can present";
+        return 0;
+    }
+    if ( cringedFindDepthFormat ( device ) == VK_FORMAT_UNDEFINED )
+    {
+        candidate->reason = "no depth attachment format";
+        return 0;
+    }
+
+    /* Static rating: the type dominates, the rest orders within a type */
+    int64_t score = queueScore;
+    switch ( props->deviceType )
+    {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: score += 10000; break;
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: score += 5000; break;
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: score += 2000; break;
+        case VK_PHYSICAL_DEVICE_TYPE_CPU: score += 100; break;
+        default: break;
+    }
+
+    VkPhysicalDeviceMemoryProperties memProps;
+    vkGetPhysicalDeviceMemoryProperties ( device, &memProps );
+    VkDeviceSize localBytes = 0;
+    for ( uint32_t i = 0; i < memProps.memoryHeapCount; i++ )
+        if ( memProps.memoryHeaps[ i ].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT )
+            localBytes += memProps.memoryHeaps[ i ].size;
+    score += ( int64_t ) ( localBytes >> 26 ); /* per 64 MiB */
+
+    score += props->limits.maxImageDimension2D / 256;
+    score += props->limits.maxComputeWorkGroupInvocations / 64;
+    if ( props->apiVersion >= VK_API_VERSION_1_3 )
+        score += 200; /* dynamic rendering, synchronization2 */
+
+    candidate->score  = score;
+    candidate->usable = 1;
+    return 1;
+}
+
+/* =============================================
+ *            MICRO-BENCHMARK
+ * ============================================= */
+
+double
+cringedBenchDevice ( const CringedDeviceCandidate * candidate )
+{
+    VkResult        opResult;
+    double          rcode    = -1.0;
+    VkDevice        device   = VK_NULL_HANDLE;
+    VkCommandPool   pool     = VK_NULL_HANDLE;
+    VkFence         fence    = VK_NULL_HANDLE;
+    BasedBuffer     buffer   = {};
+    VkCommandBuffer cmds[ 2 ];
+
+    float                   priority  = 1.0f;
+    VkDeviceQueueCreateInfo queueInfo = {};
+    queueInfo.sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfo.queueFamilyIndex = candidate->graphicsFamily;
+    queueInfo.queueCount       = 1;
+    queueInfo.pQueuePriorities = &priority;
+
+    VkDeviceCreateInfo deviceInfo   = {};
+    deviceInfo.sType                = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.queueCreateInfoCount = 1;
+    deviceInfo.pQueueCreateInfos    = &queueInfo;
+
+    if ( ( opResult = vkCreateDevice (
+               candidate->device, &deviceInfo, NULL, &device ) ) !=
+         VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: bench device: %d\n", opResult );
+        device = VK_NULL_HANDLE;
+        goto defer_cleanup;
+    }
+    VkQueue queue;
+    vkGetDeviceQueue ( device, candidate->graphicsFamily, 0, &queue );
+
+    if ( ( opResult = cringedCreateBuffer ( //
+               candidate->device,
+               device,
+               CRINGED_BENCH_BUFFER_SIZE,
+               VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+               &buffer ) ) != VK_SUCCESS )
+        goto defer_cleanup;
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = candidate->graphicsFamily;
+    if ( ( opResult = vkCreateCommandPool (
+               device, &poolInfo, NULL, &pool ) ) != VK_SUCCESS )
+    {
+        pool = VK_NULL_HANDLE;
+        goto defer_cleanup;
+    }
+
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = pool;
+    allocInfo.level       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 2;
+    if ( vkAllocateCommandBuffers ( device, &allocInfo, cmds ) != VK_SUCCESS )
+        goto defer_cleanup;
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType             = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if ( vkCreateFence ( device, &fenceInfo, NULL, &fence ) != VK_SUCCESS )
+    {
+        fence = VK_NULL_HANDLE;
+        goto defer_cleanup;
+    }
+
+    /* [0] warms up clocks and first-touch paging, [1] is timed */
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    for ( uint32_t c = 0; c < 2; c++ )
+    {
+        vkBeginCommandBuffer ( cmds[ c ], &beginInfo );
+        uint32_t passes = c ? CRINGED_BENCH_PASSES : 1;
+        for ( uint32_t p = 0; p < passes; p++ )
+            vkCmdFillBuffer (
+                cmds[ c ], buffer.buffer, 0, VK_WHOLE_SIZE, p * 0x01010101u );
+        vkEndCommandBuffer ( cmds[ c ] );
+    }
+
+    double seconds = 0.0;
+    for ( uint32_t c = 0; c < 2; c++ )
+    {
+        VkSubmitInfo submitInfo       = {};
+        submitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers    = &cmds[ c ];
+
+        double start = nowSeconds ();
+        if ( ( opResult = vkQueueSubmit ( queue, 1, &submitInfo, fence ) ) !=
+                 VK_SUCCESS ||
+             ( opResult = vkWaitForFences (
+                   device, 1, &fence, VK_TRUE, UINT64_MAX ) ) != VK_SUCCESS )
+        {
+            _DEBUG_P ( "error: bench submit: %d\n", opResult );
+            goto defer_cleanup;
+        }
+        seconds = nowSeconds () - start;
+        vkResetFences ( device, 1, &fence );
+    }
+
+    if ( seconds > 0.0 )
+        rcode = ( double ) CRINGED_BENCH_BUFFER_SIZE * CRINGED_BENCH_PASSES /
+                seconds * 1e-9;
+
+defer_cleanup:
+    if ( device )
+    {
+        if ( fence ) vkDestroyFence ( device, fence, NULL );
+        if ( pool ) vkDestroyCommandPool ( device, pool, NULL );
+        cringedDestroyBuffer ( device, &buffer );
+        vkDestroyDevice ( device, NULL );
+    }
+    return rcode;
+}
+
+/* =============================================
+ *            CACHE & SELECTION
+ * ============================================= */
+
+/* One line per device: "<uuid hex> <driver version> <GB/s>" */
+typedef struct
+{
+    uint8_t  uuid[ VK_UUID_SIZE ];
+    uint32_t driverVersion;
+    double   bandwidth;
+} DeviceCacheEntry;
+
+static uint32_t
+loadCache ( const char * path, DeviceCacheEntry * entries )
+{
+    FILE * file = path ? fopen ( path, "r" ) : NULL;
+    if ( ! file ) return 0;
+
+    uint32_t count = 0;
+    char     hex[ 2 * VK_UUID_SIZE + 1 ];
+    while ( count < DEVICE_CACHE_MAX &&
+            fscanf ( file,
+                     "%32s %u %lf",
+                     hex,
+                     &entries[ count ].driverVersion,
+                     &entries[ count ].bandwidth ) == 3 )
+    {
+        if ( strlen ( hex ) != 2 * VK_UUID_SIZE ) continue;
+        for ( uint32_t i = 0; i < VK_UUID_SIZE; i++ )
+        {
+            unsigned int byte;
+            sscanf ( hex + 2 * i, "%2x", &byte );
+            entries[ count ].uuid[ i ] = ( uint8_t ) byte;
+        }
+        count++;
+    }
+    fclose ( file );
+    return count;
+}
+
+static void
+saveCache ( const char *             path,
+            const DeviceCacheEntry * entries,
+            uint32_t                 count )
+{
+    FILE * file = path ? fopen ( path, "w" ) : NULL;
+    if ( ! file )
+    {
+        _DEBUG_P ( "warning: device cache not writable: %s\n",
+                   path ? path : "(none)" );
+        return;
+    }
+    for ( uint32_t e = 0; e < count; e++ )
+    {
+        for ( uint32_t i = 0; i < VK_UUID_SIZE; i++ )
+            fprintf ( file, "%02x", entries[ e ].uuid[ i ] );
+        fprintf ( file,
+                  " %u %.3f\n",
+                  entries[ e ].driverVersion,
+                  entries[ e ].bandwidth );
+    }
+    fclose ( file );
+}
+
+/* Cached bandwidth of `candidate`, probing and recording it on a miss */
+static void
+measure ( CringedDeviceCandidate * candidate,
+          DeviceCacheEntry *       entries,
+          uint32_t *               count,
+          uint8_t *                dirty )
+{
+    uint32_t slot = *count;
+    for ( uint32_t e = 0; e < *count; e++ )
+    {
+        if ( memcmp ( entries[ e ].uuid, candidate->uuid, VK_UUID_SIZE ) )
+            continue;
+        if ( entries[ e ].driverVersion ==
+             candidate->properties.driverVersion )
+        {
+            candidate->bandwidth = entries[ e ].bandwidth;
+            return;
+        }
+        slot = e; /* driver changed: measure again in place */
+    }
+
+    candidate->bandwidth = cringedBenchDevice ( candidate );
+    if ( candidate->bandwidth < 0.0 ) return;
+    if ( slot == DEVICE_CACHE_MAX ) slot = 0; /* NOTE: full, evict the first */
+    if ( slot == *count ) ( *count )++;
+    memcpy ( entries[ slot ].uuid, candidate->uuid, VK_UUID_SIZE );
+    entries[ slot ].driverVersion = candidate->properties.driverVersion;
+    entries[ slot ].bandwidth     = candidate->bandwidth;
+    *dirty                        = 1;
+}
+
+uint32_t
+cringedSelectDevice ( CringedDeviceCandidate * candidates,
+                      uint32_t                 count,
+                      uint8_t                  benchmark,
+                      const char *             cachePath )
+{
+    uint32_t best = CRINGED_DEVICE_NONE, usableCount = 0;
+    for ( uint32_t i = 0; i < count; i++ )
+    {
+        if ( ! candidates[ i ].usable ) continue;
+        usableCount++;
+        if ( best == CRINGED_DEVICE_NONE ||
+             candidates[ i ].score > candidates[ best ].score )
+            best = i;
+    }
+
+    /* NOTE: a single usable device needs no probe */
+    if ( benchmark && usableCount > 1 )
+    {
+        DeviceCacheEntry entries[ DEVICE_CACHE_MAX ];
+        uint32_t         entryCount = loadCache ( cachePath, entries );
+        uint8_t          dirty      = 0;
+        uint32_t         fastest    = CRINGED_DEVICE_NONE;
+        for ( uint32_t i = 0; i < count; i++ )
+        {
+            if ( ! candidates[ i ].usable ) continue;
+            measure ( &candidates[ i ], entries, &entryCount, &dirty );
+            if ( candidates[ i ].bandwidth >= 0.0 &&
+                 ( fastest == CRINGED_DEVICE_NONE ||
+                   candidates[ i ].bandwidth >
+                       candidates[ fastest ].bandwidth ) )
+                fastest = i;
+        }
+        if ( dirty ) saveCache ( cachePath, entries, entryCount );
+        if ( fastest != CRINGED_DEVICE_NONE ) best = fastest;
+    }
+
+    for ( uint32_t i = 0; i < count; i++ )
+    {
+        if ( candidates[ i ].usable )
+            _DEBUG_P ( "Device %s: score %lld, %.1f GB/s%s\n",
+                       candidates[ i ].properties.deviceName,
+                       ( long long ) candidates[ i ].score,
+                       candidates[ i ].bandwidth,
+                       i == best ? " <- selected" : "" );
+        else
+            _DEBUG_P ( "Device %s: unusable, %s\n",
+                       candidates[ i ].properties.deviceName,
+                       candidates[ i ].reason );
+    }
+    return best;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#ifndef CRINGED_DEVICE_SELECT_H
+#define CRINGED_DEVICE_SELECT_H
+
+#ifndef NDEBUG
+#define _DEBUG_P( ... ) printf ( __VA_ARGS__ )
+#else
+#define _DEBUG_P( ... ) ( ( void ) 0 )
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vulkan/vulkan.h>
+
+#define CRINGED_DEVICE_NONE UINT32_MAX
+
+/* Fill-rate probe: bytes written per pass, passes per timed submit */
+#define CRINGED_BENCH_BUFFER_SIZE ( 64u << 20 )
+#define CRINGED_BENCH_PASSES      16
+
+/* One physical device as seen by the selection:
+ *   usable    hard requirements met (graphics + present queue, extensions,
+ *             a depth attachment format, type allowed by the build)
+ *   score     static rating from type, heaps, limits and queue layout
+ *   bandwidth measured fill throughput in GB/s, < 0 when unknown */
+typedef struct
+{
+    VkPhysicalDevice           device;
+    VkPhysicalDeviceProperties properties;
+    uint8_t                    uuid[ VK_UUID_SIZE ];
+    uint32_t                   graphicsFamily;
+    uint8_t                    usable;
+    const char *               reason; /* why not usable */
+    int64_t                    score;
+    double                     bandwidth;
+} CringedDeviceCandidate;
+
+/* First depth format usable as an optimal-tiling attachment */
+VkFormat
+cringedFindDepthFormat ( VkPhysicalDevice physicalDevice );
+
+uint8_t
+cringedDeviceHasExtensions ( VkPhysicalDevice     device,
+                             const char * const * extensions,
+                             uint32_t             extensionCount );
+
+/* Fills `candidate`, returns `candidate->usable` */
+uint8_t
+cringedRateDevice ( VkPhysicalDevice         device,
+                    VkSurfaceKHR             surface,
+                    const char * const *     extensions,
+                    uint32_t                 extensionCount,
+                    CringedDeviceCandidate * candidate );
+
+/* Throughput of vkCmdFillBuffer on a throwaway logical device, in GB/s;
+ * a negative value when the probe could not run */
+double
+cringedBenchDevice ( const CringedDeviceCandidate * candidate );
+
+/* Index of the best usable candidate or CRINGED_DEVICE_NONE.
+ * With `benchmark` set and more than one usable candidate, the measured
+ * bandwidth decides; results are cached in `cachePath` (may be NULL) by
+ * device UUID and driver version, so only new devices or drivers pay for
+ * the probe. Otherwise the static score decides. */
+uint32_t
+cringedSelectDevice ( CringedDeviceCandidate * candidates,
+                      uint32_t                 count,
+                      uint8_t                  benchmark,
+                      const char *             cachePath );
+
+#endif /* CRINGED_DEVICE_SELECT_H */
@@ -0,0 +1,188 @@
+#include "gpuTrace.h"
+
+CringedGpuTrace *
+cringedCreateGpuTrace ( VkPhysicalDevice physicalDevice,
+                        VkDevice         device,
+                        uint32_t         timestampValidBits,
+                        uint32_t         frameCount,
+                        uint8_t          calibrated )
+{
+    if ( ! timestampValidBits || frameCount > CRINGED_GPU_TRACE_FRAMES )
+        return NULL;
+
+    CringedGpuTrace * trace =
+        ( CringedGpuTrace * ) calloc ( 1, sizeof ( CringedGpuTrace ) );
+    if ( ! trace ) return NULL;
+
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties ( physicalDevice, &props );
+    trace->device     = device;
+    trace->frameCount = frameCount;
+    trace->period     = props.limits.timestampPeriod;
+    trace->validMask  = timestampValidBits >= 64
+                            ? UINT64_MAX
+                            : ( 1ull << timestampValidBits ) - 1;
+    if ( calibrated )
+        trace->calibrate =
+            ( PFN_vkGetCalibratedTimestampsEXT ) vkGetDeviceProcAddr (
+                device, "vkGetCalibratedTimestampsEXT" );
+
+    VkQueryPoolCreateInfo poolInfo = {};
+    poolInfo.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = frameCount * CRINGED_GPU_TRACE_ZONES * 2;
+    if ( vkCreateQueryPool ( device, &poolInfo, NULL, &trace->pool ) !=
+         VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: creating timestamp query pool\n" );
+        free ( trace );
+        return NULL;
+    }
+    return trace;
+}
+
+void
+cringedDestroyGpuTrace ( CringedGpuTrace * trace )
+{
+    if ( ! trace ) return;
+    vkDestroyQueryPool ( trace->device, trace->pool, NULL );
+    free ( trace );
+}
+
+/* GPU ns -> CPU ns offset: calibrated when possible, else fence bound */
+static void
+updateOffset ( CringedGpuTrace * trace, uint64_t lastEnd, uint64_t fenceSeen )
+{
+    int64_t offset;
+    if ( trace->calibrate )
+    {
+        VkCalibratedTimestampInfoEXT infos[ 2 ] = {};
+        infos[ 0 ].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+        infos[ 0 ].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+        infos[ 1 ].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+        infos[ 1 ].timeDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+        uint64_t stamps[ 2 ], deviation;
+        if ( trace->calibrate (
+                 trace->device, 2, infos, stamps, &deviation ) == VK_SUCCESS )
+        {
+            offset = ( int64_t ) stamps[ 1 ] -
+                     ( int64_t ) ( ( double ) ( stamps[ 0 ] &
+                                                trace->validMask ) *
+                                   trace->period );
+            trace->offset     = offset;
+            trace->haveOffset = 1;
+            cringedTraceGpuOffset ( offset );
+            return;
+        }
+        trace->calibrate = NULL; /* NOTE: domain unsupported, fall back */
+    }
+
+    offset = ( int64_t ) fenceSeen - ( int64_t ) lastEnd;
+    if ( ! trace->haveOffset || offset < trace->offset )
+    {
+        trace->offset     = offset;
+        trace->haveOffset = 1;
+        cringedTraceGpuOffset ( offset );
+    }
+}
+
+void
+cringedGpuTraceCollect ( CringedGpuTrace * trace,
+                         uint32_t          frame,
+                         uint64_t          fenceSeen )
+{
+    if ( ! trace || ! trace->zoneCount[ frame ] ) return;
+
+    uint32_t count = trace->zoneCount[ frame ];
+    uint64_t stamps[ CRINGED_GPU_TRACE_ZONES * 2 ];
+    trace->zoneCount[ frame ] = 0;
+    trace->frameNs            = 0;
+    trace->lastCount          = 0;
+    if ( vkGetQueryPoolResults ( trace->device,
+                                 trace->pool,
+                                 frame * CRINGED_GPU_TRACE_ZONES * 2,
+                                 count * 2,
+                                 sizeof ( stamps ),
+                                 stamps,
+                                 sizeof ( uint64_t ),
+                                 VK_QUERY_RESULT_64_BIT ) != VK_SUCCESS )
+        return;
+
+    uint64_t firstBegin = UINT64_MAX, lastEnd = 0;
+    for ( uint32_t z = 0; z < count; z++ )
+    {
+        uint64_t begin = ( uint64_t ) ( ( double ) ( stamps[ 2 * z ] &
+                                                     trace->validMask ) *
+                                        trace->period );
+        uint64_t end   = ( uint64_t ) ( ( double ) ( stamps[ 2 * z + 1 ] &
+                                                   trace->validMask ) *
+                                      trace->period );
+        if ( end < begin ) end = begin;
+        if ( begin < firstBegin ) firstBegin = begin;
+        if ( end > lastEnd ) lastEnd = end;
+        trace->lastNames[ z ] = trace->names[ frame ][ z ];
+        trace->lastNs[ z ]    = end - begin;
+        if ( cringedTraceEnabled )
+            cringedTraceEmitGpu ( trace->names[ frame ][ z ], begin, end );
+    }
+    trace->frameNs   = lastEnd - firstBegin;
+    trace->lastCount = count;
+    if ( cringedTraceEnabled ) updateOffset ( trace, lastEnd, fenceSeen );
+}
+
+uint64_t
+cringedGpuTraceZoneNs ( const CringedGpuTrace * trace, const char * name )
+{
+    if ( ! trace ) return 0;
+    uint64_t ns = 0;
+    for ( uint32_t z = 0; z < trace->lastCount; z++ )
+        if ( strcmp ( trace->lastNames[ z ], name ) == 0 )
+            ns += trace->lastNs[ z ];
+    return ns;
+}
+
+void
+cringedGpuTraceBeginFrame ( CringedGpuTrace * trace,
+                            VkCommandBuffer   commandBuffer,
+                            uint32_t          frame )
+{
+    if ( ! trace ) return;
+    trace->frame              = frame;
+    trace->zoneCount[ frame ] = 0;
+    vkCmdResetQueryPool ( commandBuffer,
+                          trace->pool,
+                          frame * CRINGED_GPU_TRACE_ZONES * 2,
+                          CRINGED_GPU_TRACE_ZONES * 2 );
+}
+
+uint32_t
+cringedGpuZoneBegin ( CringedGpuTrace * trace,
+                      VkCommandBuffer   commandBuffer,
+                      const char *      name )
+{
+    if ( ! trace ) return UINT32_MAX;
+    uint32_t zone = trace->zoneCount[ trace->frame ];
+    if ( zone == CRINGED_GPU_TRACE_ZONES ) return UINT32_MAX;
+
+    trace->names[ trace->frame ][ zone ] = name;
+    trace->zoneCount[ trace->frame ]++;
+    vkCmdWriteTimestamp (
+        commandBuffer,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        trace->pool,
+        ( trace->frame * CRINGED_GPU_TRACE_ZONES + zone ) * 2 );
+    return zone;
+}
+
+void
+cringedGpuZoneEnd ( CringedGpuTrace * trace,
+                    VkCommandBuffer   commandBuffer,
+                    uint32_t          zone )
+{
+    if ( ! trace || zone == UINT32_MAX ) return;
+    vkCmdWriteTimestamp (
+        commandBuffer,
+        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        trace->pool,
+        ( trace->frame * CRINGED_GPU_TRACE_ZONES + zone ) * 2 + 1 );
+}
@@ -0,0 +1,79 @@
+#pragma once
+#ifndef CRINGED_GPU_TRACE_H
+#define CRINGED_GPU_TRACE_H
+
+#include "trace.h"
+
+#include <vulkan/vulkan.h>
+
+#define CRINGED_GPU_TRACE_FRAMES 4  /* frames in flight supported */
+#define CRINGED_GPU_TRACE_ZONES  32 /* per frame */
+
+/* Timestamp pairs per frame in flight, read back once its fence was
+ * waited. GPU time maps onto CLOCK_MONOTONIC with an offset from
+ * VK_EXT_calibrated_timestamps when enabled; otherwise it is bounded by
+ * the fence: a frame cannot end after the CPU saw it complete, the
+ * tightest such bound over the run is used. */
+typedef struct
+{
+    VkDevice                         device;
+    VkQueryPool                      pool;
+    uint32_t                         frameCount;
+    double                           period; /* ns per tick */
+    uint64_t                         validMask;
+    PFN_vkGetCalibratedTimestampsEXT calibrate;
+    uint32_t                         frame; /* slot being recorded */
+    uint32_t     zoneCount[ CRINGED_GPU_TRACE_FRAMES ];
+    const char * names[ CRINGED_GPU_TRACE_FRAMES ][ CRINGED_GPU_TRACE_ZONES ];
+    uint8_t      haveOffset;
+    int64_t      offset;  /* CPU ns minus GPU ns */
+    uint64_t     frameNs; /* first zone begin to last zone end, 0: none */
+    /* Durations of the last collected frame's zones */
+    uint32_t     lastCount;
+    const char * lastNames[ CRINGED_GPU_TRACE_ZONES ];
+    uint64_t     lastNs[ CRINGED_GPU_TRACE_ZONES ];
+} CringedGpuTrace;
+
+/* NULL when the queue has no timestamps; `calibrated`: the device was
+ * created with VK_EXT_calibrated_timestamps. Zones are only emitted to
+ * the trace while tracing, `frameNs` is kept either way (HUD). */
+CringedGpuTrace *
+cringedCreateGpuTrace ( VkPhysicalDevice physicalDevice,
+                        VkDevice         device,
+                        uint32_t         timestampValidBits,
+                        uint32_t         frameCount,
+                        uint8_t          calibrated );
+
+void
+cringedDestroyGpuTrace ( CringedGpuTrace * trace );
+
+/* After the fence of `frame` was waited at CPU time `fenceSeen`: emits
+ * the zones that frame recorded last time */
+void
+cringedGpuTraceCollect ( CringedGpuTrace * trace,
+                         uint32_t          frame,
+                         uint64_t          fenceSeen );
+
+/* Total nanoseconds of the zones named `name` in the last collected
+ * frame; 0 when there were none. NULL-safe. */
+uint64_t
+cringedGpuTraceZoneNs ( const CringedGpuTrace * trace, const char * name );
+
+/* First thing in the frame's command buffer: resets its queries */
+void
+cringedGpuTraceBeginFrame ( CringedGpuTrace * trace,
+                            VkCommandBuffer   commandBuffer,
+                            uint32_t          frame );
+
+/* NULL-safe; returns the zone for cringedGpuZoneEnd */
+uint32_t
+cringedGpuZoneBegin ( CringedGpuTrace * trace,
+                      VkCommandBuffer   commandBuffer,
+                      const char *      name );
+
+void
+cringedGpuZoneEnd ( CringedGpuTrace * trace,
+                    VkCommandBuffer   commandBuffer,
+                    uint32_t          zone );
+
+#endif /* CRINGED_GPU_TRACE_H */
@@ -0,0 +1,378 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "hud.h"
+
+#include <unistd.h>
+
+/* Atlas: 16 x 8 cells of 8 x 8 texels, ASCII 0x20 - 0x5F in the first
+ * 64, the last cell solid for panels and graph bars */
+#define ATLAS_WIDTH  128
+#define ATLAS_HEIGHT 64
+#define CELL         8
+#define GLYPH_WIDTH  5
+#define SOLID_CELL   127
+
+#define GLYPH_ADVANCE 6
+#define LINE_HEIGHT   10
+#define MARGIN        8
+#define GRAPH_HEIGHT  32   /* atlas texels, at GRAPH_MAX_MS */
+#define GRAPH_MAX_MS  33.3f
+#define GRAPH_LINE_MS 16.7f
+
+/* 5x7, one byte per column, bit 0 at the top */
+static const uint8_t font[ 64 ][ GLYPH_WIDTH ] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00 }, /* ' ' */
+    { 0x00, 0x00, 0x5F, 0x00, 0x00 }, /* ! */
+    { 0x00, 0x07, 0x00, 0x07, 0x00 }, /* " */
+    { 0x14, 0x7F, 0x14, 0x7F, 0x14 }, /* # */
+    { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, /* $ */
+    { 0x23, 0x13, 0x08, 0x64, 0x62 }, /* % */
+    { 0x36, 0x49, 0x56, 0x20, 0x50 }, /* & */
+    { 0x00, 0x08, 0x07, 0x03, 0x00 }, /* ' */
+    { 0x00, 0x1C, 0x22, 0x41, 0x00 }, /* ( */
+    { 0x00, 0x41, 0x22, 0x1C, 0x00 }, /* ) */
+    { 0x2A, 0x1C, 0x7F, 0x1C, 0x2A }, /* * */
+    { 0x08, 0x08, 0x3E, 0x08, 0x08 }, /* + */
+    { 0x00, 0x50, 0x30, 0x00, 0x00 }, /* , */
+    { 0x08, 0x08, 0x08, 0x08, 0x08 }, /* - */
+    { 0x00, 0x60, 0x60, 0x00, 0x00 }, /* . */
+    { 0x20, 0x10, 0x08, 0x04, 0x02 }, /* / */
+    { 0x3E, 0x51, 0x49, 0x45, 0x3E }, /* 0 */
+    { 0x00, 0x42, 0x7F, 0x40, 0x00 }, /* 1 */
+    { 0x72, 0x49, 0x49, 0x49, 0x46 }, /* 2 */
+    { 0x21, 0x41, 0x49, 0x4D, 0x33 }, /* 3 */
+    { 0x18, 0x14, 0x12, 0x7F, 0x10 }, /* 4 */
+    { 0x27, 0x45, 0x45, 0x45, 0x39 }, /* 5 */
+    { 0x3C, 0x4A, 0x49, 0x49, 0x31 }, /* 6 */
+    { 0x41, 0x21, 0x11, 0x09, 0x07 }, /* 7 */
+    { 0x36, 0x49, 0x49, 0x49, 0x36 }, /* 8 */
+    { 0x46, 0x49, 0x49, 0x29, 0x1E }, /* 9 */
+    { 0x00, 0x00, 0x14, 0x00, 0x00 }, /* : */
+    { 0x00, 0x40, 0x34, 0x00, 0x00 }, /* ; */
+    { 0x00, 0x08, 0x14, 0x22, 0x41 }, /* < */
+    { 0x14, 0x14, 0x14, 0x14, 0x14 }, /* = */
+    { 0x00, 0x41, 0x22, 0x14, 0x08 }, /* > */
+    { 0x02, 0x01, 0x59, 0x09, 0x06 }, /* ? */
+    { 0x3E, 0x41, 0x5D, 0x59, 0x4E }, /* @ */
+    { 0x7C, 0x12, 0x11, 0x12, 0x7C }, /* A */
+    { 0x7F, 0x49, 0x49, 0x49, 0x36 }, /* B */
+    { 0x3E, 0x41, 0x41, 0x41, 0x22 }, /* C */
+    { 0x7F, 0x41, 0x41, 0x41, 0x3E }, /* D */
+    { 0x7F, 0x49, 0x49, 0x49, 0x41 }, /* E */
+    { 0x7F, 0x09, 0x09, 0x09, 0x01 }, /* F */
+    { 0x3E, 0x41, 0x41, 0x51, 0x73 }, /* G */
+    { 0x7F, 0x08, 0x08, 0x08, 0x7F }, /* H */
+    { 0x00, 0x41, 0x7F, 0x41, 0x00 }, /* I */
+    { 0x20, 0x40, 0x41, 0x3F, 0x01 }, /* J */
+    { 0x7F, 0x08, 0x14, 0x22, 0x41 }, /* K */
+    { 0x7F, 0x40, 0x40, 0x40, 0x40 }, /* L */
+    { 0x7F, 0x02, 0x1C, 0x02, 0x7F }, /* M */
+    { 0x7F, 0x04, 0x08, 0x10, 0x7F }, /* N */
+    { 0x3E, 0x41, 0x41, 0x41, 0x3E }, /* O */
+    { 0x7F, 0x09, 0x09, 0x09, 0x06 }, /* P */
+    { 0x3E, 0x41, 0x51, 0x21, 0x5E }, /* Q */
+    { 0x7F, 0x09, 0x19, 0x29, 0x46 }, /* R */
+    { 0x26, 0x49, 0x49, 0x49, 0x32 }, /* S */
+    { 0x03, 0x01, 0x7F, 0x01, 0x03 }, /* T */
+    { 0x3F, 0x40, 0x40, 0x40, 0x3F }, /* U */
+    { 0x1F, 0x20, 0x40, 0x20, 0x1F }, /* V */
+    { 0x3F, 0x40, 0x38, 0x40, 0x3F }, /* W */
+    { 0x63, 0x14, 0x08, 0x14, 0x63 }, /* X */
+    { 0x03, 0x04, 0x78, 0x04, 0x03 }, /* Y */
+    { 0x61, 0x59, 0x49, 0x4D, 0x43 }, /* Z */
+    { 0x00, 0x7F, 0x41, 0x41, 0x41 }, /* [ */
+    { 0x02, 0x04, 0x08, 0x10, 0x20 }, /* \ */
+    { 0x00, 0x41, 0x41, 0x41, 0x7F }, /* ] */
+    { 0x04, 0x02, 0x01, 0x02, 0x04 }, /* ^ */
+    { 0x40, 0x40, 0x40, 0x40, 0x40 }, /* _ */
+};
+
+CringedHud *
+cringedCreateHud ( uint8_t visible )
+{
+    CringedHud * hud = ( CringedHud * ) calloc ( 1, sizeof ( CringedHud ) );
+    if ( hud == NULL ) return NULL;
+    hud->visible     = visible;
+    hud->atlas       = CRINGED_SPRITE_NONE;
+    hud->scale       = 2;
+    hud->windowStart = cringedTraceNow ();
+    hud->mark        = hud->windowStart;
+    return hud;
+}
+
+void
+cringedDestroyHud ( CringedHud * hud )
+{
+    free ( hud );
+}
+
+VkResult
+cringedHudCreateAtlas ( CringedHud * hud, CringedSpriteBatch * batch )
+{
+    /* White everywhere, coverage in alpha: no dark fringes when blended */
+    static uint32_t texels[ ATLAS_WIDTH * ATLAS_HEIGHT ];
+    for ( uint32_t i = 0; i < ATLAS_WIDTH * ATLAS_HEIGHT; i++ )
+        texels[ i ] = CRINGED_RGBA ( 255, 255, 255, 0 );
+
+    for ( uint32_t g = 0; g < 64; g++ )
+    {
+        uint32_t x0 = ( g % 16 ) * CELL, y0 = ( g / 16 ) * CELL;
+        for ( uint32_t col = 0; col < GLYPH_WIDTH; col++ )
+            for ( uint32_t row = 0; row < CELL; row++ )
+                if ( font[ g ][ col ] & ( 1u << row ) )
+                    texels[ ( y0 + row ) * ATLAS_WIDTH + x0 + col ] =
+                        CRINGED_RGBA ( 255, 255, 255, 255 );
+    }
+    uint32_t x0 = ( SOLID_CELL % 16 ) * CELL, y0 = ( SOLID_CELL / 16 ) * CELL;
+    for ( uint32_t row = 0; row < CELL; row++ )
+        for ( uint32_t col = 0; col < CELL; col++ )
+            texels[ ( y0 + row ) * ATLAS_WIDTH + x0 + col ] =
+                CRINGED_RGBA ( 255, 255, 255, 255 );
+
+    /* NOTE: nearest, glyphs stay crisp at integer scales; pinned, the HUD
+     * reports memory pressure rather than vanishing under it */
+    hud->atlas = cringedSpriteCreateTexture ( batch,
+                                              ATLAS_WIDTH,
+                                              ATLAS_HEIGHT,
+                                              texels,
+                                              VK_FILTER_NEAREST,
+                                              CRINGED_PRIORITY_PINNED );
+    if ( hud->atlas == CRINGED_SPRITE_NONE )
+    {
+        _DEBUG_P ( "error: creating HUD glyph atlas\n" );
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+    return VK_SUCCESS;
+}
+
+void
+cringedHudBeginFrame ( CringedHud * hud )
+{
+    if ( ! hud ) return;
+    uint64_t now = cringedTraceNow ();
+    if ( hud->frameStart )
+    {
+        uint64_t frame = now - hud->frameStart;
+        hud->frameNs += frame;
+        hud->windowFrames++;
+        hud->history[ hud->historyHead ] = ( float ) ( frame * 1e-6 );
+        hud->historyHead = ( hud->historyHead + 1 ) % CRINGED_HUD_HISTORY;
+    }
+    hud->frameStart = now;
+    hud->mark       = now;
+}
+
+static const char *
+presentModeName ( VkPresentModeKHR mode )
+{
+    switch ( mode )
+    {
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:    return "IMMEDIATE";
+    case VK_PRESENT_MODE_MAILBOX_KHR:      return "MAILBOX";
+    case VK_PRESENT_MODE_FIFO_KHR:         return "FIFO";
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "FIFO RELAXED";
+    default:                               return "?";
+    }
+}
+
+/* Resident set of the process; 0 when /proc is unavailable */
+static uint64_t
+residentBytes ( void )
+{
+    unsigned long size, resident = 0;
+    FILE *        statm = fopen ( "/proc/self/statm", "r" );
+    if ( ! statm ) return 0;
+    if ( fscanf ( statm, "%lu %lu", &size, &resident ) != 2 ) resident = 0;
+    fclose ( statm );
+    return ( uint64_t ) resident * ( uint64_t ) sysconf ( _SC_PAGESIZE );
+}
+
+/* End of an averaging window: the only place text is formatted */
+static void
+formatText ( CringedHud * hud, const CringedHudStats * stats )
+{
+    double frames  = hud->windowFrames;
+    double frameMs = hud->frameNs * 1e-6 / frames;
+    double ms[ CRINGED_HUD_STAGE_COUNT ];
+    for ( uint32_t s = 0; s < CRINGED_HUD_STAGE_COUNT; s++ )
+        ms[ s ] = hud->stageNs[ s ] * 1e-6 / frames;
+
+    char gpu[ 32 ] = "GPU      N/A";
+    if ( hud->gpuFrames )
+        snprintf ( gpu,
+                   sizeof ( gpu ),
+                   "GPU   %6.2f MS",
+                   hud->gpuNs * 1e-6 / hud->gpuFrames );
+
+    int length = snprintf ( //
+        hud->text,
+        sizeof ( hud->text ),
+        "FRAME %6.2f MS %5.0f FPS\n"
+        "%s\n"
+        "CPU WAIT %.2f ACQ %.2f REC %.2f SUB %.2f\n"
+        "%uX%u %s, %u IMAGES, %u IN FLIGHT\n"
+        "DRAWS %u INSTANCES %u QUEUED %u SPRITES %u\n"
+        "TRIANGLES %llu OF %llu AT FULL DETAIL\n"
+        "RSS %.1f MB BUFFERS %.1f MB\n"
+        "VRAM %.1f OF %.1f MB %s, %llu EVICTED\n"
+        "HUD %.3f MS",
+        frameMs,
+        frameMs > 0.0 ? 1e3 / frameMs : 0.0,
+        gpu,
+        ms[ CRINGED_HUD_WAIT ],
+        ms[ CRINGED_HUD_ACQUIRE ],
+        ms[ CRINGED_HUD_RECORD ],
+        ms[ CRINGED_HUD_SUBMIT ],
+        stats->extent.width,
+        stats->extent.height,
+        presentModeName ( stats->presentMode ),
+        stats->swapchainImages,
+        stats->framesInFlight,
+        hud->draws,
+        stats->instances,
+        stats->queued,
+        stats->sprites,
+        ( unsigned long long ) stats->triangles,
+        ( unsigned long long ) stats->fullTriangles,
+        residentBytes () / 1048576.0,
+        atomic_load_explicit ( &cringedBufferMemory, memory_order_relaxed ) /
+            1048576.0,
+        stats->deviceUsage / 1048576.0,
+        stats->deviceBudget / 1048576.0,
+        stats->budgetMeasured ? "BUDGET" : "HEAPS",
+        ( unsigned long long ) stats->evictions,
+        hud->selfNs * 1e-6 / frames );
+    hud->textLength = length < 0 ? 0
+                      : ( uint32_t ) length < sizeof ( hud->text )
+                          ? ( uint32_t ) length
+                          : sizeof ( hud->text ) - 1;
+
+    hud->windowFrames = 0;
+    hud->frameNs      = 0;
+    hud->gpuNs        = 0;
+    hud->gpuFrames    = 0;
+    hud->selfNs       = 0;
+    memset ( hud->stageNs, 0, sizeof ( hud->stageNs ) );
+}
+
+static void
+solid ( CringedHud *         hud,
+        CringedSpriteBatch * batch,
+        float                x,
+        float                y,
+        float                w,
+        float                h,
+        uint32_t             color )
+{
+    float u = ( ( SOLID_CELL % 16 ) * CELL + CELL / 2 ) /
+              ( float ) ATLAS_WIDTH;
+    float v = ( ( SOLID_CELL / 16 ) * CELL + CELL / 2 ) /
+              ( float ) ATLAS_HEIGHT;
+    CringedSprite sprite = {
+        x, y, w, h, u, v, u, v, color, hud->atlas, CRINGED_SPRITE_ALPHA,
+        CRINGED_HUD_LAYER };
+    cringedSpriteDraw ( batch, &sprite );
+}
+
+void
+cringedHudDraw ( CringedHud *            hud,
+                 CringedSpriteBatch *    batch,
+                 const CringedHudStats * stats )
+{
+    if ( ! hud || hud->atlas == CRINGED_SPRITE_NONE ) return;
+    uint64_t start = cringedTraceNow ();
+
+    if ( hud->windowFrames &&
+         start - hud->windowStart >= CRINGED_HUD_REFRESH_NS )
+    {
+        formatText ( hud, stats );
+        hud->windowStart = start;
+    }
+    if ( ! hud->visible ) goto done;
+
+    /* Panel size from the cached text */
+    float    s     = ( float ) hud->scale;
+    uint32_t lines = 1, column = 0, columns = 0;
+    for ( uint32_t i = 0; i < hud->textLength; i++ )
+    {
+        if ( hud->text[ i ] == '\n' )
+        {
+            lines++;
+            column = 0;
+            continue;
+        }
+        if ( ++column > columns ) columns = column;
+    }
+    float textWidth  = columns * GLYPH_ADVANCE * s;
+    float graphWidth = CRINGED_HUD_HISTORY * s;
+    float graphTop   = MARGIN * 2 + lines * LINE_HEIGHT * s;
+    float panelWidth = ( textWidth > graphWidth ? textWidth : graphWidth );
+    solid ( hud,
+            batch,
+            MARGIN,
+            MARGIN,
+            panelWidth + MARGIN * 2,
+            graphTop + GRAPH_HEIGHT * s,
+            CRINGED_RGBA ( 0, 0, 0, 160 ) );
+
+    /* Text */
+    float x = MARGIN * 2, y = MARGIN * 2;
+    for ( uint32_t i = 0; i < hud->textLength; i++ )
+    {
+        unsigned char c = ( unsigned char ) hud->text[ i ];
+        if ( c == '\n' )
+        {
+            x = MARGIN * 2;
+            y += LINE_HEIGHT * s;
+            continue;
+        }
+        if ( c >= 'a' && c <= 'z' ) c -= 'a' - 'A';
+        if ( c > ' ' && c < 0x60 )
+        {
+            uint32_t      g      = c - 0x20;
+            float         u0     = ( g % 16 ) * CELL / ( float ) ATLAS_WIDTH;
+            float         v0     = ( g / 16 ) * CELL / ( float ) ATLAS_HEIGHT;
+            CringedSprite sprite = {
+                x,
+                y,
+                GLYPH_WIDTH * s,
+                CELL * s,
+                u0,
+                v0,
+                u0 + GLYPH_WIDTH / ( float ) ATLAS_WIDTH,
+                v0 + CELL / ( float ) ATLAS_HEIGHT,
+                CRINGED_RGBA ( 255, 255, 255, 255 ),
+                hud->atlas,
+                CRINGED_SPRITE_ALPHA,
+                CRINGED_HUD_LAYER };
+            cringedSpriteDraw ( batch, &sprite );
+        }
+        x += GLYPH_ADVANCE * s;
+    }
+
+    /* Frame time graph, oldest on the left, GRAPH_MAX_MS full height */
+    float bottom = graphTop + GRAPH_HEIGHT * s;
+    for ( uint32_t i = 0; i < CRINGED_HUD_HISTORY; i++ )
+    {
+        float ms =
+            hud->history[ ( hud->historyHead + i ) % CRINGED_HUD_HISTORY ];
+        if ( ms <= 0.0f ) continue;
+        float    h     = ( ms < GRAPH_MAX_MS ? ms : GRAPH_MAX_MS ) /
+                         GRAPH_MAX_MS * GRAPH_HEIGHT * s;
+        uint32_t color = ms <= GRAPH_LINE_MS ? CRINGED_RGBA ( 64, 220, 64, 255 )
+                         : ms <= GRAPH_MAX_MS
+                             ? CRINGED_RGBA ( 230, 200, 40, 255 )
+                             : CRINGED_RGBA ( 230, 50, 40, 255 );
+        solid ( hud, batch, MARGIN * 2 + i * s, bottom - h, s, h, color );
+    }
+    solid ( hud,
+            batch,
+            MARGIN * 2,
+            bottom - GRAPH_LINE_MS / GRAPH_MAX_MS * GRAPH_HEIGHT * s,
+            graphWidth,
+            1.0f,
+            CRINGED_RGBA ( 255, 255, 255, 96 ) );
+
+done:
+    hud->selfNs += cringedTraceNow () - start;
+}
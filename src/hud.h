@@ -0,0 +1,121 @@
+#pragma once
+#ifndef CRINGED_HUD_H
+#define CRINGED_HUD_H
+
+#include "sprite.h"
+#include "trace.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vulkan/vulkan.h>
+
+#ifndef NDEBUG
+#define _DEBUG_P( ... ) printf ( __VA_ARGS__ )
+#else
+#define _DEBUG_P( ... ) ( ( void ) 0 )
+#endif
+
+#define CRINGED_HUD_HISTORY    128         /* frames in the graph */
+#define CRINGED_HUD_REFRESH_NS 250000000ull /* text averaging window */
+#define CRINGED_HUD_TEXT       512
+#define CRINGED_HUD_LAYER      255 /* above everything else */
+
+/* CPU stages of basedDrawFrame, in order */
+typedef enum
+{
+    CRINGED_HUD_WAIT,    /* in-flight fence */
+    CRINGED_HUD_ACQUIRE, /* deletions, recreate, acquire */
+    CRINGED_HUD_RECORD,
+    CRINGED_HUD_SUBMIT, /* submit and present flush */
+    CRINGED_HUD_STAGE_COUNT,
+} CringedHudStage;
+
+/* Engine state the HUD prints, filled by the renderer each frame */
+typedef struct
+{
+    VkExtent2D       extent;
+    VkPresentModeKHR presentMode;
+    uint32_t         framesInFlight;
+    uint32_t         swapchainImages;
+    uint32_t         instances;     /* visible after culling */
+    uint32_t         queued;        /* render queue commands */
+    uint32_t         sprites;       /* application quads, HUD excluded */
+    uint64_t         triangles;     /* visible instances, at their level */
+    uint64_t         fullTriangles; /* the same, all at full detail */
+    VkDeviceSize     deviceUsage;   /* device local heaps, bytes */
+    VkDeviceSize     deviceBudget;
+    uint8_t          budgetMeasured; /* else heap sizes */
+    uint64_t         evictions;
+} CringedHudStats;
+
+/* Stage times are accumulated with one clock read per stage boundary and
+ * averaged over CRINGED_HUD_REFRESH_NS; the text is formatted once per
+ * window only. Every frame then costs one quad per glyph and graph bar,
+ * all from one atlas on one layer: a single sprite batch draw. */
+typedef struct
+{
+    uint8_t  visible;
+    uint16_t atlas; /* sprite texture, CRINGED_SPRITE_NONE until created */
+    uint32_t scale; /* atlas texels to pixels */
+    /* This frame */
+    uint64_t frameStart;
+    uint64_t mark; /* last stage boundary */
+    uint32_t draws; /* draw calls recorded, set by the renderer */
+    /* Averaging window */
+    uint64_t windowStart;
+    uint32_t windowFrames;
+    uint64_t frameNs;
+    uint64_t stageNs[ CRINGED_HUD_STAGE_COUNT ];
+    uint64_t gpuNs;
+    uint32_t gpuFrames;
+    uint64_t selfNs; /* the HUD's own update and draw */
+    /* Frame time graph, milliseconds, ring */
+    float    history[ CRINGED_HUD_HISTORY ];
+    uint32_t historyHead;
+    /* Formatted at the end of each window */
+    char     text[ CRINGED_HUD_TEXT ];
+    uint32_t textLength;
+} CringedHud;
+
+CringedHud *
+cringedCreateHud ( uint8_t visible );
+
+void
+cringedDestroyHud ( CringedHud * hud );
+
+/* Glyph atlas as a sprite texture; dies with the batch resources */
+VkResult
+cringedHudCreateAtlas ( CringedHud * hud, CringedSpriteBatch * batch );
+
+/* Start of basedDrawFrame: closes the previous frame */
+void
+cringedHudBeginFrame ( CringedHud * hud );
+
+/* End of `stage`: time since the previous boundary. NULL-safe. */
+static inline void
+cringedHudStage ( CringedHud * hud, CringedHudStage stage )
+{
+    if ( ! hud ) return;
+    uint64_t now          = cringedTraceNow ();
+    hud->stageNs[ stage ] += now - hud->mark;
+    hud->mark             = now;
+}
+
+/* GPU time of a completed frame, 0 when it was not measured */
+static inline void
+cringedHudGpuTime ( CringedHud * hud, uint64_t ns )
+{
+    if ( ! hud || ! ns ) return;
+    hud->gpuNs += ns;
+    hud->gpuFrames++;
+}
+
+/* Queues the overlay into `batch`, before it is prepared */
+void
+cringedHudDraw ( CringedHud *            hud,
+                 CringedSpriteBatch *    batch,
+                 const CringedHudStats * stats );
+
+#endif /* CRINGED_HUD_H */
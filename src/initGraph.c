@@ -0,0 +1,212 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "initGraph.h"
+
+#include <time.h>
+
+static double
+nowSeconds ( void )
+{
+    struct timespec ts;
+    clock_gettime ( CLOCK_MONOTONIC, &ts );
+    return ( double ) ts.tv_sec + ( double ) ts.tv_nsec * 1e-9;
+}
+
+void
+cringedInitReset ( CringedInitGraph * graph )
+{
+    memset ( graph, 0, sizeof ( *graph ) );
+    graph->failed = CRINGED_INIT_NONE;
+}
+
+uint32_t
+cringedInitAdd ( CringedInitGraph * graph,
+                 const char *       name,
+                 CringedInitFn      run,
+                 void *             userData,
+                 uint32_t           deps,
+                 uint8_t            mainThread )
+{
+    uint32_t index = graph->stepCount;
+    if ( index == CRINGED_INIT_MAX_STEPS || ( deps >> index ) )
+    {
+        _DEBUG_P ( "error: init step %s rejected\n", name );
+        return CRINGED_INIT_NONE;
+    }
+
+    CringedInitStep * step = &graph->steps[ graph->stepCount++ ];
+    memset ( step, 0, sizeof ( *step ) );
+    step->name       = name;
+    step->run        = run;
+    step->userData   = userData;
+    step->deps       = deps;
+    step->mainThread = mainThread;
+    return index;
+}
+
+/* Lock held. A pending step whose dependencies are done; the calling
+ * thread takes its own steps first so workers never wait on it. */
+static uint32_t
+findReady ( const CringedInitGraph * graph, uint8_t onWorker )
+{
+    uint32_t ready = CRINGED_INIT_NONE;
+    for ( uint32_t i = 0; i < graph->stepCount; i++ )
+    {
+        const CringedInitStep * step = &graph->steps[ i ];
+        if ( step->state != CRINGED_INIT_PENDING ) continue;
+        if ( onWorker && step->mainThread ) continue;
+
+        uint8_t blocked = 0;
+        for ( uint32_t d = 0; d < i && ! blocked; d++ )
+            blocked = ( step->deps & CRINGED_INIT_DEP ( d ) ) &&
+                      graph->steps[ d ].state != CRINGED_INIT_DONE;
+        if ( blocked ) continue;
+
+        if ( onWorker || step->mainThread ) return i;
+        if ( ready == CRINGED_INIT_NONE ) ready = i;
+    }
+    return ready;
+}
+
+static void
+runSteps ( CringedInitGraph * graph, uint8_t onWorker )
+{
+    pthread_mutex_lock ( &graph->lock );
+    for ( ;; )
+    {
+        if ( graph->doneCount == graph->stepCount ) break;
+        if ( graph->failed != CRINGED_INIT_NONE )
+        {
+            /* NOTE: the caller cleans up, so it waits for running steps */
+            if ( onWorker || ! graph->runningCount ) break;
+            pthread_cond_wait ( &graph->changed, &graph->lock );
+            continue;
+        }
+
+        uint32_t index = findReady ( graph, onWorker );
+        if ( index == CRINGED_INIT_NONE )
+        {
+            pthread_cond_wait ( &graph->changed, &graph->lock );
+            continue;
+        }
+
+        CringedInitStep * step = &graph->steps[ index ];
+        step->state            = CRINGED_INIT_RUNNING;
+        step->onWorker         = onWorker;
+        graph->runningCount++;
+        pthread_mutex_unlock ( &graph->lock );
+
+        CRINGED_ZONE_BEGIN ( zone, step->name );
+        double start  = nowSeconds ();
+        int    result = step->run ( step->userData );
+        double end    = nowSeconds ();
+        CRINGED_ZONE_END ( zone );
+
+        pthread_mutex_lock ( &graph->lock );
+        step->start   = start - graph->begin;
+        step->seconds = end - start;
+        step->result  = result;
+        step->state   = CRINGED_INIT_DONE;
+        graph->runningCount--;
+        graph->doneCount++;
+        if ( result && graph->failed == CRINGED_INIT_NONE )
+            graph->failed = index;
+        pthread_cond_broadcast ( &graph->changed );
+    }
+    pthread_mutex_unlock ( &graph->lock );
+}
+
+static void *
+initWorker ( void * arg )
+{
+    cringedTraceThreadName ( "init worker" );
+    runSteps ( ( CringedInitGraph * ) arg, 1 );
+    return NULL;
+}
+
+uint32_t
+cringedInitRun ( CringedInitGraph * graph, uint32_t workerCount )
+{
+    pthread_t workers[ CRINGED_INIT_MAX_STEPS ];
+    uint32_t  started = 0;
+    if ( workerCount > CRINGED_INIT_MAX_STEPS )
+        workerCount = CRINGED_INIT_MAX_STEPS;
+
+    graph->doneCount    = 0;
+    graph->runningCount = 0;
+    graph->failed       = CRINGED_INIT_NONE;
+    graph->begin        = nowSeconds ();
+    for ( uint32_t i = 0; i < graph->stepCount; i++ )
+        graph->steps[ i ].state = CRINGED_INIT_PENDING;
+
+    pthread_mutex_init ( &graph->lock, NULL );
+    pthread_cond_init ( &graph->changed, NULL );
+
+    for ( uint32_t i = 0; i < workerCount; i++ )
+    {
+        if ( pthread_create ( &workers[ started ], NULL, initWorker, graph ) )
+            break; /* run with whatever workers we got */
+        started++;
+    }
+
+    /* NOTE: dependencies only point backwards, so every step becomes
+     * ready eventually and the last one to finish wakes everybody */
+    runSteps ( graph, 0 );
+    for ( uint32_t i = 0; i < started; i++ )
+        pthread_join ( workers[ i ], NULL );
+
+    pthread_cond_destroy ( &graph->changed );
+    pthread_mutex_destroy ( &graph->lock );
+    graph->seconds = nowSeconds () - graph->begin;
+    return graph->failed;
+}
+
+void
+cringedInitReport ( const CringedInitGraph * graph, FILE * out )
+{
+    /* Longest chain of dependent steps ending at each step */
+    double   chain[ CRINGED_INIT_MAX_STEPS ];
+    uint32_t via[ CRINGED_INIT_MAX_STEPS ];
+    uint32_t last   = CRINGED_INIT_NONE;
+    double   serial = 0.0;
+    for ( uint32_t i = 0; i < graph->stepCount; i++ )
+    {
+        const CringedInitStep * step = &graph->steps[ i ];
+        chain[ i ]                   = 0.0;
+        via[ i ]                     = CRINGED_INIT_NONE;
+        for ( uint32_t d = 0; d < i; d++ )
+            if ( ( step->deps & CRINGED_INIT_DEP ( d ) ) &&
+                 chain[ d ] > chain[ i ] )
+            {
+                chain[ i ] = chain[ d ];
+                via[ i ]   = d;
+            }
+        chain[ i ] += step->seconds;
+        serial += step->seconds;
+        if ( last == CRINGED_INIT_NONE || chain[ i ] > chain[ last ] )
+            last = i;
+
+        fprintf ( out,
+                  "init: %-16s start %8.3f ms  took %8.3f ms  %s%s\n",
+                  step->name,
+                  step->start * 1e3,
+                  step->seconds * 1e3,
+                  step->onWorker ? "worker" : "main",
+                  step->state != CRINGED_INIT_DONE ? " (skipped)"
+                  : step->result                    ? " (failed)"
+                                                    : "" );
+    }
+
+    fprintf ( out,
+              "init: total %.3f ms, serial %.3f ms, critical path %.3f ms:",
+              graph->seconds * 1e3,
+              serial * 1e3,
+              last == CRINGED_INIT_NONE ? 0.0 : chain[ last ] * 1e3 );
+    /* NOTE: printed from the end backwards */
+    for ( uint32_t i = last; i != CRINGED_INIT_NONE; i = via[ i ] )
+        fprintf ( out,
+                  " %s%s",
+                  graph->steps[ i ].name,
+                  via[ i ] != CRINGED_INIT_NONE ? " <-" : "" );
+    fprintf ( out, "\n" );
+}
@@ -0,0 +1,88 @@
+#pragma once
+#ifndef CRINGED_INIT_GRAPH_H
+#define CRINGED_INIT_GRAPH_H
+
+#ifndef NDEBUG
+#define _DEBUG_P( ... ) printf ( __VA_ARGS__ )
+#else
+#define _DEBUG_P( ... ) ( ( void ) 0 )
+#endif
+
+#include "trace.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CRINGED_INIT_MAX_STEPS 32
+#define CRINGED_INIT_NONE      UINT32_MAX
+#define CRINGED_INIT_DEP( step ) ( 1u << ( step ) )
+
+/* Nonzero is a failure, matching both VkResult and the GLFW stage */
+typedef int ( *CringedInitFn ) ( void * userData );
+
+typedef enum
+{
+    CRINGED_INIT_PENDING,
+    CRINGED_INIT_RUNNING,
+    CRINGED_INIT_DONE,
+} CringedInitState;
+
+typedef struct
+{
+    const char *  name;
+    CringedInitFn run;
+    void *        userData;
+    uint32_t      deps;       /* CRINGED_INIT_DEP of earlier steps */
+    uint8_t       mainThread; /* e.g. GLFW window calls */
+    /* Filled by cringedInitRun, seconds since its start */
+    CringedInitState state;
+    int              result;
+    uint8_t          onWorker;
+    double           start;
+    double           seconds;
+} CringedInitStep;
+
+/* Startup as a dependency graph: a step runs as soon as every step it
+ * depends on is done, on the calling thread or on one of the workers.
+ * Steps running at the same time must touch disjoint state. */
+typedef struct
+{
+    uint32_t        stepCount;
+    CringedInitStep steps[ CRINGED_INIT_MAX_STEPS ];
+    /* Scheduling, valid during cringedInitRun */
+    pthread_mutex_t lock;
+    pthread_cond_t  changed;
+    uint32_t        doneCount;
+    uint32_t        runningCount;
+    uint32_t        failed; /* first failed step or NONE */
+    double          begin;
+    double          seconds; /* wall time of the whole run */
+} CringedInitGraph;
+
+void
+cringedInitReset ( CringedInitGraph * graph );
+
+/* Returns the step index, or NONE when full or `deps` names a later step
+ * (which also rules out cycles) */
+uint32_t
+cringedInitAdd ( CringedInitGraph * graph,
+                 const char *       name,
+                 CringedInitFn      run,
+                 void *             userData,
+                 uint32_t           deps,
+                 uint8_t            mainThread );
+
+/* Runs every step with `workerCount` extra threads. Stops scheduling at
+ * the first failure and returns once nothing runs any more: the failed
+ * step index, or CRINGED_INIT_NONE on success. */
+uint32_t
+cringedInitRun ( CringedInitGraph * graph, uint32_t workerCount );
+
+/* Per-step start and duration, the serial sum and the critical path */
+void
+cringedInitReport ( const CringedInitGraph * graph, FILE * out );
+
+#endif /* CRINGED_INIT_GRAPH_H */
@@ -0,0 +1,62 @@
+#include "inputQueue.h"
+
+CringedInputQueue *
+cringedCreateInputQueue ( uint32_t capacity )
+{
+    uint32_t size = 2;
+    while ( size < capacity ) size <<= 1;
+
+    CringedInputQueue * queue =
+        ( CringedInputQueue * ) malloc ( sizeof ( CringedInputQueue ) );
+    if ( queue == NULL ) return NULL;
+
+    queue->events =
+        ( CringedInputEvent * ) malloc ( size * sizeof ( CringedInputEvent ) );
+    if ( queue->events == NULL )
+    {
+        free ( queue );
+        return NULL;
+    }
+    queue->mask = size - 1;
+    atomic_init ( &queue->head, 0 );
+    atomic_init ( &queue->tail, 0 );
+    atomic_init ( &queue->dropped, 0 );
+    return queue;
+}
+
+void
+cringedDestroyInputQueue ( CringedInputQueue * queue )
+{
+    if ( queue == NULL ) return;
+    uint32_t dropped = atomic_load ( &queue->dropped );
+    if ( dropped ) _DEBUG_P ( "input: %u events dropped\n", dropped );
+    free ( queue->events );
+    free ( queue );
+}
+
+uint8_t
+cringedInputPush ( CringedInputQueue * queue, const CringedInputEvent * event )
+{
+    /* Own index relaxed, the other side's acquire: frees the slot read */
+    uint32_t tail = atomic_load_explicit ( &queue->tail, memory_order_relaxed );
+    uint32_t head = atomic_load_explicit ( &queue->head, memory_order_acquire );
+    if ( tail - head > queue->mask )
+    {
+        atomic_fetch_add_explicit ( &queue->dropped, 1, memory_order_relaxed );
+        return 0;
+    }
+    queue->events[ tail & queue->mask ] = *event;
+    atomic_store_explicit ( &queue->tail, tail + 1, memory_order_release );
+    return 1;
+}
+
+uint8_t
+cringedInputPop ( CringedInputQueue * queue, CringedInputEvent * event )
+{
+    uint32_t head = atomic_load_explicit ( &queue->head, memory_order_relaxed );
+    uint32_t tail = atomic_load_explicit ( &queue->tail, memory_order_acquire );
+    if ( head == tail ) return 0;
+    *event = queue->events[ head & queue->mask ];
+    atomic_store_explicit ( &queue->head, head + 1, memory_order_release );
+    return 1;
+}
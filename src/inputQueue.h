@@ -0,0 +1,74 @@
+#pragma once
+#ifndef CRINGED_INPUT_QUEUE_H
+#define CRINGED_INPUT_QUEUE_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef NDEBUG
+#define _DEBUG_P( ... ) printf ( __VA_ARGS__ )
+#else
+#define _DEBUG_P( ... ) ( ( void ) 0 )
+#endif
+
+typedef enum
+{
+    CRINGED_INPUT_KEY,
+    CRINGED_INPUT_MOUSE_BUTTON,
+    CRINGED_INPUT_CURSOR,
+    CRINGED_INPUT_SCROLL,
+} CringedInputType;
+
+/* One window event as GLFW reported it, codes are GLFW's */
+typedef struct
+{
+    CringedInputType type;
+    double           time; /* glfwGetTime () when received */
+    union
+    {
+        struct
+        {
+            int key, scancode, action, mods;
+        } key;
+        struct
+        {
+            int button, action, mods;
+        } button;
+        struct
+        {
+            double x, y;
+        } cursor, scroll;
+    };
+} CringedInputEvent;
+
+/* Single producer (event thread), single consumer (render thread) ring.
+ * Each index is written by one side only; the release store publishes the
+ * slot, the other side's acquire load sees it. Full: the event drops. */
+typedef struct
+{
+    uint32_t mask; /* capacity - 1, power of two */
+    _Alignas ( 64 ) atomic_uint head; /* next to pop, consumer */
+    _Alignas ( 64 ) atomic_uint tail; /* next to push, producer */
+    atomic_uint         dropped;
+    CringedInputEvent * events;
+} CringedInputQueue;
+
+/* Capacity rounds up to a power of two */
+CringedInputQueue *
+cringedCreateInputQueue ( uint32_t capacity );
+
+void
+cringedDestroyInputQueue ( CringedInputQueue * queue );
+
+/* Producer side, 0 when full */
+uint8_t
+cringedInputPush ( CringedInputQueue * queue, const CringedInputEvent * event );
+
+/* Consumer side, 0 when empty */
+uint8_t
+cringedInputPop ( CringedInputQueue * queue, CringedInputEvent * event );
+
+#endif /* CRINGED_INPUT_QUEUE_H */
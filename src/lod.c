@@ -0,0 +1,86 @@
+#include "lod.h"
+
+/* The disc is a fan of 48, 24, 12 then 6 segments, three vertices each,
+ * laid out one level after the other behind the triangle */
+const CringedMeshLods cringedBuiltinMeshes[ CRINGED_MESH_COUNT ] = {
+    /* CRINGED_MESH_TRIANGLE */
+    { 1, { 0 }, { 3 }, { 0.0f } },
+    /* CRINGED_MESH_DISC */
+    { 4,
+      { 3, 147, 219, 255 },
+      { 144, 72, 36, 18 },
+      { 192.0f, 64.0f, 16.0f, 0.0f } },
+};
+
+CringedLodSelector *
+cringedCreateLodSelector ( uint32_t capacity, float hysteresis )
+{
+    CringedLodSelector * selector =
+        ( CringedLodSelector * ) calloc ( 1, sizeof ( CringedLodSelector ) );
+    if ( ! selector ) return NULL;
+
+    /* Every instance starts at full detail, the first frame settles it */
+    selector->current = ( uint8_t * ) calloc ( capacity, sizeof ( uint8_t ) );
+    if ( ! selector->current )
+    {
+        free ( selector );
+        return NULL;
+    }
+    selector->capacity   = capacity;
+    selector->hysteresis = hysteresis;
+    return selector;
+}
+
+void
+cringedDestroyLodSelector ( CringedLodSelector * selector )
+{
+    if ( ! selector ) return;
+    free ( selector->current );
+    free ( selector );
+}
+
+void
+cringedLodSelect ( CringedLodSelector *    selector,
+                   const CringedMeshLods * mesh,
+                   const CringedSpheres *  spheres,
+                   const uint32_t *        visible,
+                   uint32_t                visibleCount,
+                   mat4                    viewProj,
+                   float                   pixelScale )
+{
+    uint32_t last      = mesh->count - 1;
+    float    finer     = 1.0f + selector->hysteresis;
+    float    coarser   = 1.0f - selector->hysteresis;
+    uint64_t triangles = 0;
+
+    for ( uint32_t v = 0; v < visibleCount; v++ )
+    {
+        uint32_t i = visible[ v ];
+        if ( i >= selector->capacity ) continue;
+
+        /* Clip w of the center: view depth for any perspective matrix */
+        float w = viewProj[ 0 ][ 3 ] * spheres->x[ i ] +
+                  viewProj[ 1 ][ 3 ] * spheres->y[ i ] +
+                  viewProj[ 2 ][ 3 ] * spheres->z[ i ] + viewProj[ 3 ][ 3 ];
+        uint32_t level = selector->current[ i ];
+        if ( level > last ) level = last;
+        if ( w <= 1e-4f )
+            level = 0; /* around the camera: as large as it gets */
+        else
+        {
+            float pixels = spheres->r[ i ] * pixelScale / w;
+            while ( level > 0 &&
+                    pixels >= mesh->minPixels[ level - 1 ] * finer )
+                level--;
+            while ( level < last &&
+                    pixels < mesh->minPixels[ level ] * coarser )
+                level++;
+        }
+        selector->current[ i ] = ( uint8_t ) level;
+        triangles += mesh->vertexCount[ level ] / 3;
+    }
+
+    selector->triangles     = triangles;
+    selector->fullTriangles =
+        ( uint64_t ) visibleCount * ( mesh->vertexCount[ 0 ] / 3 );
+}
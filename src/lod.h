@@ -0,0 +1,67 @@
+#pragma once
+#ifndef CRINGED_LOD_H
+#define CRINGED_LOD_H
+
+#include "cull.h"
+#include "renderQueue.h"
+
+#include <cglm/cglm.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef NDEBUG
+#define _DEBUG_P( ... ) printf ( __VA_ARGS__ )
+#else
+#define _DEBUG_P( ... ) ( ( void ) 0 )
+#endif
+
+#define CRINGED_LOD_MAX 4 /* Occlusion_comp.glsl LOD_MAX matches */
+
+/* Levels of one built-in mesh, finest first: each a vertex range the
+ * shader generates. Level l is the coarsest whose `minPixels` the
+ * projected diameter reaches; the last level's is 0. */
+typedef struct
+{
+    uint32_t count;
+    uint32_t firstVertex[ CRINGED_LOD_MAX ];
+    uint32_t vertexCount[ CRINGED_LOD_MAX ];
+    float    minPixels[ CRINGED_LOD_MAX ];
+} CringedMeshLods;
+
+/* Indexed by CRINGED_MESH_*, ranges match Triangle_vert.glsl */
+extern const CringedMeshLods cringedBuiltinMeshes[ CRINGED_MESH_COUNT ];
+
+/* Per-instance level, kept across frames: a level only changes once the
+ * size is `hysteresis` past the threshold, so instances hovering around
+ * one do not flicker between levels every frame. */
+typedef struct
+{
+    uint32_t  capacity;
+    float     hysteresis; /* fraction of the threshold, both directions */
+    uint8_t * current;    /* [instance] */
+    /* Last selection, triangles of the visible instances */
+    uint64_t triangles;
+    uint64_t fullTriangles; /* had they all been drawn at level 0 */
+} CringedLodSelector;
+
+CringedLodSelector *
+cringedCreateLodSelector ( uint32_t capacity, float hysteresis );
+
+void
+cringedDestroyLodSelector ( CringedLodSelector * selector );
+
+/* Updates `current` of the `visibleCount` instances in `visible` from
+ * their bounding spheres; `pixelScale` is proj[1][1] * viewport height,
+ * so that diameter in pixels = r * pixelScale / w */
+void
+cringedLodSelect ( CringedLodSelector *    selector,
+                   const CringedMeshLods * mesh,
+                   const CringedSpheres *  spheres,
+                   const uint32_t *        visible,
+                   uint32_t                visibleCount,
+                   mat4                    viewProj,
+                   float                   pixelScale );
+
+#endif /* CRINGED_LOD_H */
@@ -1,5 +1,9 @@
+#define _POSIX_C_SOURCE 199309L
+
 #include "main.h"
 
+#include <time.h>
+
 void
 glfwErrorCallback ( int error, const char * description )
 {
@@ -7,10 +11,76 @@ glfwErrorCallback ( int error, const char * description )
 }
 
 static void
-windowResizeCallback ( GLFWwindow * window, int width, int height )
+storeWindowExtent ( CringedWindow * window, int width, int height )
+{
+    uint64_t extent = ( ( uint64_t ) ( uint32_t ) width << 32 ) |
+                      ( uint32_t ) height;
+    atomic_store_explicit ( &window->extent, extent, memory_order_release );
+}
+
+/* GLFW callbacks run on the event (main) thread, inside glfwWaitEvents */
+static void
+windowResizeCallback ( GLFWwindow * glfwWindow, int width, int height )
+{
+    Engine * engine = ( Engine * ) glfwGetWindowUserPointer ( glfwWindow );
+    for ( uint32_t w = 0; w < engine->windowCount; w++ )
+    {
+        CringedWindow * window = &engine->windows[ w ];
+        if ( window->window != glfwWindow ) continue;
+        storeWindowExtent ( window, width, height );
+        atomic_store_explicit ( &window->resized, 1, memory_order_release );
+    }
+}
+
+static void
+forwardInput ( GLFWwindow * window, CringedInputEvent * event )
 {
-    Engine * engine    = ( Engine * ) glfwGetWindowUserPointer ( window );
-    engine->winResized = true;
+    Engine * engine = ( Engine * ) glfwGetWindowUserPointer ( window );
+    event->time     = glfwGetTime ();
+    cringedInputPush ( engine->input, event );
+}
+
+static void
+keyCallback ( GLFWwindow * window,
+              int          key,
+              int          scancode,
+              int          action,
+              int          mods )
+{
+    CringedInputEvent event = { .type = CRINGED_INPUT_KEY };
+    event.key.key           = key;
+    event.key.scancode      = scancode;
+    event.key.action        = action;
+    event.key.mods          = mods;
+    forwardInput ( window, &event );
+}
+
+static void
+mouseButtonCallback ( GLFWwindow * window, int button, int action, int mods )
+{
+    CringedInputEvent event = { .type = CRINGED_INPUT_MOUSE_BUTTON };
+    event.button.button     = button;
+    event.button.action     = action;
+    event.button.mods       = mods;
+    forwardInput ( window, &event );
+}
+
+static void
+cursorCallback ( GLFWwindow * window, double x, double y )
+{
+    CringedInputEvent event = { .type = CRINGED_INPUT_CURSOR };
+    event.cursor.x          = x;
+    event.cursor.y          = y;
+    forwardInput ( window, &event );
+}
+
+static void
+scrollCallback ( GLFWwindow * window, double x, double y )
+{
+    CringedInputEvent event = { .type = CRINGED_INPUT_SCROLL };
+    event.scroll.x          = x;
+    event.scroll.y          = y;
+    forwardInput ( window, &event );
 }
 
 uint8_t
@@ -26,128 +96,491 @@ BasedGLFWInit ( Engine * engine )
 
     glfwWindowHint ( GLFW_CLIENT_API, GLFW_NO_API );
 
-    engine->window =
-        glfwCreateWindow ( 800, 600, "Sample VK window", NULL, NULL );
-
-    if ( ! engine->window )
+    for ( uint32_t w = 0; w < engine->windowCount; w++ )
     {
-        printf ( "GLFW Create Window Error\n" );
-        glfwTerminate ();
-        return 1;
+        CringedWindow * window = &engine->windows[ w ];
+        char            title[ 64 ];
+        if ( w == 0 )
+            snprintf ( title, sizeof ( title ), "Sample VK window" );
+        else
+            snprintf ( title, sizeof ( title ), "Sample VK window %u", w + 1 );
+
+        window->window = glfwCreateWindow ( 800, 600, title, NULL, NULL );
+        if ( ! window->window )
+        {
+            printf ( "GLFW Create Window Error\n" );
+            while ( w-- )
+            {
+                glfwDestroyWindow ( engine->windows[ w ].window );
+                engine->windows[ w ].window = NULL;
+            }
+            glfwTerminate ();
+            return 1;
+        }
+
+        int width, height;
+        glfwGetFramebufferSize ( window->window, &width, &height );
+        storeWindowExtent ( window, width, height );
+
+        /* Input of every window lands in the one queue */
+        glfwSetWindowUserPointer ( window->window, engine );
+        glfwSetFramebufferSizeCallback ( window->window,
+                                         windowResizeCallback );
+        glfwSetKeyCallback ( window->window, keyCallback );
+        glfwSetMouseButtonCallback ( window->window, mouseButtonCallback );
+        glfwSetCursorPosCallback ( window->window, cursorCallback );
+        glfwSetScrollCallback ( window->window, scrollCallback );
     }
 
-    glfwSetWindowUserPointer ( engine->window, engine );
-    glfwSetFramebufferSizeCallback ( engine->window, windowResizeCallback );
-
     return 0;
 }
 
+/* Init graph adapters: every stage takes the engine */
+#define INIT_STEP( stage )                            \
+    static int stage##Step ( void * engine )          \
+    {                                                 \
+        return ( int ) stage ( ( Engine * ) engine ); \
+    }
+
+INIT_STEP ( BasedGLFWInit )
+INIT_STEP ( BasedVKInit )
+INIT_STEP ( BasedSurfaceFormat )
+INIT_STEP ( CringedSceneSetup )
+INIT_STEP ( CringedFrameRing )
+INIT_STEP ( CringedSwapChain )
+INIT_STEP ( BasedGraphicsPipeline )
+INIT_STEP ( CringedSprites )
+INIT_STEP ( CringedParticlesSetup )
+INIT_STEP ( CringedOcclusionSetup )
+INIT_STEP ( CringedStreamSetup )
+INIT_STEP ( CringedFrameBuffers )
+INIT_STEP ( CringedCommandBuffer )
+INIT_STEP ( BasedSyncSetup )
+
 uint8_t
 init ()
 {
-    if ( BasedGLFWInit ( CRINGE_ENGINE ) ) return 1;
-    if ( BasedVKInit ( CRINGE_ENGINE ) ) return 1;
-    if ( CringedSwapChain ( CRINGE_ENGINE ) ) return 1;
-    if ( BasedGraphicsPipeline ( CRINGE_ENGINE ) ) return 1;
-    if ( CringedFrameBuffers ( CRINGE_ENGINE ) ) return 1;
-    if ( CringedCommandBuffer ( CRINGE_ENGINE ) ) return 1;
-    if ( BasedSyncSetup ( CRINGE_ENGINE ) ) return 1;
-
+    /* Pipelines only need the color format and the descriptor layout, not
+     * the swapchain: shader modules and pipeline compilation (the bulk of
+     * startup on lavapipe) overlap with swapchain, scene and sync setup.
+     * GLFW window calls stay on the main thread; the swapchain reads the
+     * framebuffer size stored by the glfw step. */
+    CringedInitGraph graph;
+    Engine *         e = CRINGE_ENGINE;
+    cringedInitReset ( &graph );
+
+#define AFTER( step ) CRINGED_INIT_DEP ( step )
+    uint32_t glfw = //
+        cringedInitAdd ( &graph, "glfw", BasedGLFWInitStep, e, 0, 1 );
+    uint32_t vulkan = cringedInitAdd ( //
+        &graph, "vulkan", BasedVKInitStep, e, AFTER ( glfw ), 0 );
+    uint32_t format = cringedInitAdd ( //
+        &graph, "format", BasedSurfaceFormatStep, e, AFTER ( vulkan ), 0 );
+    uint32_t scene = cringedInitAdd ( //
+        &graph, "scene", CringedSceneSetupStep, e, AFTER ( vulkan ), 0 );
+    uint32_t ring = cringedInitAdd ( //
+        &graph, "frame-ring", CringedFrameRingStep, e, AFTER ( scene ), 0 );
+    uint32_t swapChain = cringedInitAdd ( //
+        &graph, "swapchain", CringedSwapChainStep, e, AFTER ( format ), 0 );
+    uint32_t pipeline = cringedInitAdd ( //
+        &graph,
+        "pipeline",
+        BasedGraphicsPipelineStep,
+        e,
+        AFTER ( format ) | AFTER ( ring ),
+        0 );
+    cringedInitAdd ( //
+        &graph, "sprites", CringedSpritesStep, e, AFTER ( pipeline ), 0 );
+    cringedInitAdd ( //
+        &graph,
+        "particles",
+        CringedParticlesSetupStep,
+        e,
+        AFTER ( pipeline ),
+        0 );
+    uint32_t occlusion = cringedInitAdd ( //
+        &graph,
+        "occlusion",
+        CringedOcclusionSetupStep,
+        e,
+        AFTER ( ring ) | AFTER ( pipeline ),
+        0 );
+    cringedInitAdd ( //
+        &graph,
+        "frame-graph",
+        CringedFrameBuffersStep,
+        e,
+        AFTER ( swapChain ) | AFTER ( pipeline ) | AFTER ( occlusion ),
+        0 );
+    cringedInitAdd ( //
+        &graph, "commands", CringedCommandBufferStep, e, AFTER ( vulkan ), 0 );
+    cringedInitAdd ( //
+        &graph, "sync", BasedSyncSetupStep, e, AFTER ( vulkan ), 0 );
+    cringedInitAdd ( //
+        &graph, "stream", CringedStreamSetupStep, e, AFTER ( vulkan ), 0 );
+#undef AFTER
+
+    uint32_t failed = cringedInitRun ( &graph, INIT_WORKER_THREADS );
+    cringedInitReport ( &graph, stdout );
+    if ( failed != CRINGED_INIT_NONE )
+    {
+        printf ( "init step %s failed\n",
+                 failed < graph.stepCount ? graph.steps[ failed ].name : "?" );
+        return 1;
+    }
     return 0;
 }
 
-void
+/* Anything but VK_SUCCESS: the frame was not submitted, stop drawing */
+VkResult
 basedDrawFrame ( Engine * engine )
 {
     /* VK Frame Rendering:
         - Wait for the previous frame to finish
-        - Acquire an image from the swap chain
-        - Record a command buffer which draws the scene onto that image
+        - Acquire an image from every window's swap chain
+        - Record a command buffer which draws the scene onto those images
         - Submit the recorded command buffer
-        - Present the swap chain image
+        - Present all the swap chain images in one call
     */
     // TODO: handle all error
 
-    if ( engine->winResized )
-    {
-        engine->winResized = 0;
-        CringedSwapChainRecreate ( engine );
-        return;
-    }
-
+    CRINGED_ZONE ( "frame" );
     VkResult opResult;
+    cringedHudBeginFrame ( engine->hud );
+
+    CRINGED_ZONE_BEGIN ( waitZone, "wait-fence" );
     vkWaitForFences ( *engine->device,
                       1,
                       engine->sync[ engine->cFrame ].inFlight,
                       VK_TRUE,
                       UINT64_MAX );
+    CRINGED_ZONE_END ( waitZone );
+    cringedHudStage ( engine->hud, CRINGED_HUD_WAIT );
+    /* GPU zones of this slot's previous frame, bounded by the wait */
+    if ( engine->gpuTrace )
+    {
+        cringedGpuTraceCollect (
+            engine->gpuTrace, engine->cFrame, cringedTraceNow () );
+        cringedHudGpuTime ( engine->hud, engine->gpuTrace->frameNs );
+    }
+
+    /* This slot's previous frame is done, so is everything before it:
+     * objects deferred while recording those can go, in one sweep */
+    uint64_t safeFrame =
+        engine->frameNumber + 1 >= engine->MaxFramesInFlight
+            ? engine->frameNumber + 1 - engine->MaxFramesInFlight
+            : 0;
+    CRINGED_ZONE_BEGIN ( deletionZone, "deletions" );
+    cringedDeletionBeginFrame (
+        engine->deletions, engine->frameNumber, safeFrame );
+    CRINGED_ZONE_END ( deletionZone );
+    /* Budget queried once per frame, streamed resources past it evicted */
+    CRINGED_ZONE_BEGIN ( residencyZone, "residency" );
+    cringedResidencyBeginFrame (
+        engine->residency, engine->frameNumber, safeFrame );
+    CRINGED_ZONE_END ( residencyZone );
+    /* Finished reads reaped, the most urgent queued ones issued; never
+     * waits on the disk */
+    CRINGED_ZONE_BEGIN ( streamZone, "stream" );
+    cringedStreamBeginFrame ( engine->stream, engine->frameNumber, safeFrame );
+    CRINGED_ZONE_END ( streamZone );
+
+    /* Every window acquires on its own: one being resized or minimized
+     * only drops out of this frame */
+    uint32_t acquiredCount = 0;
+    uint8_t  minimized     = 0;
+    CRINGED_ZONE_BEGIN ( acquireZone, "acquire" );
+    for ( uint32_t w = 0; w < engine->windowCount; w++ )
+    {
+        CringedWindow * window = &engine->windows[ w ];
+        window->acquired       = 0;
+
+        /* Taken before recreating: a resize landing meanwhile raises it
+         * again and is picked up next frame */
+        if ( atomic_exchange ( &window->resized, 0 ) )
+        {
+            CRINGED_ZONE ( "recreate" );
+            /* NOTE: no device idle, frames in flight keep the old
+             * swapchain */
+            if ( ( opResult = CringedSwapChainRecreate ( engine, window ) ) !=
+                 VK_SUCCESS )
+            {
+                atomic_store ( &window->resized, 1 );
+                /* Minimized: nothing to draw until the event thread sees
+                 * a new size */
+                minimized |= opResult == VK_NOT_READY;
+                continue;
+            }
+        }
+        if ( window->swapChain == VK_NULL_HANDLE ) continue;
+
+        opResult = vkAcquireNextImageKHR ( //
+            *engine->device,
+            window->swapChain,
+            UINT64_MAX,
+            window->imageAvailable[ engine->cFrame ],
+            VK_NULL_HANDLE,
+            &window->imageIndex );
+        /* Out of date: nothing was acquired, its semaphore stays unsignaled */
+        if ( opResult == VK_ERROR_OUT_OF_DATE_KHR ||
+             opResult == VK_SUBOPTIMAL_KHR )
+            atomic_store ( &window->resized, 1 );
+        if ( opResult != VK_SUCCESS && opResult != VK_SUBOPTIMAL_KHR )
+            continue;
+        window->acquired = 1;
+        acquiredCount++;
+    }
+    CRINGED_ZONE_END ( acquireZone );
+    cringedHudStage ( engine->hud, CRINGED_HUD_ACQUIRE );
+
+    /* Nothing acquired: nothing submitted, the fence stays signaled */
+    if ( acquiredCount == 0 )
+    {
+        if ( minimized )
+            nanosleep ( &( struct timespec ) { 0, MINIMIZED_POLL_NS }, NULL );
+        return VK_SUCCESS;
+    }
+
+    /* GPU is done with this frame's ring partition */
+    cringedRingBegin ( engine->frameRing, engine->cFrame );
 
-    uint32_t imageIndex;
-    opResult = vkAcquireNextImageKHR ( //
-        *engine->device,
-        *engine->swapChain,
-        UINT64_MAX,
-        *engine->sync[ engine->cFrame ].imageAvailable,
-        VK_NULL_HANDLE,
-        &imageIndex );
+    CRINGED_ZONE_BEGIN ( recordZone, "record" );
+    vkResetCommandBuffer ( engine->commandBuffer[ engine->cFrame ], 0 );
 
-    if ( opResult == VK_ERROR_OUT_OF_DATE_KHR ||
-         opResult == VK_SUBOPTIMAL_KHR )
-        engine->winResized = 1;
+    opResult = CringedRecordCommandBuffer (
+        engine, &engine->commandBuffer[ engine->cFrame ] );
+    CRINGED_ZONE_END ( recordZone );
+    cringedHudStage ( engine->hud, CRINGED_HUD_RECORD );
+    /* NOTE: left recording, never submitted; the fence is only reset
+     * below, so waiting on this slot cannot hang */
+    if ( opResult != VK_SUCCESS )
+    {
+        printf ( "error: recording frame %llu: %d\n",
+                 ( unsigned long long ) engine->frameNumber,
+                 opResult );
+        return opResult;
+    }
 
     vkResetFences (
         *engine->device, 1, engine->sync[ engine->cFrame ].inFlight );
 
-    vkResetCommandBuffer ( engine->commandBuffer[ engine->cFrame ], 0 );
+    /* Submissions and presents are collected, then issued in one flush:
+     * the frame waits for every acquire, and all of its swapchains are
+     * presented by a single vkQueuePresentKHR waiting on `rendered` */
+    VkSemaphoreSubmitInfo acquired[ CRINGED_MAX_WINDOWS ] = {};
+    uint32_t              waitCount = 0;
+    for ( uint32_t w = 0; w < engine->windowCount; w++ )
+    {
+        if ( ! engine->windows[ w ].acquired ) continue;
+        VkSemaphoreSubmitInfo * wait = &acquired[ waitCount++ ];
+        wait->sType                  = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+        wait->semaphore = engine->windows[ w ].imageAvailable[ engine->cFrame ];
+        wait->stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+    }
+    VkSemaphoreSubmitInfo rendered = {};
+    rendered.sType     = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    rendered.semaphore = *engine->sync[ engine->cFrame ].renderFinished;
+    rendered.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+    CringedSubmission frame  = {};
+    frame.waits              = acquired;
+    frame.waitCount          = waitCount;
+    frame.commandBuffers     = &engine->commandBuffer[ engine->cFrame ];
+    frame.commandBufferCount = 1;
+    frame.signals            = &rendered;
+    frame.signalCount        = 1;
+    frame.fence              = *engine->sync[ engine->cFrame ].inFlight;
+    if ( ( opResult = cringedSubmit (
+               engine->submitter, engine->graphicsQueue, &frame ) ) !=
+         VK_SUCCESS )
+    {
+        printf ( "error: queueing frame %llu: %d\n",
+                 ( unsigned long long ) engine->frameNumber,
+                 opResult );
+        return opResult;
+    }
 
-    CringedRecordCommandBuffer (
-        engine, &engine->commandBuffer[ engine->cFrame ], imageIndex );
-
-    VkSubmitInfo submitInfo      = {};
-    submitInfo.sType             = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    VkSemaphore waitSemaphores[] = {
-        *engine->sync[ engine->cFrame ].imageAvailable };
-    VkPipelineStageFlags waitStages[] = {
-        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    submitInfo.waitSemaphoreCount  = 1;
-    submitInfo.pWaitSemaphores     = waitSemaphores;
-    submitInfo.pWaitDstStageMask   = waitStages;
-    submitInfo.commandBufferCount  = 1;
-    submitInfo.pCommandBuffers     = &engine->commandBuffer[ engine->cFrame ];
-    VkSemaphore signalSemaphores[] = {
-        *engine->sync[ engine->cFrame ].renderFinished };
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores    = signalSemaphores;
-
-    vkQueueSubmit ( engine->graphicsQueue,
-                    1,
-                    &submitInfo,
-                    *engine->sync[ engine->cFrame ].inFlight );
-
-    VkPresentInfoKHR presentInfo   = {};
-    presentInfo.sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-    presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores    = signalSemaphores;
-    VkSwapchainKHR swapChains[]    = { *engine->swapChain };
-    presentInfo.swapchainCount     = 1;
-    presentInfo.pSwapchains        = swapChains;
-    presentInfo.pImageIndices      = &imageIndex;
-    presentInfo.pResults           = NULL;
-    vkQueuePresentKHR ( engine->presentQueue, &presentInfo );
+    uint32_t presents[ CRINGED_MAX_WINDOWS ];
+    for ( uint32_t w = 0; w < engine->windowCount; w++ )
+        presents[ w ] =
+            engine->windows[ w ].acquired
+                ? cringedSubmitPresent ( engine->submitter,
+                                         engine->presentQueue,
+                                         engine->windows[ w ].swapChain,
+                                         engine->windows[ w ].imageIndex,
+                                         rendered.semaphore )
+                : CRINGED_SUBMIT_NO_PRESENT;
+
+    CRINGED_ZONE_BEGIN ( submitZone, "submit-present" );
+    VkResult flushResult = cringedSubmitFlush ( engine->submitter );
+    CRINGED_ZONE_END ( submitZone );
+    cringedHudStage ( engine->hud, CRINGED_HUD_SUBMIT );
+    for ( uint32_t w = 0; w < engine->windowCount; w++ )
+    {
+        if ( presents[ w ] == CRINGED_SUBMIT_NO_PRESENT ) continue;
+        opResult = flushResult == VK_SUCCESS
+                       ? engine->submitter->presentResults[ presents[ w ] ]
+                       : flushResult;
+        if ( opResult == VK_ERROR_OUT_OF_DATE_KHR ||
+             opResult == VK_SUBOPTIMAL_KHR )
+            atomic_store ( &engine->windows[ w ].resized, 1 );
+    }
+    /* NOTE: not submitted, the fence of this slot would never signal */
+    if ( flushResult != VK_SUCCESS && flushResult != VK_ERROR_OUT_OF_DATE_KHR &&
+         flushResult != VK_SUBOPTIMAL_KHR )
+    {
+        printf ( "error: submitting frame %llu: %d\n",
+                 ( unsigned long long ) engine->frameNumber,
+                 flushResult );
+        return flushResult;
+    }
 
     engine->cFrame = ( engine->cFrame + 1 ) % engine->MaxFramesInFlight;
+    engine->frameNumber++;
+    return VK_SUCCESS;
+}
+
+/* Render thread: drains the input forwarded by the event thread */
+static void
+handleInput ( Engine * engine )
+{
+    CringedInputEvent event;
+    while ( cringedInputPop ( engine->input, &event ) )
+    {
+        if ( event.type == CRINGED_INPUT_KEY &&
+             event.key.key == GLFW_KEY_ESCAPE &&
+             event.key.action == GLFW_PRESS )
+        {
+            atomic_store ( &engine->running, 0 );
+            glfwPostEmptyEvent (); /* wake the event thread */
+        }
+        if ( event.type == CRINGED_INPUT_KEY &&
+             event.key.key == GLFW_KEY_F1 && event.key.action == GLFW_PRESS )
+            engine->hud->visible = ! engine->hud->visible;
+    }
+}
+
+/* PARTICLE_BENCH, render thread only: device times of the collected
+ * frames, averaged per step; returns 0 once every step was reported */
+static uint8_t
+particleBench ( Engine * engine )
+{
+    static uint32_t step = 0, frames = 0, samples = 0;
+    static uint64_t simNs = 0, drawNs = 0;
+    static double   start = 0.0;
+
+    if ( ++frames == PARTICLE_WARMUP ) start = glfwGetTime ();
+    if ( frames <= PARTICLE_WARMUP ) return 1;
+
+    CringedGpuTrace * trace = engine->gpuTrace;
+    uint64_t          sim   = cringedGpuTraceZoneNs ( trace, "particles-sim" );
+    uint64_t          draw  = cringedGpuTraceZoneNs ( trace, "particles-draw" );
+    if ( sim || draw )
+    {
+        simNs += sim;
+        drawNs += draw;
+        samples++;
+    }
+    if ( frames < PARTICLE_WARMUP + PARTICLE_FRAMES ) return 1;
+
+    double frameMs = ( glfwGetTime () - start ) * 1e3 / PARTICLE_FRAMES;
+    if ( samples )
+        printf ( "particles %7u: simulate %8.3f ms, render %8.3f ms, "
+                 "frame %8.3f ms\n",
+                 engine->particles->limit,
+                 simNs * 1e-6 / samples,
+                 drawNs * 1e-6 / samples,
+                 frameMs );
+    else
+        printf ( "particles %7u: no GPU timestamps, frame %8.3f ms\n",
+                 engine->particles->limit,
+                 frameMs );
+
+    frames = samples = 0;
+    simNs = drawNs = 0;
+    if ( ++step == sizeof ( PARTICLE_STEPS ) / sizeof ( PARTICLE_STEPS[ 0 ] ) )
+        return 0;
+    engine->particles->limit = PARTICLE_STEPS[ step ];
+    return 1;
+}
+
+static void *
+renderLoop ( void * data )
+{
+    Engine * engine = ( Engine * ) data;
+    void *   failed = NULL;
+    cringedTraceThreadName ( "render" );
+
+#ifndef NDEBUG
+    /* Frame stats: average wall time over FRAME_STATS_INTERVAL frames */
+    uint32_t statsFrames = 0;
+    double   statsStart  = glfwGetTime ();
+#endif
+    while ( atomic_load ( &engine->running ) )
+    {
+        handleInput ( engine );
+        if ( basedDrawFrame ( engine ) != VK_SUCCESS )
+        {
+            atomic_store ( &engine->running, 0 );
+            glfwPostEmptyEvent (); /* wake the event thread */
+            failed = engine;
+            break;
+        }
+        /* NOTE: the GLFW timer starts with the first init step */
+        if ( engine->frameNumber == 1 )
+            printf ( "first frame: %.3f ms after glfwInit\n",
+                     glfwGetTime () * 1e3 );
+        if ( engine->particleBench && ! particleBench ( engine ) )
+        {
+            atomic_store ( &engine->running, 0 );
+            glfwPostEmptyEvent ();
+        }
+
+#ifndef NDEBUG
+        if ( ++statsFrames == FRAME_STATS_INTERVAL )
+        {
+            double now = glfwGetTime ();
+            _DEBUG_P ( "frame: %8.3f ms avg over %u frames, depth pre-pass "
+                       "%s\n",
+                       ( now - statsStart ) * 1e3 / statsFrames,
+                       statsFrames,
+                       engine->scene->depthPrePass ? "on" : "off" );
+            statsFrames = 0;
+            statsStart  = now;
+        }
+#endif
+    }
+    vkDeviceWaitIdle ( *engine->device );
+    return failed;
 }
 
 uint8_t
 mainLoop ()
 {
-    while ( ! glfwWindowShouldClose ( CRINGE_ENGINE->window ) )
+    /* Frames go on their own thread: a fence wait or a blocking present
+     * no longer holds up the event pump, nor an event burst the submit */
+    Engine * engine = CRINGE_ENGINE;
+    atomic_store ( &engine->running, 1 );
+    if ( pthread_create ( &engine->renderThread, NULL, renderLoop, engine ) )
     {
-        glfwPollEvents ();
-        basedDrawFrame ( CRINGE_ENGINE );
+        printf ( "error: render thread\n" );
+        return 1;
     }
-    vkDeviceWaitIdle ( *CRINGE_ENGINE->device );
-    return 0;
+
+    /* Sleeps until there are events, or the render thread asks to stop;
+     * closing any window ends the run */
+    while ( atomic_load ( &engine->running ) )
+    {
+        glfwWaitEvents ();
+        for ( uint32_t w = 0; w < engine->windowCount; w++ )
+            if ( glfwWindowShouldClose ( engine->windows[ w ].window ) )
+                atomic_store ( &engine->running, 0 );
+    }
+
+    atomic_store ( &engine->running, 0 );
+    void * failed = NULL; /* the engine when a frame failed */
+    pthread_join ( engine->renderThread, &failed );
+    return failed != NULL;
 }
 
 uint8_t
@@ -156,8 +589,14 @@ cleanup ()
     BasedSyncCleanup ( CRINGE_ENGINE );
     CringedCommandBufferCleanup ( CRINGE_ENGINE );
     CringedFrameBuffersCleanup ( CRINGE_ENGINE );
+    CringedStreamCleanup ( CRINGE_ENGINE );
+    CringedOcclusionCleanup ( CRINGE_ENGINE );
+    CringedParticlesCleanup ( CRINGE_ENGINE );
+    CringedSpritesCleanup ( CRINGE_ENGINE );
     BasedGraphicsPipelineCleanup ( CRINGE_ENGINE );
     CringedSwapChainCleanup ( CRINGE_ENGINE );
+    CringedFrameRingCleanup ( CRINGE_ENGINE );
+    CringedSceneCleanup ( CRINGE_ENGINE );
     BasedVKCleanup ( CRINGE_ENGINE );
     return 0;
 }
@@ -165,13 +604,171 @@ cleanup ()
 Engine *
 CringeInitEngine ( void )
 {
-    Engine * engine = ( Engine * ) malloc ( sizeof ( Engine ) );
+    /* Zeroed: cleanup after a failed init step only finds NULL handles
+     * where later steps never ran */
+    Engine * engine = ( Engine * ) calloc ( 1, sizeof ( Engine ) );
     if ( engine == NULL ) { return NULL; }
 
     engine->MaxFramesInFlight = MAX_FRAMES_IN_FLIGHT;
     engine->cFrame            = 0;
-    engine->winResized        = 0;
+    engine->frameNumber       = 0;
+    engine->lastFrameTime     = 0.0;
+    atomic_init ( &engine->running, 0 );
     engine->physicalDevice    = VK_NULL_HANDLE;
+    engine->deviceBenchmark   = 1;
+    engine->deviceCachePath   = DEVICE_CACHE_PATH;
+    engine->dynamicRendering  = 0;
+    engine->calibratedTimestamps = 0;
+    engine->gpuTrace             = NULL;
+    engine->synchronization2     = 0;
+    engine->memoryBudget         = 0;
+    engine->depthClamp           = 0;
+    engine->drawIndirectFirstInstance = 0;
+    engine->colorFormat       = VK_FORMAT_UNDEFINED;
+
+    engine->frameRingSize       = FRAME_RING_SIZE;
+    engine->frameRing           = NULL;
+    engine->descriptorSetLayout = NULL;
+    engine->descriptorPool      = NULL;
+    engine->descriptorSet       = VK_NULL_HANDLE;
+    engine->depthFormat         = VK_FORMAT_UNDEFINED;
+    engine->depthRenderPass     = VK_NULL_HANDLE;
+    memset ( engine->variants, 0, sizeof ( engine->variants ) );
+    engine->pipelineCache       = VK_NULL_HANDLE;
+    engine->pipelineCachePath   = PIPELINE_CACHE_PATH;
+    glm_mat4_identity ( engine->view );
+    glm_mat4_identity ( engine->proj );
+
+    /* Default scene: the triangle as a single identity instance */
+    engine->maxInstances = MAX_INSTANCES;
+    engine->transforms   = cringedCreateTransforms ( engine->maxInstances );
+    if ( engine->transforms == NULL ) goto defer_cleanup;
+    vec3   position = { 0.0f, 0.0f, 0.0f };
+    vec3   scale    = { 1.0f, 1.0f, 1.0f };
+    versor rotation;
+    glm_quat_identity ( rotation );
+    cringedTransformsAdd ( engine->transforms, position, rotation, scale );
+
+    engine->culler =
+        cringedCreateCuller ( engine->maxInstances, CULL_WORKER_THREADS );
+    if ( engine->culler == NULL ) goto defer_transforms;
+
+    engine->deletions = cringedCreateDeletionQueue ( DELETION_QUEUE_SIZE );
+    if ( engine->deletions == NULL ) goto defer_culler;
+
+    /* NOTE: BUDGET_MB=n caps every heap's budget at n MiB, e.g. to watch
+     * the residency evict */
+    engine->residency = cringedCreateResidency (
+        MAX_RESIDENTS, BUDGET_HIGH_WATER, BUDGET_LOW_WATER );
+    if ( engine->residency == NULL ) goto defer_deletions;
+    const char * budgetCap = getenv ( "BUDGET_MB" );
+    if ( budgetCap && atoi ( budgetCap ) > 0 )
+        engine->residency->cap = ( VkDeviceSize ) atoi ( budgetCap ) << 20;
+
+    engine->graph = cringedCreateRenderGraph ( engine->deletions );
+    if ( engine->graph == NULL ) goto defer_residency;
+
+    /* Hierarchy nodes, empty until the application adds some */
+    engine->scene = cringedCreateScene ( MAX_SCENE_NODES );
+    if ( engine->scene == NULL ) goto defer_graph;
+
+    /* Window input, event thread -> render thread */
+    engine->input = cringedCreateInputQueue ( INPUT_QUEUE_SIZE );
+    if ( engine->input == NULL ) goto defer_scene;
+
+    /* Draw requests from any thread, see renderQueue.h */
+    engine->renderQueue = cringedCreateRenderQueue ( RENDER_QUEUE_SIZE );
+    engine->submitter   = cringedCreateSubmitter ();
+    engine->sprites     = cringedCreateSpriteBatch ( MAX_SPRITES );
+    /* NOTE: F1 toggles the HUD, HUD=0 starts with it hidden */
+    const char * hud = getenv ( "HUD" );
+    engine->hud      = cringedCreateHud ( ! hud || hud[ 0 ] != '0' );
+    if ( engine->renderQueue == NULL || engine->submitter == NULL ||
+         engine->sprites == NULL || engine->hud == NULL )
+        goto defer_frontend;
+    /* NOTE: PARTICLES=n simulates about n particles on the device,
+     * PARTICLE_BENCH=1 steps through PARTICLE_STEPS and exits */
+    const char * particles     = getenv ( "PARTICLES" );
+    const char * particleBench = getenv ( "PARTICLE_BENCH" );
+    engine->particleBench      = particleBench && particleBench[ 0 ] == '1';
+    engine->particles          = NULL;
+    if ( engine->particleBench || ( particles && atoi ( particles ) > 0 ) )
+    {
+        engine->particles = cringedCreateParticles (
+            MAX_PARTICLES,
+            engine->particleBench ? PARTICLE_STEPS[ 0 ] : atoi ( particles ) );
+        if ( engine->particles == NULL ) goto defer_frontend;
+        /* Bench: constant population, refilled every frame */
+        if ( engine->particleBench ) engine->particles->emitRate = 0;
+    }
+
+    /* NOTE: INSTANCE_MESH=disc draws the instances with levels of detail */
+    const char * instanceMesh = getenv ( "INSTANCE_MESH" );
+    engine->instanceMesh      = CRINGED_MESH_TRIANGLE;
+    if ( instanceMesh && ! strcmp ( instanceMesh, "disc" ) )
+        engine->instanceMesh = CRINGED_MESH_DISC;
+    engine->lods =
+        cringedCreateLodSelector ( engine->maxInstances, LOD_HYSTERESIS );
+    if ( engine->lods == NULL ) goto defer_particles;
+
+    /* NOTE: OCCLUSION=0 draws every frustum survivor, no Hi-Z passes */
+    const char * occlusion = getenv ( "OCCLUSION" );
+    engine->occlusion      = NULL;
+    if ( ! occlusion || occlusion[ 0 ] != '0' )
+    {
+        engine->occlusion = cringedCreateOcclusion (
+            engine->maxInstances,
+            &cringedBuiltinMeshes[ engine->instanceMesh ] );
+        if ( engine->occlusion == NULL ) goto defer_lods;
+    }
+
+    /* Every SPIR-V program, mapped once; built by `make` */
+    engine->shaders = cringedOpenShaderArchive ( SHADER_ARCHIVE_PATH );
+    if ( engine->shaders == NULL )
+    {
+        printf ( "no shader archive at %s\n", SHADER_ARCHIVE_PATH );
+        goto defer_occlusion;
+    }
+
+    /* NOTE: STREAM_IO=pread skips io_uring for the worker threads */
+    const char * streamIo     = getenv ( "STREAM_IO" );
+    engine->streamStagingSize = STREAM_STAGING_SIZE;
+    engine->stream            = cringedCreateStream (
+        MAX_STREAM_REQUESTS,
+        STREAM_QUEUE_DEPTH,
+        STREAM_WORKERS,
+        ! streamIo || strcmp ( streamIo, "pread" ) );
+    if ( engine->stream == NULL ) goto defer_shaders;
+
+    /* NOTE: A/B switch for the frame stats, e.g. DEPTH_PRE_PASS=1 make run */
+    const char * prePass         = getenv ( "DEPTH_PRE_PASS" );
+    engine->scene->depthPrePass = prePass && prePass[ 0 ] == '1';
+    /* NOTE: DEBUG_VIEW=instance|depth shades every draw with a debug
+     * variant of its material instead */
+    const char * debugView = getenv ( "DEBUG_VIEW" );
+    engine->debugView      = 0;
+    if ( debugView && ! strcmp ( debugView, "instance" ) )
+        engine->debugView = CRINGED_DEBUG_VIEW_INSTANCE
+                            << CRINGED_FEATURE_DEBUG_SHIFT;
+    else if ( debugView && ! strcmp ( debugView, "depth" ) )
+        engine->debugView = CRINGED_DEBUG_VIEW_DEPTH
+                            << CRINGED_FEATURE_DEBUG_SHIFT;
+    /* NOTE: DEVICE_BENCH=0 picks by static score only */
+    const char * deviceBench = getenv ( "DEVICE_BENCH" );
+    engine->deviceBenchmark  = ! deviceBench || deviceBench[ 0 ] != '0';
+    /* NOTE: WINDOWS=2 opens a second window onto the same scene (up to
+     * CRINGED_MAX_WINDOWS), every frame presents all of them at once */
+    const char * windows = getenv ( "WINDOWS" );
+    engine->windowCount  = windows ? ( uint32_t ) atoi ( windows ) : 1;
+    if ( engine->windowCount < 1 ) engine->windowCount = 1;
+    if ( engine->windowCount > CRINGED_MAX_WINDOWS )
+        engine->windowCount = CRINGED_MAX_WINDOWS;
+    memset ( engine->windows, 0, sizeof ( engine->windows ) );
+    for ( uint32_t w = 0; w < CRINGED_MAX_WINDOWS; w++ )
+    {
+        atomic_init ( &engine->windows[ w ].resized, 0 );
+        atomic_init ( &engine->windows[ w ].extent, 0 );
+    }
 
     engine->validationLayers.data  = layers;
     engine->customInstanceExt.data = instanceExtensions;
@@ -190,12 +787,50 @@ CringeInitEngine ( void )
 #endif
 
     return engine;
+
+    /* Failures unwind from their stage down, in reverse creation order */
+defer_shaders:
+    cringedCloseShaderArchive ( engine->shaders );
+defer_occlusion:
+    cringedDestroyOcclusion ( engine->occlusion );
+defer_lods:
+    cringedDestroyLodSelector ( engine->lods );
+defer_particles:
+    cringedDestroyParticles ( engine->particles );
+defer_frontend:
+    cringedDestroyHud ( engine->hud );
+    cringedDestroySpriteBatch ( engine->sprites );
+    cringedDestroySubmitter ( engine->submitter );
+    cringedDestroyRenderQueue ( engine->renderQueue );
+    cringedDestroyInputQueue ( engine->input );
+defer_scene:
+    cringedDestroyScene ( engine->scene );
+defer_graph:
+    cringedDestroyRenderGraph ( engine->graph );
+defer_residency:
+    cringedDestroyResidency ( engine->residency );
+defer_deletions:
+    cringedDestroyDeletionQueue ( engine->deletions );
+defer_culler:
+    cringedDestroyCuller ( engine->culler );
+defer_transforms:
+    cringedDestroyTransforms ( engine->transforms );
+defer_cleanup:
+    free ( engine );
+    return NULL;
 }
 
 int
 main ()
 {
-    int rcode     = 1;
+    int rcode = 1;
+
+    /* NOTE: e.g. TRACE=build/trace.json make run, open in Perfetto.
+     * Started first so every thread the engine spawns is named. */
+    const char * tracePath = getenv ( "TRACE" );
+    if ( tracePath && tracePath[ 0 ] ) cringedTraceStart ();
+    cringedTraceThreadName ( "main" );
+
     CRINGE_ENGINE = CringeInitEngine ();
 
     if ( ! CRINGE_ENGINE )
@@ -222,11 +857,32 @@ main ()
 exit_base:
     cleanup ();
 
-    if ( CRINGE_ENGINE->window )
+    if ( CRINGE_ENGINE->windows[ 0 ].window )
     {
-        glfwDestroyWindow ( CRINGE_ENGINE->window );
+        for ( uint32_t w = 0; w < CRINGE_ENGINE->windowCount; w++ )
+            glfwDestroyWindow ( CRINGE_ENGINE->windows[ w ].window );
         glfwTerminate ();
     }
+    cringedDestroyStream ( CRINGE_ENGINE->stream );
+    cringedCloseShaderArchive ( CRINGE_ENGINE->shaders );
+    cringedDestroyOcclusion ( CRINGE_ENGINE->occlusion );
+    cringedDestroyLodSelector ( CRINGE_ENGINE->lods );
+    cringedDestroyParticles ( CRINGE_ENGINE->particles );
+    cringedDestroyHud ( CRINGE_ENGINE->hud );
+    cringedDestroySpriteBatch ( CRINGE_ENGINE->sprites );
+    cringedDestroySubmitter ( CRINGE_ENGINE->submitter );
+    cringedDestroyRenderQueue ( CRINGE_ENGINE->renderQueue );
+    cringedDestroyInputQueue ( CRINGE_ENGINE->input );
+    cringedDestroyScene ( CRINGE_ENGINE->scene );
+    cringedDestroyRenderGraph ( CRINGE_ENGINE->graph );
+    cringedDestroyResidency ( CRINGE_ENGINE->residency );
+    cringedDestroyDeletionQueue ( CRINGE_ENGINE->deletions );
+    cringedDestroyCuller ( CRINGE_ENGINE->culler );
+    cringedDestroyTransforms ( CRINGE_ENGINE->transforms );
     free ( CRINGE_ENGINE );
+
+    /* Every traced thread has been joined by now */
+    if ( cringedTraceEnabled ) cringedTraceWrite ( tracePath );
+    cringedTraceShutdown ();
     return rcode;
 }
@@ -2,12 +2,13 @@
 #ifndef BASED_CODE_VK
 #define BASED_CODE_VK
 
-// NOTE: define to use software rendering:
-// #define LLVM_MESA
+// NOTE: software rendering: pin the lavapipe ICD, see `make run`
 
 // NOTE: define to remove validation layers:
 // #define NDEBUG
 
+#include "gpuTrace.h"
+#include "initGraph.h"
 #include "vkinit.h"
 
 #include <cglm/cglm.h>
@@ -29,6 +30,32 @@ Engine *
 CringeInitEngine ( void );
 
 const int    MAX_FRAMES_IN_FLIGHT = 2;
+const size_t FRAME_RING_SIZE      = 4 << 20; /* bytes per frame in flight */
+const int    MAX_INSTANCES        = 16384;
+const int    CULL_WORKER_THREADS  = 3;
+const int    INIT_WORKER_THREADS  = 3;
+const int    MAX_SCENE_NODES      = 4096;
+const int    FRAME_STATS_INTERVAL = 300; /* debug builds only */
+const int    DELETION_QUEUE_SIZE  = 256; /* grows on demand */
+const int    INPUT_QUEUE_SIZE     = 1024; /* events between two frames */
+const long   MINIMIZED_POLL_NS    = 10000000;
+const int    RENDER_QUEUE_SIZE    = 4096; /* draws per frame, grows */
+const int    MAX_SPRITES          = 131072; /* quads per frame */
+const int    MAX_PARTICLES        = 1 << 20; /* device buffers, x2 */
+const int    PARTICLE_WARMUP      = 60;  /* bench frames per step, skipped */
+const int    PARTICLE_FRAMES      = 240; /* bench frames per step, measured */
+const int    PARTICLE_STEPS[]     = { 10000, 100000, 250000, 500000, 1000000 };
+const float  LOD_HYSTERESIS       = 0.15f; /* of a level's size threshold */
+const int    MAX_RESIDENTS        = 1024;  /* evictable resources */
+const float  BUDGET_HIGH_WATER    = 0.90f; /* of a heap's budget: evict */
+const float  BUDGET_LOW_WATER     = 0.80f; /* ... down to this */
+const int    MAX_STREAM_REQUESTS  = 256;
+const int    STREAM_QUEUE_DEPTH   = 32; /* reads in flight */
+const int    STREAM_WORKERS       = 2;  /* threads, without io_uring */
+const size_t STREAM_STAGING_SIZE  = 16 << 20; /* bytes, mapped */
+const char * DEVICE_CACHE_PATH    = "build/device_bench.cache";
+const char * PIPELINE_CACHE_PATH  = "build/pipeline.cache";
+const char * SHADER_ARCHIVE_PATH  = "build/shaders.pack";
 const char * layers[]             = { "VK_LAYER_KHRONOS_validation" };
 const char * instanceExtensions[] = {
     VK_EXT_DEBUG_UTILS_EXTENSION_NAME,
@@ -0,0 +1,770 @@
+#include "occlusion.h"
+
+CringedOcclusion *
+cringedCreateOcclusion ( uint32_t capacity, const CringedMeshLods * mesh )
+{
+    CringedOcclusion * occlusion =
+        ( CringedOcclusion * ) calloc ( 1, sizeof ( CringedOcclusion ) );
+    if ( occlusion == NULL ) return NULL;
+
+    occlusion->capacity = capacity;
+    occlusion->mesh     = mesh;
+    glm_mat4_identity ( occlusion->viewProj );
+    return occlusion;
+}
+
+void
+cringedDestroyOcclusion ( CringedOcclusion * occlusion )
+{
+    free ( occlusion );
+}
+
+/* =============================================
+ *            RESOURCES
+ * ============================================= */
+
+static VkResult
+createSets ( CringedOcclusion * occlusion, BasedRingBuffer * ring )
+{
+    VkResult opResult;
+    VkDevice device = occlusion->device;
+    uint32_t frames = occlusion->frameCount;
+
+    /* Cull: candidates (ring), lists, draw commands, pyramid */
+    VkDescriptorSetLayoutBinding bindings[ 4 ] = {};
+    for ( uint32_t b = 0; b < 4; b++ )
+    {
+        bindings[ b ].binding         = b;
+        bindings[ b ].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[ b ].descriptorCount = 1;
+        bindings[ b ].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    bindings[ 0 ].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    bindings[ 3 ].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 4;
+    layoutInfo.pBindings    = bindings;
+    if ( ( opResult = vkCreateDescriptorSetLayout (
+               device, &layoutInfo, NULL, &occlusion->cullSetLayout ) ) !=
+         VK_SUCCESS )
+        return opResult;
+
+    /* Reduce: the level read, the level written */
+    bindings[ 0 ].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[ 1 ].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    layoutInfo.bindingCount      = 2;
+    if ( ( opResult = vkCreateDescriptorSetLayout (
+               device, &layoutInfo, NULL, &occlusion->reduceSetLayout ) ) !=
+         VK_SUCCESS )
+        return opResult;
+
+    uint32_t reduceCount = frames * CRINGED_HIZ_MAX_MIPS;
+    VkDescriptorPoolSize poolSizes[ 4 ] = {
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, frames },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 * frames },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, frames + reduceCount },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, reduceCount },
+    };
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets       = frames + reduceCount;
+    poolInfo.poolSizeCount = 4;
+    poolInfo.pPoolSizes    = poolSizes;
+    if ( ( opResult = vkCreateDescriptorPool (
+               device, &poolInfo, NULL, &occlusion->descriptorPool ) ) !=
+         VK_SUCCESS )
+        return opResult;
+
+    occlusion->cullSets =
+        ( VkDescriptorSet * ) calloc ( frames, sizeof ( VkDescriptorSet ) );
+    occlusion->reduceSets = ( VkDescriptorSet * ) calloc (
+        reduceCount, sizeof ( VkDescriptorSet ) );
+    occlusion->setGeneration =
+        ( uint32_t * ) calloc ( frames, sizeof ( uint32_t ) );
+    VkDescriptorSetLayout * layouts = ( VkDescriptorSetLayout * ) malloc (
+        reduceCount * sizeof ( VkDescriptorSetLayout ) );
+    if ( ! occlusion->cullSets || ! occlusion->reduceSets ||
+         ! occlusion->setGeneration || ! layouts )
+    {
+        free ( layouts );
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    VkDescriptorSetAllocateInfo setInfo = {};
+    setInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setInfo.descriptorPool     = occlusion->descriptorPool;
+    setInfo.descriptorSetCount = frames;
+    setInfo.pSetLayouts        = layouts;
+    for ( uint32_t s = 0; s < frames; s++ )
+        layouts[ s ] = occlusion->cullSetLayout;
+    if ( ( opResult = vkAllocateDescriptorSets (
+               device, &setInfo, occlusion->cullSets ) ) != VK_SUCCESS )
+    {
+        free ( layouts );
+        return opResult;
+    }
+    setInfo.descriptorSetCount = reduceCount;
+    for ( uint32_t s = 0; s < reduceCount; s++ )
+        layouts[ s ] = occlusion->reduceSetLayout;
+    opResult =
+        vkAllocateDescriptorSets ( device, &setInfo, occlusion->reduceSets );
+    free ( layouts );
+    if ( opResult != VK_SUCCESS ) return opResult;
+
+    /* Buffers never change; the pyramid is written once it exists */
+    VkDescriptorBufferInfo buffers[ 3 ] = {
+        { ring->buffer.buffer,
+          0,
+          occlusion->capacity * sizeof ( CringedOcclusionCandidate ) },
+        { occlusion->lists.buffer, 0, VK_WHOLE_SIZE },
+        { occlusion->commands.buffer, 0, VK_WHOLE_SIZE },
+    };
+    for ( uint32_t s = 0; s < frames; s++ )
+    {
+        VkWriteDescriptorSet writes[ 3 ] = {};
+        for ( uint32_t b = 0; b < 3; b++ )
+        {
+            writes[ b ].sType  = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[ b ].dstSet = occlusion->cullSets[ s ];
+            writes[ b ].dstBinding      = b;
+            writes[ b ].descriptorCount = 1;
+            writes[ b ].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[ b ].pBufferInfo     = &buffers[ b ];
+        }
+        writes[ 0 ].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+        vkUpdateDescriptorSets ( device, 3, writes, 0, NULL );
+    }
+    return VK_SUCCESS;
+}
+
+static VkResult
+createPipeline ( CringedOcclusion *           occlusion,
+                 const CringedShaderArchive * shaders,
+                 const char *                 name,
+                 VkDescriptorSetLayout        setLayout,
+                 uint32_t                     pushSize,
+                 VkPipelineLayout *           layout,
+                 VkPipeline *                 pipeline )
+{
+    VkResult       opResult;
+    VkDevice       device = occlusion->device;
+    VkShaderModule module = VK_NULL_HANDLE;
+    if ( ( opResult = cringedArchiveModule (
+               shaders, device, name, &module ) ) != VK_SUCCESS )
+        return opResult;
+
+    VkPushConstantRange range = { VK_SHADER_STAGE_COMPUTE_BIT, 0, pushSize };
+    VkPipelineLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount         = 1;
+    layoutInfo.pSetLayouts            = &setLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges    = &range;
+    if ( ( opResult = vkCreatePipelineLayout (
+               device, &layoutInfo, NULL, layout ) ) == VK_SUCCESS )
+    {
+        VkComputePipelineCreateInfo computeInfo = {};
+        computeInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        computeInfo.stage.sType =
+            VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        computeInfo.stage.stage       = VK_SHADER_STAGE_COMPUTE_BIT;
+        computeInfo.stage.module      = module;
+        computeInfo.stage.pName       = "main";
+        computeInfo.layout            = *layout;
+        computeInfo.basePipelineIndex = -1;
+        opResult                      = vkCreateComputePipelines (
+            device, VK_NULL_HANDLE, 1, &computeInfo, NULL, pipeline );
+    }
+    vkDestroyShaderModule ( device, module, NULL );
+    return opResult;
+}
+
+VkResult
+cringedOcclusionCreateResources ( CringedOcclusion *           occlusion,
+                                  VkPhysicalDevice             physicalDevice,
+                                  VkDevice                     device,
+                                  uint32_t                     frameCount,
+                                  BasedRingBuffer *            ring,
+                                  const CringedShaderArchive * shaders )
+{
+    VkResult opResult, rcode = VK_INCOMPLETE;
+    occlusion->device         = device;
+    occlusion->physicalDevice = physicalDevice;
+    occlusion->frameCount     = frameCount;
+
+    /* A list per phase and level, then one flag per candidate */
+    VkDeviceSize listsSize = ( 2 * CRINGED_LOD_MAX + 1 ) *
+                             ( VkDeviceSize ) occlusion->capacity *
+                             sizeof ( uint32_t );
+    if ( ( opResult = cringedCreateBuffer ( //
+               physicalDevice,
+               device,
+               listsSize,
+               VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+               &occlusion->lists ) ) != VK_SUCCESS ||
+         ( opResult = cringedCreateBuffer ( //
+               physicalDevice,
+               device,
+               2 * CRINGED_LOD_MAX * sizeof ( VkDrawIndirectCommand ),
+               VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                   VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                   VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+               &occlusion->commands ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: occlusion buffers: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    /* Only texelFetch: no filtering, no reduction mode needed */
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter    = VK_FILTER_NEAREST;
+    samplerInfo.minFilter    = VK_FILTER_NEAREST;
+    samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod       = VK_LOD_CLAMP_NONE;
+    if ( ( opResult = vkCreateSampler (
+               device, &samplerInfo, NULL, &occlusion->sampler ) ) !=
+         VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: occlusion sampler: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    if ( ( opResult = createSets ( occlusion, ring ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: occlusion descriptors: %d\n", opResult );
+        goto defer_cleanup;
+    }
+    if ( ( opResult = createPipeline ( //
+               occlusion,
+               shaders,
+               "Occlusion_comp",
+               occlusion->cullSetLayout,
+               sizeof ( CringedOcclusionCull ),
+               &occlusion->cullLayout,
+               &occlusion->cullPipeline ) ) != VK_SUCCESS ||
+         ( opResult = createPipeline ( //
+               occlusion,
+               shaders,
+               "HiZ_comp",
+               occlusion->reduceSetLayout,
+               sizeof ( CringedHiZReduce ),
+               &occlusion->reduceLayout,
+               &occlusion->reducePipeline ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: occlusion pipelines: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    rcode = VK_SUCCESS;
+
+defer_cleanup:
+    if ( rcode ) cringedOcclusionDestroyResources ( occlusion );
+    return rcode;
+}
+
+static void
+destroyPyramid ( CringedOcclusion * occlusion )
+{
+    VkDevice device = occlusion->device;
+    for ( uint32_t m = 0; m < occlusion->mipCount; m++ )
+        vkDestroyImageView ( device, occlusion->mipViews[ m ], NULL );
+    if ( occlusion->view ) vkDestroyImageView ( device, occlusion->view, NULL );
+    if ( occlusion->image ) vkDestroyImage ( device, occlusion->image, NULL );
+    if ( occlusion->memory ) vkFreeMemory ( device, occlusion->memory, NULL );
+    occlusion->mipCount = 0;
+    occlusion->view     = VK_NULL_HANDLE;
+    occlusion->image    = VK_NULL_HANDLE;
+    occlusion->memory   = VK_NULL_HANDLE;
+}
+
+void
+cringedOcclusionDestroyResources ( CringedOcclusion * occlusion )
+{
+    VkDevice device = occlusion->device;
+    if ( device == VK_NULL_HANDLE ) return;
+
+    destroyPyramid ( occlusion );
+    if ( occlusion->cullPipeline )
+        vkDestroyPipeline ( device, occlusion->cullPipeline, NULL );
+    if ( occlusion->reducePipeline )
+        vkDestroyPipeline ( device, occlusion->reducePipeline, NULL );
+    if ( occlusion->cullLayout )
+        vkDestroyPipelineLayout ( device, occlusion->cullLayout, NULL );
+    if ( occlusion->reduceLayout )
+        vkDestroyPipelineLayout ( device, occlusion->reduceLayout, NULL );
+    if ( occlusion->descriptorPool ) /* frees the sets */
+        vkDestroyDescriptorPool ( device, occlusion->descriptorPool, NULL );
+    if ( occlusion->cullSetLayout )
+        vkDestroyDescriptorSetLayout (
+            device, occlusion->cullSetLayout, NULL );
+    if ( occlusion->reduceSetLayout )
+        vkDestroyDescriptorSetLayout (
+            device, occlusion->reduceSetLayout, NULL );
+    if ( occlusion->sampler )
+        vkDestroySampler ( device, occlusion->sampler, NULL );
+    free ( occlusion->cullSets );
+    free ( occlusion->reduceSets );
+    free ( occlusion->setGeneration );
+    occlusion->cullPipeline    = VK_NULL_HANDLE;
+    occlusion->reducePipeline  = VK_NULL_HANDLE;
+    occlusion->cullLayout      = VK_NULL_HANDLE;
+    occlusion->reduceLayout    = VK_NULL_HANDLE;
+    occlusion->descriptorPool  = VK_NULL_HANDLE;
+    occlusion->cullSetLayout   = VK_NULL_HANDLE;
+    occlusion->reduceSetLayout = VK_NULL_HANDLE;
+    occlusion->sampler         = VK_NULL_HANDLE;
+    occlusion->cullSets        = NULL;
+    occlusion->reduceSets      = NULL;
+    occlusion->setGeneration   = NULL;
+    cringedDestroyBuffer ( device, &occlusion->lists );
+    cringedDestroyBuffer ( device, &occlusion->commands );
+    occlusion->device = VK_NULL_HANDLE;
+}
+
+uint8_t
+cringedOcclusionSupports ( VkPhysicalDevice physicalDevice,
+                           VkFormat         depthFormat )
+{
+    VkFormatProperties props;
+    switch ( depthFormat )
+    {
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_X8_D24_UNORM_PACK32:
+        case VK_FORMAT_D32_SFLOAT: break;
+        default: return 0; /* stencil: no combined depth view sampling */
+    }
+    vkGetPhysicalDeviceFormatProperties ( physicalDevice, depthFormat, &props );
+    if ( ! ( props.optimalTilingFeatures &
+             VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT ) )
+        return 0;
+    vkGetPhysicalDeviceFormatProperties (
+        physicalDevice, VK_FORMAT_R32_SFLOAT, &props );
+    return ( props.optimalTilingFeatures &
+             VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT ) != 0;
+}
+
+static uint32_t
+floorPow2 ( uint32_t value )
+{
+    uint32_t pow2 = 1;
+    while ( pow2 * 2 <= value ) pow2 *= 2;
+    return pow2;
+}
+
+VkResult
+cringedOcclusionResize ( CringedOcclusion *     occlusion,
+                         VkExtent2D             extent,
+                         CringedDeletionQueue * deletions )
+{
+    VkResult opResult;
+    VkDevice device = occlusion->device;
+    if ( occlusion->image &&
+         occlusion->depthExtent.width == extent.width &&
+         occlusion->depthExtent.height == extent.height )
+        return VK_SUCCESS;
+
+    /* Frames in flight may still build or read the old one */
+    for ( uint32_t m = 0; m < occlusion->mipCount; m++ )
+        cringedDefer ( deletions,
+                       ( CringedDeletion ) { CRINGED_DELETE_IMAGE_VIEW,
+                                             .imageView =
+                                                 occlusion->mipViews[ m ] } );
+    if ( occlusion->view )
+        cringedDefer ( deletions,
+                       ( CringedDeletion ) { CRINGED_DELETE_IMAGE_VIEW,
+                                             .imageView = occlusion->view } );
+    if ( occlusion->image )
+        cringedDefer ( deletions,
+                       ( CringedDeletion ) { CRINGED_DELETE_IMAGE,
+                                             .image = occlusion->image } );
+    if ( occlusion->memory )
+        cringedDefer ( deletions,
+                       ( CringedDeletion ) { CRINGED_DELETE_MEMORY,
+                                             .memory = occlusion->memory } );
+    occlusion->mipCount = 0;
+    occlusion->view     = VK_NULL_HANDLE;
+    occlusion->image    = VK_NULL_HANDLE;
+    occlusion->memory   = VK_NULL_HANDLE;
+
+    occlusion->depthExtent   = extent;
+    occlusion->extent.width  = floorPow2 ( extent.width );
+    occlusion->extent.height = floorPow2 ( extent.height );
+    uint32_t largest         = occlusion->extent.width;
+    if ( occlusion->extent.height > largest )
+        largest = occlusion->extent.height;
+    uint32_t mipCount = 1;
+    while ( ( largest >> mipCount ) && mipCount < CRINGED_HIZ_MAX_MIPS )
+        mipCount++;
+
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType         = VK_IMAGE_TYPE_2D;
+    imageInfo.format            = VK_FORMAT_R32_SFLOAT;
+    imageInfo.extent.width      = occlusion->extent.width;
+    imageInfo.extent.height     = occlusion->extent.height;
+    imageInfo.extent.depth      = 1;
+    imageInfo.mipLevels         = mipCount;
+    imageInfo.arrayLayers       = 1;
+    imageInfo.samples           = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling            = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage =
+        VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if ( ( opResult = vkCreateImage (
+               device, &imageInfo, NULL, &occlusion->image ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: depth pyramid image: %d\n", opResult );
+        goto fail;
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements ( device, occlusion->image, &requirements );
+    int32_t memoryType =
+        cringedFindMemoryType ( occlusion->physicalDevice,
+                                requirements.memoryTypeBits,
+                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+    if ( memoryType < 0 )
+    {
+        _DEBUG_P ( "error: no device local memory for the depth pyramid\n" );
+        opResult = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+        goto fail;
+    }
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType                = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize       = requirements.size;
+    allocInfo.memoryTypeIndex      = memoryType;
+    if ( ( opResult = vkAllocateMemory (
+               device, &allocInfo, NULL, &occlusion->memory ) ) !=
+             VK_SUCCESS ||
+         ( opResult = vkBindImageMemory (
+               device, occlusion->image, occlusion->memory, 0 ) ) !=
+             VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: depth pyramid memory: %d\n", opResult );
+        goto fail;
+    }
+
+    VkImageViewCreateInfo viewInfo = {};
+    viewInfo.sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image    = occlusion->image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format   = VK_FORMAT_R32_SFLOAT;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.levelCount = mipCount;
+    viewInfo.subresourceRange.layerCount = 1;
+    if ( ( opResult = vkCreateImageView (
+               device, &viewInfo, NULL, &occlusion->view ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: depth pyramid view: %d\n", opResult );
+        goto fail;
+    }
+    viewInfo.subresourceRange.levelCount = 1;
+    for ( ; occlusion->mipCount < mipCount; occlusion->mipCount++ )
+    {
+        viewInfo.subresourceRange.baseMipLevel = occlusion->mipCount;
+        if ( ( opResult = vkCreateImageView ( //
+                   device,
+                   &viewInfo,
+                   NULL,
+                   &occlusion->mipViews[ occlusion->mipCount ] ) ) !=
+             VK_SUCCESS )
+        {
+            _DEBUG_P ( "error: depth pyramid mip view: %d\n", opResult );
+            goto fail;
+        }
+    }
+
+    /* Nothing to test against until the first frame built it */
+    occlusion->generation++;
+    occlusion->layoutReady = 0;
+    occlusion->valid       = 0;
+    return VK_SUCCESS;
+
+fail:
+    destroyPyramid ( occlusion );
+    return opResult;
+}
+
+/* =============================================
+ *            FRAME
+ * ============================================= */
+
+static void
+memoryBarrier ( VkCommandBuffer      commandBuffer,
+                VkPipelineStageFlags srcStages,
+                VkAccessFlags        srcAccess,
+                VkPipelineStageFlags dstStages,
+                VkAccessFlags        dstAccess )
+{
+    VkMemoryBarrier barrier = {};
+    barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask   = srcAccess;
+    barrier.dstAccessMask   = dstAccess;
+    vkCmdPipelineBarrier ( commandBuffer,
+                           srcStages,
+                           dstStages,
+                           0,
+                           1,
+                           &barrier,
+                           0,
+                           NULL,
+                           0,
+                           NULL );
+}
+
+void
+cringedOcclusionBeginFrame ( CringedOcclusion * occlusion, uint32_t frame )
+{
+    occlusion->frame = frame % occlusion->frameCount;
+    uint32_t f       = occlusion->frame;
+    if ( occlusion->setGeneration[ f ] == occlusion->generation ) return;
+
+    /* Pyramid sampled by the cull, and level by level by the reduction;
+     * the depth buffer, mip 0's source, is written at record time */
+    VkDescriptorImageInfo pyramid = { occlusion->sampler,
+                                      occlusion->view,
+                                      VK_IMAGE_LAYOUT_GENERAL };
+    VkDescriptorImageInfo     mips[ CRINGED_HIZ_MAX_MIPS ];
+    VkWriteDescriptorSet      writes[ 2 * CRINGED_HIZ_MAX_MIPS ] = {};
+    uint32_t                  writeCount = 0;
+    VkWriteDescriptorSet *    w          = &writes[ writeCount++ ];
+    w->sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    w->dstSet          = occlusion->cullSets[ f ];
+    w->dstBinding      = 3;
+    w->descriptorCount = 1;
+    w->descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    w->pImageInfo      = &pyramid;
+    for ( uint32_t m = 0; m < occlusion->mipCount; m++ )
+    {
+        VkDescriptorSet set =
+            occlusion->reduceSets[ f * CRINGED_HIZ_MAX_MIPS + m ];
+        mips[ m ] = ( VkDescriptorImageInfo ) { VK_NULL_HANDLE,
+                                                occlusion->mipViews[ m ],
+                                                VK_IMAGE_LAYOUT_GENERAL };
+        w                  = &writes[ writeCount++ ];
+        w->sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        w->dstSet          = set;
+        w->dstBinding      = 1;
+        w->descriptorCount = 1;
+        w->descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        w->pImageInfo      = &mips[ m ];
+        if ( ! m ) continue;
+        w                  = &writes[ writeCount++ ];
+        w->sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        w->dstSet          = set;
+        w->dstBinding      = 0;
+        w->descriptorCount = 1;
+        w->descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        w->pImageInfo      = &pyramid;
+    }
+    vkUpdateDescriptorSets ( occlusion->device, writeCount, writes, 0, NULL );
+    occlusion->setGeneration[ f ] = occlusion->generation;
+}
+
+static void
+recordCull ( CringedOcclusion * occlusion,
+             VkCommandBuffer    commandBuffer,
+             uint32_t           phase,
+             mat4               viewProj,
+             uint32_t           candidateOffset,
+             uint32_t           count )
+{
+    CringedOcclusionCull cull;
+    glm_mat4_copy ( viewProj, cull.viewProj );
+    cull.counts[ 0 ]  = count;
+    cull.counts[ 1 ]  = phase;
+    cull.counts[ 2 ]  = occlusion->mipCount;
+    cull.counts[ 3 ]  = occlusion->capacity;
+    cull.pyramid[ 0 ] = ( float ) occlusion->extent.width;
+    cull.pyramid[ 1 ] = ( float ) occlusion->extent.height;
+    cull.pyramid[ 2 ] = occlusion->valid ? 1.0f : 0.0f;
+    cull.pyramid[ 3 ] = 0.0f;
+
+    vkCmdBindPipeline ( commandBuffer,
+                        VK_PIPELINE_BIND_POINT_COMPUTE,
+                        occlusion->cullPipeline );
+    vkCmdBindDescriptorSets ( commandBuffer,
+                              VK_PIPELINE_BIND_POINT_COMPUTE,
+                              occlusion->cullLayout,
+                              0,
+                              1,
+                              &occlusion->cullSets[ occlusion->frame ],
+                              1,
+                              &candidateOffset );
+    vkCmdPushConstants ( commandBuffer,
+                         occlusion->cullLayout,
+                         VK_SHADER_STAGE_COMPUTE_BIT,
+                         0,
+                         sizeof ( cull ),
+                         &cull );
+    if ( count )
+        vkCmdDispatch ( commandBuffer,
+                        ( count + CRINGED_OCCLUSION_GROUP - 1 ) /
+                            CRINGED_OCCLUSION_GROUP,
+                        1,
+                        1 );
+}
+
+void
+cringedOcclusionRecordEarly ( CringedOcclusion * occlusion,
+                              VkCommandBuffer    commandBuffer,
+                              uint32_t           candidateOffset,
+                              uint32_t           count )
+{
+    if ( ! occlusion->layoutReady )
+    {
+        /* Contents are undefined until `valid`, only the layout matters */
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout           = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image               = occlusion->image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.levelCount = occlusion->mipCount;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.dstAccessMask =
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier ( commandBuffer,
+                               VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                               0,
+                               0,
+                               NULL,
+                               0,
+                               NULL,
+                               1,
+                               &barrier );
+        occlusion->layoutReady = 1;
+    }
+
+    /* Last frame's draws may still read the commands; its pyramid must be
+     * complete before this frame samples it */
+    VkDrawIndirectCommand commands[ 2 * CRINGED_LOD_MAX ] = {};
+    for ( uint32_t c = 0; c < 2 * CRINGED_LOD_MAX; c++ )
+    {
+        uint32_t level = c % CRINGED_LOD_MAX;
+        if ( level >= occlusion->mesh->count ) continue;
+        commands[ c ].vertexCount   = occlusion->mesh->vertexCount[ level ];
+        commands[ c ].firstVertex   = occlusion->mesh->firstVertex[ level ];
+        commands[ c ].firstInstance = c * occlusion->capacity;
+    }
+    memoryBarrier ( commandBuffer,
+                    VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    0,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    0 );
+    vkCmdUpdateBuffer ( commandBuffer,
+                        occlusion->commands.buffer,
+                        0,
+                        sizeof ( commands ),
+                        commands );
+    memoryBarrier ( commandBuffer,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT |
+                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT );
+
+    recordCull ( occlusion,
+                 commandBuffer,
+                 CRINGED_OCCLUSION_EARLY,
+                 occlusion->viewProj,
+                 candidateOffset,
+                 count );
+}
+
+void
+cringedOcclusionRecordLate ( CringedOcclusion * occlusion,
+                             VkCommandBuffer    commandBuffer,
+                             VkImageView        depthView,
+                             mat4               viewProj,
+                             uint32_t           candidateOffset,
+                             uint32_t           count )
+{
+    uint32_t f = occlusion->frame;
+
+    /* The graph's transient depth view may change on any recompile */
+    VkDescriptorImageInfo depth = { occlusion->sampler,
+                                    depthView,
+                                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    VkWriteDescriptorSet  write = {};
+    write.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet          = occlusion->reduceSets[ f * CRINGED_HIZ_MAX_MIPS ];
+    write.dstBinding      = 0;
+    write.descriptorCount = 1;
+    write.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo      = &depth;
+    vkUpdateDescriptorSets ( occlusion->device, 1, &write, 0, NULL );
+
+    /* The early cull read the pyramid about to be overwritten */
+    memoryBarrier ( commandBuffer,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    0,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    0 );
+    vkCmdBindPipeline ( commandBuffer,
+                        VK_PIPELINE_BIND_POINT_COMPUTE,
+                        occlusion->reducePipeline );
+    VkExtent2D source = occlusion->depthExtent;
+    for ( uint32_t m = 0; m < occlusion->mipCount; m++ )
+    {
+        VkExtent2D target = { occlusion->extent.width >> m,
+                              occlusion->extent.height >> m };
+        if ( ! target.width ) target.width = 1;
+        if ( ! target.height ) target.height = 1;
+
+        CringedHiZReduce reduce = {
+            { ( int32_t ) source.width,
+              ( int32_t ) source.height,
+              ( int32_t ) target.width,
+              ( int32_t ) target.height },
+            { m ? ( int32_t ) m - 1 : 0, 0, 0, 0 } };
+        vkCmdBindDescriptorSets (
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            occlusion->reduceLayout,
+            0,
+            1,
+            &occlusion->reduceSets[ f * CRINGED_HIZ_MAX_MIPS + m ],
+            0,
+            NULL );
+        vkCmdPushConstants ( commandBuffer,
+                             occlusion->reduceLayout,
+                             VK_SHADER_STAGE_COMPUTE_BIT,
+                             0,
+                             sizeof ( reduce ),
+                             &reduce );
+        vkCmdDispatch ( commandBuffer,
+                        ( target.width + CRINGED_HIZ_GROUP - 1 ) /
+                            CRINGED_HIZ_GROUP,
+                        ( target.height + CRINGED_HIZ_GROUP - 1 ) /
+                            CRINGED_HIZ_GROUP,
+                        1 );
+        memoryBarrier ( commandBuffer,
+                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                        VK_ACCESS_SHADER_WRITE_BIT,
+                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                        VK_ACCESS_SHADER_READ_BIT );
+        source = target;
+    }
+    glm_mat4_copy ( viewProj, occlusion->viewProj );
+    occlusion->valid = 1;
+
+    recordCull ( occlusion,
+                 commandBuffer,
+                 CRINGED_OCCLUSION_LATE,
+                 viewProj,
+                 candidateOffset,
+                 count );
+}
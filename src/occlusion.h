@@ -0,0 +1,173 @@
+#pragma once
+#ifndef CRINGED_OCCLUSION_H
+#define CRINGED_OCCLUSION_H
+
+#include "bufferUtils.h"
+#include "deletionQueue.h"
+#include "lod.h"
+#include "shaderUtils.h"
+
+#include <cglm/cglm.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vulkan/vulkan.h>
+
+#ifndef NDEBUG
+#define _DEBUG_P( ... ) printf ( __VA_ARGS__ )
+#else
+#define _DEBUG_P( ... ) ( ( void ) 0 )
+#endif
+
+#define CRINGED_OCCLUSION_GROUP 64 /* compute local size, both shaders */
+#define CRINGED_HIZ_GROUP       8  /* HiZ_comp local size, square */
+#define CRINGED_HIZ_MAX_MIPS    16
+
+/* std430, one per frustum-visible instance, written into the frame ring */
+typedef struct
+{
+    vec4     sphere; /* xyz: world center, w: radius */
+    uint32_t instance[ 4 ]; /* x: index into the instances ring, y: level */
+} CringedOcclusionCandidate;
+
+/* Occlusion_comp push constants */
+typedef struct
+{
+    mat4     viewProj; /* the pyramid was rendered with */
+    uint32_t counts[ 4 ]; /* candidates, phase, mip count, capacity */
+    vec4     pyramid;     /* xy: mip 0 size, z: 1 when valid */
+} CringedOcclusionCull;
+
+/* HiZ_comp push constants */
+typedef struct
+{
+    int32_t sizes[ 4 ]; /* xy: source size, zw: target size */
+    int32_t sourceLod[ 4 ];
+} CringedHiZReduce;
+
+#define CRINGED_OCCLUSION_EARLY 0
+#define CRINGED_OCCLUSION_LATE  1
+
+/* Two-phase hierarchical-Z culling of the frustum-visible instances:
+ *   early: tested against last frame's depth pyramid, survivors drawn by
+ *          the main pass with one indirect draw per level of detail
+ *   pyramid: max-reduced from this frame's depth after the main pass
+ *   late:  early rejects re-tested against the new pyramid, the ones
+ *          that turn out visible are drawn right away, so nothing pops
+ *          when the camera or an occluder moves.
+ * Both phases append instance indices to the list of their phase and
+ * level in `lists`, read by the vertex shader through `gl_InstanceIndex`;
+ * the CPU never sees the counts.
+ * The pyramid is sized to the previous power of two of the swapchain:
+ * every mip 0 texel covers at most 3x3 depth texels, every other one
+ * exactly 2x2 of the level below. */
+typedef struct
+{
+    uint32_t                capacity; /* candidates per frame */
+    const CringedMeshLods * mesh;     /* the drawn one, its levels */
+    uint32_t                frameCount;
+    /* Device */
+    VkDevice         device;
+    VkPhysicalDevice physicalDevice;
+    BasedBuffer      lists;    /* [phase][level][cap], then early flags */
+    BasedBuffer      commands; /* VkDrawIndirectCommand [phase][level] */
+    VkSampler        sampler;
+    /* Pyramid, recreated with the swapchain */
+    VkExtent2D     depthExtent;
+    VkExtent2D     extent; /* mip 0 */
+    uint32_t       mipCount;
+    VkImage        image;
+    VkDeviceMemory memory;
+    VkImageView    view; /* every mip, sampled */
+    VkImageView    mipViews[ CRINGED_HIZ_MAX_MIPS ]; /* storage */
+    uint32_t       generation; /* bumped per pyramid */
+    uint8_t        layoutReady; /* transitioned to GENERAL */
+    uint8_t        valid;       /* holds a complete previous frame */
+    mat4           viewProj;    /* of the frame the pyramid came from */
+    /* Descriptors, per frame in flight: pyramid views are rewritten
+     * lazily after a resize, the depth view every frame, each once the
+     * frame that last used the set retired */
+    VkDescriptorSetLayout cullSetLayout;
+    VkDescriptorSetLayout reduceSetLayout;
+    VkDescriptorPool      descriptorPool;
+    VkDescriptorSet *     cullSets;   /* [frame] */
+    VkDescriptorSet *     reduceSets; /* [frame * MAX_MIPS + mip] */
+    uint32_t *            setGeneration;
+    uint32_t              frame;
+    VkPipelineLayout      cullLayout;
+    VkPipelineLayout      reduceLayout;
+    VkPipeline            cullPipeline;
+    VkPipeline            reducePipeline;
+} CringedOcclusion;
+
+/* Instances are drawn as `mesh`, the candidates carry their level */
+CringedOcclusion *
+cringedCreateOcclusion ( uint32_t capacity, const CringedMeshLods * mesh );
+
+/* GPU resources must have been destroyed */
+void
+cringedDestroyOcclusion ( CringedOcclusion * occlusion );
+
+/* Buffers, pipelines and descriptors; `ring` backs the candidates */
+VkResult
+cringedOcclusionCreateResources ( CringedOcclusion *           occlusion,
+                                  VkPhysicalDevice             physicalDevice,
+                                  VkDevice                     device,
+                                  uint32_t                     frameCount,
+                                  BasedRingBuffer *            ring,
+                                  const CringedShaderArchive * shaders );
+
+/* The device must be idle */
+void
+cringedOcclusionDestroyResources ( CringedOcclusion * occlusion );
+
+/* Depth formats the pyramid can be built from: sampled, no stencil */
+uint8_t
+cringedOcclusionSupports ( VkPhysicalDevice physicalDevice,
+                           VkFormat         depthFormat );
+
+/* New pyramid for `extent`; the old one goes through `deletions` */
+VkResult
+cringedOcclusionResize ( CringedOcclusion *     occlusion,
+                         VkExtent2D             extent,
+                         CringedDeletionQueue * deletions );
+
+/* Start of recording `frame`, whose previous use has completed */
+void
+cringedOcclusionBeginFrame ( CringedOcclusion * occlusion, uint32_t frame );
+
+/* Outside a render pass: resets all draws, tests `count` candidates at
+ * `candidateOffset` in the ring against the previous pyramid */
+void
+cringedOcclusionRecordEarly ( CringedOcclusion * occlusion,
+                              VkCommandBuffer    commandBuffer,
+                              uint32_t           candidateOffset,
+                              uint32_t           count );
+
+/* Outside a render pass, `depthView` in SHADER_READ_ONLY: builds the
+ * pyramid, then re-tests the early rejects with `viewProj` */
+void
+cringedOcclusionRecordLate ( CringedOcclusion * occlusion,
+                             VkCommandBuffer    commandBuffer,
+                             VkImageView        depthView,
+                             mat4               viewProj,
+                             uint32_t           candidateOffset,
+                             uint32_t           count );
+
+/* Pyramid and pipelines exist: the passes can be declared. NULL-safe. */
+static inline uint8_t
+cringedOcclusionReady ( const CringedOcclusion * occlusion )
+{
+    return occlusion && occlusion->image != VK_NULL_HANDLE;
+}
+
+/* Offset of a phase's draw command for `level` in `commands` */
+static inline VkDeviceSize
+cringedOcclusionDrawOffset ( uint32_t phase, uint32_t level )
+{
+    return ( phase * CRINGED_LOD_MAX + level ) *
+           sizeof ( VkDrawIndirectCommand );
+}
+
+#endif /* CRINGED_OCCLUSION_H */
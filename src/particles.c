@@ -0,0 +1,594 @@
+#include "particles.h"
+
+CringedParticles *
+cringedCreateParticles ( uint32_t capacity, uint32_t limit )
+{
+    CringedParticles * particles =
+        ( CringedParticles * ) calloc ( 1, sizeof ( CringedParticles ) );
+    if ( particles == NULL ) return NULL;
+
+    particles->capacity = capacity;
+    particles->limit    = limit < capacity ? limit : capacity;
+    particles->speed    = 1.2f;
+    particles->spread   = 0.6f;
+    particles->lifetime = 1.5f;
+    particles->size     = 0.004f;
+    particles->emitRate = ( uint32_t ) ( particles->limit /
+                                         particles->lifetime );
+    /* NOTE: NDC under the identity camera, +y is down */
+    glm_vec3_copy ( ( vec3 ) { 0.0f, 0.6f, 0.5f }, particles->emitter );
+    glm_vec3_copy ( ( vec3 ) { 0.0f, 1.6f, 0.0f }, particles->gravity );
+    return particles;
+}
+
+void
+cringedDestroyParticles ( CringedParticles * particles )
+{
+    free ( particles );
+}
+
+/* =============================================
+ *            RESOURCES
+ * ============================================= */
+
+static VkResult
+createSets ( CringedParticles * particles )
+{
+    VkResult opResult;
+    VkDevice device = particles->device;
+
+    VkDescriptorSetLayoutBinding bindings[ 3 ] = {};
+    for ( uint32_t b = 0; b < 3; b++ )
+    {
+        bindings[ b ].binding         = b;
+        bindings[ b ].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[ b ].descriptorCount = 1;
+        bindings[ b ].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 3; /* source, target, counters */
+    layoutInfo.pBindings    = bindings;
+    if ( ( opResult = vkCreateDescriptorSetLayout (
+               device, &layoutInfo, NULL, &particles->computeSetLayout ) ) !=
+         VK_SUCCESS )
+        return opResult;
+
+    bindings[ 0 ].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    layoutInfo.bindingCount  = 1; /* particles drawn */
+    if ( ( opResult = vkCreateDescriptorSetLayout (
+               device, &layoutInfo, NULL, &particles->drawSetLayout ) ) !=
+         VK_SUCCESS )
+        return opResult;
+
+    VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                      2 * 3 + 2 };
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets       = 4;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes    = &poolSize;
+    if ( ( opResult = vkCreateDescriptorPool (
+               device, &poolInfo, NULL, &particles->descriptorPool ) ) !=
+         VK_SUCCESS )
+        return opResult;
+
+    VkDescriptorSetLayout layouts[ 4 ] = { particles->computeSetLayout,
+                                           particles->computeSetLayout,
+                                           particles->drawSetLayout,
+                                           particles->drawSetLayout };
+    VkDescriptorSet       sets[ 4 ];
+    VkDescriptorSetAllocateInfo setInfo = {};
+    setInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setInfo.descriptorPool     = particles->descriptorPool;
+    setInfo.descriptorSetCount = 4;
+    setInfo.pSetLayouts        = layouts;
+    if ( ( opResult = vkAllocateDescriptorSets ( device, &setInfo, sets ) ) !=
+         VK_SUCCESS )
+        return opResult;
+
+    VkDescriptorBufferInfo buffers[ 3 ] = {
+        { particles->states[ 0 ].buffer, 0, VK_WHOLE_SIZE },
+        { particles->states[ 1 ].buffer, 0, VK_WHOLE_SIZE },
+        { particles->counters.buffer, 0, VK_WHOLE_SIZE },
+    };
+    VkWriteDescriptorSet writes[ 8 ] = {};
+    uint32_t             writeCount  = 0;
+    for ( uint32_t s = 0; s < 2; s++ )
+    {
+        particles->computeSets[ s ] = sets[ s ];
+        particles->drawSets[ s ]    = sets[ 2 + s ];
+
+        /* Compute set `s` simulates from state `s` into the other */
+        const VkDescriptorBufferInfo * order[ 3 ] = {
+            &buffers[ s ], &buffers[ 1 - s ], &buffers[ 2 ] };
+        for ( uint32_t b = 0; b < 3; b++ )
+        {
+            VkWriteDescriptorSet * w = &writes[ writeCount++ ];
+            w->sType                 = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            w->dstSet                = sets[ s ];
+            w->dstBinding            = b;
+            w->descriptorCount       = 1;
+            w->descriptorType        = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            w->pBufferInfo           = order[ b ];
+        }
+        VkWriteDescriptorSet * w = &writes[ writeCount++ ];
+        w->sType                 = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        w->dstSet                = sets[ 2 + s ];
+        w->dstBinding            = 0;
+        w->descriptorCount       = 1;
+        w->descriptorType        = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        w->pBufferInfo           = &buffers[ s ];
+    }
+    vkUpdateDescriptorSets ( device, writeCount, writes, 0, NULL );
+    return VK_SUCCESS;
+}
+
+static VkResult
+createPipelines ( CringedParticles *           particles,
+                  VkFormat                     colorFormat,
+                  VkFormat                     depthFormat,
+                  VkRenderPass                 renderPass,
+                  const CringedShaderArchive * shaders )
+{
+    VkResult       opResult, rcode = VK_INCOMPLETE;
+    VkDevice       device = particles->device;
+    VkShaderModule comp = VK_NULL_HANDLE, vert = VK_NULL_HANDLE,
+                   frag = VK_NULL_HANDLE;
+
+    if ( ( opResult = cringedArchiveModule (
+               shaders, device, "Particles_comp", &comp ) ) != VK_SUCCESS ||
+         ( opResult = cringedArchiveModule (
+               shaders, device, "Particles_vert", &vert ) ) != VK_SUCCESS ||
+         ( opResult = cringedArchiveModule (
+               shaders, device, "Particles_frag", &frag ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: particle shader modules: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    /* Simulation */
+    VkPushConstantRange simRange = { VK_SHADER_STAGE_COMPUTE_BIT,
+                                     0,
+                                     sizeof ( CringedParticleSimulation ) };
+    VkPipelineLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount         = 1;
+    layoutInfo.pSetLayouts            = &particles->computeSetLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges    = &simRange;
+    if ( ( opResult = vkCreatePipelineLayout (
+               device, &layoutInfo, NULL, &particles->computeLayout ) ) !=
+         VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: particle compute layout: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    VkComputePipelineCreateInfo computeInfo = {};
+    computeInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    computeInfo.stage.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    computeInfo.stage.stage       = VK_SHADER_STAGE_COMPUTE_BIT;
+    computeInfo.stage.module      = comp;
+    computeInfo.stage.pName       = "main";
+    computeInfo.layout            = particles->computeLayout;
+    computeInfo.basePipelineIndex = -1;
+    if ( ( opResult = vkCreateComputePipelines (
+               device,
+               VK_NULL_HANDLE,
+               1,
+               &computeInfo,
+               NULL,
+               &particles->computePipeline ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: particle compute pipeline: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    /* Draw: no vertex input, quads come from the instance and vertex ids */
+    VkPushConstantRange cameraRange = { VK_SHADER_STAGE_VERTEX_BIT,
+                                        0,
+                                        sizeof ( CringedParticleCamera ) };
+    layoutInfo.pSetLayouts          = &particles->drawSetLayout;
+    layoutInfo.pPushConstantRanges  = &cameraRange;
+    if ( ( opResult = vkCreatePipelineLayout (
+               device, &layoutInfo, NULL, &particles->drawLayout ) ) !=
+         VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: particle draw layout: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    VkPipelineShaderStageCreateInfo stages[ 2 ] = {};
+    stages[ 0 ].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[ 0 ].stage  = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[ 0 ].module = vert;
+    stages[ 0 ].pName  = "main";
+    stages[ 1 ].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[ 1 ].stage  = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[ 1 ].module = frag;
+    stages[ 1 ].pName  = "main";
+
+    VkPipelineVertexInputStateCreateInfo vertexInput = {};
+    vertexInput.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+    inputAssembly.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT,
+                                       VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicState = {};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 2;
+    dynamicState.pDynamicStates    = dynamicStates;
+
+    VkPipelineViewportStateCreateInfo viewportState = {};
+    viewportState.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount  = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer = {};
+    rasterizer.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.cullMode    = VK_CULL_MODE_NONE;
+    rasterizer.frontFace   = VK_FRONT_FACE_CLOCKWISE;
+    rasterizer.lineWidth   = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisampling = {};
+    multisampling.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampling.minSampleShading     = 1.0f;
+
+    /* Occluded by the scene, but additive: no depth writes, no sorting */
+    VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+    depthStencil.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable  = VK_TRUE;
+    depthStencil.depthWriteEnable = VK_FALSE;
+    depthStencil.depthCompareOp   = VK_COMPARE_OP_LESS_OR_EQUAL;
+    depthStencil.maxDepthBounds   = 1.0f;
+
+    VkPipelineColorBlendAttachmentState blend = {};
+    blend.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                           VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    blend.blendEnable         = VK_TRUE;
+    blend.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    blend.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    blend.colorBlendOp        = VK_BLEND_OP_ADD;
+    blend.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    blend.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    blend.alphaBlendOp        = VK_BLEND_OP_ADD;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending = {};
+    colorBlending.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments    = &blend;
+
+    VkPipelineRenderingCreateInfo renderingInfo = {};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+    renderingInfo.colorAttachmentCount    = 1;
+    renderingInfo.pColorAttachmentFormats = &colorFormat;
+    renderingInfo.depthAttachmentFormat   = depthFormat;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType      = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext      = renderPass ? NULL : &renderingInfo;
+    pipelineInfo.stageCount = 2;
+    pipelineInfo.pStages    = stages;
+    pipelineInfo.pVertexInputState   = &vertexInput;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState      = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState   = &multisampling;
+    pipelineInfo.pDepthStencilState  = &depthStencil;
+    pipelineInfo.pColorBlendState    = &colorBlending;
+    pipelineInfo.pDynamicState       = &dynamicState;
+    pipelineInfo.layout              = particles->drawLayout;
+    pipelineInfo.renderPass          = renderPass;
+    pipelineInfo.basePipelineIndex   = -1;
+    if ( ( opResult = vkCreateGraphicsPipelines (
+               device,
+               VK_NULL_HANDLE,
+               1,
+               &pipelineInfo,
+               NULL,
+               &particles->drawPipeline ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: particle draw pipeline: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    rcode = VK_SUCCESS;
+
+defer_cleanup:
+    if ( comp ) vkDestroyShaderModule ( device, comp, NULL );
+    if ( vert ) vkDestroyShaderModule ( device, vert, NULL );
+    if ( frag ) vkDestroyShaderModule ( device, frag, NULL );
+    return rcode;
+}
+
+VkResult
+cringedParticlesCreateResources ( CringedParticles *           particles,
+                                  VkPhysicalDevice             physicalDevice,
+                                  VkDevice                     device,
+                                  VkFormat                     colorFormat,
+                                  VkFormat                     depthFormat,
+                                  VkRenderPass                 renderPass,
+                                  const CringedShaderArchive * shaders )
+{
+    VkResult opResult, rcode = VK_INCOMPLETE;
+    particles->device        = device;
+    particles->countersReady = 0;
+    particles->source        = 0;
+
+    for ( uint32_t s = 0; s < 2; s++ )
+        if ( ( opResult = cringedCreateBuffer ( //
+                   physicalDevice,
+                   device,
+                   ( VkDeviceSize ) particles->capacity *
+                       sizeof ( CringedParticle ),
+                   VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                   &particles->states[ s ] ) ) != VK_SUCCESS )
+        {
+            _DEBUG_P ( "error: particle state buffer: %d\n", opResult );
+            goto defer_cleanup;
+        }
+    if ( ( opResult = cringedCreateBuffer ( //
+               physicalDevice,
+               device,
+               2 * sizeof ( VkDrawIndirectCommand ),
+               VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                   VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                   VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+               &particles->counters ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: particle counter buffer: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    if ( ( opResult = createSets ( particles ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: particle descriptors: %d\n", opResult );
+        goto defer_cleanup;
+    }
+    if ( ( opResult = createPipelines ( //
+               particles,
+               colorFormat,
+               depthFormat,
+               renderPass,
+               shaders ) ) != VK_SUCCESS )
+        goto defer_cleanup;
+
+    rcode = VK_SUCCESS;
+
+defer_cleanup:
+    if ( rcode ) cringedParticlesDestroyResources ( particles );
+    return rcode;
+}
+
+void
+cringedParticlesDestroyResources ( CringedParticles * particles )
+{
+    VkDevice device = particles->device;
+    if ( device == VK_NULL_HANDLE ) return;
+
+    if ( particles->computePipeline )
+        vkDestroyPipeline ( device, particles->computePipeline, NULL );
+    if ( particles->drawPipeline )
+        vkDestroyPipeline ( device, particles->drawPipeline, NULL );
+    if ( particles->computeLayout )
+        vkDestroyPipelineLayout ( device, particles->computeLayout, NULL );
+    if ( particles->drawLayout )
+        vkDestroyPipelineLayout ( device, particles->drawLayout, NULL );
+    if ( particles->descriptorPool ) /* frees the sets */
+        vkDestroyDescriptorPool ( device, particles->descriptorPool, NULL );
+    if ( particles->computeSetLayout )
+        vkDestroyDescriptorSetLayout (
+            device, particles->computeSetLayout, NULL );
+    if ( particles->drawSetLayout )
+        vkDestroyDescriptorSetLayout ( device, particles->drawSetLayout, NULL );
+    particles->computePipeline  = VK_NULL_HANDLE;
+    particles->drawPipeline     = VK_NULL_HANDLE;
+    particles->computeLayout    = VK_NULL_HANDLE;
+    particles->drawLayout       = VK_NULL_HANDLE;
+    particles->descriptorPool   = VK_NULL_HANDLE;
+    particles->computeSetLayout = VK_NULL_HANDLE;
+    particles->drawSetLayout    = VK_NULL_HANDLE;
+    cringedDestroyBuffer ( device, &particles->states[ 0 ] );
+    cringedDestroyBuffer ( device, &particles->states[ 1 ] );
+    cringedDestroyBuffer ( device, &particles->counters );
+    particles->device = VK_NULL_HANDLE;
+}
+
+/* =============================================
+ *            FRAME
+ * ============================================= */
+
+static void
+memoryBarrier ( VkCommandBuffer      commandBuffer,
+                VkPipelineStageFlags srcStages,
+                VkAccessFlags        srcAccess,
+                VkPipelineStageFlags dstStages,
+                VkAccessFlags        dstAccess )
+{
+    VkMemoryBarrier barrier = {};
+    barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask   = srcAccess;
+    barrier.dstAccessMask   = dstAccess;
+    vkCmdPipelineBarrier ( commandBuffer,
+                           srcStages,
+                           dstStages,
+                           0,
+                           1,
+                           &barrier,
+                           0,
+                           NULL,
+                           0,
+                           NULL );
+}
+
+void
+cringedParticlesRecordSimulate ( CringedParticles * particles,
+                                 VkCommandBuffer    commandBuffer,
+                                 float              dt )
+{
+    if ( particles->device == VK_NULL_HANDLE ) return;
+
+    uint32_t source = particles->source, target = 1 - source;
+    if ( ! particles->countersReady )
+    {
+        /* Both buffers empty, quads of 6 vertices */
+        VkDrawIndirectCommand commands[ 2 ] = { { 6, 0, 0, 0 },
+                                                { 6, 0, 0, 0 } };
+        vkCmdUpdateBuffer ( commandBuffer,
+                            particles->counters.buffer,
+                            0,
+                            sizeof ( commands ),
+                            commands );
+        particles->countersReady = 1;
+    }
+
+    /* Last frame's step wrote `source` and may still be drawing from it;
+     * `target` was read by that step, its count by an older draw */
+    memoryBarrier ( commandBuffer,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT |
+                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                    VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT |
+                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT |
+                        VK_ACCESS_SHADER_WRITE_BIT );
+    vkCmdFillBuffer ( commandBuffer,
+                      particles->counters.buffer,
+                      target * sizeof ( VkDrawIndirectCommand ) +
+                          offsetof ( VkDrawIndirectCommand, instanceCount ),
+                      sizeof ( uint32_t ),
+                      0 );
+    memoryBarrier ( commandBuffer,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_ACCESS_TRANSFER_WRITE_BIT,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT );
+
+    if ( dt > CRINGED_PARTICLE_MAX_DT ) dt = CRINGED_PARTICLE_MAX_DT;
+    uint32_t emit = particles->limit;
+    if ( particles->emitRate )
+    {
+        particles->emitCarry += particles->emitRate * dt;
+        emit = ( uint32_t ) particles->emitCarry;
+        particles->emitCarry -= ( float ) emit;
+    }
+
+    CringedParticleSimulation sim = {};
+    glm_vec3_copy ( particles->emitter, sim.emitter );
+    sim.emitter[ 3 ] = particles->speed;
+    glm_vec3_copy ( particles->gravity, sim.gravity );
+    sim.gravity[ 3 ] = dt;
+    sim.counts[ 0 ]  = emit;
+    sim.counts[ 1 ]  = particles->limit;
+    sim.counts[ 2 ]  = ++particles->step * 0x9E3779B9u;
+    sim.counts[ 3 ]  = source;
+    sim.params[ 0 ]  = particles->lifetime;
+    sim.params[ 1 ]  = particles->spread;
+
+    vkCmdBindPipeline ( commandBuffer,
+                        VK_PIPELINE_BIND_POINT_COMPUTE,
+                        particles->computePipeline );
+    vkCmdBindDescriptorSets ( commandBuffer,
+                              VK_PIPELINE_BIND_POINT_COMPUTE,
+                              particles->computeLayout,
+                              0,
+                              1,
+                              &particles->computeSets[ source ],
+                              0,
+                              NULL );
+    vkCmdPushConstants ( commandBuffer,
+                         particles->computeLayout,
+                         VK_SHADER_STAGE_COMPUTE_BIT,
+                         0,
+                         sizeof ( sim ),
+                         &sim );
+    /* Survivors are at most `limit`, emitted ones fill up to it */
+    vkCmdDispatch ( commandBuffer,
+                    ( particles->limit + CRINGED_PARTICLE_GROUP - 1 ) /
+                        CRINGED_PARTICLE_GROUP,
+                    1,
+                    1 );
+
+    memoryBarrier ( commandBuffer,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    VK_ACCESS_SHADER_WRITE_BIT,
+                    VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                    VK_ACCESS_INDIRECT_COMMAND_READ_BIT |
+                        VK_ACCESS_SHADER_READ_BIT );
+    particles->source = target;
+}
+
+void
+cringedParticlesRecordDraw ( CringedParticles * particles,
+                             VkCommandBuffer    commandBuffer,
+                             mat4               view,
+                             mat4               proj,
+                             VkExtent2D         extent )
+{
+    if ( particles->device == VK_NULL_HANDLE || ! particles->countersReady )
+        return;
+
+    /* Billboards: the view matrix rows are the camera axes in world */
+    CringedParticleCamera camera;
+    glm_mat4_mul ( proj, view, camera.viewProj );
+    camera.right[ 0 ] = view[ 0 ][ 0 ];
+    camera.right[ 1 ] = view[ 1 ][ 0 ];
+    camera.right[ 2 ] = view[ 2 ][ 0 ];
+    camera.right[ 3 ] = particles->size;
+    camera.up[ 0 ]    = view[ 0 ][ 1 ];
+    camera.up[ 1 ]    = view[ 1 ][ 1 ];
+    camera.up[ 2 ]    = view[ 2 ][ 1 ];
+    camera.up[ 3 ]    = 0.0f;
+
+    VkViewport viewport = {};
+    viewport.width      = ( float ) extent.width;
+    viewport.height     = ( float ) extent.height;
+    viewport.maxDepth   = 1.0f;
+    VkRect2D scissor    = {};
+    scissor.extent      = extent;
+    vkCmdSetViewport ( commandBuffer, 0, 1, &viewport );
+    vkCmdSetScissor ( commandBuffer, 0, 1, &scissor );
+
+    vkCmdBindPipeline ( commandBuffer,
+                        VK_PIPELINE_BIND_POINT_GRAPHICS,
+                        particles->drawPipeline );
+    vkCmdBindDescriptorSets ( commandBuffer,
+                              VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              particles->drawLayout,
+                              0,
+                              1,
+                              &particles->drawSets[ particles->source ],
+                              0,
+                              NULL );
+    vkCmdPushConstants ( commandBuffer,
+                         particles->drawLayout,
+                         VK_SHADER_STAGE_VERTEX_BIT,
+                         0,
+                         sizeof ( camera ),
+                         &camera );
+    /* The instance count was written by the step, never read back */
+    vkCmdDrawIndirect ( commandBuffer,
+                        particles->counters.buffer,
+                        particles->source * sizeof ( VkDrawIndirectCommand ),
+                        1,
+                        sizeof ( VkDrawIndirectCommand ) );
+}
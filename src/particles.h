@@ -0,0 +1,123 @@
+#pragma once
+#ifndef CRINGED_PARTICLES_H
+#define CRINGED_PARTICLES_H
+
+#include "bufferUtils.h"
+#include "shaderUtils.h"
+
+#include <cglm/cglm.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vulkan/vulkan.h>
+
+#ifndef NDEBUG
+#define _DEBUG_P( ... ) printf ( __VA_ARGS__ )
+#else
+#define _DEBUG_P( ... ) ( ( void ) 0 )
+#endif
+
+#define CRINGED_PARTICLE_GROUP  256  /* compute local size */
+#define CRINGED_PARTICLE_MAX_DT 0.1f /* seconds, clamps hitches */
+
+/* std430, as the shaders read it */
+typedef struct
+{
+    vec4 positionAge;  /* xyz: position, w: age in seconds */
+    vec4 velocityLife; /* xyz: velocity, w: lifetime in seconds */
+} CringedParticle;
+
+/* Particles_comp push constants */
+typedef struct
+{
+    vec4     emitter; /* xyz: position, w: speed */
+    vec4     gravity; /* xyz: acceleration, w: delta seconds */
+    uint32_t counts[ 4 ]; /* emit, limit, seed, source buffer */
+    vec4     params;      /* x: lifetime, y: spread */
+} CringedParticleSimulation;
+
+/* Particles_vert push constants */
+typedef struct
+{
+    mat4 viewProj;
+    vec4 right; /* w: half size */
+    vec4 up;
+} CringedParticleCamera;
+
+/* State lives on the device only, in two storage buffers used ping-pong:
+ * each frame a compute pass ages and moves the particles of one, emits,
+ * and appends the survivors compacted to the other, counting them into
+ * that buffer's indirect draw command. The draw is one instanced quad per
+ * live particle from the new buffer; the CPU never sees the count, it
+ * only fills push constants. */
+typedef struct
+{
+    uint32_t capacity;
+    uint32_t limit;     /* live particles at most, <= capacity */
+    uint32_t emitRate;  /* per second; 0: refill to `limit` every frame */
+    float    emitCarry; /* fractional particles of the last frames */
+    uint32_t source;    /* buffer simulated from next */
+    uint32_t step;      /* seeds the emitter */
+    vec3     emitter;
+    vec3     gravity;
+    float    speed;
+    float    spread;
+    float    lifetime;
+    float    size;
+    /* GPU */
+    VkDevice              device;
+    BasedBuffer           states[ 2 ];
+    BasedBuffer           counters; /* VkDrawIndirectCommand per state */
+    uint8_t               countersReady;
+    VkDescriptorSetLayout computeSetLayout;
+    VkDescriptorSetLayout drawSetLayout;
+    VkDescriptorPool      descriptorPool;
+    VkDescriptorSet       computeSets[ 2 ]; /* by source buffer */
+    VkDescriptorSet       drawSets[ 2 ];    /* by buffer drawn */
+    VkPipelineLayout      computeLayout;
+    VkPipelineLayout      drawLayout;
+    VkPipeline            computePipeline;
+    VkPipeline            drawPipeline;
+} CringedParticles;
+
+/* A fountain at `emitter` for the identity camera; steady state of about
+ * `limit` live particles */
+CringedParticles *
+cringedCreateParticles ( uint32_t capacity, uint32_t limit );
+
+/* GPU resources must have been destroyed */
+void
+cringedDestroyParticles ( CringedParticles * particles );
+
+/* Buffers and pipelines; the draw pipeline is compatible with
+ * `renderPass` or, when it is NULL, dynamic rendering on the formats */
+VkResult
+cringedParticlesCreateResources ( CringedParticles *           particles,
+                                  VkPhysicalDevice             physicalDevice,
+                                  VkDevice                     device,
+                                  VkFormat                     colorFormat,
+                                  VkFormat                     depthFormat,
+                                  VkRenderPass                 renderPass,
+                                  const CringedShaderArchive * shaders );
+
+/* The device must be idle */
+void
+cringedParticlesDestroyResources ( CringedParticles * particles );
+
+/* Outside a render pass: one simulation step of `dt` seconds, then
+ * flips the buffers */
+void
+cringedParticlesRecordSimulate ( CringedParticles * particles,
+                                 VkCommandBuffer    commandBuffer,
+                                 float              dt );
+
+/* Inside the color pass: draws what the last step produced */
+void
+cringedParticlesRecordDraw ( CringedParticles * particles,
+                             VkCommandBuffer    commandBuffer,
+                             mat4               view,
+                             mat4               proj,
+                             VkExtent2D         extent );
+
+#endif /* CRINGED_PARTICLES_H */
@@ -0,0 +1,1317 @@
+#include "renderGraph.h"
+
+#ifndef NDEBUG
+#define _DEBUG_P( ... ) printf ( __VA_ARGS__ )
+#else
+#define _DEBUG_P( ... ) ( ( void ) 0 )
+#endif
+
+typedef struct
+{
+    VkPipelineStageFlags stage;
+    VkAccessFlags        access;
+    VkImageLayout        layout;
+    VkImageUsageFlags    imageUsage;
+    uint8_t              write;
+    uint8_t              attachment;
+} UsageInfo;
+
+static const UsageInfo usageInfo[ CRINGED_USAGE_COUNT ] = {
+    [CRINGED_USAGE_COLOR_WRITE] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                    VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+                                        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                                    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                                    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+                                    1,
+                                    1 },
+    [CRINGED_USAGE_DEPTH_WRITE] =
+        { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+              VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+          VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+              VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+          VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+          VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+          1,
+          1 },
+    [CRINGED_USAGE_DEPTH_READ] =
+        { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+              VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+          VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+          VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+          VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+          0,
+          1 },
+    [CRINGED_USAGE_SAMPLED] = { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                VK_ACCESS_SHADER_READ_BIT,
+                                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                VK_IMAGE_USAGE_SAMPLED_BIT,
+                                0,
+                                0 },
+    [CRINGED_USAGE_VERTEX_READ] = { VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                                    VK_ACCESS_SHADER_READ_BIT,
+                                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                    VK_IMAGE_USAGE_SAMPLED_BIT,
+                                    0,
+                                    0 },
+    [CRINGED_USAGE_STORAGE_READ] = { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                     VK_ACCESS_SHADER_READ_BIT,
+                                     VK_IMAGE_LAYOUT_GENERAL,
+                                     VK_IMAGE_USAGE_STORAGE_BIT,
+                                     0,
+                                     0 },
+    [CRINGED_USAGE_STORAGE_WRITE] = { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                      VK_ACCESS_SHADER_READ_BIT |
+                                          VK_ACCESS_SHADER_WRITE_BIT,
+                                      VK_IMAGE_LAYOUT_GENERAL,
+                                      VK_IMAGE_USAGE_STORAGE_BIT,
+                                      1,
+                                      0 },
+    [CRINGED_USAGE_INDIRECT_READ] = { VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                                      VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+                                      VK_IMAGE_LAYOUT_UNDEFINED,
+                                      0,
+                                      0,
+                                      0 },
+    [CRINGED_USAGE_TRANSFER_SRC] = { VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                     VK_ACCESS_TRANSFER_READ_BIT,
+                                     VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                     VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                                     0,
+                                     0 },
+    [CRINGED_USAGE_TRANSFER_DST] = { VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                     VK_ACCESS_TRANSFER_WRITE_BIT,
+                                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                     VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                                     1,
+                                     0 },
+    [CRINGED_USAGE_PRESENT] = { VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                0,
+                                VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                                0,
+                                0,
+                                0 },
+};
+
+static const VkAccessFlags writeAccessMask =
+    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT |
+    VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT |
+    VK_ACCESS_MEMORY_WRITE_BIT;
+
+/* Per-resource hazard tracking while the schedule is compiled */
+typedef struct
+{
+    VkImageLayout        layout;
+    VkPipelineStageFlags writeStage; /* last write or layout transition */
+    VkAccessFlags        writeAccess;
+    VkPipelineStageFlags readStages; /* reads since the last write */
+    VkPipelineStageFlags visibleStages;
+    VkAccessFlags        visibleAccess;
+    uint8_t              touched;
+} TrackState;
+
+static VkImageAspectFlags
+aspectOfFormat ( VkFormat format )
+{
+    switch ( format )
+    {
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_X8_D24_UNORM_PACK32:
+        case VK_FORMAT_D32_SFLOAT: return VK_IMAGE_ASPECT_DEPTH_BIT;
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+        default: return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+}
+
+static uint64_t
+hashBytes ( uint64_t hash, const void * data, size_t size )
+{
+    /* FNV-1a */
+    const uint8_t * bytes = ( const uint8_t * ) data;
+    for ( size_t i = 0; i < size; i++ )
+    {
+        hash ^= bytes[ i ];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static VkAttachmentLoadOp
+loadOpOf ( const CringedGraphAccess * access )
+{
+    switch ( access->load )
+    {
+        case CRINGED_LOAD_CLEAR: return VK_ATTACHMENT_LOAD_OP_CLEAR;
+        case CRINGED_LOAD_KEEP: return VK_ATTACHMENT_LOAD_OP_LOAD;
+        default: return VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    }
+}
+
+static VkAttachmentStoreOp
+storeOpOf ( const CringedGraphAccess * access )
+{
+    return access->store ? VK_ATTACHMENT_STORE_OP_STORE
+                         : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+}
+
+/* =============================================
+ *            DECLARATION
+ * ============================================= */
+
+CringedRenderGraph *
+cringedCreateRenderGraph ( CringedDeletionQueue * deletions )
+{
+    CringedRenderGraph * graph =
+        ( CringedRenderGraph * ) calloc ( 1, sizeof ( CringedRenderGraph ) );
+    if ( graph ) graph->deletions = deletions;
+    return graph;
+}
+
+void
+cringedDestroyRenderGraph ( CringedRenderGraph * graph )
+{
+    if ( ! graph ) return;
+    cringedGraphRelease ( graph );
+    free ( graph );
+}
+
+void
+cringedGraphReset ( CringedRenderGraph * graph )
+{
+    graph->passCount     = 0;
+    graph->resourceCount = 0;
+    graph->invalid       = 0;
+}
+
+static uint32_t
+addResource ( CringedRenderGraph * graph, const char * name )
+{
+    if ( graph->resourceCount >= CRINGED_GRAPH_MAX_RESOURCES )
+    {
+        _DEBUG_P ( "error: render graph resource limit at '%s'\n", name );
+        graph->invalid = 1;
+        return CRINGED_GRAPH_NONE;
+    }
+    uint32_t               idx = graph->resourceCount++;
+    CringedGraphResource * res = &graph->resources[ idx ];
+    memset ( res, 0, sizeof ( *res ) );
+    res->name       = name;
+    res->finalUsage = CRINGED_GRAPH_NONE;
+    return idx;
+}
+
+uint32_t
+cringedGraphImportImage ( CringedRenderGraph *      graph,
+                          const char *              name,
+                          VkImage                   image,
+                          VkImageView               view,
+                          VkFormat                  format,
+                          VkExtent2D                extent,
+                          const CringedGraphState * initial,
+                          uint32_t                  finalUsage )
+{
+    uint32_t idx = addResource ( graph, name );
+    if ( idx == CRINGED_GRAPH_NONE ) return idx;
+
+    CringedGraphResource * res = &graph->resources[ idx ];
+    res->imported              = 1;
+    res->image                 = image;
+    res->view                  = view;
+    res->format                = format;
+    res->extent                = extent;
+    res->aspect                = aspectOfFormat ( format );
+    res->initial               = *initial;
+    res->finalUsage            = finalUsage;
+    return idx;
+}
+
+uint32_t
+cringedGraphImportBuffer ( CringedRenderGraph *      graph,
+                           const char *              name,
+                           VkBuffer                  buffer,
+                           const CringedGraphState * initial,
+                           uint32_t                  finalUsage )
+{
+    uint32_t idx = addResource ( graph, name );
+    if ( idx == CRINGED_GRAPH_NONE ) return idx;
+
+    CringedGraphResource * res = &graph->resources[ idx ];
+    res->imported              = 1;
+    res->isBuffer              = 1;
+    res->buffer                = buffer;
+    res->initial               = *initial;
+    res->finalUsage            = finalUsage;
+    return idx;
+}
+
+uint32_t
+cringedGraphCreateImage ( CringedRenderGraph * graph,
+                          const char *         name,
+                          VkFormat             format,
+                          VkExtent2D           extent )
+{
+    uint32_t idx = addResource ( graph, name );
+    if ( idx == CRINGED_GRAPH_NONE ) return idx;
+
+    CringedGraphResource * res = &graph->resources[ idx ];
+    res->format                = format;
+    res->extent                = extent;
+    res->aspect                = aspectOfFormat ( format );
+    return idx;
+}
+
+uint32_t
+cringedGraphAddPass ( CringedRenderGraph * graph,
+                      const char *         name,
+                      CringedGraphRecord   record,
+                      void *               userData )
+{
+    if ( graph->passCount >= CRINGED_GRAPH_MAX_PASSES )
+    {
+        _DEBUG_P ( "error: render graph pass limit at '%s'\n", name );
+        graph->invalid = 1;
+        return CRINGED_GRAPH_NONE;
+    }
+    uint32_t           idx  = graph->passCount++;
+    CringedGraphPass * pass = &graph->passes[ idx ];
+    memset ( pass, 0, sizeof ( *pass ) );
+    pass->name     = name;
+    pass->record   = record;
+    pass->userData = userData;
+    return idx;
+}
+
+static void
+addAccess ( CringedRenderGraph * graph,
+            uint32_t             pass,
+            uint32_t             resource,
+            CringedGraphUsage    usage,
+            CringedGraphLoad     load,
+            const VkClearValue * clear )
+{
+    if ( pass >= graph->passCount || resource >= graph->resourceCount )
+    {
+        graph->invalid = 1;
+        return;
+    }
+    CringedGraphPass * p = &graph->passes[ pass ];
+    for ( uint32_t a = 0; a < p->accessCount; a++ )
+        if ( p->accesses[ a ].resource == resource )
+        {
+            _DEBUG_P ( "error: pass '%s' declares '%s' twice\n",
+                       p->name,
+                       graph->resources[ resource ].name );
+            graph->invalid = 1;
+            return;
+        }
+    if ( p->accessCount >= CRINGED_GRAPH_MAX_ACCESSES )
+    {
+        _DEBUG_P ( "error: pass '%s' access limit\n", p->name );
+        graph->invalid = 1;
+        return;
+    }
+
+    CringedGraphAccess * access = &p->accesses[ p->accessCount++ ];
+    memset ( access, 0, sizeof ( *access ) );
+    access->resource = resource;
+    access->usage    = usage;
+    access->load     = load;
+    if ( clear ) access->clear = *clear;
+    graph->resources[ resource ].usage |= usageInfo[ usage ].imageUsage;
+}
+
+void
+cringedGraphRead ( CringedRenderGraph * graph,
+                   uint32_t             pass,
+                   uint32_t             resource,
+                   CringedGraphUsage    usage )
+{
+    addAccess ( graph, pass, resource, usage, CRINGED_LOAD_KEEP, NULL );
+}
+
+void
+cringedGraphWrite ( CringedRenderGraph * graph,
+                    uint32_t             pass,
+                    uint32_t             resource,
+                    CringedGraphUsage    usage,
+                    CringedGraphLoad     load,
+                    const VkClearValue * clear )
+{
+    addAccess ( graph, pass, resource, usage, load, clear );
+}
+
+VkImageView
+cringedGraphImageView ( const CringedRenderGraph * graph, uint32_t resource )
+{
+    return resource < graph->resourceCount
+               ? graph->resources[ resource ].view
+               : VK_NULL_HANDLE;
+}
+
+/* =============================================
+ *            PHYSICAL RESOURCES
+ * ============================================= */
+
+VkResult
+cringedGraphCreateRenderPass ( VkDevice                    device,
+                               uint32_t                    colorCount,
+                               const VkFormat *            colorFormats,
+                               VkFormat                    depthFormat,
+                               uint8_t                     depthReadOnly,
+                               const VkAttachmentLoadOp *  loadOps,
+                               const VkAttachmentStoreOp * storeOps,
+                               VkRenderPass *              renderPass )
+{
+    VkAttachmentDescription attachments[ CRINGED_GRAPH_MAX_ACCESSES ] = {};
+    VkAttachmentReference   colorRefs[ CRINGED_GRAPH_MAX_ACCESSES ]   = {};
+    VkAttachmentReference   depthRef                                  = {};
+    uint8_t  hasDepth = depthFormat != VK_FORMAT_UNDEFINED;
+    uint32_t count    = colorCount + hasDepth;
+    if ( count > CRINGED_GRAPH_MAX_ACCESSES )
+        return VK_ERROR_INITIALIZATION_FAILED;
+
+    for ( uint32_t i = 0; i < count; i++ )
+    {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        if ( i == colorCount )
+            layout = depthReadOnly
+                         ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+                         : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        attachments[ i ].format =
+            i < colorCount ? colorFormats[ i ] : depthFormat;
+        attachments[ i ].samples = VK_SAMPLE_COUNT_1_BIT;
+        attachments[ i ].loadOp =
+            loadOps ? loadOps[ i ] : VK_ATTACHMENT_LOAD_OP_CLEAR;
+        attachments[ i ].storeOp =
+            storeOps ? storeOps[ i ] : VK_ATTACHMENT_STORE_OP_STORE;
+        attachments[ i ].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachments[ i ].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        /* NOTE: no implicit transitions, the graph records them */
+        attachments[ i ].initialLayout = layout;
+        attachments[ i ].finalLayout   = layout;
+
+        if ( i < colorCount )
+        {
+            colorRefs[ i ].attachment = i;
+            colorRefs[ i ].layout     = layout;
+        }
+        else
+        {
+            depthRef.attachment = i;
+            depthRef.layout     = layout;
+        }
+    }
+
+    VkSubpassDescription subpass    = {};
+    subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount    = colorCount;
+    subpass.pColorAttachments       = colorRefs;
+    subpass.pDepthStencilAttachment = hasDepth ? &depthRef : NULL;
+
+    VkRenderPassCreateInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = count;
+    renderPassInfo.pAttachments    = attachments;
+    renderPassInfo.subpassCount    = 1;
+    renderPassInfo.pSubpasses      = &subpass;
+    renderPassInfo.dependencyCount = 0;
+    renderPassInfo.pDependencies   = NULL;
+
+    return vkCreateRenderPass ( device, &renderPassInfo, NULL, renderPass );
+}
+
+/* Deferred: frames in flight may still reference them */
+static void
+releaseFramebuffers ( CringedRenderGraph * graph )
+{
+    CringedGraphPhysical * phys = &graph->physical;
+    for ( uint32_t i = 0; i < phys->framebufferCount; i++ )
+    {
+        VkFramebuffer framebuffer = phys->framebuffers[ i ].framebuffer;
+        cringedDefer ( graph->deletions,
+                       ( CringedDeletion ) { CRINGED_DELETE_FRAMEBUFFER,
+                                             .framebuffer = framebuffer } );
+    }
+    phys->framebufferCount = 0;
+}
+
+static void
+releasePhysical ( CringedRenderGraph * graph )
+{
+    CringedGraphPhysical * phys = &graph->physical;
+    releaseFramebuffers ( graph );
+    for ( uint32_t p = 0; p < CRINGED_GRAPH_MAX_PASSES; p++ )
+        if ( phys->renderPasses[ p ] )
+            cringedDefer ( graph->deletions,
+                           ( CringedDeletion ) {
+                               CRINGED_DELETE_RENDER_PASS,
+                               .renderPass = phys->renderPasses[ p ] } );
+    for ( uint32_t r = 0; r < CRINGED_GRAPH_MAX_RESOURCES; r++ )
+    {
+        if ( phys->transientViews[ r ] )
+            cringedDefer ( graph->deletions,
+                           ( CringedDeletion ) {
+                               CRINGED_DELETE_IMAGE_VIEW,
+                               .imageView = phys->transientViews[ r ] } );
+        if ( phys->transientImages[ r ] )
+            cringedDefer ( graph->deletions,
+                           ( CringedDeletion ) {
+                               CRINGED_DELETE_IMAGE,
+                               .image = phys->transientImages[ r ] } );
+    }
+    /* NOTE: after the images bound to them */
+    for ( uint32_t b = 0; b < phys->blockCount; b++ )
+        cringedDefer ( graph->deletions,
+                       ( CringedDeletion ) {
+                           CRINGED_DELETE_MEMORY,
+                           .memory = phys->blocks[ b ].memory } );
+    memset ( phys, 0, sizeof ( *phys ) );
+}
+
+void
+cringedGraphRelease ( CringedRenderGraph * graph )
+{
+    releasePhysical ( graph );
+    graph->builtHash = 0;
+}
+
+/* Creates transient images, places them into as few memory blocks as
+ * their lifetimes allow, then creates views and render passes */
+static VkResult
+buildPhysical ( CringedRenderGraph * graph,
+                VkPhysicalDevice     physicalDevice,
+                VkDevice             device )
+{
+    VkResult opResult;
+    graph->device         = device;
+    graph->transientBytes = 0;
+    graph->aliasedBytes   = 0;
+
+    uint32_t             order[ CRINGED_GRAPH_MAX_RESOURCES ];
+    uint32_t             transientCount = 0;
+    VkMemoryRequirements reqs[ CRINGED_GRAPH_MAX_RESOURCES ];
+    for ( uint32_t r = 0; r < graph->resourceCount; r++ )
+    {
+        CringedGraphResource * res = &graph->resources[ r ];
+        graph->blockOf[ r ]        = CRINGED_GRAPH_NONE;
+        graph->aliasPrev[ r ]      = CRINGED_GRAPH_NONE;
+        if ( res->imported || res->firstPass == CRINGED_GRAPH_NONE ) continue;
+
+        VkImageCreateInfo imageInfo = {};
+        imageInfo.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType         = VK_IMAGE_TYPE_2D;
+        imageInfo.format            = res->format;
+        imageInfo.extent.width      = res->extent.width;
+        imageInfo.extent.height     = res->extent.height;
+        imageInfo.extent.depth      = 1;
+        imageInfo.mipLevels         = 1;
+        imageInfo.arrayLayers       = 1;
+        imageInfo.samples           = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling            = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage             = res->usage;
+        imageInfo.sharingMode       = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+        if ( ( opResult = vkCreateImage ( //
+                   device,
+                   &imageInfo,
+                   NULL,
+                   &graph->physical.transientImages[ r ] ) ) != VK_SUCCESS )
+        {
+            _DEBUG_P ( "error: creating transient '%s': %d\n",
+                       res->name,
+                       opResult );
+            return opResult;
+        }
+        vkGetImageMemoryRequirements (
+            device, graph->physical.transientImages[ r ], &reqs[ r ] );
+        graph->transientBytes += reqs[ r ].size;
+
+        /* Largest first: a block is as big as its first occupant */
+        uint32_t i = transientCount++;
+        while ( i > 0 && reqs[ order[ i - 1 ] ].size < reqs[ r ].size )
+        {
+            order[ i ] = order[ i - 1 ];
+            i--;
+        }
+        order[ i ] = r;
+    }
+
+    for ( uint32_t t = 0; t < transientCount; t++ )
+    {
+        uint32_t               r   = order[ t ];
+        CringedGraphResource * res = &graph->resources[ r ];
+        uint32_t               b   = 0;
+        for ( ; b < graph->physical.blockCount; b++ )
+        {
+            CringedGraphBlock * block = &graph->physical.blocks[ b ];
+            /* NOTE: everything binds at offset 0, alignment always holds */
+            if ( ! ( block->typeBits & reqs[ r ].memoryTypeBits ) ) continue;
+            uint8_t overlaps = 0;
+            for ( uint32_t o = 0; o < graph->resourceCount && ! overlaps; o++ )
+            {
+                if ( graph->blockOf[ o ] != b ) continue;
+                const CringedGraphResource * other = &graph->resources[ o ];
+                overlaps = ! ( other->lastPass < res->firstPass ||
+                               res->lastPass < other->firstPass );
+            }
+            if ( ! overlaps ) break;
+        }
+        if ( b == graph->physical.blockCount )
+        {
+            graph->physical.blocks[ b ].memory   = VK_NULL_HANDLE;
+            graph->physical.blocks[ b ].size     = reqs[ r ].size;
+            graph->physical.blocks[ b ].typeBits = reqs[ r ].memoryTypeBits;
+            graph->physical.blocks[ b ].stage    = 0;
+            graph->physical.blocks[ b ].access   = 0;
+            graph->physical.blockCount++;
+        }
+        else
+        {
+            graph->physical.blocks[ b ].typeBits &= reqs[ r ].memoryTypeBits;
+            graph->aliasedBytes += reqs[ r ].size;
+        }
+        graph->blockOf[ r ] = b;
+    }
+
+    /* Predecessor in the same block: the hazard source of a first use */
+    for ( uint32_t r = 0; r < graph->resourceCount; r++ )
+    {
+        if ( graph->blockOf[ r ] == CRINGED_GRAPH_NONE ) continue;
+        uint32_t prevLast = 0;
+        for ( uint32_t o = 0; o < graph->resourceCount; o++ )
+        {
+            if ( o == r || graph->blockOf[ o ] != graph->blockOf[ r ] )
+                continue;
+            uint32_t last = graph->resources[ o ].lastPass;
+            if ( last < graph->resources[ r ].firstPass &&
+                 ( graph->aliasPrev[ r ] == CRINGED_GRAPH_NONE ||
+                   last >= prevLast ) )
+            {
+                graph->aliasPrev[ r ] = o;
+                prevLast              = last;
+            }
+        }
+    }
+
+    for ( uint32_t b = 0; b < graph->physical.blockCount; b++ )
+    {
+        CringedGraphBlock * block = &graph->physical.blocks[ b ];
+        int32_t             type  = cringedFindMemoryType (
+            physicalDevice, block->typeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+        if ( type < 0 )
+            type = cringedFindMemoryType ( physicalDevice, block->typeBits, 0 );
+        if ( type < 0 ) return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+
+        VkMemoryAllocateInfo allocInfo = {};
+        allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize  = block->size;
+        allocInfo.memoryTypeIndex = ( uint32_t ) type;
+        if ( ( opResult = vkAllocateMemory (
+                   device, &allocInfo, NULL, &block->memory ) ) != VK_SUCCESS )
+        {
+            _DEBUG_P ( "error: allocating transient block: %d\n", opResult );
+            return opResult;
+        }
+    }
+
+    for ( uint32_t r = 0; r < graph->resourceCount; r++ )
+    {
+        if ( graph->blockOf[ r ] == CRINGED_GRAPH_NONE ) continue;
+        CringedGraphResource * res = &graph->resources[ r ];
+        if ( ( opResult = vkBindImageMemory ( //
+                   device,
+                   graph->physical.transientImages[ r ],
+                   graph->physical.blocks[ graph->blockOf[ r ] ].memory,
+                   0 ) ) != VK_SUCCESS )
+            return opResult;
+
+        VkImageViewCreateInfo viewInfo = {};
+        viewInfo.sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image    = graph->physical.transientImages[ r ];
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format   = res->format;
+        viewInfo.subresourceRange.aspectMask     = res->aspect;
+        viewInfo.subresourceRange.baseMipLevel   = 0;
+        viewInfo.subresourceRange.levelCount     = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount     = 1;
+        if ( ( opResult = vkCreateImageView ( //
+                   device,
+                   &viewInfo,
+                   NULL,
+                   &graph->physical.transientViews[ r ] ) ) != VK_SUCCESS )
+            return opResult;
+    }
+
+    if ( graph->dynamicRendering )
+    {
+        graph->beginRendering = ( PFN_vkCmdBeginRendering )
+            vkGetDeviceProcAddr ( device, "vkCmdBeginRendering" );
+        graph->endRendering = ( PFN_vkCmdEndRendering ) vkGetDeviceProcAddr (
+            device, "vkCmdEndRendering" );
+        if ( ! graph->beginRendering || ! graph->endRendering )
+        {
+            _DEBUG_P ( "error: vkCmdBeginRendering not available\n" );
+            return VK_ERROR_FEATURE_NOT_PRESENT;
+        }
+        /* NOTE: nothing to bake, attachments are begun from views */
+        return VK_SUCCESS;
+    }
+
+    for ( uint32_t p = 0; p < graph->passCount; p++ )
+    {
+        CringedGraphPass * pass = &graph->passes[ p ];
+        if ( ! pass->live || ! pass->attachmentCount ) continue;
+
+        VkFormat            colors[ CRINGED_GRAPH_MAX_ACCESSES ];
+        VkAttachmentLoadOp  loads[ CRINGED_GRAPH_MAX_ACCESSES ];
+        VkAttachmentStoreOp stores[ CRINGED_GRAPH_MAX_ACCESSES ];
+        VkFormat            depth         = VK_FORMAT_UNDEFINED;
+        uint8_t             depthReadOnly = 0;
+        uint32_t            colorCount    = 0;
+        const CringedGraphAccess * depthAccess = NULL;
+        for ( uint32_t a = 0; a < pass->accessCount; a++ )
+        {
+            const CringedGraphAccess * access = &pass->accesses[ a ];
+            if ( ! usageInfo[ access->usage ].attachment ) continue;
+            if ( access->usage == CRINGED_USAGE_COLOR_WRITE )
+            {
+                colors[ colorCount ] =
+                    graph->resources[ access->resource ].format;
+                loads[ colorCount ]  = loadOpOf ( access );
+                stores[ colorCount ] = storeOpOf ( access );
+                colorCount++;
+            }
+            else
+                depthAccess = access;
+        }
+        if ( depthAccess )
+        {
+            depth         = graph->resources[ depthAccess->resource ].format;
+            depthReadOnly = depthAccess->usage == CRINGED_USAGE_DEPTH_READ;
+            loads[ colorCount ]  = loadOpOf ( depthAccess );
+            stores[ colorCount ] = storeOpOf ( depthAccess );
+        }
+
+        if ( ( opResult = cringedGraphCreateRenderPass ( //
+                   device,
+                   colorCount,
+                   colors,
+                   depth,
+                   depthReadOnly,
+                   loads,
+                   stores,
+                   &graph->physical.renderPasses[ p ] ) ) != VK_SUCCESS )
+        {
+            _DEBUG_P ( "error: creating render pass for '%s': %d\n",
+                       pass->name,
+                       opResult );
+            return opResult;
+        }
+    }
+    return VK_SUCCESS;
+}
+
+/* =============================================
+ *            COMPILE
+ * ============================================= */
+
+/* Reverse sweep from the exported resources: a pass lives when it has side
+ * effects or writes something a later live pass (or the outside) needs */
+static void
+cullPasses ( CringedRenderGraph * graph )
+{
+    for ( uint32_t r = 0; r < graph->resourceCount; r++ )
+    {
+        CringedGraphResource * res = &graph->resources[ r ];
+        res->needed    = res->imported && res->finalUsage != CRINGED_GRAPH_NONE;
+        res->firstPass = CRINGED_GRAPH_NONE;
+        res->lastPass  = 0;
+    }
+
+    graph->livePassCount = 0;
+    for ( uint32_t p = graph->passCount; p-- > 0; )
+    {
+        CringedGraphPass * pass = &graph->passes[ p ];
+        pass->live              = pass->sideEffects;
+        for ( uint32_t a = 0; a < pass->accessCount && ! pass->live; a++ )
+        {
+            const CringedGraphAccess * access = &pass->accesses[ a ];
+            if ( usageInfo[ access->usage ].write &&
+                 graph->resources[ access->resource ].needed )
+                pass->live = 1;
+        }
+        if ( ! pass->live ) continue;
+        graph->livePassCount++;
+
+        /* A full overwrite ends the need, reads (and loads) start it */
+        for ( uint32_t a = 0; a < pass->accessCount; a++ )
+        {
+            const CringedGraphAccess * access = &pass->accesses[ a ];
+            graph->resources[ access->resource ].needed =
+                ! usageInfo[ access->usage ].write ||
+                access->load == CRINGED_LOAD_KEEP;
+        }
+    }
+    graph->culledPasses = graph->passCount - graph->livePassCount;
+
+    for ( uint32_t p = 0; p < graph->passCount; p++ )
+    {
+        CringedGraphPass * pass = &graph->passes[ p ];
+        if ( ! pass->live ) continue;
+        for ( uint32_t a = 0; a < pass->accessCount; a++ )
+        {
+            CringedGraphResource * res =
+                &graph->resources[ pass->accesses[ a ].resource ];
+            if ( res->firstPass == CRINGED_GRAPH_NONE ) res->firstPass = p;
+            res->lastPass = p;
+        }
+    }
+
+    /* Attachments are stored only if someone reads them afterwards */
+    for ( uint32_t p = 0; p < graph->passCount; p++ )
+    {
+        CringedGraphPass * pass = &graph->passes[ p ];
+        pass->attachmentCount   = 0;
+        for ( uint32_t a = 0; a < pass->accessCount; a++ )
+        {
+            CringedGraphAccess *         access = &pass->accesses[ a ];
+            const CringedGraphResource * res =
+                &graph->resources[ access->resource ];
+            access->store = res->imported || p < res->lastPass;
+            if ( pass->live && usageInfo[ access->usage ].attachment )
+            {
+                if ( ! pass->attachmentCount ) pass->extent = res->extent;
+                pass->attachmentCount++;
+            }
+        }
+    }
+}
+
+static uint64_t
+structureHash ( const CringedRenderGraph * graph )
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    hash          = hashBytes (
+        hash, &graph->dynamicRendering, sizeof ( graph->dynamicRendering ) );
+    for ( uint32_t r = 0; r < graph->resourceCount; r++ )
+    {
+        const CringedGraphResource * res = &graph->resources[ r ];
+        hash = hashBytes ( hash, &res->imported, sizeof ( res->imported ) );
+        hash = hashBytes ( hash, &res->format, sizeof ( res->format ) );
+        hash = hashBytes ( hash, &res->extent, sizeof ( res->extent ) );
+        hash = hashBytes ( hash, &res->usage, sizeof ( res->usage ) );
+        hash = hashBytes ( hash, &res->firstPass, sizeof ( res->firstPass ) );
+        hash = hashBytes ( hash, &res->lastPass, sizeof ( res->lastPass ) );
+    }
+    for ( uint32_t p = 0; p < graph->passCount; p++ )
+    {
+        const CringedGraphPass * pass = &graph->passes[ p ];
+        hash = hashBytes ( hash, &pass->live, sizeof ( pass->live ) );
+        if ( ! pass->live ) continue;
+        for ( uint32_t a = 0; a < pass->accessCount; a++ )
+        {
+            const CringedGraphAccess * access = &pass->accesses[ a ];
+            hash = hashBytes (
+                hash, &access->resource, sizeof ( access->resource ) );
+            hash = hashBytes ( hash, &access->usage, sizeof ( access->usage ) );
+            hash = hashBytes ( hash, &access->load, sizeof ( access->load ) );
+            hash = hashBytes ( hash, &access->store, sizeof ( access->store ) );
+        }
+    }
+    return hash ? hash : 1;
+}
+
+static void
+initTrackState ( const CringedRenderGraph * graph,
+                 uint32_t                   r,
+                 TrackState *               state )
+{
+    const CringedGraphResource * res = &graph->resources[ r ];
+    memset ( state, 0, sizeof ( *state ) );
+    if ( res->imported )
+    {
+        state->layout      = res->initial.layout;
+        state->writeStage  = res->initial.stage;
+        state->writeAccess = res->initial.access & writeAccessMask;
+    }
+    else
+    {
+        /* Contents are discarded; the last frame's occupants of the block
+         * may still be using the memory */
+        const CringedGraphBlock * block =
+            &graph->physical.blocks[ graph->blockOf[ r ] ];
+        state->layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+        state->writeStage  = block->stage;
+        state->writeAccess = block->access;
+    }
+}
+
+/* Emits the barrier (if any) that moves `r` from `state` into `usage` */
+static void
+trackAccess ( CringedRenderGraph * graph,
+              uint32_t             r,
+              TrackState *         state,
+              CringedGraphUsage    usage,
+              VkPipelineStageFlags * srcStage,
+              VkPipelineStageFlags * dstStage )
+{
+    const CringedGraphResource * res = &graph->resources[ r ];
+    const UsageInfo *            u   = &usageInfo[ usage ];
+
+    uint8_t layoutChange = ! res->isBuffer && state->layout != u->layout;
+    uint8_t needed       = 0;
+    VkPipelineStageFlags src       = 0;
+    VkAccessFlags        srcAccess = 0;
+
+    if ( u->write || layoutChange )
+    {
+        /* WAW, WAR or a transition: wait for everything before */
+        src       = state->writeStage | state->readStages;
+        srcAccess = state->writeAccess;
+        needed    = layoutChange || src != 0;
+    }
+    else if ( ( state->writeStage && ( u->stage & ~state->visibleStages ) ) ||
+              ( state->writeAccess && ( u->access & ~state->visibleAccess ) ) )
+    {
+        /* RAW not yet made visible to this stage */
+        src       = state->writeStage;
+        srcAccess = state->writeAccess;
+        needed    = 1;
+    }
+
+    if ( needed )
+    {
+        if ( res->isBuffer )
+        {
+            VkBufferMemoryBarrier * b =
+                &graph->bufferBarriers[ graph->bufferBarrierCount++ ];
+            memset ( b, 0, sizeof ( *b ) );
+            b->sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            b->srcAccessMask       = srcAccess;
+            b->dstAccessMask       = u->access;
+            b->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            b->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            b->buffer              = res->buffer;
+            b->offset              = 0;
+            b->size                = VK_WHOLE_SIZE;
+        }
+        else
+        {
+            VkImageMemoryBarrier * b =
+                &graph->imageBarriers[ graph->imageBarrierCount++ ];
+            memset ( b, 0, sizeof ( *b ) );
+            b->sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            b->srcAccessMask       = srcAccess;
+            b->dstAccessMask       = u->access;
+            b->oldLayout           = state->layout;
+            b->newLayout           = u->layout;
+            b->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            b->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            b->image               = res->image;
+            b->subresourceRange.aspectMask     = res->aspect;
+            b->subresourceRange.baseMipLevel   = 0;
+            b->subresourceRange.levelCount     = 1;
+            b->subresourceRange.baseArrayLayer = 0;
+            b->subresourceRange.layerCount     = 1;
+        }
+        *srcStage |= src;
+        *dstStage |= u->stage;
+    }
+
+    if ( ! res->isBuffer ) state->layout = u->layout;
+    if ( u->write || layoutChange )
+    {
+        state->writeStage    = u->stage;
+        state->writeAccess   = u->access & writeAccessMask;
+        state->readStages    = u->write ? 0 : u->stage;
+        state->visibleStages = u->stage;
+        state->visibleAccess = u->write ? 0 : u->access;
+    }
+    else
+    {
+        state->readStages |= u->stage;
+        if ( needed )
+        {
+            state->visibleStages |= u->stage;
+            state->visibleAccess |= u->access;
+        }
+    }
+}
+
+VkResult
+cringedGraphCompile ( CringedRenderGraph * graph,
+                      VkPhysicalDevice     physicalDevice,
+                      VkDevice             device )
+{
+    VkResult opResult;
+    if ( graph->invalid ) return VK_ERROR_INITIALIZATION_FAILED;
+
+    cullPasses ( graph );
+
+    /* Physical objects only change with the structure: a steady frame only
+     * pays for the sweep, the hash and the barrier walk */
+    uint64_t hash = structureHash ( graph );
+    if ( hash != graph->builtHash || graph->device != device )
+    {
+        /* NOTE: rare (toggles, resizes); frames in flight keep using the
+         * replaced objects, their destruction is deferred */
+        cringedGraphRelease ( graph );
+        if ( ( opResult = buildPhysical ( graph, physicalDevice, device ) ) !=
+             VK_SUCCESS )
+        {
+            releasePhysical ( graph );
+            return opResult;
+        }
+        graph->builtHash = hash;
+    }
+
+    for ( uint32_t r = 0; r < graph->resourceCount; r++ )
+        if ( graph->blockOf[ r ] != CRINGED_GRAPH_NONE )
+        {
+            graph->resources[ r ].image = graph->physical.transientImages[ r ];
+            graph->resources[ r ].view  = graph->physical.transientViews[ r ];
+        }
+
+    /* Block masks cover every use of the memory: that is what a first use
+     * in the next frame has to wait for */
+    for ( uint32_t b = 0; b < graph->physical.blockCount; b++ )
+    {
+        graph->physical.blocks[ b ].stage  = 0;
+        graph->physical.blocks[ b ].access = 0;
+    }
+    for ( uint32_t p = 0; p < graph->passCount; p++ )
+    {
+        const CringedGraphPass * pass = &graph->passes[ p ];
+        if ( ! pass->live ) continue;
+        for ( uint32_t a = 0; a < pass->accessCount; a++ )
+        {
+            uint32_t b = graph->blockOf[ pass->accesses[ a ].resource ];
+            if ( b == CRINGED_GRAPH_NONE ) continue;
+            const UsageInfo * u = &usageInfo[ pass->accesses[ a ].usage ];
+            graph->physical.blocks[ b ].stage |= u->stage;
+            graph->physical.blocks[ b ].access |= u->access & writeAccessMask;
+        }
+    }
+
+    TrackState states[ CRINGED_GRAPH_MAX_RESOURCES ];
+    for ( uint32_t r = 0; r < graph->resourceCount; r++ )
+        states[ r ].touched = 0;
+
+    graph->imageBarrierCount  = 0;
+    graph->bufferBarrierCount = 0;
+    for ( uint32_t p = 0; p < graph->passCount; p++ )
+    {
+        CringedGraphPass * pass  = &graph->passes[ p ];
+        pass->imageBarrierFirst  = graph->imageBarrierCount;
+        pass->bufferBarrierFirst = graph->bufferBarrierCount;
+        pass->srcStage           = 0;
+        pass->dstStage           = 0;
+        pass->renderPass         = graph->physical.renderPasses[ p ];
+        if ( pass->live )
+            for ( uint32_t a = 0; a < pass->accessCount; a++ )
+            {
+                const CringedGraphAccess * access = &pass->accesses[ a ];
+                uint32_t                   r      = access->resource;
+                if ( ! states[ r ].touched )
+                {
+                    initTrackState ( graph, r, &states[ r ] );
+                    uint32_t prev = graph->aliasPrev[ r ];
+                    if ( prev != CRINGED_GRAPH_NONE && states[ prev ].touched )
+                    {
+                        /* Same frame: only the previous occupant matters */
+                        states[ r ].writeStage = states[ prev ].writeStage |
+                                                 states[ prev ].readStages;
+                        states[ r ].writeAccess = states[ prev ].writeAccess;
+                    }
+                    states[ r ].touched = 1;
+                }
+                trackAccess ( graph,
+                              r,
+                              &states[ r ],
+                              access->usage,
+                              &pass->srcStage,
+                              &pass->dstStage );
+            }
+        pass->imageBarrierCount =
+            graph->imageBarrierCount - pass->imageBarrierFirst;
+        pass->bufferBarrierCount =
+            graph->bufferBarrierCount - pass->bufferBarrierFirst;
+    }
+
+    /* Hand imported resources back in the state the outside expects */
+    graph->finalImageFirst     = graph->imageBarrierCount;
+    graph->finalSrcStage = 0;
+    graph->finalDstStage = 0;
+    uint32_t finalBuffer = graph->bufferBarrierCount;
+    for ( uint32_t r = 0; r < graph->resourceCount; r++ )
+    {
+        const CringedGraphResource * res = &graph->resources[ r ];
+        if ( ! res->imported || res->finalUsage == CRINGED_GRAPH_NONE ||
+             ! states[ r ].touched )
+            continue;
+        trackAccess ( graph,
+                      r,
+                      &states[ r ],
+                      ( CringedGraphUsage ) res->finalUsage,
+                      &graph->finalSrcStage,
+                      &graph->finalDstStage );
+    }
+    graph->finalImageCount  = graph->imageBarrierCount - graph->finalImageFirst;
+    graph->finalBufferFirst = finalBuffer;
+    graph->finalBufferCount = graph->bufferBarrierCount - finalBuffer;
+    return VK_SUCCESS;
+}
+
+/* =============================================
+ *            EXECUTE
+ * ============================================= */
+
+static VkResult
+getFramebuffer ( CringedRenderGraph *     graph,
+                 const CringedGraphPass * pass,
+                 VkFramebuffer *          framebuffer )
+{
+    VkImageView views[ CRINGED_GRAPH_MAX_ACCESSES ];
+    uint32_t    viewCount = 0;
+    VkImageView depthView = VK_NULL_HANDLE;
+    for ( uint32_t a = 0; a < pass->accessCount; a++ )
+    {
+        const CringedGraphAccess * access = &pass->accesses[ a ];
+        if ( ! usageInfo[ access->usage ].attachment ) continue;
+        if ( access->usage == CRINGED_USAGE_COLOR_WRITE )
+            views[ viewCount++ ] = graph->resources[ access->resource ].view;
+        else
+            depthView = graph->resources[ access->resource ].view;
+    }
+    if ( depthView ) views[ viewCount++ ] = depthView;
+
+    CringedGraphPhysical * phys = &graph->physical;
+    uint64_t               use  = ++phys->framebufferUses;
+    for ( uint32_t i = 0; i < phys->framebufferCount; i++ )
+    {
+        CringedGraphFramebuffer * fb = &phys->framebuffers[ i ];
+        if ( fb->renderPass == pass->renderPass &&
+             fb->viewCount == viewCount &&
+             fb->extent.width == pass->extent.width &&
+             fb->extent.height == pass->extent.height &&
+             ! memcmp ( fb->views, views, viewCount * sizeof ( VkImageView ) ) )
+        {
+            fb->lastUse  = use;
+            *framebuffer = fb->framebuffer;
+            return VK_SUCCESS;
+        }
+    }
+
+    /* NOTE: only on churn through many imported views; the least recently
+     * used one goes, the others stay cached */
+    uint32_t slot = phys->framebufferCount;
+    if ( slot == CRINGED_GRAPH_FRAMEBUFFER_CACHE )
+    {
+        slot = 0;
+        for ( uint32_t i = 1; i < phys->framebufferCount; i++ )
+            if ( phys->framebuffers[ i ].lastUse <
+                 phys->framebuffers[ slot ].lastUse )
+                slot = i;
+    }
+
+    VkFramebufferCreateInfo framebufferInfo = {};
+    framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass      = pass->renderPass;
+    framebufferInfo.attachmentCount = viewCount;
+    framebufferInfo.pAttachments    = views;
+    framebufferInfo.width           = pass->extent.width;
+    framebufferInfo.height          = pass->extent.height;
+    framebufferInfo.layers          = 1;
+
+    VkFramebuffer created;
+    VkResult      opResult =
+        vkCreateFramebuffer ( graph->device, &framebufferInfo, NULL, &created );
+    if ( opResult != VK_SUCCESS ) return opResult;
+
+    CringedGraphFramebuffer * fb = &phys->framebuffers[ slot ];
+    if ( slot < phys->framebufferCount )
+        cringedDefer ( graph->deletions,
+                       ( CringedDeletion ) { CRINGED_DELETE_FRAMEBUFFER,
+                                             .framebuffer = fb->framebuffer } );
+    fb->framebuffer = created;
+    fb->renderPass  = pass->renderPass;
+    fb->extent      = pass->extent;
+    fb->viewCount   = viewCount;
+    fb->lastUse     = use;
+    memcpy ( fb->views, views, viewCount * sizeof ( VkImageView ) );
+    if ( slot == phys->framebufferCount ) phys->framebufferCount++;
+    *framebuffer = fb->framebuffer;
+    return VK_SUCCESS;
+}
+
+static void
+recordBarriers ( const CringedRenderGraph * graph,
+                 VkCommandBuffer            commandBuffer,
+                 VkPipelineStageFlags       srcStage,
+                 VkPipelineStageFlags       dstStage,
+                 uint32_t                   bufferFirst,
+                 uint32_t                   bufferCount,
+                 uint32_t                   imageFirst,
+                 uint32_t                   imageCount )
+{
+    if ( ! bufferCount && ! imageCount ) return;
+    vkCmdPipelineBarrier ( commandBuffer,
+                           srcStage ? srcStage
+                                    : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                           dstStage ? dstStage
+                                    : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                           0,
+                           0,
+                           NULL,
+                           bufferCount,
+                           graph->bufferBarriers + bufferFirst,
+                           imageCount,
+                           graph->imageBarriers + imageFirst );
+}
+
+/* Dynamic rendering: the same attachments straight from their views */
+static void
+beginRendering ( const CringedRenderGraph * graph,
+                 const CringedGraphPass *   pass,
+                 VkCommandBuffer            commandBuffer )
+{
+    VkRenderingAttachmentInfo colors[ CRINGED_GRAPH_MAX_ACCESSES ] = {};
+    VkRenderingAttachmentInfo depth                                = {};
+    uint32_t                  colorCount                           = 0;
+    uint8_t                   hasDepth                             = 0;
+    for ( uint32_t a = 0; a < pass->accessCount; a++ )
+    {
+        const CringedGraphAccess * access = &pass->accesses[ a ];
+        if ( ! usageInfo[ access->usage ].attachment ) continue;
+
+        VkRenderingAttachmentInfo * info =
+            access->usage == CRINGED_USAGE_COLOR_WRITE ? &colors[ colorCount++ ]
+                                                       : &depth;
+        hasDepth |= info == &depth;
+        info->sType       = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        info->imageView   = graph->resources[ access->resource ].view;
+        info->imageLayout = usageInfo[ access->usage ].layout;
+        info->resolveMode = VK_RESOLVE_MODE_NONE;
+        info->loadOp      = loadOpOf ( access );
+        info->storeOp     = storeOpOf ( access );
+        info->clearValue  = access->clear;
+    }
+
+    VkRenderingInfo renderingInfo      = {};
+    renderingInfo.sType                = VK_STRUCTURE_TYPE_RENDERING_INFO;
+    renderingInfo.renderArea.offset.x  = 0;
+    renderingInfo.renderArea.offset.y  = 0;
+    renderingInfo.renderArea.extent    = pass->extent;
+    renderingInfo.layerCount           = 1;
+    renderingInfo.colorAttachmentCount = colorCount;
+    renderingInfo.pColorAttachments    = colors;
+    renderingInfo.pDepthAttachment     = hasDepth ? &depth : NULL;
+    graph->beginRendering ( commandBuffer, &renderingInfo );
+}
+
+static VkResult
+executePass ( CringedRenderGraph * graph,
+              CringedGraphPass *   pass,
+              VkCommandBuffer      commandBuffer )
+{
+    VkResult opResult;
+
+    recordBarriers ( graph,
+                     commandBuffer,
+                     pass->srcStage,
+                     pass->dstStage,
+                     pass->bufferBarrierFirst,
+                     pass->bufferBarrierCount,
+                     pass->imageBarrierFirst,
+                     pass->imageBarrierCount );
+
+    if ( ! pass->attachmentCount )
+    {
+        if ( pass->record ) pass->record ( commandBuffer, pass->userData );
+        return VK_SUCCESS;
+    }
+    if ( graph->dynamicRendering )
+    {
+        beginRendering ( graph, pass, commandBuffer );
+        if ( pass->record ) pass->record ( commandBuffer, pass->userData );
+        graph->endRendering ( commandBuffer );
+        return VK_SUCCESS;
+    }
+
+    VkFramebuffer framebuffer;
+    if ( ( opResult = getFramebuffer ( graph, pass, &framebuffer ) ) !=
+         VK_SUCCESS )
+    {
+        _DEBUG_P (
+            "error: framebuffer for '%s': %d\n", pass->name, opResult );
+        return opResult;
+    }
+
+    /* Clear values follow attachment order: colors, then depth */
+    VkClearValue clears[ CRINGED_GRAPH_MAX_ACCESSES ];
+    uint32_t     clearCount = 0;
+    VkClearValue depthClear = {};
+    uint8_t      hasDepth   = 0;
+    for ( uint32_t a = 0; a < pass->accessCount; a++ )
+    {
+        const CringedGraphAccess * access = &pass->accesses[ a ];
+        if ( ! usageInfo[ access->usage ].attachment ) continue;
+        if ( access->usage == CRINGED_USAGE_COLOR_WRITE )
+            clears[ clearCount++ ] = access->clear;
+        else
+        {
+            depthClear = access->clear;
+            hasDepth   = 1;
+        }
+    }
+    if ( hasDepth ) clears[ clearCount++ ] = depthClear;
+
+    VkRenderPassBeginInfo renderPassInfo = {};
+    renderPassInfo.sType       = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass  = pass->renderPass;
+    renderPassInfo.framebuffer = framebuffer;
+    renderPassInfo.renderArea.offset.x = 0;
+    renderPassInfo.renderArea.offset.y = 0;
+    renderPassInfo.renderArea.extent   = pass->extent;
+    renderPassInfo.clearValueCount     = clearCount;
+    renderPassInfo.pClearValues        = clears;
+    vkCmdBeginRenderPass (
+        commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE );
+    if ( pass->record ) pass->record ( commandBuffer, pass->userData );
+    vkCmdEndRenderPass ( commandBuffer );
+    return VK_SUCCESS;
+}
+
+VkResult
+cringedGraphExecute ( CringedRenderGraph * graph,
+                      VkCommandBuffer      commandBuffer )
+{
+    VkResult opResult;
+    for ( uint32_t p = 0; p < graph->passCount; p++ )
+    {
+        CringedGraphPass * pass = &graph->passes[ p ];
+        if ( ! pass->live ) continue;
+
+        uint32_t zone =
+            cringedGpuZoneBegin ( graph->gpuTrace, commandBuffer, pass->name );
+        opResult = executePass ( graph, pass, commandBuffer );
+        cringedGpuZoneEnd ( graph->gpuTrace, commandBuffer, zone );
+        if ( opResult != VK_SUCCESS ) return opResult;
+    }
+
+    recordBarriers ( graph,
+                     commandBuffer,
+                     graph->finalSrcStage,
+                     graph->finalDstStage,
+                     graph->finalBufferFirst,
+                     graph->finalBufferCount,
+                     graph->finalImageFirst,
+                     graph->finalImageCount );
+    return VK_SUCCESS;
+}
@@ -0,0 +1,279 @@
+#pragma once
+#ifndef CRINGED_RENDER_GRAPH_H
+#define CRINGED_RENDER_GRAPH_H
+
+#include "bufferUtils.h"
+#include "deletionQueue.h"
+#include "gpuTrace.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vulkan/vulkan.h>
+
+#define CRINGED_GRAPH_NONE              UINT32_MAX
+#define CRINGED_GRAPH_MAX_PASSES        32
+#define CRINGED_GRAPH_MAX_RESOURCES     32
+#define CRINGED_GRAPH_MAX_ACCESSES      8 /* per pass */
+/* Render pass path: up to 3 framebuffers per image of the first window
+ * and 1 per image of the others; CRINGED_MAX_WINDOWS swapchains of up to
+ * 5 images fit without evicting */
+#define CRINGED_GRAPH_FRAMEBUFFER_CACHE 64
+
+/* How a pass touches a resource; each maps to a stage, access mask and
+ * (for images) a layout, see `usageInfo` in renderGraph.c */
+typedef enum
+{
+    CRINGED_USAGE_COLOR_WRITE,
+    CRINGED_USAGE_DEPTH_WRITE,
+    CRINGED_USAGE_DEPTH_READ, /* depth test without writes */
+    CRINGED_USAGE_SAMPLED,
+    CRINGED_USAGE_VERTEX_READ, /* storage buffer read in the vertex stage */
+    CRINGED_USAGE_STORAGE_READ,
+    CRINGED_USAGE_STORAGE_WRITE,
+    CRINGED_USAGE_INDIRECT_READ,
+    CRINGED_USAGE_TRANSFER_SRC,
+    CRINGED_USAGE_TRANSFER_DST,
+    CRINGED_USAGE_PRESENT,
+    CRINGED_USAGE_COUNT
+} CringedGraphUsage;
+
+typedef enum
+{
+    CRINGED_LOAD_DONT_CARE,
+    CRINGED_LOAD_CLEAR,
+    CRINGED_LOAD_KEEP, /* read-modify-write: keeps earlier writers alive */
+} CringedGraphLoad;
+
+typedef void ( *CringedGraphRecord ) ( VkCommandBuffer commandBuffer,
+                                       void *          userData );
+
+typedef struct
+{
+    VkImageLayout        layout;
+    VkPipelineStageFlags stage;
+    VkAccessFlags        access;
+} CringedGraphState;
+
+typedef struct
+{
+    const char * name;
+    uint8_t      imported;
+    uint8_t      isBuffer;
+    /* Image description */
+    VkFormat           format;
+    VkExtent2D         extent;
+    VkImageAspectFlags aspect;
+    VkImageUsageFlags  usage; /* accumulated from declared accesses */
+    /* Imported handles, or the physical transient after compile */
+    VkImage     image;
+    VkImageView view;
+    VkBuffer    buffer;
+    /* Imported: state on entry, usage the graph must leave it in */
+    CringedGraphState initial;
+    uint32_t          finalUsage; /* CringedGraphUsage or NONE */
+    /* Compiled */
+    uint32_t firstPass;
+    uint32_t lastPass;
+    uint8_t  needed;
+} CringedGraphResource;
+
+typedef struct
+{
+    uint32_t          resource;
+    CringedGraphUsage usage;
+    CringedGraphLoad  load;
+    VkClearValue      clear;
+    uint8_t           store; /* compiled: contents read later */
+} CringedGraphAccess;
+
+typedef struct
+{
+    const char *       name;
+    CringedGraphRecord record;
+    void *             userData;
+    uint8_t            sideEffects; /* never culled */
+    uint32_t           accessCount;
+    CringedGraphAccess accesses[ CRINGED_GRAPH_MAX_ACCESSES ];
+    /* Compiled */
+    uint8_t              live;
+    uint32_t             imageBarrierFirst;
+    uint32_t             imageBarrierCount;
+    uint32_t             bufferBarrierFirst;
+    uint32_t             bufferBarrierCount;
+    VkPipelineStageFlags srcStage;
+    VkPipelineStageFlags dstStage;
+    uint32_t             attachmentCount;
+    VkExtent2D           extent;
+    VkRenderPass         renderPass;
+} CringedGraphPass;
+
+/* Transient memory shared by resources with disjoint lifetimes */
+typedef struct
+{
+    VkDeviceMemory       memory;
+    VkDeviceSize         size;
+    uint32_t             typeBits;
+    VkPipelineStageFlags stage; /* every stage any occupant touches */
+    VkAccessFlags        access;
+} CringedGraphBlock;
+
+typedef struct
+{
+    VkRenderPass  renderPass;
+    VkExtent2D    extent;
+    uint32_t      viewCount;
+    VkImageView   views[ CRINGED_GRAPH_MAX_ACCESSES ];
+    VkFramebuffer framebuffer;
+    uint64_t      lastUse; /* of CringedGraphPhysical.framebufferUses */
+} CringedGraphFramebuffer;
+
+/* Everything compile creates; replaced as a whole on structural change */
+typedef struct
+{
+    uint32_t                blockCount;
+    CringedGraphBlock       blocks[ CRINGED_GRAPH_MAX_RESOURCES ];
+    VkImage                 transientImages[ CRINGED_GRAPH_MAX_RESOURCES ];
+    VkImageView             transientViews[ CRINGED_GRAPH_MAX_RESOURCES ];
+    VkRenderPass            renderPasses[ CRINGED_GRAPH_MAX_PASSES ];
+    uint32_t                framebufferCount;
+    CringedGraphFramebuffer framebuffers[ CRINGED_GRAPH_FRAMEBUFFER_CACHE ];
+    uint64_t                framebufferUses; /* lookups, for the LRU */
+} CringedGraphPhysical;
+
+typedef struct
+{
+    /* Declaration, reset every frame */
+    uint32_t             passCount;
+    CringedGraphPass     passes[ CRINGED_GRAPH_MAX_PASSES ];
+    uint32_t             resourceCount;
+    CringedGraphResource resources[ CRINGED_GRAPH_MAX_RESOURCES ];
+    uint8_t              invalid; /* a declaration overflowed */
+    /* Compiled schedule */
+    uint32_t              livePassCount;
+    uint32_t              imageBarrierCount;
+    VkImageMemoryBarrier  imageBarriers[ CRINGED_GRAPH_MAX_PASSES *
+                                        CRINGED_GRAPH_MAX_ACCESSES +
+                                        CRINGED_GRAPH_MAX_RESOURCES ];
+    uint32_t              bufferBarrierCount;
+    VkBufferMemoryBarrier bufferBarriers[ CRINGED_GRAPH_MAX_PASSES *
+                                          CRINGED_GRAPH_MAX_ACCESSES +
+                                          CRINGED_GRAPH_MAX_RESOURCES ];
+    /* Barriers after the last pass, into imported `finalUsage` */
+    uint32_t             finalImageFirst;
+    uint32_t             finalImageCount;
+    uint32_t             finalBufferFirst;
+    uint32_t             finalBufferCount;
+    VkPipelineStageFlags finalSrcStage;
+    VkPipelineStageFlags finalDstStage;
+    /* Begin attachments with vkCmdBeginRendering (core 1.3) instead of
+     * render pass + framebuffer objects; set before the first compile */
+    uint8_t                dynamicRendering;
+    PFN_vkCmdBeginRendering beginRendering;
+    PFN_vkCmdEndRendering   endRendering;
+    /* Timestamp zone per live pass, NULL when not tracing */
+    CringedGpuTrace * gpuTrace;
+    /* Physical objects, rebuilt only when the structure hash changes.
+     * Replaced ones go through `deletions` once frames in flight are done. */
+    CringedDeletionQueue * deletions;
+    VkDevice               device;
+    uint64_t               builtHash;
+    uint32_t               blockOf[ CRINGED_GRAPH_MAX_RESOURCES ];
+    uint32_t               aliasPrev[ CRINGED_GRAPH_MAX_RESOURCES ];
+    CringedGraphPhysical   physical;
+    /* Stats of the last compile */
+    uint32_t     culledPasses;
+    VkDeviceSize transientBytes;
+    VkDeviceSize aliasedBytes; /* saved by aliasing */
+} CringedRenderGraph;
+
+CringedRenderGraph *
+cringedCreateRenderGraph ( CringedDeletionQueue * deletions );
+
+/* Releases every physical object, then the graph itself */
+void
+cringedDestroyRenderGraph ( CringedRenderGraph * graph );
+
+/* Defers destruction of transients, render passes and framebuffers, the
+ * next compile builds fresh ones. Frames already submitted keep theirs. */
+void
+cringedGraphRelease ( CringedRenderGraph * graph );
+
+/* Starts a new declaration, physical objects are kept for reuse */
+void
+cringedGraphReset ( CringedRenderGraph * graph );
+
+uint32_t
+cringedGraphImportImage ( CringedRenderGraph *      graph,
+                          const char *              name,
+                          VkImage                   image,
+                          VkImageView               view,
+                          VkFormat                  format,
+                          VkExtent2D                extent,
+                          const CringedGraphState * initial,
+                          uint32_t                  finalUsage );
+
+uint32_t
+cringedGraphImportBuffer ( CringedRenderGraph *      graph,
+                           const char *              name,
+                           VkBuffer                  buffer,
+                           const CringedGraphState * initial,
+                           uint32_t                  finalUsage );
+
+/* Transient image: created, aliased and destroyed by the graph */
+uint32_t
+cringedGraphCreateImage ( CringedRenderGraph * graph,
+                          const char *         name,
+                          VkFormat             format,
+                          VkExtent2D           extent );
+
+/* Passes are scheduled in declaration order */
+uint32_t
+cringedGraphAddPass ( CringedRenderGraph * graph,
+                      const char *         name,
+                      CringedGraphRecord   record,
+                      void *               userData );
+
+void
+cringedGraphRead ( CringedRenderGraph * graph,
+                   uint32_t             pass,
+                   uint32_t             resource,
+                   CringedGraphUsage    usage );
+
+void
+cringedGraphWrite ( CringedRenderGraph * graph,
+                    uint32_t             pass,
+                    uint32_t             resource,
+                    CringedGraphUsage    usage,
+                    CringedGraphLoad     load,
+                    const VkClearValue * clear );
+
+/* Culls, computes lifetimes and barriers; (re)creates physical objects
+ * when the declared structure changed since the last compile */
+VkResult
+cringedGraphCompile ( CringedRenderGraph * graph,
+                      VkPhysicalDevice     physicalDevice,
+                      VkDevice             device );
+
+VkResult
+cringedGraphExecute ( CringedRenderGraph * graph,
+                      VkCommandBuffer      commandBuffer );
+
+VkImageView
+cringedGraphImageView ( const CringedRenderGraph * graph, uint32_t resource );
+
+/* Render pass with every attachment kept in its subpass layout: the graph
+ * records the transitions, so no implicit ones or external dependencies.
+ * Pipelines use one with the same formats for compatibility. */
+VkResult
+cringedGraphCreateRenderPass ( VkDevice                    device,
+                               uint32_t                    colorCount,
+                               const VkFormat *            colorFormats,
+                               VkFormat                    depthFormat,
+                               uint8_t                     depthReadOnly,
+                               const VkAttachmentLoadOp *  loadOps,
+                               const VkAttachmentStoreOp * storeOps,
+                               VkRenderPass *              renderPass );
+
+#endif /* CRINGED_RENDER_GRAPH_H */
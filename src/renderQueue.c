@@ -0,0 +1,253 @@
+#include "renderQueue.h"
+
+CringedRenderQueue *
+cringedCreateRenderQueue ( uint32_t capacity )
+{
+    CringedRenderQueue * queue =
+        ( CringedRenderQueue * ) malloc ( sizeof ( CringedRenderQueue ) );
+    if ( queue == NULL ) return NULL;
+
+    if ( capacity == 0 ) capacity = CRINGED_RENDER_BATCH;
+    queue->count    = 0;
+    queue->capacity = capacity;
+    queue->commands = ( CringedRenderCommand * ) malloc (
+        capacity * sizeof ( CringedRenderCommand ) );
+    queue->staging = ( CringedRenderCommand * ) malloc (
+        capacity * sizeof ( CringedRenderCommand ) );
+    queue->order = ( CringedRenderSortEntry * ) malloc (
+        capacity * sizeof ( CringedRenderSortEntry ) );
+    if ( ! queue->commands || ! queue->staging || ! queue->order )
+    {
+        free ( queue->commands );
+        free ( queue->staging );
+        free ( queue->order );
+        free ( queue );
+        return NULL;
+    }
+    atomic_init ( &queue->pending, NULL );
+    atomic_init ( &queue->producers, NULL );
+    return queue;
+}
+
+static void
+freeBlocks ( CringedRenderBlock * block )
+{
+    while ( block )
+    {
+        CringedRenderBlock * next = block->next;
+        free ( block );
+        block = next;
+    }
+}
+
+void
+cringedDestroyRenderQueue ( CringedRenderQueue * queue )
+{
+    if ( queue == NULL ) return;
+
+    /* Every block is in exactly one list: pending, or one producer's */
+    freeBlocks ( atomic_load ( &queue->pending ) );
+    CringedRenderProducer * producer = atomic_load ( &queue->producers );
+    while ( producer )
+    {
+        CringedRenderProducer * next = producer->next;
+        if ( producer->dropped )
+            _DEBUG_P ( "render queue: %u commands dropped\n",
+                       producer->dropped );
+        free ( producer->current );
+        freeBlocks ( producer->free );
+        freeBlocks ( atomic_load ( &producer->returned ) );
+        free ( producer );
+        producer = next;
+    }
+    free ( queue->commands );
+    free ( queue->staging );
+    free ( queue->order );
+    free ( queue );
+}
+
+CringedRenderProducer *
+cringedRenderProducer ( CringedRenderQueue * queue )
+{
+    CringedRenderProducer * producer = ( CringedRenderProducer * ) malloc (
+        sizeof ( CringedRenderProducer ) );
+    if ( producer == NULL ) return NULL;
+
+    producer->queue   = queue;
+    producer->current = NULL;
+    producer->free    = NULL;
+    producer->dropped = 0;
+    atomic_init ( &producer->returned, NULL );
+
+    producer->next = atomic_load_explicit ( //
+        &queue->producers,
+        memory_order_relaxed );
+    while ( ! atomic_compare_exchange_weak_explicit ( &queue->producers,
+                                                      &producer->next,
+                                                      producer,
+                                                      memory_order_release,
+                                                      memory_order_relaxed ) )
+        ;
+    return producer;
+}
+
+/* Own free list first, then whatever the render thread returned; only a
+ * pool smaller than the frame's demand allocates */
+static CringedRenderBlock *
+takeBlock ( CringedRenderProducer * producer )
+{
+    if ( producer->free == NULL )
+        producer->free = atomic_exchange_explicit (
+            &producer->returned, NULL, memory_order_acquire );
+
+    CringedRenderBlock * block = producer->free;
+    if ( block )
+        producer->free = block->next;
+    else if ( ( block = ( CringedRenderBlock * ) malloc (
+                    sizeof ( CringedRenderBlock ) ) ) == NULL )
+        return NULL;
+
+    block->owner = producer;
+    block->count = 0;
+    block->next  = NULL;
+    return block;
+}
+
+static void
+publish ( CringedRenderQueue * queue, CringedRenderBlock * block )
+{
+    block->next =
+        atomic_load_explicit ( &queue->pending, memory_order_relaxed );
+    while ( ! atomic_compare_exchange_weak_explicit ( &queue->pending,
+                                                      &block->next,
+                                                      block,
+                                                      memory_order_release,
+                                                      memory_order_relaxed ) )
+        ;
+}
+
+uint8_t
+cringedRenderSubmit ( CringedRenderProducer *      producer,
+                      const CringedRenderCommand * command )
+{
+    CringedRenderBlock * block = producer->current;
+    if ( block && block->count == CRINGED_RENDER_BATCH )
+    {
+        publish ( producer->queue, block );
+        block = NULL;
+    }
+    if ( block == NULL && ( block = takeBlock ( producer ) ) == NULL )
+    {
+        producer->current = NULL;
+        producer->dropped++;
+        return 0;
+    }
+    producer->current                 = block;
+    block->commands[ block->count++ ] = *command;
+    return 1;
+}
+
+void
+cringedRenderFlush ( CringedRenderProducer * producer )
+{
+    CringedRenderBlock * block = producer->current;
+    if ( block == NULL || block->count == 0 ) return;
+    publish ( producer->queue, block );
+    producer->current = NULL;
+}
+
+static int
+compareEntries ( const void * a, const void * b )
+{
+    const CringedRenderSortEntry * x = ( const CringedRenderSortEntry * ) a;
+    const CringedRenderSortEntry * y = ( const CringedRenderSortEntry * ) b;
+    if ( x->key != y->key ) return x->key < y->key ? -1 : 1;
+    return ( x->index > y->index ) - ( x->index < y->index );
+}
+
+static uint8_t
+reserve ( CringedRenderQueue * queue, uint32_t count )
+{
+    if ( count <= queue->capacity ) return 1;
+
+    uint32_t capacity = queue->capacity;
+    while ( capacity < count ) capacity *= 2;
+    /* Each array keeps at least the old capacity if a later one fails */
+    CringedRenderCommand * commands = ( CringedRenderCommand * ) realloc (
+        queue->commands, capacity * sizeof ( CringedRenderCommand ) );
+    if ( commands == NULL ) return 0;
+    queue->commands = commands;
+
+    CringedRenderCommand * staging = ( CringedRenderCommand * ) realloc (
+        queue->staging, capacity * sizeof ( CringedRenderCommand ) );
+    if ( staging == NULL ) return 0;
+    queue->staging = staging;
+
+    CringedRenderSortEntry * order = ( CringedRenderSortEntry * ) realloc (
+        queue->order, capacity * sizeof ( CringedRenderSortEntry ) );
+    if ( order == NULL ) return 0;
+    queue->order    = order;
+    queue->capacity = capacity;
+    return 1;
+}
+
+uint32_t
+cringedRenderQueueDrain ( CringedRenderQueue * queue )
+{
+    CringedRenderBlock * blocks = atomic_exchange_explicit (
+        &queue->pending, NULL, memory_order_acquire );
+
+    /* The stack is newest first: reverse into publication order */
+    CringedRenderBlock * ordered = NULL;
+    uint32_t             total   = 0;
+    while ( blocks )
+    {
+        CringedRenderBlock * next = blocks->next;
+        blocks->next              = ordered;
+        ordered                   = blocks;
+        total += blocks->count;
+        blocks = next;
+    }
+
+    uint32_t limit = reserve ( queue, total ) ? total : queue->capacity;
+    if ( limit < total )
+        _DEBUG_P ( "render queue: %u commands dropped\n", total - limit );
+
+    uint32_t count = 0;
+    while ( ordered )
+    {
+        CringedRenderBlock * block = ordered;
+        ordered                    = block->next;
+
+        uint32_t take = block->count;
+        if ( take > limit - count ) take = limit - count;
+        memcpy ( &queue->staging[ count ],
+                 block->commands,
+                 take * sizeof ( CringedRenderCommand ) );
+        for ( uint32_t i = 0; i < take; i++ )
+        {
+            queue->order[ count + i ].key   = block->commands[ i ].sortKey;
+            queue->order[ count + i ].index = count + i;
+        }
+        count += take;
+
+        /* Back to its producer, which takes the whole list at once */
+        CringedRenderProducer * owner = block->owner;
+        block->next =
+            atomic_load_explicit ( &owner->returned, memory_order_relaxed );
+        while ( ! atomic_compare_exchange_weak_explicit (
+            &owner->returned,
+            &block->next,
+            block,
+            memory_order_release,
+            memory_order_relaxed ) )
+            ;
+    }
+
+    qsort ( queue->order, count, sizeof ( CringedRenderSortEntry ), //
+            compareEntries );
+    for ( uint32_t i = 0; i < count; i++ )
+        queue->commands[ i ] = queue->staging[ queue->order[ i ].index ];
+    queue->count = count;
+    return count;
+}
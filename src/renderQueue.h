@@ -0,0 +1,110 @@
+#pragma once
+#ifndef CRINGED_RENDER_QUEUE_H
+#define CRINGED_RENDER_QUEUE_H
+
+#include <cglm/cglm.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef NDEBUG
+#define _DEBUG_P( ... ) printf ( __VA_ARGS__ )
+#else
+#define _DEBUG_P( ... ) ( ( void ) 0 )
+#endif
+
+#define CRINGED_RENDER_BATCH 256 /* commands per block */
+
+/* Built-in meshes: draw ranges of the vertices the shader generates */
+#define CRINGED_MESH_TRIANGLE 0
+#define CRINGED_MESH_DISC     1 /* levels of detail, see lod.h */
+#define CRINGED_MESH_COUNT    2
+
+/* Materials pick a variant of the triangle program by feature bits,
+ * see cringedMaterialFeatures; a material change splits draws */
+#define CRINGED_MATERIAL_DEFAULT 0 /* vertex colors */
+#define CRINGED_MATERIAL_LIT     1 /* vertex colors, Lambert lighting */
+#define CRINGED_MATERIAL_COUNT   2
+
+/* One draw request, valid for the frame that drains it */
+typedef struct
+{
+    uint64_t sortKey; /* ascending, ties keep submission order */
+    uint32_t mesh;
+    uint32_t material;
+    mat4     world;
+} CringedRenderCommand;
+
+struct CringedRenderProducer;
+
+typedef struct CringedRenderBlock
+{
+    struct CringedRenderBlock *    next;
+    struct CringedRenderProducer * owner; /* gets the block back */
+    uint32_t                       count;
+    CringedRenderCommand           commands[ CRINGED_RENDER_BATCH ];
+} CringedRenderBlock;
+
+/* Per-thread batching: commands fill a private block, full or flushed
+ * blocks are published with one CAS. The render thread hands drained
+ * blocks back, so the pool stops growing once it covers a frame. */
+typedef struct CringedRenderProducer
+{
+    struct CringedRenderQueue *    queue;
+    struct CringedRenderProducer * next; /* all producers, for destroy */
+    CringedRenderBlock *           current;
+    CringedRenderBlock *           free;     /* producer only */
+    _Atomic ( CringedRenderBlock * ) returned; /* render thread pushes */
+    uint32_t                       dropped;  /* out of memory */
+} CringedRenderProducer;
+
+typedef struct
+{
+    uint64_t key;
+    uint32_t index;
+} CringedRenderSortEntry;
+
+/* Multi-producer, single-consumer: producers push whole blocks onto
+ * `pending`, the render thread takes the list in one exchange per frame.
+ * Neither side ever waits for the other. */
+typedef struct CringedRenderQueue
+{
+    _Atomic ( CringedRenderBlock * ) pending;
+    _Atomic ( CringedRenderProducer * ) producers;
+    /* Render thread only: this frame's commands, sorted by key */
+    uint32_t                 count;
+    uint32_t                 capacity;
+    CringedRenderCommand *   commands;
+    CringedRenderCommand *   staging;
+    CringedRenderSortEntry * order;
+} CringedRenderQueue;
+
+/* `capacity` commands per frame before the arrays grow */
+CringedRenderQueue *
+cringedCreateRenderQueue ( uint32_t capacity );
+
+/* No producer may be submitting anymore */
+void
+cringedDestroyRenderQueue ( CringedRenderQueue * queue );
+
+/* One per submitting thread, lives until the queue is destroyed */
+CringedRenderProducer *
+cringedRenderProducer ( CringedRenderQueue * queue );
+
+/* Returns 0 when the command was dropped (no block and out of memory) */
+uint8_t
+cringedRenderSubmit ( CringedRenderProducer *      producer,
+                      const CringedRenderCommand * command );
+
+/* Publishes the partial block; call once the thread's frame is submitted */
+void
+cringedRenderFlush ( CringedRenderProducer * producer );
+
+/* Render thread, once per frame: takes everything published so far into
+ * `queue->commands`, sorted. Returns the command count. */
+uint32_t
+cringedRenderQueueDrain ( CringedRenderQueue * queue );
+
+#endif /* CRINGED_RENDER_QUEUE_H */
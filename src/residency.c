@@ -0,0 +1,225 @@
+#include "residency.h"
+
+CringedResidency *
+cringedCreateResidency ( uint32_t capacity, float high, float low )
+{
+    CringedResidency * residency =
+        ( CringedResidency * ) calloc ( 1, sizeof ( CringedResidency ) );
+    if ( ! residency ) return NULL;
+
+    residency->residents =
+        ( CringedResident * ) calloc ( capacity, sizeof ( CringedResident ) );
+    if ( ! residency->residents )
+    {
+        free ( residency );
+        return NULL;
+    }
+    residency->capacity = capacity;
+    residency->high     = high;
+    residency->low      = low < high ? low : high;
+    return residency;
+}
+
+void
+cringedDestroyResidency ( CringedResidency * residency )
+{
+    if ( ! residency ) return;
+    free ( residency->residents );
+    free ( residency );
+}
+
+void
+cringedResidencyAttach ( CringedResidency * residency,
+                         VkPhysicalDevice   physicalDevice,
+                         uint8_t            budgetExtension )
+{
+    residency->physicalDevice  = physicalDevice;
+    residency->budgetExtension = budgetExtension;
+    vkGetPhysicalDeviceMemoryProperties ( physicalDevice,
+                                          &residency->memoryProperties );
+    cringedQueryMemoryBudget ( residency, &residency->budget );
+}
+
+void
+cringedQueryMemoryBudget ( const CringedResidency * residency,
+                           CringedMemoryBudget *    budget )
+{
+    memset ( budget, 0, sizeof ( *budget ) );
+    if ( residency->physicalDevice == VK_NULL_HANDLE ) return;
+
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT driver = {};
+    driver.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    VkPhysicalDeviceMemoryProperties2 properties = {};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    if ( residency->budgetExtension ) properties.pNext = &driver;
+    vkGetPhysicalDeviceMemoryProperties2 ( residency->physicalDevice,
+                                           &properties );
+
+    /* NOTE: the driver's usage covers every allocation of the process,
+     * other applications' included in its budget */
+    const VkPhysicalDeviceMemoryProperties * memory =
+        &properties.memoryProperties;
+    budget->heapCount = memory->memoryHeapCount;
+    budget->measured  = residency->budgetExtension;
+    for ( uint32_t h = 0; h < budget->heapCount; h++ )
+    {
+        budget->flags[ h ]  = memory->memoryHeaps[ h ].flags;
+        budget->usage[ h ]  = budget->measured ? driver.heapUsage[ h ]
+                                               : residency->held[ h ];
+        budget->budget[ h ] = budget->measured ? driver.heapBudget[ h ]
+                                               : memory->memoryHeaps[ h ].size;
+        if ( residency->cap && budget->budget[ h ] > residency->cap )
+            budget->budget[ h ] = residency->cap;
+    }
+}
+
+/* Held bytes and the last query follow every change until the next one */
+static void
+account ( CringedResidency * residency, uint32_t heap, int64_t bytes )
+{
+    if ( heap >= VK_MAX_MEMORY_HEAPS ) return;
+    residency->held[ heap ] += bytes;
+    VkDeviceSize * usage = &residency->budget.usage[ heap ];
+    *usage = bytes < 0 && *usage < ( VkDeviceSize ) -bytes ? 0
+                                                           : *usage + bytes;
+}
+
+uint32_t
+cringedResidencyAdd ( CringedResidency * residency,
+                      uint32_t           heap,
+                      VkDeviceSize       size,
+                      uint8_t            priority,
+                      CringedEvictFn     evict,
+                      void *             owner,
+                      uint32_t           id )
+{
+    uint32_t handle = 0;
+    while ( handle < residency->count && residency->residents[ handle ].evict )
+        handle++;
+    if ( handle == residency->capacity )
+    {
+        _DEBUG_P ( "warning: residency full, resource not tracked\n" );
+        return CRINGED_RESIDENT_NONE;
+    }
+    if ( handle == residency->count ) residency->count++;
+
+    CringedResident * resident = &residency->residents[ handle ];
+    resident->size             = size;
+    resident->lastUsed         = residency->frame;
+    resident->heap             = heap;
+    resident->priority         = priority;
+    resident->resident         = 1;
+    resident->evict            = evict;
+    resident->owner            = owner;
+    resident->id               = id;
+    account ( residency, heap, ( int64_t ) size );
+    return handle;
+}
+
+void
+cringedResidencyRemove ( CringedResidency * residency, uint32_t handle )
+{
+    if ( ! residency || handle >= residency->count ) return;
+    CringedResident * resident = &residency->residents[ handle ];
+    if ( resident->resident )
+        account ( residency, resident->heap, -( int64_t ) resident->size );
+    memset ( resident, 0, sizeof ( *resident ) );
+    while ( residency->count && ! residency->residents[ residency->count - 1 ]
+                                      .evict )
+        residency->count--;
+}
+
+void
+cringedResidencyRestored ( CringedResidency * residency, uint32_t handle )
+{
+    if ( ! residency || handle >= residency->count ) return;
+    CringedResident * resident = &residency->residents[ handle ];
+    if ( resident->resident ) return;
+    resident->resident = 1;
+    resident->lastUsed = residency->frame;
+    account ( residency, resident->heap, ( int64_t ) resident->size );
+}
+
+/* Lowest priority, then least recently used; only residents no frame in
+ * flight can still read */
+static uint32_t
+pickVictim ( const CringedResidency * residency, uint32_t heap )
+{
+    uint32_t victim = CRINGED_RESIDENT_NONE;
+    for ( uint32_t r = 0; r < residency->count; r++ )
+    {
+        const CringedResident * c = &residency->residents[ r ];
+        if ( ! c->evict || ! c->resident || c->heap != heap ||
+             c->priority == CRINGED_PRIORITY_PINNED ||
+             c->lastUsed >= residency->safeFrame )
+            continue;
+        const CringedResident * v =
+            victim == CRINGED_RESIDENT_NONE ? NULL
+                                            : &residency->residents[ victim ];
+        if ( ! v || c->priority < v->priority ||
+             ( c->priority == v->priority && c->lastUsed < v->lastUsed ) )
+            victim = r;
+    }
+    return victim;
+}
+
+/* Evicts from `heap` until its usage is at most `target` */
+static uint32_t
+trim ( CringedResidency * residency, uint32_t heap, VkDeviceSize target )
+{
+    uint32_t evicted = 0, victim;
+    while ( residency->budget.usage[ heap ] > target &&
+            ( victim = pickVictim ( residency, heap ) ) !=
+                CRINGED_RESIDENT_NONE )
+    {
+        CringedResident * resident = &residency->residents[ victim ];
+        resident->evict ( resident->owner, resident->id );
+        resident->resident = 0;
+        account ( residency, heap, -( int64_t ) resident->size );
+        residency->evictions++;
+        evicted++;
+    }
+    return evicted;
+}
+
+uint32_t
+cringedResidencyBeginFrame ( CringedResidency * residency,
+                             uint64_t           frame,
+                             uint64_t           safeFrame )
+{
+    residency->frame     = frame;
+    residency->safeFrame = safeFrame;
+    if ( residency->physicalDevice == VK_NULL_HANDLE ) return 0;
+
+    /* One query per frame: the driver's numbers lag allocations anyway */
+    cringedQueryMemoryBudget ( residency, &residency->budget );
+    uint32_t evicted = 0;
+    for ( uint32_t h = 0; h < residency->budget.heapCount; h++ )
+    {
+        VkDeviceSize budget = residency->budget.budget[ h ];
+        if ( residency->budget.usage[ h ] >
+             ( VkDeviceSize ) ( budget * residency->high ) )
+            evicted += trim (
+                residency, h, ( VkDeviceSize ) ( budget * residency->low ) );
+    }
+    if ( evicted )
+        _DEBUG_P ( "residency: frame %llu evicted %u\n",
+                   ( unsigned long long ) frame,
+                   evicted );
+    return evicted;
+}
+
+uint8_t
+cringedResidencyMakeRoom ( CringedResidency * residency,
+                           uint32_t           heap,
+                           VkDeviceSize       size )
+{
+    if ( ! residency || heap >= residency->budget.heapCount ) return 1;
+
+    VkDeviceSize limit = ( VkDeviceSize ) ( residency->budget.budget[ heap ] *
+                                            residency->high );
+    if ( size > limit ) return 0;
+    trim ( residency, heap, limit - size );
+    return residency->budget.usage[ heap ] + size <= limit;
+}
@@ -0,0 +1,144 @@
+#pragma once
+#ifndef CRINGED_RESIDENCY_H
+#define CRINGED_RESIDENCY_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vulkan/vulkan.h>
+
+#ifndef NDEBUG
+#define _DEBUG_P( ... ) printf ( __VA_ARGS__ )
+#else
+#define _DEBUG_P( ... ) ( ( void ) 0 )
+#endif
+
+#define CRINGED_RESIDENT_NONE UINT32_MAX
+
+/* Residents of equal priority go least recently used first; a lower
+ * priority goes before any higher one */
+#define CRINGED_PRIORITY_LOW    64
+#define CRINGED_PRIORITY_NORMAL 128
+#define CRINGED_PRIORITY_HIGH   192
+#define CRINGED_PRIORITY_PINNED 255 /* counted, never evicted */
+
+/* Releases the resident's memory; the registry only calls it once no
+ * frame in flight uses the resident, so the owner may destroy at once */
+typedef void ( *CringedEvictFn ) ( void * owner, uint32_t id );
+
+/* Per heap, bytes */
+typedef struct
+{
+    uint32_t          heapCount;
+    VkDeviceSize      usage[ VK_MAX_MEMORY_HEAPS ];
+    VkDeviceSize      budget[ VK_MAX_MEMORY_HEAPS ];
+    VkMemoryHeapFlags flags[ VK_MAX_MEMORY_HEAPS ];
+    uint8_t           measured; /* by the driver, VK_EXT_memory_budget */
+} CringedMemoryBudget;
+
+typedef struct
+{
+    VkDeviceSize   size;
+    uint64_t       lastUsed; /* frame number */
+    uint32_t       heap;
+    uint8_t        priority; /* CRINGED_PRIORITY_* */
+    uint8_t        resident; /* 0: evicted, or a free slot */
+    CringedEvictFn evict;    /* NULL: free slot */
+    void *         owner;
+    uint32_t       id; /* the owner's, handed back to `evict` */
+} CringedResident;
+
+/* Streamed resources register with their size, heap and priority, and
+ * are touched by every frame that draws them. Once a frame the budget is
+ * queried; a heap past `high` of its budget loses residents, least
+ * important first, until it is back under `low`. Owners bring evicted
+ * residents back on demand and report it with cringedResidencyRestored.
+ *   Without VK_EXT_memory_budget the budget is the heap size and the
+ * usage only what the registry holds. */
+typedef struct
+{
+    uint32_t          capacity;
+    uint32_t          count; /* slots in use, free ones included */
+    CringedResident * residents;
+    float             high, low; /* fractions of the budget */
+    VkDeviceSize      cap;       /* per heap budget limit, 0: none */
+    uint64_t          frame;     /* being recorded */
+    uint64_t          safeFrame; /* every frame before it completed */
+    /* Attached once the device exists */
+    VkPhysicalDevice                 physicalDevice;
+    uint8_t                          budgetExtension;
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    VkDeviceSize                     held[ VK_MAX_MEMORY_HEAPS ];
+    /* Last query, with this frame's evictions taken off */
+    CringedMemoryBudget budget;
+    uint64_t            evictions; /* since creation */
+} CringedResidency;
+
+CringedResidency *
+cringedCreateResidency ( uint32_t capacity, float high, float low );
+
+void
+cringedDestroyResidency ( CringedResidency * residency );
+
+/* `budgetExtension`: VK_EXT_memory_budget is enabled on the device */
+void
+cringedResidencyAttach ( CringedResidency * residency,
+                         VkPhysicalDevice   physicalDevice,
+                         uint8_t            budgetExtension );
+
+/* Fills `budget` from the driver, or from heap sizes and `held` */
+void
+cringedQueryMemoryBudget ( const CringedResidency * residency,
+                           CringedMemoryBudget *    budget );
+
+/* Heap of a memory type, from the attached device */
+static inline uint32_t
+cringedResidencyHeap ( const CringedResidency * residency,
+                       uint32_t                 memoryType )
+{
+    return residency->memoryProperties.memoryTypes[ memoryType ].heapIndex;
+}
+
+/* Returns the handle, CRINGED_RESIDENT_NONE when the registry is full */
+uint32_t
+cringedResidencyAdd ( CringedResidency * residency,
+                      uint32_t           heap,
+                      VkDeviceSize       size,
+                      uint8_t            priority,
+                      CringedEvictFn     evict,
+                      void *             owner,
+                      uint32_t           id );
+
+/* The owner destroyed the resource itself */
+void
+cringedResidencyRemove ( CringedResidency * residency, uint32_t handle );
+
+/* The frame being recorded uses the resident */
+static inline void
+cringedResidencyTouch ( CringedResidency * residency, uint32_t handle )
+{
+    if ( residency && handle < residency->count )
+        residency->residents[ handle ].lastUsed = residency->frame;
+}
+
+/* An evicted resident's memory was allocated again */
+void
+cringedResidencyRestored ( CringedResidency * residency, uint32_t handle );
+
+/* `frame` is about to be recorded, every frame before `safeFrame` has
+ * completed: queries the budget and evicts what the heaps past `high`
+ * can lose. Returns the number of residents evicted. */
+uint32_t
+cringedResidencyBeginFrame ( CringedResidency * residency,
+                             uint64_t           frame,
+                             uint64_t           safeFrame );
+
+/* Before allocating `size` bytes on `heap`: evicts until they fit under
+ * `high`, returns 0 if they still don't */
+uint8_t
+cringedResidencyMakeRoom ( CringedResidency * residency,
+                           uint32_t           heap,
+                           VkDeviceSize       size );
+
+#endif /* CRINGED_RESIDENCY_H */
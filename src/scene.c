@@ -0,0 +1,399 @@
+#include "scene.h"
+
+static int
+compareU32 ( const void * a, const void * b )
+{
+    uint32_t x = *( const uint32_t * ) a, y = *( const uint32_t * ) b;
+    return ( x > y ) - ( x < y );
+}
+
+static int
+compareU64 ( const void * a, const void * b )
+{
+    uint64_t x = *( const uint64_t * ) a, y = *( const uint64_t * ) b;
+    return ( x > y ) - ( x < y );
+}
+
+static inline void
+markDirty ( CringedScene * scene, uint32_t slot )
+{
+    if ( scene->dirtyMark[ slot ] ) return;
+    scene->dirtyMark[ slot ]               = 1;
+    scene->dirty[ scene->dirtyCount++ ] = slot;
+}
+
+/* Gathers `arr[ order[ k ] ]` into slot k, through `scratch` */
+static void
+permute ( void *           arr,
+          size_t           elemSize,
+          const uint32_t * order,
+          uint32_t         count,
+          void *           scratch )
+{
+    uint8_t * src = ( uint8_t * ) arr;
+    uint8_t * tmp = ( uint8_t * ) scratch;
+    for ( uint32_t k = 0; k < count; k++ )
+        memcpy ( tmp + k * elemSize, src + order[ k ] * elemSize, elemSize );
+    memcpy ( arr, scratch, count * elemSize );
+}
+
+CringedScene *
+cringedCreateScene ( uint32_t capacity )
+{
+    if ( ! capacity ) return NULL;
+
+    CringedScene * scene =
+        ( CringedScene * ) calloc ( 1, sizeof ( CringedScene ) );
+    if ( ! scene ) return NULL;
+
+    size_t n          = capacity;
+    scene->capacity   = capacity;
+    scene->flattened  = 1;
+    scene->parent     = ( uint32_t * ) malloc ( n * sizeof ( uint32_t ) );
+    scene->firstChild = ( uint32_t * ) malloc ( n * sizeof ( uint32_t ) );
+    scene->childCount = ( uint32_t * ) malloc ( n * sizeof ( uint32_t ) );
+    scene->depth      = ( uint32_t * ) malloc ( n * sizeof ( uint32_t ) );
+    scene->depthStart =
+        ( uint32_t * ) malloc ( ( n + 1 ) * sizeof ( uint32_t ) );
+    scene->ids       = ( uint32_t * ) malloc ( n * sizeof ( uint32_t ) );
+    scene->remap     = ( uint32_t * ) malloc ( n * sizeof ( uint32_t ) );
+    scene->position  = ( vec3 * ) malloc ( n * sizeof ( vec3 ) );
+    scene->rotation  = ( versor * ) aligned_alloc ( 16, n * sizeof ( versor ) );
+    scene->scale     = ( vec3 * ) malloc ( n * sizeof ( vec3 ) );
+    scene->world     = ( mat4 * ) aligned_alloc ( 32, n * sizeof ( mat4 ) );
+    scene->stamp     = ( uint64_t * ) calloc ( n, sizeof ( uint64_t ) );
+    scene->dirtyMark = ( uint8_t * ) calloc ( n, sizeof ( uint8_t ) );
+    scene->dirty     = ( uint32_t * ) malloc ( n * sizeof ( uint32_t ) );
+    scene->queue     = ( uint32_t * ) malloc ( n * sizeof ( uint32_t ) );
+    scene->changed   = ( uint32_t * ) malloc ( n * sizeof ( uint32_t ) );
+    scene->ranges = ( CringedRange * ) malloc ( n * sizeof ( CringedRange ) );
+    scene->copies = ( VkBufferCopy * ) malloc ( n * sizeof ( VkBufferCopy ) );
+    scene->sortKeys = ( uint64_t * ) malloc ( n * sizeof ( uint64_t ) );
+    scene->scratch  = aligned_alloc ( 32, n * sizeof ( mat4 ) );
+
+    if ( ! scene->parent || ! scene->firstChild || ! scene->childCount ||
+         ! scene->depth || ! scene->depthStart || ! scene->ids ||
+         ! scene->remap || ! scene->position || ! scene->rotation ||
+         ! scene->scale || ! scene->world || ! scene->stamp ||
+         ! scene->dirtyMark || ! scene->dirty || ! scene->queue ||
+         ! scene->changed || ! scene->ranges || ! scene->copies ||
+         ! scene->sortKeys || ! scene->scratch )
+    {
+        cringedDestroyScene ( scene );
+        return NULL;
+    }
+    return scene;
+}
+
+void
+cringedDestroyScene ( CringedScene * scene )
+{
+    if ( ! scene ) return;
+    void * arrays[] = { scene->parent,    scene->firstChild, scene->childCount,
+                        scene->depth,     scene->depthStart, scene->ids,
+                        scene->remap,     scene->position,   scene->rotation,
+                        scene->scale,     scene->world,      scene->stamp,
+                        scene->dirtyMark, scene->dirty,      scene->queue,
+                        scene->changed,   scene->ranges,     scene->copies,
+                        scene->sortKeys,  scene->scratch };
+    for ( uint32_t i = 0; i < sizeof ( arrays ) / sizeof ( arrays[ 0 ] ); i++ )
+        free ( arrays[ i ] );
+    free ( scene );
+}
+
+uint32_t
+cringedSceneAdd ( CringedScene * scene,
+                  uint32_t       parentId,
+                  vec3           position,
+                  versor         rotation,
+                  vec3           scale )
+{
+    if ( scene->count >= scene->capacity ) return CRINGED_SCENE_NONE;
+    if ( parentId != CRINGED_SCENE_NONE && parentId >= scene->count )
+        return CRINGED_SCENE_NONE;
+
+    /* NOTE: appended after its parent, so parent slot < child slot holds
+     * even before the next flatten */
+    uint32_t slot = scene->count, id = scene->count;
+    uint32_t parentSlot =
+        parentId == CRINGED_SCENE_NONE ? CRINGED_SCENE_NONE
+                                       : scene->remap[ parentId ];
+
+    scene->parent[ slot ]     = parentSlot;
+    scene->depth[ slot ]      = parentSlot == CRINGED_SCENE_NONE
+                                    ? 0
+                                    : scene->depth[ parentSlot ] + 1;
+    scene->firstChild[ slot ] = CRINGED_SCENE_NONE;
+    scene->childCount[ slot ] = 0;
+    scene->ids[ slot ]        = id;
+    scene->remap[ id ]        = slot;
+    scene->stamp[ slot ]      = 0;
+    scene->dirtyMark[ slot ]  = 0;
+    glm_vec3_copy ( position, scene->position[ slot ] );
+    glm_vec4_copy ( rotation, scene->rotation[ slot ] );
+    glm_vec3_copy ( scale, scene->scale[ slot ] );
+
+    scene->count++;
+    scene->flattened = 0;
+    return id;
+}
+
+void
+cringedSceneSetLocal ( CringedScene * scene,
+                       uint32_t       id,
+                       vec3           position,
+                       versor         rotation,
+                       vec3           scale )
+{
+    uint32_t slot = scene->remap[ id ];
+    glm_vec3_copy ( position, scene->position[ slot ] );
+    glm_vec4_copy ( rotation, scene->rotation[ slot ] );
+    glm_vec3_copy ( scale, scene->scale[ slot ] );
+    markDirty ( scene, slot );
+}
+
+void
+cringedSceneFlatten ( CringedScene * scene )
+{
+    uint32_t   n        = scene->count;
+    uint32_t * order    = scene->changed; /* new slot -> old slot */
+    uint32_t * oldToNew = scene->queue;
+    uint32_t * cursor   = scene->childCount; /* rebuilt below */
+
+    /* Bucket by depth (stable) */
+    uint32_t depthCount = 0;
+    for ( uint32_t i = 0; i < n; i++ )
+        if ( scene->depth[ i ] + 1 > depthCount )
+            depthCount = scene->depth[ i ] + 1;
+
+    memset ( scene->depthStart, 0, ( depthCount + 1 ) * sizeof ( uint32_t ) );
+    for ( uint32_t i = 0; i < n; i++ ) scene->depthStart[ scene->depth[ i ] + 1 ]++;
+    for ( uint32_t d = 0; d < depthCount; d++ )
+    {
+        scene->depthStart[ d + 1 ] += scene->depthStart[ d ];
+        cursor[ d ] = scene->depthStart[ d ];
+    }
+    for ( uint32_t i = 0; i < n; i++ ) order[ cursor[ scene->depth[ i ] ]++ ] = i;
+
+    /* Within a level group siblings: sort by the parent's new slot */
+    for ( uint32_t d = 0; d < depthCount; d++ )
+    {
+        uint32_t start = scene->depthStart[ d ];
+        uint32_t end   = scene->depthStart[ d + 1 ];
+        if ( d > 0 )
+        {
+            for ( uint32_t k = start; k < end; k++ )
+            {
+                uint32_t old = order[ k ];
+                scene->sortKeys[ k - start ] =
+                    ( ( uint64_t ) oldToNew[ scene->parent[ old ] ] << 32 ) |
+                    old;
+            }
+            qsort ( scene->sortKeys,
+                    end - start,
+                    sizeof ( uint64_t ),
+                    compareU64 );
+            for ( uint32_t k = start; k < end; k++ )
+                order[ k ] = ( uint32_t ) scene->sortKeys[ k - start ];
+        }
+        for ( uint32_t k = start; k < end; k++ ) oldToNew[ order[ k ] ] = k;
+    }
+
+    permute ( scene->parent, sizeof ( uint32_t ), order, n, scene->scratch );
+    permute ( scene->depth, sizeof ( uint32_t ), order, n, scene->scratch );
+    permute ( scene->ids, sizeof ( uint32_t ), order, n, scene->scratch );
+    permute ( scene->position, sizeof ( vec3 ), order, n, scene->scratch );
+    permute ( scene->rotation, sizeof ( versor ), order, n, scene->scratch );
+    permute ( scene->scale, sizeof ( vec3 ), order, n, scene->scratch );
+
+    for ( uint32_t k = 0; k < n; k++ )
+    {
+        if ( scene->parent[ k ] != CRINGED_SCENE_NONE )
+            scene->parent[ k ] = oldToNew[ scene->parent[ k ] ];
+        scene->remap[ scene->ids[ k ] ] = k;
+        scene->firstChild[ k ]          = CRINGED_SCENE_NONE;
+        scene->childCount[ k ]          = 0;
+    }
+    for ( uint32_t k = 0; k < n; k++ )
+    {
+        uint32_t p = scene->parent[ k ];
+        if ( p == CRINGED_SCENE_NONE ) continue;
+        if ( ! scene->childCount[ p ] ) scene->firstChild[ p ] = k;
+        scene->childCount[ p ]++;
+    }
+
+    /* Slots moved: everything is re-propagated and re-uploaded once */
+    for ( uint32_t k = 0; k < n; k++ )
+    {
+        scene->dirty[ k ]     = k;
+        scene->dirtyMark[ k ] = 1;
+    }
+    scene->dirtyCount   = n;
+    scene->changedCount = 0;
+    scene->rangeCount   = 0;
+    scene->depthCount   = depthCount;
+    scene->flattened    = 1;
+}
+
+static inline void
+propagateNode ( CringedScene * scene, uint32_t slot )
+{
+    mat4 translate, rot, local;
+    glm_translate_make ( translate, scene->position[ slot ] );
+    glm_quat_mat4 ( scene->rotation[ slot ], rot );
+    glm_mat4_mul ( translate, rot, local );
+    glm_scale ( local, scene->scale[ slot ] );
+
+    uint32_t parent = scene->parent[ slot ];
+    if ( parent == CRINGED_SCENE_NONE )
+        glm_mat4_copy ( local, scene->world[ slot ] );
+    else
+        glm_mat4_mul ( scene->world[ parent ], local, scene->world[ slot ] );
+}
+
+uint32_t
+cringedScenePropagate ( CringedScene * scene )
+{
+    if ( ! scene->flattened ) cringedSceneFlatten ( scene );
+    scene->frame++;
+
+    /* Explicitly dirty slots, ascending == parents before children */
+    qsort ( scene->dirty, scene->dirtyCount, sizeof ( uint32_t ), compareU32 );
+
+    /* Merge the sorted dirty list with the queue of descendants; the queue
+     * is ascending too, since siblings are contiguous and levels ordered */
+    uint32_t d = 0, head = 0, tail = 0, updated = 0;
+    while ( d < scene->dirtyCount || head < tail )
+    {
+        uint32_t slot;
+        if ( head < tail &&
+             ( d >= scene->dirtyCount || scene->queue[ head ] <= scene->dirty[ d ] ) )
+            slot = scene->queue[ head++ ];
+        else
+            slot = scene->dirty[ d++ ];
+
+        if ( scene->stamp[ slot ] == scene->frame ) continue;
+        scene->stamp[ slot ]     = scene->frame;
+        scene->dirtyMark[ slot ] = 0;
+
+        propagateNode ( scene, slot );
+        scene->changed[ updated++ ] = slot;
+
+        uint32_t first = scene->firstChild[ slot ];
+        for ( uint32_t c = 0; c < scene->childCount[ slot ]; c++ )
+            scene->queue[ tail++ ] = first + c;
+    }
+    scene->dirtyCount   = 0;
+    scene->changedCount = updated;
+
+    /* Coalesce changed slots into copy ranges, bridging small gaps */
+    for ( uint32_t i = 0; i < updated; i++ )
+    {
+        uint32_t       slot = scene->changed[ i ];
+        CringedRange * last =
+            scene->rangeCount ? &scene->ranges[ scene->rangeCount - 1 ] : NULL;
+        if ( last && slot < last->first + last->count + CRINGED_SCENE_RANGE_GAP )
+            last->count = slot - last->first + 1;
+        else
+        {
+            scene->ranges[ scene->rangeCount ].first = slot;
+            scene->ranges[ scene->rangeCount ].count = 1;
+            scene->rangeCount++;
+        }
+    }
+    return updated;
+}
+
+VkResult
+cringedSceneCreateBuffer ( CringedScene *   scene,
+                           VkPhysicalDevice physicalDevice,
+                           VkDevice         device )
+{
+    return cringedCreateBuffer ( physicalDevice,
+                                 device,
+                                 scene->capacity * sizeof ( mat4 ),
+                                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                     VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                 &scene->worldBuffer );
+}
+
+void
+cringedSceneDestroyBuffer ( CringedScene * scene, VkDevice device )
+{
+    cringedDestroyBuffer ( device, &scene->worldBuffer );
+}
+
+VkDeviceSize
+cringedSceneRecordUpload ( CringedScene *    scene,
+                           VkCommandBuffer   commandBuffer,
+                           BasedRingBuffer * ring )
+{
+    if ( ! scene->rangeCount || ! scene->worldBuffer.buffer ) return 0;
+
+    VkDeviceSize bytes     = 0;
+    uint32_t     copyCount = 0;
+    for ( uint32_t r = 0; r < scene->rangeCount; r++ )
+    {
+        CringedRange * range = &scene->ranges[ r ];
+        VkDeviceSize   size  = range->count * sizeof ( mat4 );
+        uint32_t       offset;
+        void *         dst = cringedRingAlloc ( ring, size, &offset );
+        if ( ! dst )
+        {
+            /* Ring exhausted: whatever is left goes out next frame */
+            for ( ; r < scene->rangeCount; r++ )
+                for ( uint32_t s = 0; s < scene->ranges[ r ].count; s++ )
+                    markDirty ( scene, scene->ranges[ r ].first + s );
+            break;
+        }
+        memcpy ( dst, scene->world + range->first, size );
+
+        scene->copies[ copyCount ].srcOffset = offset;
+        scene->copies[ copyCount ].dstOffset = range->first * sizeof ( mat4 );
+        scene->copies[ copyCount ].size      = size;
+        copyCount++;
+        bytes += size;
+    }
+    scene->rangeCount = 0;
+    if ( ! copyCount ) return 0;
+
+    /* WAR: earlier frames may still read the buffer in the vertex stage */
+    vkCmdPipelineBarrier ( commandBuffer,
+                           VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT,
+                           0,
+                           0,
+                           NULL,
+                           0,
+                           NULL,
+                           0,
+                           NULL );
+
+    vkCmdCopyBuffer ( commandBuffer,
+                      ring->buffer.buffer,
+                      scene->worldBuffer.buffer,
+                      copyCount,
+                      scene->copies );
+
+    VkBufferMemoryBarrier barrier = {};
+    barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask       = VK_ACCESS_SHADER_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer              = scene->worldBuffer.buffer;
+    barrier.offset              = 0;
+    barrier.size                = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier ( commandBuffer,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT,
+                           VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                           0,
+                           0,
+                           NULL,
+                           1,
+                           &barrier,
+                           0,
+                           NULL );
+    return bytes;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#ifndef CRINGED_SCENE_H
+#define CRINGED_SCENE_H
+
+#include "bufferUtils.h"
+
+#include <cglm/cglm.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vulkan/vulkan.h>
+
+#define CRINGED_SCENE_NONE UINT32_MAX
+
+/* Changed nodes closer than this are uploaded as one copy region */
+#define CRINGED_SCENE_RANGE_GAP 8
+
+typedef struct
+{
+    uint32_t first;
+    uint32_t count;
+} CringedRange;
+
+/* Flattened hierarchy: nodes sorted by depth, children of a node form one
+ * contiguous range on the next level. A node's parent always has a lower
+ * index, so ascending index order is a valid propagation order.
+ * Callers address nodes by stable ids; `remap` maps id -> slot. */
+typedef struct
+{
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t depthCount;
+    uint8_t  flattened;
+    uint8_t  depthPrePass; /* render depth first, shade with an EQUAL test */
+    /* Hierarchy (by slot) */
+    uint32_t * parent;
+    uint32_t * firstChild;
+    uint32_t * childCount;
+    uint32_t * depth;
+    uint32_t * depthStart; /* first slot of each level, depthCount + 1 */
+    uint32_t * ids;        /* slot -> id */
+    uint32_t * remap;      /* id -> slot */
+    /* Local TRS + propagated world (by slot) */
+    vec3 *   position;
+    versor * rotation;
+    vec3 *   scale;
+    mat4 *   world;
+    /* Dirty tracking */
+    uint64_t   frame;
+    uint64_t * stamp;     /* frame a slot was last propagated */
+    uint8_t *  dirtyMark; /* slot already in `dirty` */
+    uint32_t * dirty;
+    uint32_t   dirtyCount;
+    uint32_t * queue;
+    uint32_t * changed;
+    uint32_t   changedCount;
+    /* Pending GPU upload */
+    CringedRange * ranges;
+    uint32_t       rangeCount;
+    VkBufferCopy * copies;
+    BasedBuffer    worldBuffer; /* device local, one mat4 per slot */
+    /* Flatten scratch */
+    uint64_t * sortKeys;
+    void *     scratch;
+} CringedScene;
+
+CringedScene *
+cringedCreateScene ( uint32_t capacity );
+
+void
+cringedDestroyScene ( CringedScene * scene );
+
+/* Returns node id, or CRINGED_SCENE_NONE when full. `parentId` must be an
+ * existing node or CRINGED_SCENE_NONE for a root. */
+uint32_t
+cringedSceneAdd ( CringedScene * scene,
+                  uint32_t       parentId,
+                  vec3           position,
+                  versor         rotation,
+                  vec3           scale );
+
+void
+cringedSceneSetLocal ( CringedScene * scene,
+                       uint32_t       id,
+                       vec3           position,
+                       versor         rotation,
+                       vec3           scale );
+
+/* Re-sort by depth after structural edits; marks every node dirty */
+void
+cringedSceneFlatten ( CringedScene * scene );
+
+/* Updates world matrices of dirty subtrees only, collects the changed
+ * slots into upload ranges. Returns the number of nodes updated. */
+uint32_t
+cringedScenePropagate ( CringedScene * scene );
+
+VkResult
+cringedSceneCreateBuffer ( CringedScene *   scene,
+                           VkPhysicalDevice physicalDevice,
+                           VkDevice         device );
+
+void
+cringedSceneDestroyBuffer ( CringedScene * scene, VkDevice device );
+
+/* Stages changed ranges through `ring` and records the copies plus
+ * barriers into `commandBuffer` (outside a render pass). Returns the
+ * number of bytes uploaded. */
+VkDeviceSize
+cringedSceneRecordUpload ( CringedScene *    scene,
+                           VkCommandBuffer   commandBuffer,
+                           BasedRingBuffer * ring );
+
+#endif /* CRINGED_SCENE_H */
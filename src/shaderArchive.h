@@ -0,0 +1,68 @@
+#pragma once
+#ifndef CRINGED_SHADER_ARCHIVE_H
+#define CRINGED_SHADER_ARCHIVE_H
+
+#include <stdint.h>
+
+/* Shader archive, written by shaderPack.c, mapped by shaderUtils.c.
+ * Host byte order, every offset from the start of the file:
+ *   header
+ *   entries[ entryCount ]  sorted by nameHash, for a binary search
+ *   blobs[ blobCount ]     distinct SPIR-V, shared by equal entries
+ *   blob data              each at a CRINGED_ARCHIVE_ALIGN offset
+ * Names are the .spv file names without the extension, "Triangle_vert",
+ * hashed with cringedArchiveHash. */
+#define CRINGED_ARCHIVE_MAGIC   0x41534843u /* "CHSA" */
+#define CRINGED_ARCHIVE_VERSION 1
+#define CRINGED_ARCHIVE_ALIGN   4 /* SPIR-V words, vkCreateShaderModule */
+
+/* Blob flags */
+#define CRINGED_ARCHIVE_LZ 1u /* compressed, see below */
+
+/* Compressed blobs are a stream of 32-bit tokens, each followed by
+ *   bit 31 clear: `token` literal words
+ *   bit 31 set:   nothing; copies (token & 0xffff) words starting
+ *                 ((token >> 16) & 0x7fff) words back in the output
+ * SPIR-V repeats whole instructions, so matching words is enough. */
+#define CRINGED_ARCHIVE_MATCH        0x80000000u
+#define CRINGED_ARCHIVE_MAX_DISTANCE 0x7fffu
+#define CRINGED_ARCHIVE_MAX_LENGTH   0xffffu
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t blobCount;
+} CringedArchiveHeader;
+
+typedef struct
+{
+    uint64_t nameHash;
+    uint32_t blob;
+    uint32_t reserved;
+} CringedArchiveEntry;
+
+typedef struct
+{
+    uint32_t offset;
+    uint32_t size;    /* bytes stored */
+    uint32_t rawSize; /* bytes of SPIR-V */
+    uint32_t flags;   /* CRINGED_ARCHIVE_* */
+} CringedArchiveBlob;
+
+/* FNV-1a, 64-bit */
+static inline uint64_t
+cringedArchiveHash ( const void * data, uint64_t size )
+{
+    const uint8_t * bytes = ( const uint8_t * ) data;
+    uint64_t        hash  = 0xcbf29ce484222325ull;
+    for ( uint64_t i = 0; i < size; i++ )
+    {
+        hash ^= bytes[ i ];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+#endif /* CRINGED_SHADER_ARCHIVE_H */
@@ -0,0 +1,251 @@
+#include "shaderArchive.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* =============================================
+ *     SHADER ARCHIVE PACKER (make shaders)
+ * ============================================= */
+
+/* shaderPack [-z] OUT.pack A.spv B.spv ...
+ *   -z: compress the blobs that get smaller */
+
+typedef struct
+{
+    uint64_t nameHash;
+    uint32_t blob;
+    char     name[ 256 ];
+} Input;
+
+typedef struct
+{
+    uint32_t * words; /* as stored */
+    uint32_t   size;
+    uint32_t   rawSize;
+    uint32_t   flags;
+    uint64_t   contentHash;
+    uint32_t * raw; /* for deduplication */
+} Blob;
+
+static uint32_t *
+readSpirv ( const char * path, uint32_t * size )
+{
+    FILE * file = fopen ( path, "rb" );
+    if ( ! file ) return NULL;
+
+    uint32_t * words = NULL;
+    long       bytes = 0;
+    if ( fseek ( file, 0, SEEK_END ) == 0 && ( bytes = ftell ( file ) ) > 0 &&
+         bytes % CRINGED_ARCHIVE_ALIGN == 0 &&
+         fseek ( file, 0, SEEK_SET ) == 0 &&
+         ( words = ( uint32_t * ) malloc ( bytes ) ) &&
+         fread ( words, 1, bytes, file ) != ( size_t ) bytes )
+    {
+        free ( words );
+        words = NULL;
+    }
+    fclose ( file );
+    *size = ( uint32_t ) bytes;
+    return words;
+}
+
+/* Greedy: the last position of every word pair, the longest run from it */
+static uint32_t *
+compress ( const uint32_t * in, uint32_t count, uint32_t * outCount )
+{
+    enum { TABLE_BITS = 14 };
+    uint32_t * out   = ( uint32_t * ) malloc ( ( 2 * count + 1 ) * 4 );
+    int64_t *  table = ( int64_t * ) malloc ( sizeof ( int64_t )
+                                              << TABLE_BITS );
+    if ( ! out || ! table )
+    {
+        free ( out );
+        free ( table );
+        return NULL;
+    }
+    for ( uint32_t t = 0; t < 1u << TABLE_BITS; t++ ) table[ t ] = -1;
+
+    uint32_t o = 0, literal = 0, literalToken = 0;
+    for ( uint32_t i = 0; i < count; )
+    {
+        uint32_t length = 0, distance = 0;
+        if ( i + 1 < count )
+        {
+            uint32_t slot = ( in[ i ] * 2654435761u ^ in[ i + 1 ] * 40503u ) >>
+                            ( 32 - TABLE_BITS );
+            int64_t candidate = table[ slot ];
+            table[ slot ]     = i;
+            if ( candidate >= 0 &&
+                 i - candidate <= CRINGED_ARCHIVE_MAX_DISTANCE )
+            {
+                while ( i + length < count &&
+                        length < CRINGED_ARCHIVE_MAX_LENGTH &&
+                        in[ candidate + length ] == in[ i + length ] )
+                    length++;
+                distance = i - ( uint32_t ) candidate;
+            }
+        }
+
+        /* A match token only pays off from two words on */
+        if ( length >= 2 )
+        {
+            out[ o++ ] =
+                CRINGED_ARCHIVE_MATCH | distance << 16 | length;
+            literal = 0;
+            i += length;
+            continue;
+        }
+        if ( ! literal ) literalToken = o++;
+        out[ literalToken ] = ++literal;
+        out[ o++ ]          = in[ i++ ];
+    }
+    free ( table );
+    *outCount = o;
+    return out;
+}
+
+static void
+baseName ( const char * path, char * name, size_t size )
+{
+    const char * slash = strrchr ( path, '/' );
+    const char * start = slash ? slash + 1 : path;
+    const char * dot   = strrchr ( start, '.' );
+    size_t       len   = dot ? ( size_t ) ( dot - start ) : strlen ( start );
+    if ( len >= size ) len = size - 1;
+    memcpy ( name, start, len );
+    name[ len ] = '\0';
+}
+
+static int
+byHash ( const void * a, const void * b )
+{
+    uint64_t x = ( ( const Input * ) a )->nameHash;
+    uint64_t y = ( ( const Input * ) b )->nameHash;
+    return x < y ? -1 : x > y;
+}
+
+int
+main ( int argc, char ** argv )
+{
+    int lz    = argc > 1 && ! strcmp ( argv[ 1 ], "-z" );
+    int first = 2 + lz;
+    if ( argc < first )
+    {
+        fprintf (
+            stderr, "usage: %s [-z] OUT.pack SHADER.spv...\n", argv[ 0 ] );
+        return 1;
+    }
+
+    uint32_t inputCount = ( uint32_t ) ( argc - first );
+    Input *  inputs = ( Input * ) calloc ( inputCount + 1, sizeof ( Input ) );
+    Blob *   blobs  = ( Blob * ) calloc ( inputCount + 1, sizeof ( Blob ) );
+    if ( ! inputs || ! blobs ) return 1;
+
+    uint32_t blobCount = 0;
+    uint64_t rawBytes = 0, storedBytes = 0;
+    for ( uint32_t s = 0; s < inputCount; s++ )
+    {
+        const char * path = argv[ first + s ];
+        uint32_t     size;
+        uint32_t *   words = readSpirv ( path, &size );
+        if ( ! words )
+        {
+            fprintf ( stderr, "error: reading SPIR-V %s\n", path );
+            return 1;
+        }
+        baseName ( path, inputs[ s ].name, sizeof ( inputs[ s ].name ) );
+        inputs[ s ].nameHash = cringedArchiveHash (
+            inputs[ s ].name, strlen ( inputs[ s ].name ) );
+        for ( uint32_t p = 0; p < s; p++ )
+            if ( inputs[ p ].nameHash == inputs[ s ].nameHash )
+            {
+                fprintf ( stderr,
+                          "error: %s and %s hash alike\n",
+                          inputs[ p ].name,
+                          inputs[ s ].name );
+                return 1;
+            }
+        rawBytes += size;
+
+        /* Identical SPIR-V is stored once */
+        uint64_t contentHash = cringedArchiveHash ( words, size );
+        uint32_t b           = 0;
+        while ( b < blobCount &&
+                ! ( blobs[ b ].contentHash == contentHash &&
+                    blobs[ b ].rawSize == size &&
+                    ! memcmp ( blobs[ b ].raw, words, size ) ) )
+            b++;
+        inputs[ s ].blob = b;
+        if ( b < blobCount )
+        {
+            free ( words );
+            continue;
+        }
+
+        Blob * blob        = &blobs[ blobCount++ ];
+        blob->raw          = words;
+        blob->words        = words;
+        blob->rawSize      = size;
+        blob->size         = size;
+        blob->contentHash  = contentHash;
+        uint32_t   packed  = 0;
+        uint32_t * lzWords = lz ? compress ( words, size / 4, &packed ) : NULL;
+        if ( lzWords && packed * 4 < size )
+        {
+            blob->words = lzWords;
+            blob->size  = packed * 4;
+            blob->flags = CRINGED_ARCHIVE_LZ;
+        }
+        else
+            free ( lzWords );
+        storedBytes += blob->size;
+    }
+    qsort ( inputs, inputCount, sizeof ( Input ), byHash );
+
+    CringedArchiveHeader header = { CRINGED_ARCHIVE_MAGIC,
+                                    CRINGED_ARCHIVE_VERSION,
+                                    inputCount,
+                                    blobCount };
+    uint32_t offset = sizeof ( header ) +
+                      inputCount * sizeof ( CringedArchiveEntry ) +
+                      blobCount * sizeof ( CringedArchiveBlob );
+
+    FILE * file = fopen ( argv[ first - 1 ], "wb" );
+    if ( ! file )
+    {
+        fprintf ( stderr, "error: writing %s\n", argv[ first - 1 ] );
+        return 1;
+    }
+    fwrite ( &header, sizeof ( header ), 1, file );
+    for ( uint32_t s = 0; s < inputCount; s++ )
+    {
+        CringedArchiveEntry entry = { inputs[ s ].nameHash,
+                                      inputs[ s ].blob,
+                                      0 };
+        fwrite ( &entry, sizeof ( entry ), 1, file );
+    }
+    /* Sizes are whole words: every offset stays aligned */
+    for ( uint32_t b = 0; b < blobCount; b++ )
+    {
+        CringedArchiveBlob entry = {
+            offset, blobs[ b ].size, blobs[ b ].rawSize, blobs[ b ].flags };
+        fwrite ( &entry, sizeof ( entry ), 1, file );
+        offset += blobs[ b ].size;
+    }
+    for ( uint32_t b = 0; b < blobCount; b++ )
+        fwrite ( blobs[ b ].words, 1, blobs[ b ].size, file );
+    if ( fclose ( file ) != 0 )
+    {
+        fprintf ( stderr, "error: writing %s\n", argv[ first - 1 ] );
+        return 1;
+    }
+
+    printf ( "%s: %u shaders, %u distinct, %llu of %llu bytes\n",
+             argv[ first - 1 ],
+             inputCount,
+             blobCount,
+             ( unsigned long long ) storedBytes,
+             ( unsigned long long ) rawBytes );
+    return 0;
+}
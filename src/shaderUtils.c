@@ -1,8 +1,17 @@
+#define _POSIX_C_SOURCE 199309L
+
 #include "shaderUtils.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 void
 cringedDestroyShader ( BasedShader * shader )
 {
+    if ( ! shader ) return;
+    if ( shader->owned ) free ( shader->data );
     free ( shader );
 }
 
@@ -12,7 +21,198 @@ cringedCreateShader ( unsigned char * data, size_t size )
     BasedShader * shader =
         ( BasedShader * ) malloc ( sizeof ( BasedShader ) );
     if ( ! shader ) return NULL;
-    shader->data = data;
-    shader->size = size;
+    shader->data     = data;
+    shader->size     = size;
+    shader->s_module = NULL;
+    shader->owned    = 0;
+
+    /* pCode must be word aligned, malloc always is */
+    if ( ( uintptr_t ) data % CRINGED_ARCHIVE_ALIGN )
+    {
+        shader->data = ( unsigned char * ) malloc ( size );
+        if ( ! shader->data )
+        {
+            free ( shader );
+            return NULL;
+        }
+        memcpy ( shader->data, data, size );
+        shader->owned = 1;
+    }
     return shader;
 }
+
+/* =============================================
+ *            ARCHIVE
+ * ============================================= */
+
+CringedShaderArchive *
+cringedOpenShaderArchive ( const char * path )
+{
+    int fd = open ( path, O_RDONLY );
+    if ( fd < 0 )
+    {
+        _DEBUG_P ( "error: opening shader archive %s\n", path );
+        return NULL;
+    }
+    struct stat info;
+    void *      base = MAP_FAILED;
+    if ( fstat ( fd, &info ) == 0 &&
+         ( size_t ) info.st_size >= sizeof ( CringedArchiveHeader ) )
+        base = mmap ( NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close ( fd ); /* the mapping keeps the file */
+    if ( base == MAP_FAILED )
+    {
+        _DEBUG_P ( "error: mapping shader archive %s\n", path );
+        return NULL;
+    }
+
+    CringedShaderArchive * archive = ( CringedShaderArchive * ) calloc (
+        1, sizeof ( CringedShaderArchive ) );
+    if ( ! archive )
+    {
+        munmap ( base, info.st_size );
+        return NULL;
+    }
+    archive->base    = ( const uint8_t * ) base;
+    archive->size    = ( size_t ) info.st_size;
+    archive->header  = ( const CringedArchiveHeader * ) base;
+    archive->entries = ( const CringedArchiveEntry * ) ( archive->header + 1 );
+    archive->blobs   = ( const CringedArchiveBlob * ) ( archive->entries +
+                                                      archive->header
+                                                          ->entryCount );
+
+    /* Validated once: lookups then trust every offset */
+    const CringedArchiveHeader * header = archive->header;
+    uint64_t tables = sizeof ( *header ) +
+                      ( uint64_t ) header->entryCount *
+                          sizeof ( CringedArchiveEntry ) +
+                      ( uint64_t ) header->blobCount *
+                          sizeof ( CringedArchiveBlob );
+    uint8_t valid = header->magic == CRINGED_ARCHIVE_MAGIC &&
+                    header->version == CRINGED_ARCHIVE_VERSION &&
+                    tables <= archive->size;
+    for ( uint32_t e = 0; valid && e < header->entryCount; e++ )
+        valid = archive->entries[ e ].blob < header->blobCount;
+    for ( uint32_t b = 0; valid && b < header->blobCount; b++ )
+    {
+        const CringedArchiveBlob * blob = &archive->blobs[ b ];
+        valid = blob->offset % CRINGED_ARCHIVE_ALIGN == 0 &&
+                blob->size % 4 == 0 && blob->rawSize % 4 == 0 &&
+                ( uint64_t ) blob->offset + blob->size <= archive->size &&
+                ( blob->flags & CRINGED_ARCHIVE_LZ ||
+                  blob->size == blob->rawSize );
+    }
+    if ( ! valid )
+    {
+        _DEBUG_P ( "error: corrupt shader archive %s\n", path );
+        cringedCloseShaderArchive ( archive );
+        return NULL;
+    }
+    return archive;
+}
+
+void
+cringedCloseShaderArchive ( CringedShaderArchive * archive )
+{
+    if ( ! archive ) return;
+    munmap ( ( void * ) archive->base, archive->size );
+    free ( archive );
+}
+
+/* CRINGED_ARCHIVE_LZ stream into `out`, FALSE unless it fills it exactly */
+static uint8_t
+decompress ( const uint32_t * in,
+             uint32_t         inCount,
+             uint32_t *       out,
+             uint32_t         outCount )
+{
+    uint32_t i = 0, o = 0;
+    while ( i < inCount )
+    {
+        uint32_t token = in[ i++ ];
+        if ( token & CRINGED_ARCHIVE_MATCH )
+        {
+            uint32_t distance = ( token >> 16 ) & CRINGED_ARCHIVE_MAX_DISTANCE;
+            uint32_t length   = token & CRINGED_ARCHIVE_MAX_LENGTH;
+            if ( ! distance || distance > o || length > outCount - o )
+                return 0;
+            /* Word by word: a match may overlap its own output */
+            for ( uint32_t w = 0; w < length; w++, o++ )
+                out[ o ] = out[ o - distance ];
+        }
+        else
+        {
+            if ( token > inCount - i || token > outCount - o ) return 0;
+            memcpy ( out + o, in + i, token * sizeof ( uint32_t ) );
+            i += token;
+            o += token;
+        }
+    }
+    return o == outCount;
+}
+
+BasedShader *
+cringedArchiveShader ( const CringedShaderArchive * archive,
+                       const char *                 name )
+{
+    uint64_t hash = cringedArchiveHash ( name, strlen ( name ) );
+    uint32_t lo = 0, hi = archive->header->entryCount;
+    while ( lo < hi )
+    {
+        uint32_t mid = lo + ( hi - lo ) / 2;
+        if ( archive->entries[ mid ].nameHash < hash )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if ( lo == archive->header->entryCount ||
+         archive->entries[ lo ].nameHash != hash )
+    {
+        _DEBUG_P ( "error: shader %s not in the archive\n", name );
+        return NULL;
+    }
+
+    const CringedArchiveBlob * blob =
+        &archive->blobs[ archive->entries[ lo ].blob ];
+    unsigned char * data = ( unsigned char * ) archive->base + blob->offset;
+    if ( ! ( blob->flags & CRINGED_ARCHIVE_LZ ) )
+        return cringedCreateShader ( data, blob->size );
+
+    BasedShader * shader = ( BasedShader * ) malloc ( sizeof ( BasedShader ) );
+    uint32_t *    words  = ( uint32_t * ) malloc ( blob->rawSize );
+    if ( ! shader || ! words ||
+         ! decompress ( ( const uint32_t * ) data,
+                        blob->size / 4,
+                        words,
+                        blob->rawSize / 4 ) )
+    {
+        _DEBUG_P ( "error: decompressing shader %s\n", name );
+        free ( words );
+        free ( shader );
+        return NULL;
+    }
+    shader->data     = ( unsigned char * ) words;
+    shader->size     = blob->rawSize;
+    shader->s_module = NULL;
+    shader->owned    = 1;
+    return shader;
+}
+
+VkResult
+cringedArchiveModule ( const CringedShaderArchive * archive,
+                       VkDevice                     device,
+                       const char *                 name,
+                       VkShaderModule *             module )
+{
+    BasedShader * shader = cringedArchiveShader ( archive, name );
+    if ( ! shader ) return VK_ERROR_INITIALIZATION_FAILED;
+
+    VkShaderModuleCreateInfo createInfo = {};
+    createInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = shader->size;
+    createInfo.pCode    = ( uint32_t * ) shader->data;
+    VkResult opResult =
+        vkCreateShaderModule ( device, &createInfo, NULL, module );
+    cringedDestroyShader ( shader );
+    return opResult;
+}
@@ -11,7 +11,10 @@
 #define _DEBUG_P( ... ) ( ( void ) 0 )
 #endif
 
+#include "shaderArchive.h"
+
 #include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -19,15 +22,48 @@
 
 typedef struct
 {
-    unsigned char *  data;
+    unsigned char *  data; /* CRINGED_ARCHIVE_ALIGN aligned */
     VkShaderModule * s_module;
     size_t           size;
+    uint8_t          owned; /* `data` is a copy, freed with the shader */
 } BasedShader;
 
+/* Read-only mapping of a shaderPack.c archive, shared by every thread */
+typedef struct
+{
+    const uint8_t *              base;
+    size_t                       size;
+    const CringedArchiveHeader * header;
+    const CringedArchiveEntry *  entries;
+    const CringedArchiveBlob *   blobs;
+} CringedShaderArchive;
+
+/* `data` is used in place when aligned, copied otherwise */
 BasedShader *
 cringedCreateShader ( unsigned char * data, size_t size );
 
 void
 cringedDestroyShader ( BasedShader * shader );
 
+/* Maps and validates the archive at `path`, NULL on failure */
+CringedShaderArchive *
+cringedOpenShaderArchive ( const char * path );
+
+/* Shaders taken from the archive must be destroyed first. NULL-safe. */
+void
+cringedCloseShaderArchive ( CringedShaderArchive * archive );
+
+/* SPIR-V of `name`, e.g. "Triangle_vert": points into the mapping unless
+ * the blob is compressed. NULL when missing or corrupt. */
+BasedShader *
+cringedArchiveShader ( const CringedShaderArchive * archive,
+                       const char *                 name );
+
+/* vkCreateShaderModule over the archived `name` */
+VkResult
+cringedArchiveModule ( const CringedShaderArchive * archive,
+                       VkDevice                     device,
+                       const char *                 name,
+                       VkShaderModule *             module );
+
 #endif /* CRINGED_SHADER_UTILS_H */
@@ -0,0 +1,34 @@
+#version 450
+
+// One level of the depth pyramid: every target texel keeps the farthest
+// depth of the source texels it covers. The source is the depth buffer
+// for mip 0 (up to 3x3 texels each), the level below otherwise (2x2).
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(set = 0, binding = 0) uniform sampler2D source;
+layout(set = 0, binding = 1, r32f) uniform writeonly image2D target;
+
+layout(push_constant) uniform Reduce {
+    ivec4 sizes;     // xy: source size, zw: target size
+    ivec4 sourceLod; // x: level of `source` read
+} reduce;
+
+void main() {
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, reduce.sizes.zw)))
+        return;
+
+    // Source footprint [lo, hi) of this texel, rounded outwards
+    ivec2 lo = (texel * reduce.sizes.xy) / reduce.sizes.zw;
+    ivec2 hi = ((texel + 1) * reduce.sizes.xy + reduce.sizes.zw - 1) /
+               reduce.sizes.zw;
+    hi = min(hi, reduce.sizes.xy);
+
+    float farthest = 0.0;
+    for (int y = lo.y; y < hi.y; y++)
+        for (int x = lo.x; x < hi.x; x++)
+            farthest = max(farthest,
+                           texelFetch(source, ivec2(x, y),
+                                      reduce.sourceLod.x).r);
+    imageStore(target, texel, vec4(farthest));
+}
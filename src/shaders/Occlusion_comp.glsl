@@ -0,0 +1,130 @@
+#version 450
+
+// Hierarchical-Z test of the frustum-visible instances. Early phase:
+// against last frame's pyramid, survivors are appended to the early list
+// of their level of detail. Late phase: early rejects against this
+// frame's pyramid, appended to the late lists. Depth is 0 near, 1 far;
+// the pyramid keeps the farthest.
+layout(local_size_x = 64) in;
+
+const uint LOD_MAX = 4; // CRINGED_LOD_MAX
+
+struct Candidate {
+    vec4 sphere;    // xyz: world center, w: radius
+    uvec4 instance; // x: index into the instances ring, y: level
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Candidates {
+    Candidate candidates[];
+};
+
+// [phase][level][capacity] instance indices, then the early flags
+layout(std430, set = 0, binding = 1) buffer Lists {
+    uint lists[];
+};
+
+struct DrawCommand {
+    uint vertexCount;
+    uint instanceCount;
+    uint firstVertex;
+    uint firstInstance;
+};
+
+layout(std430, set = 0, binding = 2) buffer Commands {
+    DrawCommand commands[2 * LOD_MAX]; // [phase][level]
+};
+
+layout(set = 0, binding = 3) uniform sampler2D pyramid;
+
+layout(push_constant) uniform Cull {
+    mat4 viewProj; // the pyramid was rendered with
+    uvec4 counts;  // x: candidates, y: phase, z: mip count, w: capacity
+    vec4 size;     // xy: mip 0 size, z: 1 when the pyramid is valid
+} cull;
+
+shared uint groupCount[LOD_MAX];
+shared uint groupBase[LOD_MAX];
+
+// Conservative: anything crossing the near plane or leaving the
+// pyramid's reach counts as visible
+bool occluded(vec4 sphere) {
+    if (cull.size.z == 0.0)
+        return false;
+
+    vec2 lo = vec2(1.0), hi = vec2(-1.0);
+    float nearest = 1.0;
+    for (int i = 0; i < 8; i++) {
+        vec3 corner = vec3((i & 1) != 0 ? 1.0 : -1.0,
+                           (i & 2) != 0 ? 1.0 : -1.0,
+                           (i & 4) != 0 ? 1.0 : -1.0);
+        vec4 clip = cull.viewProj * vec4(sphere.xyz + corner * sphere.w, 1.0);
+        if (clip.w <= 0.0)
+            return false;
+        vec3 ndc = clip.xyz / clip.w;
+        lo = min(lo, ndc.xy);
+        hi = max(hi, ndc.xy);
+        nearest = min(nearest, ndc.z);
+    }
+    if (nearest <= 0.0)
+        return false;
+
+    vec2 uvLo = clamp(lo * 0.5 + 0.5, 0.0, 1.0);
+    vec2 uvHi = clamp(hi * 0.5 + 0.5, 0.0, 1.0);
+    vec2 texels = (uvHi - uvLo) * cull.size.xy;
+    int lastMip = int(cull.counts.z) - 1;
+    int mip = clamp(int(ceil(log2(max(max(texels.x, texels.y), 1.0)))),
+                    0, lastMip);
+
+    // The rectangle spans at most 2x2 texels at `mip`, rounding may
+    // need one level more
+    ivec2 size, a, b;
+    for (;;) {
+        size = textureSize(pyramid, mip);
+        a = min(ivec2(uvLo * vec2(size)), size - 1);
+        b = min(ivec2(uvHi * vec2(size)), size - 1);
+        if (all(lessThanEqual(b - a, ivec2(1))) || mip == lastMip)
+            break;
+        mip++;
+    }
+    float farthest = max(max(texelFetch(pyramid, a, mip).r,
+                             texelFetch(pyramid, ivec2(b.x, a.y), mip).r),
+                         max(texelFetch(pyramid, ivec2(a.x, b.y), mip).r,
+                             texelFetch(pyramid, b, mip).r));
+    return nearest > farthest;
+}
+
+void main() {
+    uint id = gl_GlobalInvocationID.x;
+    uint phase = cull.counts.y;
+    uint capacity = cull.counts.w;
+
+    if (gl_LocalInvocationIndex < LOD_MAX)
+        groupCount[gl_LocalInvocationIndex] = 0;
+    barrier();
+
+    bool draw = false;
+    if (id < cull.counts.x) {
+        if (phase == 0u) {
+            draw = ! occluded(candidates[id].sphere);
+            lists[2u * LOD_MAX * capacity + id] = draw ? 1u : 0u;
+        } else if (lists[2u * LOD_MAX * capacity + id] == 0u) {
+            draw = ! occluded(candidates[id].sphere);
+        }
+    }
+
+    // One global atomic per workgroup and level, not per instance
+    uint level = draw ? min(candidates[id].instance.y, LOD_MAX - 1u) : 0u;
+    uint local = 0;
+    if (draw)
+        local = atomicAdd(groupCount[level], 1);
+    barrier();
+    uint slot = phase * LOD_MAX + gl_LocalInvocationIndex;
+    if (gl_LocalInvocationIndex < LOD_MAX &&
+        groupCount[gl_LocalInvocationIndex] > 0)
+        groupBase[gl_LocalInvocationIndex] = atomicAdd(
+            commands[slot].instanceCount, groupCount[gl_LocalInvocationIndex]);
+    barrier();
+    if (draw)
+        lists[(phase * LOD_MAX + level) * capacity + groupBase[level] +
+              local] = candidates[id].instance.x;
+}
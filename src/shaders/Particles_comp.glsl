@@ -0,0 +1,94 @@
+#version 450
+
+// Ping-pong step: survivors of `source` and new particles are appended,
+// compacted, to the target buffer; its draw command counts them
+layout(local_size_x = 256) in;
+
+struct Particle {
+    vec4 positionAge;  // xyz: position, w: age in seconds
+    vec4 velocityLife; // xyz: velocity, w: lifetime in seconds
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Source {
+    Particle source[];
+};
+
+layout(std430, set = 0, binding = 1) writeonly buffer Target {
+    Particle target[];
+};
+
+struct DrawCommand {
+    uint vertexCount;
+    uint instanceCount; // live particles of that buffer
+    uint firstVertex;
+    uint firstInstance;
+};
+
+layout(std430, set = 0, binding = 2) buffer Counters {
+    DrawCommand commands[2];
+};
+
+layout(push_constant) uniform Simulation {
+    vec4  emitter; // xyz: position, w: speed
+    vec4  gravity; // xyz: acceleration, w: delta seconds
+    uvec4 counts;  // x: emit, y: limit, z: seed, w: source buffer
+    vec4  params;  // x: lifetime, y: spread
+} sim;
+
+shared uint groupCount;
+shared uint groupBase;
+
+uint hash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+float random(inout uint state) {
+    state = hash(state);
+    return float(state) * (1.0 / 4294967296.0);
+}
+
+void main() {
+    uint id = gl_GlobalInvocationID.x;
+    uint src = sim.counts.w;
+    uint alive = min(commands[src].instanceCount, sim.counts.y);
+    float dt = sim.gravity.w;
+
+    if (gl_LocalInvocationIndex == 0)
+        groupCount = 0;
+    barrier();
+
+    Particle p;
+    bool keep = false;
+    if (id < alive) {
+        p = source[id];
+        p.velocityLife.xyz += sim.gravity.xyz * dt;
+        p.positionAge.xyz += p.velocityLife.xyz * dt;
+        p.positionAge.w += dt;
+        keep = p.positionAge.w < p.velocityLife.w;
+    } else if (id < min(alive + sim.counts.x, sim.counts.y)) {
+        uint state = hash(id ^ sim.counts.z);
+        vec3 dir = normalize(vec3((random(state) - 0.5) * sim.params.y,
+                                  -1.0,
+                                  (random(state) - 0.5) * sim.params.y));
+        p.positionAge = vec4(sim.emitter.xyz, random(state) * dt);
+        p.velocityLife = vec4(dir * sim.emitter.w * (0.5 + random(state)),
+                              sim.params.x * (0.5 + random(state)));
+        keep = true;
+    }
+
+    // One global atomic per workgroup, not per particle
+    uint local = 0;
+    if (keep)
+        local = atomicAdd(groupCount, 1);
+    barrier();
+    if (gl_LocalInvocationIndex == 0 && groupCount > 0)
+        groupBase = atomicAdd(commands[1 - src].instanceCount, groupCount);
+    barrier();
+    if (keep)
+        target[groupBase + local] = p;
+}
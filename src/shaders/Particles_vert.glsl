@@ -0,0 +1,39 @@
+#version 450
+
+// Instanced camera-facing quads, one instance per live particle
+struct Particle {
+    vec4 positionAge;
+    vec4 velocityLife;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Particles {
+    Particle particles[];
+};
+
+layout(push_constant) uniform Camera {
+    mat4 viewProj;
+    vec4 right; // w: half size
+    vec4 up;
+} camera;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragCorner;
+
+const vec2 corners[6] = vec2[](
+    vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+    vec2(1.0, 1.0), vec2(-1.0, 1.0), vec2(-1.0, -1.0)
+);
+
+void main() {
+    Particle p = particles[gl_InstanceIndex];
+    vec2 corner = corners[gl_VertexIndex];
+    float t = clamp(p.positionAge.w / p.velocityLife.w, 0.0, 1.0);
+
+    vec3 world = p.positionAge.xyz +
+                 (camera.right.xyz * corner.x + camera.up.xyz * corner.y) *
+                     camera.right.w;
+    gl_Position = camera.viewProj * vec4(world, 1.0);
+    fragColor = vec4(mix(vec3(1.0, 0.8, 0.3), vec3(0.8, 0.2, 0.1), t),
+                     1.0 - t);
+    fragCorner = corner;
+}
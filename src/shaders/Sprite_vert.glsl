@@ -0,0 +1,19 @@
+#version 450
+
+// Pixel coordinates, origin top left: ndc = position * scale - 1
+layout(push_constant) uniform Screen {
+    vec2 scale;
+} screen;
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inUV;
+layout(location = 2) in vec4 inColor;
+
+layout(location = 0) out vec2 fragUV;
+layout(location = 1) out vec4 fragColor;
+
+void main() {
+    gl_Position = vec4(inPosition * screen.scale - 1.0, 0.0, 1.0);
+    fragUV = inUV;
+    fragColor = inColor;
+}
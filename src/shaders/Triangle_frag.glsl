@@ -1,9 +1,35 @@
 #version 450
 
+// Specialization constants, see variants.h
+layout(constant_id = 1) const bool LIT = false;
+layout(constant_id = 2) const uint DEBUG_VIEW = 0; // CRINGED_DEBUG_VIEW_*
+
 layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec3 fragNormal;
+layout(location = 2) flat in uint fragInstance;
 
 layout(location = 0) out vec4 outColor;
 
+const vec3 LIGHT = vec3(0.267, -0.802, -0.535); // normalized, towards it
+const float AMBIENT = 0.25;
+
 void main() {
-    outColor = vec4(fragColor, 1.0);
+    if (DEBUG_VIEW == 1u) {
+        uint h = fragInstance * 2654435761u;
+        outColor = vec4(vec3((h >> 8) & 255u, (h >> 16) & 255u,
+                             (h >> 24) & 255u) / 255.0, 1.0);
+        return;
+    }
+    if (DEBUG_VIEW == 2u) {
+        outColor = vec4(vec3(1.0 - gl_FragCoord.z), 1.0);
+        return;
+    }
+
+    vec3 color = fragColor;
+    if (LIT) {
+        // Flat meshes: either face of them may point at the light
+        float diffuse = abs(dot(normalize(fragNormal), LIGHT));
+        color *= AMBIENT + (1.0 - AMBIENT) * diffuse;
+    }
+    outColor = vec4(color, 1.0);
 }
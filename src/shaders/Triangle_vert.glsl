@@ -1,5 +1,11 @@
 #version 450
 
+// Specialization constants, see variants.h: each pipeline variant keeps
+// only the path it was built for
+layout(constant_id = 0) const uint SOURCE = 0; // CRINGED_DRAW_*
+layout(constant_id = 1) const bool LIT = false;
+layout(constant_id = 2) const uint DEBUG_VIEW = 0; // CRINGED_DEBUG_VIEW_*
+
 vec2 positions[3] = vec2[](
     vec2(0.0, -0.5),
     vec2(0.5, 0.5),
@@ -12,9 +18,83 @@ vec3 colors[3] = vec3[](
     vec3(0.0, 0.0, 1.0)
 );
 
+layout(set = 0, binding = 0) uniform FrameConstants {
+    mat4 view;
+    mat4 proj;
+    mat4 viewProj;
+    vec4 time;
+} frame;
+
+layout(set = 0, binding = 1) uniform DrawConstants {
+    mat4 model;
+    mat4 mvp;
+} draw;
+
+struct Instance {
+    mat4 world;
+    mat4 mvp;
+};
+
+layout(std430, set = 0, binding = 2) readonly buffer Instances {
+    Instance instances[];
+};
+
+layout(std430, set = 0, binding = 3) readonly buffer SceneWorld {
+    mat4 sceneWorld[];
+};
+
+// Occlusion culling output: instance indices, `gl_InstanceIndex` includes
+// the list's base from the indirect draw's firstInstance
+layout(std430, set = 0, binding = 4) readonly buffer Culled {
+    uint culled[];
+};
+
 layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragNormal;        // world, when LIT
+layout(location = 2) flat out uint fragInstance; // for DEBUG_VIEW
+
+// Vertices [0, 3): the triangle. Then the disc's levels of detail, finest
+// first, fans of 48, 24, 12 and 6 segments; see cringedBuiltinMeshes.
+vec2 meshVertex(int index, out int corner) {
+    if (index < 3) {
+        corner = index;
+        return positions[index];
+    }
+    int vertex = index - 3;
+    int segments = 48;
+    while (vertex >= 3 * segments && segments > 6) {
+        vertex -= 3 * segments;
+        segments /= 2;
+    }
+    corner = vertex % 3;
+    if (corner == 0)
+        return vec2(0.0);
+    float angle = float(vertex / 3 + corner - 1) * 6.28318531 /
+                  float(segments);
+    return 0.5 * vec2(cos(angle), sin(angle));
+}
+
+// Depth pre-pass and EQUAL color pass must produce identical depth
+invariant gl_Position;
 
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = colors[gl_VertexIndex];
+    int corner;
+    vec2 vertex = meshVertex(gl_VertexIndex, corner);
+    vec4 position = draw.model * vec4(vertex, 0.0, 1.0);
+    uint instance = SOURCE == 2u ? culled[gl_InstanceIndex]
+                                 : uint(gl_InstanceIndex);
+    mat4 world;
+    if (SOURCE == 1u) {
+        world = sceneWorld[instance];
+        gl_Position = frame.viewProj * world * position;
+    } else {
+        world = instances[instance].world;
+        gl_Position = instances[instance].mvp * position;
+    }
+    fragColor = colors[corner];
+    // The meshes are flat in their xy plane
+    fragNormal = LIT ? normalize(mat3(world) * mat3(draw.model) *
+                                 vec3(0.0, 0.0, 1.0))
+                     : vec3(0.0);
+    fragInstance = instance;
 }
@@ -0,0 +1,872 @@
+#include "sprite.h"
+
+CringedSpriteBatch *
+cringedCreateSpriteBatch ( uint32_t capacity )
+{
+    CringedSpriteBatch * batch =
+        ( CringedSpriteBatch * ) calloc ( 1, sizeof ( CringedSpriteBatch ) );
+    if ( batch == NULL ) return NULL;
+
+    batch->capacity = capacity;
+    batch->sprites =
+        ( CringedSprite * ) malloc ( capacity * sizeof ( CringedSprite ) );
+    batch->keys    = ( uint64_t * ) malloc ( capacity * sizeof ( uint64_t ) );
+    batch->scratch = ( uint64_t * ) malloc ( capacity * sizeof ( uint64_t ) );
+    batch->runs    = ( CringedSpriteRun * ) malloc (
+        capacity * sizeof ( CringedSpriteRun ) );
+    if ( ! batch->sprites || ! batch->keys || ! batch->scratch ||
+         ! batch->runs )
+    {
+        cringedDestroySpriteBatch ( batch );
+        return NULL;
+    }
+    return batch;
+}
+
+void
+cringedDestroySpriteBatch ( CringedSpriteBatch * batch )
+{
+    if ( batch == NULL ) return;
+    if ( batch->dropped )
+        _DEBUG_P ( "sprites: %u quads dropped\n", batch->dropped );
+    free ( batch->sprites );
+    free ( batch->keys );
+    free ( batch->scratch );
+    free ( batch->runs );
+    free ( batch );
+}
+
+/* =============================================
+ *            RESOURCES
+ * ============================================= */
+
+static void
+destroyImage ( VkDevice device, CringedSpriteTexture * texture )
+{
+    if ( texture->view ) vkDestroyImageView ( device, texture->view, NULL );
+    if ( texture->image ) vkDestroyImage ( device, texture->image, NULL );
+    if ( texture->memory ) vkFreeMemory ( device, texture->memory, NULL );
+    texture->view   = VK_NULL_HANDLE;
+    texture->image  = VK_NULL_HANDLE;
+    texture->memory = VK_NULL_HANDLE;
+}
+
+static VkResult
+createPipelines ( CringedSpriteBatch *         batch,
+                  VkFormat                     colorFormat,
+                  VkFormat                     depthFormat,
+                  VkRenderPass                 renderPass,
+                  const CringedShaderArchive * shaders )
+{
+    VkResult       opResult, rcode = VK_INCOMPLETE;
+    VkShaderModule vert = VK_NULL_HANDLE, frag = VK_NULL_HANDLE;
+
+    if ( ( opResult = cringedArchiveModule (
+               shaders, batch->device, "Sprite_vert", &vert ) ) !=
+             VK_SUCCESS ||
+         ( opResult = cringedArchiveModule (
+               shaders, batch->device, "Sprite_frag", &frag ) ) !=
+             VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: sprite shader modules: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    VkPipelineShaderStageCreateInfo stages[ 2 ] = {};
+    stages[ 0 ].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[ 0 ].stage  = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[ 0 ].module = vert;
+    stages[ 0 ].pName  = "main";
+    stages[ 1 ].sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[ 1 ].stage  = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[ 1 ].module = frag;
+    stages[ 1 ].pName  = "main";
+
+    VkVertexInputBindingDescription binding = {};
+    binding.binding   = 0;
+    binding.stride    = sizeof ( CringedSpriteVertex );
+    binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    VkVertexInputAttributeDescription attributes[ 3 ] = {
+        { 0, 0, VK_FORMAT_R32G32_SFLOAT, offsetof ( CringedSpriteVertex, x ) },
+        { 1, 0, VK_FORMAT_R32G32_SFLOAT, offsetof ( CringedSpriteVertex, u ) },
+        { 2,
+          0,
+          VK_FORMAT_R8G8B8A8_UNORM,
+          offsetof ( CringedSpriteVertex, color ) },
+    };
+
+    VkPipelineVertexInputStateCreateInfo vertexInput = {};
+    vertexInput.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInput.vertexBindingDescriptionCount   = 1;
+    vertexInput.pVertexBindingDescriptions      = &binding;
+    vertexInput.vertexAttributeDescriptionCount = 3;
+    vertexInput.pVertexAttributeDescriptions    = attributes;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+    inputAssembly.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT,
+                                       VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicState = {};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 2;
+    dynamicState.pDynamicStates    = dynamicStates;
+
+    VkPipelineViewportStateCreateInfo viewportState = {};
+    viewportState.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount  = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer = {};
+    rasterizer.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.cullMode    = VK_CULL_MODE_NONE; /* mirrored quads too */
+    rasterizer.frontFace   = VK_FRONT_FACE_CLOCKWISE;
+    rasterizer.lineWidth   = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisampling = {};
+    multisampling.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampling.minSampleShading     = 1.0f;
+
+    /* Overlay: drawn last in the color pass, ignores the depth buffer */
+    VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+    depthStencil.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable  = VK_FALSE;
+    depthStencil.depthWriteEnable = VK_FALSE;
+    depthStencil.maxDepthBounds   = 1.0f;
+
+    VkPipelineColorBlendAttachmentState blends[ CRINGED_SPRITE_BLEND_COUNT ] =
+        {};
+    for ( uint32_t b = 0; b < CRINGED_SPRITE_BLEND_COUNT; b++ )
+    {
+        blends[ b ].colorWriteMask =
+            VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+            VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        blends[ b ].blendEnable         = VK_TRUE;
+        blends[ b ].srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        blends[ b ].colorBlendOp        = VK_BLEND_OP_ADD;
+        blends[ b ].srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        blends[ b ].dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+        blends[ b ].alphaBlendOp        = VK_BLEND_OP_ADD;
+    }
+    blends[ CRINGED_SPRITE_ALPHA ].dstColorBlendFactor =
+        VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    blends[ CRINGED_SPRITE_ADDITIVE ].dstColorBlendFactor =
+        VK_BLEND_FACTOR_ONE;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending[
+        CRINGED_SPRITE_BLEND_COUNT ] = {};
+
+    VkPipelineRenderingCreateInfo renderingInfo = {};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+    renderingInfo.colorAttachmentCount    = 1;
+    renderingInfo.pColorAttachmentFormats = &colorFormat;
+    renderingInfo.depthAttachmentFormat   = depthFormat;
+
+    VkGraphicsPipelineCreateInfo pipelineInfos[ CRINGED_SPRITE_BLEND_COUNT ] =
+        {};
+    for ( uint32_t b = 0; b < CRINGED_SPRITE_BLEND_COUNT; b++ )
+    {
+        colorBlending[ b ].sType =
+            VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        colorBlending[ b ].attachmentCount = 1;
+        colorBlending[ b ].pAttachments    = &blends[ b ];
+
+        VkGraphicsPipelineCreateInfo * info = &pipelineInfos[ b ];
+        info->sType      = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        info->pNext      = renderPass ? NULL : &renderingInfo;
+        info->stageCount = 2;
+        info->pStages    = stages;
+        info->pVertexInputState   = &vertexInput;
+        info->pInputAssemblyState = &inputAssembly;
+        info->pViewportState      = &viewportState;
+        info->pRasterizationState = &rasterizer;
+        info->pMultisampleState   = &multisampling;
+        info->pDepthStencilState  = &depthStencil;
+        info->pColorBlendState    = &colorBlending[ b ];
+        info->pDynamicState       = &dynamicState;
+        info->layout              = batch->pipelineLayout;
+        info->renderPass          = renderPass;
+        info->basePipelineIndex   = -1;
+    }
+
+    if ( ( opResult = vkCreateGraphicsPipelines ( //
+               batch->device,
+               VK_NULL_HANDLE,
+               CRINGED_SPRITE_BLEND_COUNT,
+               pipelineInfos,
+               NULL,
+               batch->pipelines ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: sprite pipelines: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    rcode = VK_SUCCESS;
+
+defer_cleanup:
+    if ( vert ) vkDestroyShaderModule ( batch->device, vert, NULL );
+    if ( frag ) vkDestroyShaderModule ( batch->device, frag, NULL );
+    return rcode;
+}
+
+VkResult
+cringedSpriteCreateResources ( CringedSpriteBatch *         batch,
+                               VkPhysicalDevice             physicalDevice,
+                               VkDevice                     device,
+                               uint32_t                     frameCount,
+                               VkFormat                     colorFormat,
+                               VkFormat                     depthFormat,
+                               VkRenderPass                 renderPass,
+                               const CringedShaderArchive * shaders,
+                               CringedResidency *           residency )
+{
+    VkResult opResult, rcode = VK_INCOMPLETE;
+    batch->physicalDevice = physicalDevice;
+    batch->device         = device;
+    batch->residency      = residency;
+    batch->frameCount     = frameCount;
+
+    /* Streaming vertices: written in place, never staged */
+    if ( ( opResult = cringedCreateBuffer ( //
+               physicalDevice,
+               device,
+               ( VkDeviceSize ) frameCount * batch->capacity * 4 *
+                   sizeof ( CringedSpriteVertex ),
+               VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+               &batch->vertices ) ) != VK_SUCCESS ||
+         ( opResult = cringedCreateBuffer ( //
+               physicalDevice,
+               device,
+               CRINGED_SPRITE_CHUNK * 6 * sizeof ( uint16_t ),
+               VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                   VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+               &batch->indices ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: sprite buffers: %d\n", opResult );
+        goto defer_cleanup;
+    }
+    batch->indicesUploaded = 0;
+
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.borderColor  = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+    for ( uint32_t f = VK_FILTER_NEAREST; f <= VK_FILTER_LINEAR; f++ )
+    {
+        samplerInfo.magFilter = ( VkFilter ) f;
+        samplerInfo.minFilter = ( VkFilter ) f;
+        if ( ( opResult = vkCreateSampler (
+                   device, &samplerInfo, NULL, &batch->samplers[ f ] ) ) !=
+             VK_SUCCESS )
+        {
+            _DEBUG_P ( "error: sprite sampler: %d\n", opResult );
+            goto defer_cleanup;
+        }
+    }
+
+    /* One set per texture: binding 0, the sampled texture */
+    VkDescriptorSetLayoutBinding textureBinding = {};
+    textureBinding.binding         = 0;
+    textureBinding.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    textureBinding.descriptorCount = 1;
+    textureBinding.stageFlags      = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings    = &textureBinding;
+    if ( ( opResult = vkCreateDescriptorSetLayout (
+               device, &layoutInfo, NULL, &batch->setLayout ) ) !=
+         VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: sprite set layout: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                                      CRINGED_SPRITE_TEXTURES };
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets       = CRINGED_SPRITE_TEXTURES;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes    = &poolSize;
+    if ( ( opResult = vkCreateDescriptorPool (
+               device, &poolInfo, NULL, &batch->descriptorPool ) ) !=
+         VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: sprite descriptor pool: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    VkPushConstantRange screenRange = { VK_SHADER_STAGE_VERTEX_BIT,
+                                        0,
+                                        2 * sizeof ( float ) };
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount         = 1;
+    pipelineLayoutInfo.pSetLayouts            = &batch->setLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges    = &screenRange;
+    if ( ( opResult = vkCreatePipelineLayout (
+               device, &pipelineLayoutInfo, NULL, &batch->pipelineLayout ) ) !=
+         VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: sprite pipeline layout: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    if ( ( opResult = createPipelines ( //
+               batch,
+               colorFormat,
+               depthFormat,
+               renderPass,
+               shaders ) ) != VK_SUCCESS )
+        goto defer_cleanup;
+
+    uint32_t white = CRINGED_RGBA ( 255, 255, 255, 255 );
+    if ( cringedSpriteCreateTexture ( //
+             batch,
+             1,
+             1,
+             &white,
+             VK_FILTER_NEAREST,
+             CRINGED_PRIORITY_PINNED ) != CRINGED_SPRITE_WHITE )
+        goto defer_cleanup;
+
+    rcode = VK_SUCCESS;
+
+defer_cleanup:
+    if ( rcode ) cringedSpriteDestroyResources ( batch );
+    return rcode;
+}
+
+void
+cringedSpriteDestroyResources ( CringedSpriteBatch * batch )
+{
+    VkDevice device = batch->device;
+    if ( device == VK_NULL_HANDLE ) return;
+
+    for ( uint32_t t = 0; t < batch->textureCount; t++ )
+    {
+        CringedSpriteTexture * texture = &batch->textures[ t ];
+        cringedResidencyRemove ( batch->residency, texture->resident );
+        destroyImage ( device, texture );
+        free ( texture->texels );
+        texture->texels = NULL;
+    }
+    batch->textureCount = 0;
+    for ( uint32_t b = 0; b < CRINGED_SPRITE_BLEND_COUNT; b++ )
+    {
+        if ( batch->pipelines[ b ] )
+            vkDestroyPipeline ( device, batch->pipelines[ b ], NULL );
+        batch->pipelines[ b ] = VK_NULL_HANDLE;
+    }
+    if ( batch->pipelineLayout )
+        vkDestroyPipelineLayout ( device, batch->pipelineLayout, NULL );
+    if ( batch->descriptorPool ) /* frees the texture sets */
+        vkDestroyDescriptorPool ( device, batch->descriptorPool, NULL );
+    if ( batch->setLayout )
+        vkDestroyDescriptorSetLayout ( device, batch->setLayout, NULL );
+    for ( uint32_t f = 0; f < 2; f++ )
+    {
+        if ( batch->samplers[ f ] )
+            vkDestroySampler ( device, batch->samplers[ f ], NULL );
+        batch->samplers[ f ] = VK_NULL_HANDLE;
+    }
+    batch->pipelineLayout = VK_NULL_HANDLE;
+    batch->descriptorPool = VK_NULL_HANDLE;
+    batch->setLayout      = VK_NULL_HANDLE;
+    cringedDestroyBuffer ( device, &batch->vertices );
+    cringedDestroyBuffer ( device, &batch->indices );
+    batch->device    = VK_NULL_HANDLE;
+    batch->residency = NULL;
+}
+
+/* Image, memory and view from `texels`, written into the texture's set;
+ * `size` and `heap` of the allocation are returned for the residency */
+static VkResult
+createImage ( CringedSpriteBatch *   batch,
+              CringedSpriteTexture * texture,
+              const uint32_t *       texels,
+              VkDeviceSize *         size,
+              uint32_t *             heap )
+{
+    VkResult opResult, rcode = VK_INCOMPLETE;
+    VkDevice device = batch->device;
+
+    /* Linear and host visible: texels are written in place, no staging,
+     * fine for small atlases that never change */
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType         = VK_IMAGE_TYPE_2D;
+    imageInfo.format            = VK_FORMAT_R8G8B8A8_UNORM;
+    imageInfo.extent.width      = texture->width;
+    imageInfo.extent.height     = texture->height;
+    imageInfo.extent.depth      = 1;
+    imageInfo.mipLevels         = 1;
+    imageInfo.arrayLayers       = 1;
+    imageInfo.samples           = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling            = VK_IMAGE_TILING_LINEAR;
+    imageInfo.usage             = VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.sharingMode       = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout     = VK_IMAGE_LAYOUT_PREINITIALIZED;
+    if ( ( opResult = vkCreateImage (
+               device, &imageInfo, NULL, &texture->image ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: sprite texture image: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements ( device, texture->image, &requirements );
+    int32_t memoryType = cringedFindMemoryType (
+        batch->physicalDevice,
+        requirements.memoryTypeBits,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+    if ( memoryType < 0 )
+    {
+        _DEBUG_P ( "error: no host visible memory for a linear image\n" );
+        goto defer_cleanup;
+    }
+    *size = requirements.size;
+    *heap = batch->residency
+                ? cringedResidencyHeap ( batch->residency, memoryType )
+                : 0;
+    /* Less important textures go first, rather than the allocation */
+    if ( ! cringedResidencyMakeRoom ( batch->residency, *heap, *size ) )
+        _DEBUG_P ( "warning: sprite texture over the memory budget\n" );
+
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType                = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize       = requirements.size;
+    allocInfo.memoryTypeIndex      = memoryType;
+    void * mapped;
+    if ( ( opResult = vkAllocateMemory (
+               device, &allocInfo, NULL, &texture->memory ) ) != VK_SUCCESS ||
+         ( opResult = vkBindImageMemory (
+               device, texture->image, texture->memory, 0 ) ) != VK_SUCCESS ||
+         ( opResult = vkMapMemory (
+               device, texture->memory, 0, VK_WHOLE_SIZE, 0, &mapped ) ) !=
+             VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: sprite texture memory: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    VkImageSubresource  subresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0 };
+    VkSubresourceLayout layout;
+    vkGetImageSubresourceLayout (
+        device, texture->image, &subresource, &layout );
+    for ( uint32_t y = 0; y < texture->height; y++ )
+        memcpy ( ( uint8_t * ) mapped + layout.offset + y * layout.rowPitch,
+                 texels + ( size_t ) y * texture->width,
+                 texture->width * sizeof ( uint32_t ) );
+    vkUnmapMemory ( device, texture->memory );
+
+    VkImageViewCreateInfo viewInfo = {};
+    viewInfo.sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image    = texture->image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format   = VK_FORMAT_R8G8B8A8_UNORM;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.layerCount = 1;
+    if ( ( opResult = vkCreateImageView (
+               device, &viewInfo, NULL, &texture->view ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: sprite texture view: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    VkDescriptorImageInfo imageDescriptor = {
+        batch->samplers[ texture->filter == VK_FILTER_NEAREST ? 0 : 1 ],
+        texture->view,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    VkWriteDescriptorSet write = {};
+    write.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet               = texture->set;
+    write.dstBinding           = 0;
+    write.descriptorCount      = 1;
+    write.descriptorType       = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo           = &imageDescriptor;
+    vkUpdateDescriptorSets ( device, 1, &write, 0, NULL );
+
+    texture->pending = 1;
+    rcode            = VK_SUCCESS;
+
+defer_cleanup:
+    if ( rcode ) destroyImage ( device, texture );
+    return rcode;
+}
+
+/* Residency callback: no frame in flight samples the texture any more */
+static void
+evictTexture ( void * owner, uint32_t id )
+{
+    CringedSpriteBatch *   batch   = ( CringedSpriteBatch * ) owner;
+    CringedSpriteTexture * texture = &batch->textures[ id ];
+    destroyImage ( batch->device, texture );
+    texture->pending = 0;
+    texture->evicted = 1;
+}
+
+uint16_t
+cringedSpriteCreateTexture ( CringedSpriteBatch * batch,
+                             uint32_t             width,
+                             uint32_t             height,
+                             const uint32_t *     texels,
+                             VkFilter             filter,
+                             uint8_t              priority )
+{
+    VkResult opResult;
+    if ( batch->textureCount == CRINGED_SPRITE_TEXTURES )
+    {
+        _DEBUG_P ( "error: sprite textures full\n" );
+        return CRINGED_SPRITE_NONE;
+    }
+    uint32_t               id      = batch->textureCount;
+    CringedSpriteTexture * texture = &batch->textures[ id ];
+    memset ( texture, 0, sizeof ( *texture ) );
+    texture->width    = width;
+    texture->height   = height;
+    texture->filter   = ( uint8_t ) filter;
+    texture->resident = CRINGED_RESIDENT_NONE;
+
+    /* NOTE: the set, if any, goes back with the pool */
+    VkDescriptorSetAllocateInfo setInfo = {};
+    setInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setInfo.descriptorPool     = batch->descriptorPool;
+    setInfo.descriptorSetCount = 1;
+    setInfo.pSetLayouts        = &batch->setLayout;
+    if ( ( opResult = vkAllocateDescriptorSets (
+               batch->device, &setInfo, &texture->set ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: sprite texture set: %d\n", opResult );
+        return CRINGED_SPRITE_NONE;
+    }
+
+    VkDeviceSize size;
+    uint32_t     heap;
+    if ( createImage ( batch, texture, texels, &size, &heap ) != VK_SUCCESS )
+    {
+        memset ( texture, 0, sizeof ( *texture ) );
+        return CRINGED_SPRITE_NONE;
+    }
+
+    /* Evicted textures come back from their own copy; without one a
+     * texture stays pinned */
+    if ( batch->residency )
+    {
+        size_t bytes = ( size_t ) width * height * sizeof ( uint32_t );
+        if ( priority < CRINGED_PRIORITY_PINNED &&
+             ( texture->texels = ( uint32_t * ) malloc ( bytes ) ) )
+            memcpy ( texture->texels, texels, bytes );
+        else
+            priority = CRINGED_PRIORITY_PINNED;
+        texture->resident = cringedResidencyAdd ( //
+            batch->residency,
+            heap,
+            size,
+            priority,
+            evictTexture,
+            batch,
+            id );
+    }
+    return ( uint16_t ) batch->textureCount++;
+}
+
+/* =============================================
+ *            FRAME
+ * ============================================= */
+
+void
+cringedSpriteRecordUpload ( CringedSpriteBatch * batch,
+                            VkCommandBuffer      commandBuffer,
+                            BasedRingBuffer *    ring )
+{
+    if ( batch->device == VK_NULL_HANDLE ) return;
+
+    /* The quad index pattern, same for every chunk */
+    uint32_t offset;
+    uint16_t * indices =
+        batch->indicesUploaded
+            ? NULL
+            : ( uint16_t * ) cringedRingAlloc ( ring,
+                                                batch->indices.size,
+                                                &offset );
+    if ( indices )
+    {
+        for ( uint32_t q = 0; q < CRINGED_SPRITE_CHUNK; q++ )
+        {
+            uint16_t v         = ( uint16_t ) ( q * 4 );
+            indices[ q * 6 + 0 ] = v;
+            indices[ q * 6 + 1 ] = v + 1;
+            indices[ q * 6 + 2 ] = v + 2;
+            indices[ q * 6 + 3 ] = v + 2;
+            indices[ q * 6 + 4 ] = v + 3;
+            indices[ q * 6 + 5 ] = v;
+        }
+        VkBufferCopy copy = { offset, 0, batch->indices.size };
+        vkCmdCopyBuffer ( commandBuffer,
+                          ring->buffer.buffer,
+                          batch->indices.buffer,
+                          1,
+                          &copy );
+
+        VkBufferMemoryBarrier barrier = {};
+        barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask       = VK_ACCESS_INDEX_READ_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer              = batch->indices.buffer;
+        barrier.offset              = 0;
+        barrier.size                = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier ( commandBuffer,
+                               VK_PIPELINE_STAGE_TRANSFER_BIT,
+                               VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                               0,
+                               0,
+                               NULL,
+                               1,
+                               &barrier,
+                               0,
+                               NULL );
+        batch->indicesUploaded = 1;
+    }
+
+    /* Evicted textures the last prepare wanted, back before this frame's
+     * draws; a failed restore is retried once they are drawn again */
+    for ( uint32_t t = 0; t < batch->textureCount; t++ )
+    {
+        CringedSpriteTexture * texture = &batch->textures[ t ];
+        if ( ! texture->evicted || ! texture->wanted ) continue;
+        texture->wanted = 0;
+        VkDeviceSize size;
+        uint32_t     heap;
+        if ( createImage ( batch, texture, texture->texels, &size, &heap ) !=
+             VK_SUCCESS )
+            continue;
+        texture->evicted = 0;
+        cringedResidencyRestored ( batch->residency, texture->resident );
+    }
+
+    /* New textures: host writes made visible, PREINITIALIZED keeps them */
+    VkImageMemoryBarrier barriers[ CRINGED_SPRITE_TEXTURES ];
+    uint32_t             barrierCount = 0;
+    for ( uint32_t t = 0; t < batch->textureCount; t++ )
+    {
+        CringedSpriteTexture * texture = &batch->textures[ t ];
+        if ( ! texture->pending ) continue;
+        texture->pending          = 0;
+        VkImageMemoryBarrier * b = &barriers[ barrierCount++ ];
+        memset ( b, 0, sizeof ( *b ) );
+        b->sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        b->srcAccessMask       = VK_ACCESS_HOST_WRITE_BIT;
+        b->dstAccessMask       = VK_ACCESS_SHADER_READ_BIT;
+        b->oldLayout           = VK_IMAGE_LAYOUT_PREINITIALIZED;
+        b->newLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        b->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b->image               = texture->image;
+        b->subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        b->subresourceRange.levelCount = 1;
+        b->subresourceRange.layerCount = 1;
+    }
+    if ( barrierCount )
+        vkCmdPipelineBarrier ( commandBuffer,
+                               VK_PIPELINE_STAGE_HOST_BIT,
+                               VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                               0,
+                               0,
+                               NULL,
+                               0,
+                               NULL,
+                               barrierCount,
+                               barriers );
+}
+
+/* Stable LSD radix sort on the state bytes (bits 32..63); a byte equal
+ * for every quad, the usual case for layer and blend, costs one
+ * histogram pass and no scatter. Returns the sorted array. */
+static uint64_t *
+sortKeys ( uint64_t * keys, uint64_t * scratch, uint32_t count )
+{
+    uint32_t histogram[ 4 ][ 256 ] = {};
+    for ( uint32_t i = 0; i < count; i++ )
+    {
+        uint32_t state = ( uint32_t ) ( keys[ i ] >> 32 );
+        histogram[ 0 ][ state & 0xff ]++;
+        histogram[ 1 ][ ( state >> 8 ) & 0xff ]++;
+        histogram[ 2 ][ ( state >> 16 ) & 0xff ]++;
+        histogram[ 3 ][ state >> 24 ]++;
+    }
+
+    for ( uint32_t pass = 0; pass < 4; pass++ )
+    {
+        uint32_t shift = 32 + pass * 8;
+        if ( histogram[ pass ][ ( keys[ 0 ] >> shift ) & 0xff ] == count )
+            continue;
+
+        uint32_t offsets[ 256 ], sum = 0;
+        for ( uint32_t d = 0; d < 256; d++ )
+        {
+            offsets[ d ] = sum;
+            sum += histogram[ pass ][ d ];
+        }
+        for ( uint32_t i = 0; i < count; i++ )
+            scratch[ offsets[ ( keys[ i ] >> shift ) & 0xff ]++ ] = keys[ i ];
+
+        uint64_t * swap = keys;
+        keys            = scratch;
+        scratch         = swap;
+    }
+    return keys;
+}
+
+void
+cringedSpritePrepare ( CringedSpriteBatch * batch, uint32_t frame )
+{
+    uint32_t count  = batch->count;
+    batch->frame    = frame % ( batch->frameCount ? batch->frameCount : 1 );
+    batch->runCount = 0;
+    batch->count    = 0;
+    if ( count == 0 || batch->vertices.mapped == NULL ) return;
+
+    const uint64_t * keys = sortKeys ( batch->keys, batch->scratch, count );
+
+    CringedSpriteVertex * v =
+        ( CringedSpriteVertex * ) batch->vertices.mapped +
+        ( size_t ) batch->frame * batch->capacity * 4;
+    uint32_t state = ( uint32_t ) ( keys[ 0 ] >> 32 ) + 1; /* no match */
+    for ( uint32_t q = 0; q < count; q++, v += 4 )
+    {
+        const CringedSprite * s = &batch->sprites[ ( uint32_t ) keys[ q ] ];
+        float                 x1 = s->x + s->w, y1 = s->y + s->h;
+        v[ 0 ] = ( CringedSpriteVertex ) { s->x, s->y, s->u0, s->v0, s->color };
+        v[ 1 ] = ( CringedSpriteVertex ) { x1, s->y, s->u1, s->v0, s->color };
+        v[ 2 ] = ( CringedSpriteVertex ) { x1, y1, s->u1, s->v1, s->color };
+        v[ 3 ] = ( CringedSpriteVertex ) { s->x, y1, s->u0, s->v1, s->color };
+
+        /* Layer changes alone don't split a run: same pipeline and set */
+        uint32_t quadState = ( uint32_t ) ( keys[ q ] >> 32 ) & 0xffffff;
+        if ( quadState != state )
+        {
+            CringedSpriteRun * run = &batch->runs[ batch->runCount++ ];
+            run->first             = q;
+            run->count             = 0;
+            run->texture           = s->texture;
+            run->blend             = s->blend;
+            state                  = quadState;
+            if ( s->texture < batch->textureCount )
+            {
+                CringedSpriteTexture * texture =
+                    &batch->textures[ s->texture ];
+                cringedResidencyTouch ( batch->residency, texture->resident );
+                texture->wanted |= texture->evicted;
+            }
+        }
+        batch->runs[ batch->runCount - 1 ].count++;
+    }
+}
+
+uint32_t
+cringedSpriteRecord ( CringedSpriteBatch * batch,
+                      VkCommandBuffer      commandBuffer,
+                      VkExtent2D           extent )
+{
+    if ( batch->runCount == 0 ) return 0;
+
+    VkDeviceSize vertexOffset = ( VkDeviceSize ) batch->frame *
+                                batch->capacity * 4 *
+                                sizeof ( CringedSpriteVertex );
+    vkCmdBindVertexBuffers (
+        commandBuffer, 0, 1, &batch->vertices.buffer, &vertexOffset );
+    vkCmdBindIndexBuffer (
+        commandBuffer, batch->indices.buffer, 0, VK_INDEX_TYPE_UINT16 );
+
+    VkViewport viewport = {};
+    viewport.width      = ( float ) extent.width;
+    viewport.height     = ( float ) extent.height;
+    viewport.maxDepth   = 1.0f;
+    VkRect2D scissor    = {};
+    scissor.extent      = extent;
+    vkCmdSetViewport ( commandBuffer, 0, 1, &viewport );
+    vkCmdSetScissor ( commandBuffer, 0, 1, &scissor );
+
+    float screen[ 2 ] = { 2.0f / ( float ) extent.width,
+                          2.0f / ( float ) extent.height };
+    vkCmdPushConstants ( commandBuffer,
+                         batch->pipelineLayout,
+                         VK_SHADER_STAGE_VERTEX_BIT,
+                         0,
+                         sizeof ( screen ),
+                         screen );
+
+    uint32_t blend = CRINGED_SPRITE_BLEND_COUNT, texture = UINT32_MAX;
+    uint32_t draws = 0;
+    for ( uint32_t r = 0; r < batch->runCount; r++ )
+    {
+        const CringedSpriteRun * run = &batch->runs[ r ];
+        if ( run->texture >= batch->textureCount ||
+             batch->textures[ run->texture ].evicted ||
+             run->blend >= CRINGED_SPRITE_BLEND_COUNT )
+            continue;
+        if ( run->blend != blend )
+        {
+            blend = run->blend;
+            vkCmdBindPipeline ( commandBuffer,
+                                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                batch->pipelines[ blend ] );
+        }
+        if ( run->texture != texture )
+        {
+            texture = run->texture;
+            vkCmdBindDescriptorSets ( commandBuffer,
+                                      VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                      batch->pipelineLayout,
+                                      0,
+                                      1,
+                                      &batch->textures[ texture ].set,
+                                      0,
+                                      NULL );
+        }
+
+        /* 16-bit indices: a run crossing a chunk continues with the next
+         * chunk's vertex offset */
+        for ( uint32_t q = run->first; q < run->first + run->count; )
+        {
+            uint32_t chunk = q / CRINGED_SPRITE_CHUNK;
+            uint32_t local = q % CRINGED_SPRITE_CHUNK;
+            uint32_t quads = CRINGED_SPRITE_CHUNK - local;
+            if ( quads > run->first + run->count - q )
+                quads = run->first + run->count - q;
+            vkCmdDrawIndexed ( commandBuffer,
+                               quads * 6,
+                               1,
+                               local * 6,
+                               ( int32_t ) ( chunk * CRINGED_SPRITE_CHUNK * 4 ),
+                               0 );
+            q += quads;
+            draws++;
+        }
+    }
+    return draws;
+}
@@ -0,0 +1,195 @@
+#pragma once
+#ifndef CRINGED_SPRITE_H
+#define CRINGED_SPRITE_H
+
+#include "bufferUtils.h"
+#include "residency.h"
+#include "shaderUtils.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vulkan/vulkan.h>
+
+#ifndef NDEBUG
+#define _DEBUG_P( ... ) printf ( __VA_ARGS__ )
+#else
+#define _DEBUG_P( ... ) ( ( void ) 0 )
+#endif
+
+#define CRINGED_SPRITE_TEXTURES 64
+#define CRINGED_SPRITE_NONE     UINT16_MAX
+#define CRINGED_SPRITE_WHITE    0 /* 1x1 white: untextured, colored quads */
+
+/* 16-bit indices: one draw covers at most this many quads */
+#define CRINGED_SPRITE_CHUNK ( 65536 / 4 )
+
+/* Packed RGBA8, as the vertex attribute reads it */
+#define CRINGED_RGBA( r, g, b, a )                                \
+    ( ( uint32_t ) ( r ) | ( ( uint32_t ) ( g ) << 8 ) |          \
+      ( ( uint32_t ) ( b ) << 16 ) | ( ( uint32_t ) ( a ) << 24 ) )
+
+typedef enum
+{
+    CRINGED_SPRITE_ALPHA,    /* src * a + dst * ( 1 - a ) */
+    CRINGED_SPRITE_ADDITIVE, /* src * a + dst */
+    CRINGED_SPRITE_BLEND_COUNT,
+} CringedSpriteBlend;
+
+/* One quad in pixels, origin top left */
+typedef struct
+{
+    float    x, y, w, h;
+    float    u0, v0, u1, v1;
+    uint32_t color; /* CRINGED_RGBA, multiplies the texel */
+    uint16_t texture;
+    uint8_t  blend;
+    uint8_t  layer; /* drawn in ascending order, before blend/texture */
+} CringedSprite;
+
+/* 20 bytes, 4 per quad */
+typedef struct
+{
+    float    x, y;
+    float    u, v;
+    uint32_t color;
+} CringedSpriteVertex;
+
+/* Quads `first .. first + count` of the prepared partition */
+typedef struct
+{
+    uint32_t first;
+    uint32_t count;
+    uint16_t texture;
+    uint8_t  blend;
+} CringedSpriteRun;
+
+/* Host-written linear image, moved to SHADER_READ_ONLY by the upload.
+ * Evictable textures keep their texels: evicted, they are skipped by
+ * the draws until the upload after the next one that wants them. */
+typedef struct
+{
+    VkImage         image;
+    VkDeviceMemory  memory;
+    VkImageView     view;
+    VkDescriptorSet set; /* kept while evicted, rewritten on restore */
+    uint8_t         pending; /* layout transition not recorded yet */
+    uint8_t         filter;  /* VkFilter */
+    uint8_t         evicted; /* no image */
+    uint8_t         wanted;  /* drawn while evicted: restore */
+    uint32_t        width, height;
+    uint32_t *      texels;   /* host copy, evictable textures only */
+    uint32_t        resident; /* residency handle, CRINGED_RESIDENT_NONE */
+} CringedSpriteTexture;
+
+/* Quads are collected during the frame, then radix sorted by layer,
+ * blend and texture (submission order within equal keys) and written
+ * straight into this frame's mapped vertex partition. Every run of equal
+ * blend and texture is one indexed draw per CRINGED_SPRITE_CHUNK quads.
+ * Nothing allocates after creation; quads past `capacity` are dropped. */
+typedef struct
+{
+    uint32_t        count;
+    uint32_t        capacity;
+    uint32_t        dropped;
+    CringedSprite * sprites;
+    uint64_t *      keys; /* layer | blend | texture << 32, index */
+    uint64_t *      scratch;
+    /* Prepared for recording */
+    uint32_t           frame;
+    uint32_t           runCount;
+    CringedSpriteRun * runs;
+    /* GPU */
+    VkPhysicalDevice      physicalDevice;
+    VkDevice              device;
+    CringedResidency *    residency; /* NULL: textures stay resident */
+    uint32_t              frameCount;
+    BasedBuffer           vertices; /* mapped, frameCount partitions */
+    BasedBuffer           indices;  /* device local, uploaded once */
+    uint8_t               indicesUploaded;
+    VkSampler             samplers[ 2 ]; /* by VkFilter: nearest, linear */
+    VkDescriptorSetLayout setLayout;
+    VkDescriptorPool      descriptorPool;
+    VkPipelineLayout      pipelineLayout;
+    VkPipeline            pipelines[ CRINGED_SPRITE_BLEND_COUNT ];
+    uint32_t              textureCount;
+    CringedSpriteTexture  textures[ CRINGED_SPRITE_TEXTURES ];
+} CringedSpriteBatch;
+
+CringedSpriteBatch *
+cringedCreateSpriteBatch ( uint32_t capacity );
+
+/* GPU resources must have been destroyed */
+void
+cringedDestroySpriteBatch ( CringedSpriteBatch * batch );
+
+/* Buffers, the white texture and the pipelines, compatible with
+ * `renderPass` or, when it is NULL, with dynamic rendering on the given
+ * formats; textures are accounted to `residency`, which may be NULL */
+VkResult
+cringedSpriteCreateResources ( CringedSpriteBatch *         batch,
+                               VkPhysicalDevice             physicalDevice,
+                               VkDevice                     device,
+                               uint32_t                     frameCount,
+                               VkFormat                     colorFormat,
+                               VkFormat                     depthFormat,
+                               VkRenderPass                 renderPass,
+                               const CringedShaderArchive * shaders,
+                               CringedResidency *           residency );
+
+/* The device must be idle */
+void
+cringedSpriteDestroyResources ( CringedSpriteBatch * batch );
+
+/* RGBA8 texels, `width * height`, sampled with `filter` (NEAREST for
+ * pixel art and glyphs). Below CRINGED_PRIORITY_PINNED the texels are
+ * copied and the texture may be evicted under memory pressure. Returns
+ * the texture id or CRINGED_SPRITE_NONE; usable from the next recorded
+ * upload on. */
+uint16_t
+cringedSpriteCreateTexture ( CringedSpriteBatch * batch,
+                             uint32_t             width,
+                             uint32_t             height,
+                             const uint32_t *     texels,
+                             VkFilter             filter,
+                             uint8_t              priority );
+
+/* Queues one quad for this frame, 0 when the batch is full */
+static inline uint8_t
+cringedSpriteDraw ( CringedSpriteBatch * batch, const CringedSprite * sprite )
+{
+    if ( batch->count == batch->capacity )
+    {
+        batch->dropped++;
+        return 0;
+    }
+    uint32_t i          = batch->count++;
+    batch->sprites[ i ] = *sprite;
+    batch->keys[ i ] =
+        ( ( uint64_t ) sprite->layer << 56 ) |
+        ( ( uint64_t ) sprite->blend << 48 ) |
+        ( ( uint64_t ) sprite->texture << 32 ) | i;
+    return 1;
+}
+
+/* Outside a render pass: index upload on first use, evicted textures
+ * drawn since restored, new textures' layout transitions */
+void
+cringedSpriteRecordUpload ( CringedSpriteBatch * batch,
+                            VkCommandBuffer      commandBuffer,
+                            BasedRingBuffer *    ring );
+
+/* Sorts the frame's quads and writes them into partition `frame`; the
+ * batch is empty again afterwards */
+void
+cringedSpritePrepare ( CringedSpriteBatch * batch, uint32_t frame );
+
+/* Inside the color pass: draws what the last prepare wrote, returns the
+ * number of draw calls */
+uint32_t
+cringedSpriteRecord ( CringedSpriteBatch * batch,
+                      VkCommandBuffer      commandBuffer,
+                      VkExtent2D           extent );
+
+#endif /* CRINGED_SPRITE_H */
@@ -0,0 +1,543 @@
+#define _GNU_SOURCE /* syscall, pread */
+
+#include "stream.h"
+#include "trace.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* Staging offsets stay copy-aligned for any texel or index format */
+#define STAGING_ALIGN 16
+
+/* =============================================
+ *            IO_URING
+ * ============================================= */
+
+/* NOTE: raw syscalls; three calls are not worth a liburing dependency */
+
+static void
+uringTeardown ( CringedUring * uring )
+{
+    if ( uring->sqes ) munmap ( uring->sqes, uring->sqesSize );
+    if ( uring->cqMap && uring->cqMap != uring->sqMap )
+        munmap ( uring->cqMap, uring->cqMapSize );
+    if ( uring->sqMap ) munmap ( uring->sqMap, uring->sqMapSize );
+    if ( uring->fd >= 0 ) close ( uring->fd );
+    memset ( uring, 0, sizeof ( *uring ) );
+    uring->fd = -1;
+}
+
+static void *
+uringMap ( CringedUring * uring, size_t size, uint64_t offset )
+{
+    void * map = mmap ( NULL,
+                        size,
+                        PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE,
+                        uring->fd,
+                        ( off_t ) offset );
+    return map == MAP_FAILED ? NULL : map;
+}
+
+/* Fails where the kernel is too old or a sandbox filters io_uring */
+static int
+uringSetup ( CringedUring * uring, uint32_t entries )
+{
+    struct io_uring_params params;
+    memset ( &params, 0, sizeof ( params ) );
+    memset ( uring, 0, sizeof ( *uring ) );
+    uring->fd = ( int ) syscall ( __NR_io_uring_setup, entries, &params );
+    if ( uring->fd < 0 ) return -1;
+
+    /* Both rings share one mapping since 5.4 */
+    uint8_t single   = ( params.features & IORING_FEAT_SINGLE_MMAP ) != 0;
+    uring->entries   = params.sq_entries;
+    uring->sqMapSize = params.sq_off.array +
+                       params.sq_entries * sizeof ( uint32_t );
+    uring->cqMapSize = params.cq_off.cqes +
+                       params.cq_entries * sizeof ( struct io_uring_cqe );
+    if ( single && uring->cqMapSize > uring->sqMapSize )
+        uring->sqMapSize = uring->cqMapSize;
+    uring->sqesSize = params.sq_entries * sizeof ( struct io_uring_sqe );
+
+    uring->sqMap = uringMap ( uring, uring->sqMapSize, IORING_OFF_SQ_RING );
+    uring->cqMap =
+        single ? uring->sqMap
+               : uringMap ( uring, uring->cqMapSize, IORING_OFF_CQ_RING );
+    uring->sqes = ( struct io_uring_sqe * ) uringMap (
+        uring, uring->sqesSize, IORING_OFF_SQES );
+    if ( ! uring->sqMap || ! uring->cqMap || ! uring->sqes )
+    {
+        uringTeardown ( uring );
+        return -1;
+    }
+
+    uint8_t * sq   = ( uint8_t * ) uring->sqMap;
+    uint8_t * cq   = ( uint8_t * ) uring->cqMap;
+    uring->sqHead  = ( uint32_t * ) ( sq + params.sq_off.head );
+    uring->sqTail  = ( uint32_t * ) ( sq + params.sq_off.tail );
+    uring->sqMask  = ( uint32_t * ) ( sq + params.sq_off.ring_mask );
+    uring->sqArray = ( uint32_t * ) ( sq + params.sq_off.array );
+    uring->cqHead  = ( uint32_t * ) ( cq + params.cq_off.head );
+    uring->cqTail  = ( uint32_t * ) ( cq + params.cq_off.tail );
+    uring->cqMask  = ( uint32_t * ) ( cq + params.cq_off.ring_mask );
+    uring->cqes    = ( struct io_uring_cqe * ) ( cq + params.cq_off.cqes );
+    return 0;
+}
+
+/* One read of what `handle` still misses, submitted by uringSubmit; a
+ * request has at most one, so `depth` entries never overflow */
+static void
+uringQueue ( CringedStream * stream, uint32_t handle )
+{
+    CringedUring *         uring   = &stream->uring;
+    CringedStreamRequest * request = &stream->requests[ handle ];
+    request->iov.iov_base = ( uint8_t * ) stream->staging.mapped +
+                            request->staging + request->read;
+    request->iov.iov_len  = request->size - request->read;
+
+    uint32_t              tail  = *uring->sqTail; /* only written here */
+    uint32_t              index = tail & *uring->sqMask;
+    struct io_uring_sqe * sqe   = &uring->sqes[ index ];
+    memset ( sqe, 0, sizeof ( *sqe ) );
+    sqe->opcode    = IORING_OP_READV; /* 5.1, READ needs 5.6 */
+    sqe->fd        = request->fd;
+    sqe->off       = request->offset + request->read;
+    sqe->addr      = ( uint64_t ) ( uintptr_t ) &request->iov;
+    sqe->len       = 1;
+    sqe->user_data = handle;
+    uring->sqArray[ index ] = index;
+    atomic_store_explicit ( ( _Atomic uint32_t * ) uring->sqTail,
+                            tail + 1,
+                            memory_order_release );
+    uring->unsubmitted++;
+}
+
+/* Waits for `minComplete` completions only; what the kernel refuses now
+ * goes with the next call. -1 on a failure other than EINTR. */
+static int
+uringSubmit ( CringedUring * uring, uint32_t minComplete )
+{
+    while ( uring->unsubmitted || minComplete )
+    {
+        int submitted = ( int ) syscall ( //
+            __NR_io_uring_enter,
+            uring->fd,
+            uring->unsubmitted,
+            minComplete,
+            minComplete ? IORING_ENTER_GETEVENTS : 0,
+            NULL,
+            0 );
+        if ( submitted < 0 )
+        {
+            if ( errno == EINTR ) continue;
+            _DEBUG_P ( "warning: io_uring_enter: %d\n", errno );
+            return -1;
+        }
+        uring->unsubmitted -= ( uint32_t ) submitted;
+        if ( minComplete || submitted == 0 ) break;
+    }
+    return 0;
+}
+
+static void
+uringComplete ( CringedStream * stream, uint32_t handle, int32_t result )
+{
+    CringedStreamRequest * request = &stream->requests[ handle ];
+    if ( result == -EINTR || result == -EAGAIN )
+    {
+        uringQueue ( stream, handle );
+        return;
+    }
+    if ( result < 0 )
+        request->error = -result;
+    else
+        request->read += ( uint32_t ) result;
+    /* Short, not at the end of the file: the rest where it stopped */
+    if ( result > 0 && request->read < request->size )
+    {
+        uringQueue ( stream, handle );
+        return;
+    }
+    request->state = CRINGED_STREAM_COMPLETE;
+    stream->reading--;
+}
+
+static void
+uringReap ( CringedStream * stream )
+{
+    CringedUring * uring = &stream->uring;
+    uint32_t       head  = *uring->cqHead;
+    uint32_t       tail  = atomic_load_explicit (
+        ( _Atomic uint32_t * ) uring->cqTail, memory_order_acquire );
+    for ( ; head != tail; head++ )
+    {
+        struct io_uring_cqe * cqe = &uring->cqes[ head & *uring->cqMask ];
+        uringComplete ( stream, ( uint32_t ) cqe->user_data, cqe->res );
+    }
+    atomic_store_explicit (
+        ( _Atomic uint32_t * ) uring->cqHead, head, memory_order_release );
+}
+
+/* =============================================
+ *            PREAD WORKERS
+ * ============================================= */
+
+static void *
+readWorker ( void * arg )
+{
+    CringedStream * stream = ( CringedStream * ) arg;
+    cringedTraceThreadName ( "stream worker" );
+
+    pthread_mutex_lock ( &stream->lock );
+    for ( ;; )
+    {
+        while ( ! stream->quit && stream->issuedCount == 0 )
+            pthread_cond_wait ( &stream->wake, &stream->lock );
+        if ( stream->quit ) break;
+        uint32_t handle     = stream->issued[ stream->issuedFirst ];
+        stream->issuedFirst = ( stream->issuedFirst + 1 ) % stream->capacity;
+        stream->issuedCount--;
+        pthread_mutex_unlock ( &stream->lock );
+
+        /* The render thread leaves READING requests alone */
+        CringedStreamRequest * request = &stream->requests[ handle ];
+        uint8_t * bytes = ( uint8_t * ) stream->staging.mapped +
+                          request->staging;
+        while ( request->read < request->size )
+        {
+            ssize_t n = pread ( request->fd,
+                                bytes + request->read,
+                                request->size - request->read,
+                                ( off_t ) ( request->offset + request->read ) );
+            if ( n < 0 && errno == EINTR ) continue;
+            if ( n < 0 ) request->error = errno;
+            if ( n <= 0 ) break; /* error or end of file */
+            request->read += ( uint32_t ) n;
+        }
+
+        pthread_mutex_lock ( &stream->lock );
+        stream->finished[ ( stream->finishedFirst + stream->finishedCount++ ) %
+                          stream->capacity ] = handle;
+        pthread_cond_signal ( &stream->done );
+    }
+    pthread_mutex_unlock ( &stream->lock );
+    return NULL;
+}
+
+/* `wait`: blocks until at least one read finished, if any is out */
+static void
+poolReap ( CringedStream * stream, uint8_t wait )
+{
+    pthread_mutex_lock ( &stream->lock );
+    while ( wait && stream->reading && stream->finishedCount == 0 )
+        pthread_cond_wait ( &stream->done, &stream->lock );
+    for ( ; stream->finishedCount; stream->finishedCount-- )
+    {
+        uint32_t handle = stream->finished[ stream->finishedFirst ];
+        stream->finishedFirst =
+            ( stream->finishedFirst + 1 ) % stream->capacity;
+        stream->requests[ handle ].state = CRINGED_STREAM_COMPLETE;
+        stream->reading--;
+    }
+    pthread_mutex_unlock ( &stream->lock );
+}
+
+/* =============================================
+ *            STREAM
+ * ============================================= */
+
+CringedStream *
+cringedCreateStream ( uint32_t capacity,
+                      uint32_t depth,
+                      uint32_t threadCount,
+                      uint8_t  uring )
+{
+    CringedStream * stream =
+        ( CringedStream * ) calloc ( 1, sizeof ( CringedStream ) );
+    if ( ! stream ) return NULL;
+
+    stream->capacity = capacity;
+    stream->depth    = depth < capacity ? depth : capacity;
+    stream->requests = ( CringedStreamRequest * ) calloc (
+        capacity, sizeof ( CringedStreamRequest ) );
+    stream->order    = ( uint32_t * ) malloc ( capacity * sizeof ( uint32_t ) );
+    stream->issued   = ( uint32_t * ) malloc ( capacity * sizeof ( uint32_t ) );
+    stream->finished = ( uint32_t * ) malloc ( capacity * sizeof ( uint32_t ) );
+    stream->threads =
+        ( pthread_t * ) malloc ( ( threadCount + 1 ) * sizeof ( pthread_t ) );
+    if ( ! stream->requests || ! stream->order || ! stream->issued ||
+         ! stream->finished || ! stream->threads )
+    {
+        free ( stream->threads );
+        free ( stream->finished );
+        free ( stream->issued );
+        free ( stream->order );
+        free ( stream->requests );
+        free ( stream );
+        return NULL;
+    }
+    pthread_mutex_init ( &stream->lock, NULL );
+    pthread_cond_init ( &stream->wake, NULL );
+    pthread_cond_init ( &stream->done, NULL );
+
+    stream->uring.fd = -1;
+    if ( uring && uringSetup ( &stream->uring, stream->depth ) == 0 )
+        stream->backend = CRINGED_STREAM_URING;
+    else
+    {
+        stream->backend = CRINGED_STREAM_PREAD;
+        for ( uint32_t i = 0; i < threadCount; i++ )
+        {
+            if ( pthread_create (
+                     &stream->threads[ i ], NULL, readWorker, stream ) )
+                break; /* run with whatever workers we got */
+            stream->threadCount++;
+        }
+        if ( stream->threadCount == 0 )
+        {
+            cringedDestroyStream ( stream );
+            return NULL;
+        }
+    }
+    _DEBUG_P ( "Asset streaming: %s\n",
+               stream->backend == CRINGED_STREAM_URING ? "io_uring"
+                                                       : "pread workers" );
+    return stream;
+}
+
+void
+cringedDestroyStream ( CringedStream * stream )
+{
+    if ( ! stream ) return;
+    if ( stream->reads )
+        _DEBUG_P ( "stream: %llu reads, %llu bytes, %llu late\n",
+                   ( unsigned long long ) stream->reads,
+                   ( unsigned long long ) stream->bytes,
+                   ( unsigned long long ) stream->late );
+
+    pthread_mutex_lock ( &stream->lock );
+    stream->quit = 1;
+    pthread_cond_broadcast ( &stream->wake );
+    pthread_mutex_unlock ( &stream->lock );
+    for ( uint32_t i = 0; i < stream->threadCount; i++ )
+        pthread_join ( stream->threads[ i ], NULL );
+    if ( stream->backend == CRINGED_STREAM_URING )
+        uringTeardown ( &stream->uring );
+
+    pthread_cond_destroy ( &stream->done );
+    pthread_cond_destroy ( &stream->wake );
+    pthread_mutex_destroy ( &stream->lock );
+    free ( stream->threads );
+    free ( stream->finished );
+    free ( stream->issued );
+    free ( stream->order );
+    free ( stream->requests );
+    free ( stream );
+}
+
+VkResult
+cringedStreamCreateResources ( CringedStream *  stream,
+                               VkPhysicalDevice physicalDevice,
+                               VkDevice         device,
+                               VkDeviceSize     size )
+{
+    VkResult opResult;
+    if ( ( opResult = cringedCreateBuffer ( //
+               physicalDevice,
+               device,
+               size,
+               VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+               &stream->staging ) ) != VK_SUCCESS )
+        _DEBUG_P ( "error: stream staging buffer: %d\n", opResult );
+    stream->head = 0;
+    return opResult;
+}
+
+void
+cringedStreamDestroyResources ( CringedStream * stream, VkDevice device )
+{
+    /* Nothing may write into staging once it is gone */
+    while ( stream->reading )
+    {
+        if ( stream->backend == CRINGED_STREAM_URING )
+        {
+            if ( uringSubmit ( &stream->uring, 1 ) ) break;
+            uringReap ( stream );
+        }
+        else
+            poolReap ( stream, 1 );
+    }
+    for ( uint32_t r = 0; r < stream->capacity; r++ )
+        stream->requests[ r ].state = CRINGED_STREAM_FREE;
+    stream->orderCount = 0;
+    cringedDestroyBuffer ( device, &stream->staging );
+}
+
+uint32_t
+cringedStreamRead ( CringedStream *   stream,
+                    int               fd,
+                    uint64_t          offset,
+                    uint32_t          size,
+                    uint64_t          deadline,
+                    uint8_t           priority,
+                    CringedStreamDone done,
+                    void *            owner,
+                    uint32_t          id )
+{
+    if ( size == 0 || size > stream->staging.size ) return CRINGED_STREAM_NONE;
+
+    uint32_t handle = 0;
+    while ( handle < stream->capacity &&
+            stream->requests[ handle ].state != CRINGED_STREAM_FREE )
+        handle++;
+    if ( handle == stream->capacity ) return CRINGED_STREAM_NONE;
+
+    CringedStreamRequest * request = &stream->requests[ handle ];
+    memset ( request, 0, sizeof ( *request ) );
+    request->fd       = fd;
+    request->offset   = offset;
+    request->size     = size;
+    request->deadline = deadline;
+    request->priority = priority;
+    request->state    = CRINGED_STREAM_QUEUED;
+    request->done     = done;
+    request->owner    = owner;
+    request->id       = id;
+    return handle;
+}
+
+/* Earliest deadline, then highest priority, then the lowest handle */
+static uint32_t
+mostUrgent ( const CringedStream * stream )
+{
+    uint32_t urgent = CRINGED_STREAM_NONE;
+    for ( uint32_t r = 0; r < stream->capacity; r++ )
+    {
+        const CringedStreamRequest * c = &stream->requests[ r ];
+        if ( c->state != CRINGED_STREAM_QUEUED ) continue;
+        const CringedStreamRequest * u =
+            urgent == CRINGED_STREAM_NONE ? NULL : &stream->requests[ urgent ];
+        if ( ! u || c->deadline < u->deadline ||
+             ( c->deadline == u->deadline && c->priority > u->priority ) )
+            urgent = r;
+    }
+    return urgent;
+}
+
+/* After the newest allocation, or from the start when the end is too
+ * short; VK_WHOLE_SIZE while the oldest ones are in the way */
+static VkDeviceSize
+stagingAlloc ( CringedStream * stream, VkDeviceSize size )
+{
+    VkDeviceSize capacity = stream->staging.size;
+    VkDeviceSize start    = VK_WHOLE_SIZE;
+    if ( stream->orderCount == 0 )
+        start = size <= capacity ? 0 : VK_WHOLE_SIZE;
+    else
+    {
+        VkDeviceSize tail =
+            stream->requests[ stream->order[ stream->orderFirst ] ].staging;
+        if ( stream->head > tail )
+            start = capacity - stream->head >= size ? stream->head
+                    : size <= tail                  ? 0
+                                                    : VK_WHOLE_SIZE;
+        else if ( tail - stream->head >= size )
+            start = stream->head;
+    }
+    if ( start != VK_WHOLE_SIZE ) stream->head = start + size;
+    return start;
+}
+
+void
+cringedStreamBeginFrame ( CringedStream * stream,
+                          uint64_t        frame,
+                          uint64_t        safeFrame )
+{
+    stream->frame = frame;
+    if ( stream->staging.mapped == NULL ) return;
+
+    /* Staging the GPU is done with, oldest first */
+    while ( stream->orderCount )
+    {
+        CringedStreamRequest * oldest =
+            &stream->requests[ stream->order[ stream->orderFirst ] ];
+        if ( oldest->state != CRINGED_STREAM_DELIVERED ||
+             oldest->frame >= safeFrame )
+            break;
+        oldest->state      = CRINGED_STREAM_FREE;
+        stream->orderFirst = ( stream->orderFirst + 1 ) % stream->capacity;
+        stream->orderCount--;
+    }
+
+    if ( stream->backend == CRINGED_STREAM_URING )
+        uringReap ( stream );
+    else
+        poolReap ( stream, 0 );
+
+    while ( stream->reading < stream->depth )
+    {
+        uint32_t handle = mostUrgent ( stream );
+        if ( handle == CRINGED_STREAM_NONE ) break;
+        CringedStreamRequest * request = &stream->requests[ handle ];
+        VkDeviceSize           staging = stagingAlloc (
+            stream,
+            ( request->size + STAGING_ALIGN - 1 ) &
+                ~( VkDeviceSize ) ( STAGING_ALIGN - 1 ) );
+        /* Full: the most urgent waits, nothing overtakes it */
+        if ( staging == VK_WHOLE_SIZE ) break;
+
+        request->staging = staging;
+        request->state   = CRINGED_STREAM_READING;
+        stream->order[ ( stream->orderFirst + stream->orderCount++ ) %
+                       stream->capacity ] = handle;
+        stream->reading++;
+        if ( stream->backend == CRINGED_STREAM_URING )
+        {
+            uringQueue ( stream, handle );
+            continue;
+        }
+        pthread_mutex_lock ( &stream->lock );
+        stream->issued[ ( stream->issuedFirst + stream->issuedCount++ ) %
+                        stream->capacity ] = handle;
+        pthread_cond_signal ( &stream->wake );
+        pthread_mutex_unlock ( &stream->lock );
+    }
+    /* Continued short reads are queued by the reap as well */
+    if ( stream->backend == CRINGED_STREAM_URING )
+        uringSubmit ( &stream->uring, 0 );
+}
+
+void
+cringedStreamRecordUploads ( CringedStream * stream,
+                             VkCommandBuffer commandBuffer )
+{
+    /* Issue order: what was asked for first comes first */
+    for ( uint32_t i = 0; i < stream->orderCount; i++ )
+    {
+        uint32_t handle =
+            stream->order[ ( stream->orderFirst + i ) % stream->capacity ];
+        CringedStreamRequest * request = &stream->requests[ handle ];
+        if ( request->state != CRINGED_STREAM_COMPLETE ) continue;
+
+        CringedStreamData data = {};
+        data.bytes  = ( uint8_t * ) stream->staging.mapped + request->staging;
+        data.buffer = stream->staging.buffer;
+        data.offset = request->staging;
+        data.size   = request->read;
+        data.error  = request->error;
+        data.late   = stream->frame > request->deadline;
+        stream->reads++;
+        stream->bytes += request->read;
+        stream->late += data.late;
+
+        request->state = CRINGED_STREAM_DELIVERED;
+        request->frame = stream->frame;
+        request->done ( request->owner, request->id, &data, commandBuffer );
+    }
+}
@@ -0,0 +1,192 @@
+#pragma once
+#ifndef CRINGED_STREAM_H
+#define CRINGED_STREAM_H
+
+#include "bufferUtils.h"
+
+#include <linux/io_uring.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <vulkan/vulkan.h>
+
+#ifndef NDEBUG
+#define _DEBUG_P( ... ) printf ( __VA_ARGS__ )
+#else
+#define _DEBUG_P( ... ) ( ( void ) 0 )
+#endif
+
+#define CRINGED_STREAM_NONE UINT32_MAX
+
+typedef enum
+{
+    CRINGED_STREAM_URING, /* the render thread submits and reaps */
+    CRINGED_STREAM_PREAD, /* worker threads, blocking pread */
+} CringedStreamBackend;
+
+/* Request states, in order */
+typedef enum
+{
+    CRINGED_STREAM_FREE,
+    CRINGED_STREAM_QUEUED,    /* waiting for staging and queue depth */
+    CRINGED_STREAM_READING,   /* in the kernel or on a worker */
+    CRINGED_STREAM_COMPLETE,  /* delivered by the next upload */
+    CRINGED_STREAM_DELIVERED, /* staging held until the GPU is done */
+} CringedStreamState;
+
+/* A finished read, handed to its owner on the render thread while the
+ * frame's uploads are recorded. The staging bytes stay untouched until
+ * the GPU completed that frame, so copies recorded from them are fine. */
+typedef struct
+{
+    const void * bytes;  /* mapped staging memory */
+    VkBuffer     buffer; /* staging buffer, a transfer source */
+    VkDeviceSize offset; /* of `bytes` in `buffer` */
+    uint32_t     size;   /* bytes read, short at the end of the file */
+    int32_t      error;  /* 0 or an errno */
+    uint8_t      late;   /* delivered past its deadline */
+} CringedStreamData;
+
+typedef void ( *CringedStreamDone ) ( void *                    owner,
+                                      uint32_t                  id,
+                                      const CringedStreamData * data,
+                                      VkCommandBuffer           commandBuffer );
+
+typedef struct
+{
+    int               fd; /* the caller's, open until delivery */
+    uint64_t          offset;
+    uint32_t          size;
+    uint32_t          read; /* so far, short reads are continued */
+    VkDeviceSize      staging;
+    uint64_t          deadline; /* frame number the data is wanted by */
+    uint64_t          frame;    /* delivered in */
+    int32_t           error;
+    uint8_t           priority; /* among equal deadlines, higher first */
+    uint8_t           state;    /* CRINGED_STREAM_* */
+    CringedStreamDone done;
+    void *            owner;
+    uint32_t          id;
+    struct iovec      iov;
+} CringedStreamRequest;
+
+/* The submission and completion rings, mapped from the kernel */
+typedef struct
+{
+    int                   fd;
+    uint32_t              entries;
+    void *                sqMap;
+    size_t                sqMapSize;
+    void *                cqMap;
+    size_t                cqMapSize;
+    struct io_uring_sqe * sqes;
+    size_t                sqesSize;
+    uint32_t *            sqHead;
+    uint32_t *            sqTail;
+    uint32_t *            sqMask;
+    uint32_t *            sqArray;
+    uint32_t *            cqHead;
+    uint32_t *            cqTail;
+    uint32_t *            cqMask;
+    struct io_uring_cqe * cqes;
+    uint32_t              unsubmitted;
+} CringedUring;
+
+/* Asset reads without blocking the render thread. Requests wait until
+ * `depth` reads are in flight and staging has room, the most urgent one
+ * issued first: earliest deadline, then highest priority. Each reads
+ * straight into its range of the persistently mapped staging buffer,
+ * handed out in issue order and taken back in the same order once the
+ * frame that consumed it completed; a full ring holds requests back.
+ * Completions are reaped at frame start and delivered with the uploads.
+ * io_uring when the kernel has it, else pread on worker threads. Every
+ * call is render thread only. */
+typedef struct
+{
+    CringedStreamBackend   backend;
+    uint32_t               capacity;
+    CringedStreamRequest * requests;
+    uint32_t               depth;
+    uint32_t               reading;
+    uint64_t               frame;
+    /* Staging ring, allocations in issue order */
+    BasedBuffer  staging;
+    VkDeviceSize head;
+    uint32_t *   order; /* [capacity] request handles, oldest first */
+    uint32_t     orderFirst;
+    uint32_t     orderCount;
+    /* CRINGED_STREAM_URING */
+    CringedUring uring;
+    /* CRINGED_STREAM_PREAD: handles to read, handles read */
+    uint32_t        threadCount;
+    pthread_t *     threads;
+    pthread_mutex_t lock;
+    pthread_cond_t  wake;
+    pthread_cond_t  done;   /* a read finished */
+    uint32_t *      issued; /* [capacity] FIFO */
+    uint32_t        issuedFirst;
+    uint32_t        issuedCount;
+    uint32_t *      finished; /* [capacity] FIFO */
+    uint32_t        finishedFirst;
+    uint32_t        finishedCount;
+    uint8_t         quit;
+    /* Since creation */
+    uint64_t bytes;
+    uint64_t reads;
+    uint64_t late;
+} CringedStream;
+
+/* `uring` 0 forces the pread workers */
+CringedStream *
+cringedCreateStream ( uint32_t capacity,
+                      uint32_t depth,
+                      uint32_t threadCount,
+                      uint8_t  uring );
+
+/* Waits for the reads in flight; resources must have been destroyed */
+void
+cringedDestroyStream ( CringedStream * stream );
+
+/* Mapped staging memory of `size` bytes; reads stay queued until then */
+VkResult
+cringedStreamCreateResources ( CringedStream *  stream,
+                               VkPhysicalDevice physicalDevice,
+                               VkDevice         device,
+                               VkDeviceSize     size );
+
+/* The device must be idle */
+void
+cringedStreamDestroyResources ( CringedStream * stream, VkDevice device );
+
+/* Reads `size` bytes of `fd` from `offset`; `done` is called once, with
+ * the data or the error. Returns the handle, CRINGED_STREAM_NONE when
+ * every request slot is taken or `size` exceeds the staging buffer (or
+ * there is none yet). */
+uint32_t
+cringedStreamRead ( CringedStream *   stream,
+                    int               fd,
+                    uint64_t          offset,
+                    uint32_t          size,
+                    uint64_t          deadline,
+                    uint8_t           priority,
+                    CringedStreamDone done,
+                    void *            owner,
+                    uint32_t          id );
+
+/* `frame` is about to be recorded, every frame before `safeFrame` has
+ * completed: takes staging back, reaps completions, issues reads */
+void
+cringedStreamBeginFrame ( CringedStream * stream,
+                          uint64_t        frame,
+                          uint64_t        safeFrame );
+
+/* Outside a render pass: delivers the completed reads, whose owners may
+ * record copies out of staging */
+void
+cringedStreamRecordUploads ( CringedStream * stream,
+                             VkCommandBuffer commandBuffer );
+
+#endif /* CRINGED_STREAM_H */
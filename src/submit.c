@@ -0,0 +1,352 @@
+#include "submit.h"
+
+CringedSubmitter *
+cringedCreateSubmitter ( void )
+{
+    return ( CringedSubmitter * ) calloc ( 1, sizeof ( CringedSubmitter ) );
+}
+
+void
+cringedDestroySubmitter ( CringedSubmitter * submitter )
+{
+    if ( submitter == NULL ) return;
+    _DEBUG_P ( "submit: %llu batches in %llu submits, %llu presents\n",
+               ( unsigned long long ) submitter->batchesSubmitted,
+               ( unsigned long long ) submitter->submitCalls,
+               ( unsigned long long ) submitter->presentCalls );
+    free ( submitter );
+}
+
+/* Without synchronization2: same batches as VkSubmitInfo, binary
+ * semaphores only. Stage bits below 32 match the legacy flags. */
+static VkResult
+queueSubmitLegacy ( VkQueue               queue,
+                    uint32_t              infoCount,
+                    const VkSubmitInfo2 * infos,
+                    VkFence               fence )
+{
+    VkSubmitInfo         submits[ CRINGED_SUBMIT_BATCHES ];
+    VkSemaphore          waits[ CRINGED_SUBMIT_ITEMS ];
+    VkPipelineStageFlags stages[ CRINGED_SUBMIT_ITEMS ];
+    VkCommandBuffer      commandBuffers[ CRINGED_SUBMIT_ITEMS ];
+    VkSemaphore          signals[ CRINGED_SUBMIT_ITEMS ];
+    uint32_t             w = 0, c = 0, s = 0;
+
+    for ( uint32_t i = 0; i < infoCount; i++ )
+    {
+        const VkSubmitInfo2 * info = &infos[ i ];
+        VkSubmitInfo *        out  = &submits[ i ];
+        memset ( out, 0, sizeof ( *out ) );
+        out->sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        out->waitSemaphoreCount = info->waitSemaphoreInfoCount;
+        out->pWaitSemaphores    = &waits[ w ];
+        out->pWaitDstStageMask  = &stages[ w ];
+        for ( uint32_t k = 0; k < info->waitSemaphoreInfoCount; k++, w++ )
+        {
+            waits[ w ] = info->pWaitSemaphoreInfos[ k ].semaphore;
+            stages[ w ] =
+                ( VkPipelineStageFlags ) info->pWaitSemaphoreInfos[ k ]
+                    .stageMask;
+        }
+        out->commandBufferCount = info->commandBufferInfoCount;
+        out->pCommandBuffers    = &commandBuffers[ c ];
+        for ( uint32_t k = 0; k < info->commandBufferInfoCount; k++, c++ )
+            commandBuffers[ c ] = info->pCommandBufferInfos[ k ].commandBuffer;
+        out->signalSemaphoreCount = info->signalSemaphoreInfoCount;
+        out->pSignalSemaphores    = &signals[ s ];
+        for ( uint32_t k = 0; k < info->signalSemaphoreInfoCount; k++, s++ )
+            signals[ s ] = info->pSignalSemaphoreInfos[ k ].semaphore;
+    }
+    return vkQueueSubmit ( queue, infoCount, submits, fence );
+}
+
+static VkResult
+issue ( CringedSubmitter *    submitter,
+        VkQueue               queue,
+        uint32_t              infoCount,
+        const VkSubmitInfo2 * infos,
+        VkFence               fence )
+{
+    if ( infoCount == 0 ) return VK_SUCCESS;
+    submitter->submitCalls++;
+    if ( submitter->synchronization2 )
+        return vkQueueSubmit2 ( queue, infoCount, infos, fence );
+    return queueSubmitLegacy ( queue, infoCount, infos, fence );
+}
+
+/* Every batch of queue `q` in submission order, merged where the merge
+ * cannot move a wait earlier or a signal later than requested */
+static VkResult
+submitQueue ( CringedSubmitter * submitter, uint32_t q )
+{
+    VkSubmitInfo2             infos[ CRINGED_SUBMIT_BATCHES ];
+    VkSemaphoreSubmitInfo     waits[ CRINGED_SUBMIT_ITEMS ];
+    VkCommandBufferSubmitInfo commandBuffers[ CRINGED_SUBMIT_ITEMS ];
+    VkSemaphoreSubmitInfo     signals[ CRINGED_SUBMIT_ITEMS ];
+    uint32_t                  infoCount = 0, w = 0, c = 0, s = 0;
+    VkFence                   fence     = VK_NULL_HANDLE;
+    VkQueue                   queue     = submitter->queues[ q ];
+    VkResult                  opResult;
+
+    for ( uint32_t b = 0; b < submitter->batchCount; b++ )
+    {
+        const CringedSubmitBatch * batch = &submitter->batches[ b ];
+        if ( batch->queue != q ) continue;
+        submitter->batchesSubmitted++;
+
+        /* One fence per call: a second one starts the next call */
+        if ( batch->fence && fence && batch->fence != fence )
+        {
+            if ( ( opResult = issue (
+                       submitter, queue, infoCount, infos, fence ) ) !=
+                 VK_SUCCESS )
+                return opResult;
+            infoCount = w = c = s = 0;
+        }
+        if ( batch->fence ) fence = batch->fence;
+
+        VkSubmitInfo2 * info = infoCount ? &infos[ infoCount - 1 ] : NULL;
+        if ( ! info || batch->waitCount || info->signalSemaphoreInfoCount )
+        {
+            info = &infos[ infoCount++ ];
+            memset ( info, 0, sizeof ( *info ) );
+            info->sType                 = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+            info->pWaitSemaphoreInfos   = &waits[ w ];
+            info->pCommandBufferInfos   = &commandBuffers[ c ];
+            info->pSignalSemaphoreInfos = &signals[ s ];
+        }
+        /* Only the newest info grows, so its ranges stay contiguous */
+        memcpy ( &waits[ w ],
+                 &submitter->waits[ batch->waitFirst ],
+                 batch->waitCount * sizeof ( VkSemaphoreSubmitInfo ) );
+        memcpy ( &commandBuffers[ c ],
+                 &submitter->commandBuffers[ batch->commandFirst ],
+                 batch->commandCount * sizeof ( VkCommandBufferSubmitInfo ) );
+        memcpy ( &signals[ s ],
+                 &submitter->signals[ batch->signalFirst ],
+                 batch->signalCount * sizeof ( VkSemaphoreSubmitInfo ) );
+        info->waitSemaphoreInfoCount += batch->waitCount;
+        info->commandBufferInfoCount += batch->commandCount;
+        info->signalSemaphoreInfoCount += batch->signalCount;
+        w += batch->waitCount;
+        c += batch->commandCount;
+        s += batch->signalCount;
+    }
+    return issue ( submitter, queue, infoCount, infos, fence );
+}
+
+/* A queue may go once no unsubmitted queue signals what it waits on
+ * (binary semaphore signals must be submitted before their waits) */
+static uint8_t
+queueReady ( const CringedSubmitter * submitter, uint32_t q, uint32_t done )
+{
+    for ( uint32_t b = 0; b < submitter->batchCount; b++ )
+    {
+        const CringedSubmitBatch * batch = &submitter->batches[ b ];
+        if ( batch->queue != q ) continue;
+        for ( uint32_t w = 0; w < batch->waitCount; w++ )
+        {
+            VkSemaphore wait =
+                submitter->waits[ batch->waitFirst + w ].semaphore;
+            for ( uint32_t o = 0; o < submitter->batchCount; o++ )
+            {
+                const CringedSubmitBatch * other = &submitter->batches[ o ];
+                if ( other->queue == q || ( done >> other->queue ) & 1 )
+                    continue;
+                for ( uint32_t s = 0; s < other->signalCount; s++ )
+                    if ( submitter->signals[ other->signalFirst + s ]
+                             .semaphore == wait )
+                        return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static VkResult
+flushSubmissions ( CringedSubmitter * submitter )
+{
+    VkResult rcode = VK_SUCCESS, opResult;
+    uint32_t done  = 0, all = ( 1u << submitter->queueCount ) - 1;
+    while ( done != all )
+    {
+        /* NOTE: a dependency cycle falls back to registration order */
+        uint32_t next = submitter->queueCount;
+        for ( uint32_t q = 0; q < submitter->queueCount; q++ )
+        {
+            if ( ( done >> q ) & 1 ) continue;
+            if ( next == submitter->queueCount ) next = q;
+            if ( queueReady ( submitter, q, done ) )
+            {
+                next = q;
+                break;
+            }
+        }
+        done |= 1u << next;
+        if ( ( opResult = submitQueue ( submitter, next ) ) != VK_SUCCESS &&
+             rcode == VK_SUCCESS )
+        {
+            _DEBUG_P ( "error: queue submit: %d\n", opResult );
+            rcode = opResult;
+        }
+    }
+    submitter->queueCount   = 0;
+    submitter->batchCount   = 0;
+    submitter->waitCount    = 0;
+    submitter->commandCount = 0;
+    submitter->signalCount  = 0;
+    return rcode;
+}
+
+VkResult
+cringedSubmit ( CringedSubmitter *        submitter,
+                VkQueue                   queue,
+                const CringedSubmission * submission )
+{
+    VkResult opResult;
+    if ( submission->waitCount > CRINGED_SUBMIT_ITEMS ||
+         submission->commandBufferCount > CRINGED_SUBMIT_ITEMS ||
+         submission->signalCount > CRINGED_SUBMIT_ITEMS )
+    {
+        _DEBUG_P ( "error: submission over CRINGED_SUBMIT_ITEMS\n" );
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    uint32_t q = 0;
+    while ( q < submitter->queueCount && submitter->queues[ q ] != queue )
+        q++;
+    /* Out of room: what is queued goes now, order is kept */
+    if ( ( q == CRINGED_SUBMIT_QUEUES ) ||
+         submitter->batchCount == CRINGED_SUBMIT_BATCHES ||
+         submitter->waitCount + submission->waitCount >
+             CRINGED_SUBMIT_ITEMS ||
+         submitter->commandCount + submission->commandBufferCount >
+             CRINGED_SUBMIT_ITEMS ||
+         submitter->signalCount + submission->signalCount >
+             CRINGED_SUBMIT_ITEMS )
+    {
+        if ( ( opResult = flushSubmissions ( submitter ) ) != VK_SUCCESS )
+            return opResult;
+        q = 0;
+    }
+    if ( q == submitter->queueCount )
+        submitter->queues[ submitter->queueCount++ ] = queue;
+
+    CringedSubmitBatch * batch =
+        &submitter->batches[ submitter->batchCount++ ];
+    batch->queue = q;
+    batch->fence = submission->fence;
+
+    batch->waitFirst = submitter->waitCount;
+    batch->waitCount = submission->waitCount;
+    if ( submission->waitCount )
+        memcpy ( &submitter->waits[ submitter->waitCount ],
+                 submission->waits,
+                 submission->waitCount * sizeof ( VkSemaphoreSubmitInfo ) );
+    submitter->waitCount += submission->waitCount;
+
+    batch->commandFirst = submitter->commandCount;
+    batch->commandCount = submission->commandBufferCount;
+    for ( uint32_t i = 0; i < submission->commandBufferCount; i++ )
+    {
+        VkCommandBufferSubmitInfo * info =
+            &submitter->commandBuffers[ submitter->commandCount++ ];
+        memset ( info, 0, sizeof ( *info ) );
+        info->sType         = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+        info->commandBuffer = submission->commandBuffers[ i ];
+    }
+
+    batch->signalFirst = submitter->signalCount;
+    batch->signalCount = submission->signalCount;
+    if ( submission->signalCount )
+        memcpy ( &submitter->signals[ submitter->signalCount ],
+                 submission->signals,
+                 submission->signalCount * sizeof ( VkSemaphoreSubmitInfo ) );
+    submitter->signalCount += submission->signalCount;
+    return VK_SUCCESS;
+}
+
+uint32_t
+cringedSubmitPresent ( CringedSubmitter * submitter,
+                       VkQueue            queue,
+                       VkSwapchainKHR     swapChain,
+                       uint32_t           imageIndex,
+                       VkSemaphore        wait )
+{
+    if ( submitter->presentCount == CRINGED_SUBMIT_PRESENTS )
+        return CRINGED_SUBMIT_NO_PRESENT;
+    uint32_t p                     = submitter->presentCount++;
+    submitter->presentQueues[ p ]  = queue;
+    submitter->swapChains[ p ]     = swapChain;
+    submitter->imageIndices[ p ]   = imageIndex;
+    submitter->presentWaits[ p ]   = wait;
+    submitter->presentResults[ p ] = VK_NOT_READY;
+    return p;
+}
+
+/* One vkQueuePresentKHR per queue, all of its swapchains at once */
+static void
+flushPresents ( CringedSubmitter * submitter )
+{
+    uint32_t done = 0, all = ( 1u << submitter->presentCount ) - 1;
+    while ( done != all )
+    {
+        VkSwapchainKHR swapChains[ CRINGED_SUBMIT_PRESENTS ];
+        uint32_t       imageIndices[ CRINGED_SUBMIT_PRESENTS ];
+        VkSemaphore    waits[ CRINGED_SUBMIT_PRESENTS ];
+        VkResult       results[ CRINGED_SUBMIT_PRESENTS ];
+        uint32_t       slots[ CRINGED_SUBMIT_PRESENTS ];
+        uint32_t       count = 0, waitCount = 0;
+        VkQueue        queue = VK_NULL_HANDLE;
+
+        for ( uint32_t p = 0; p < submitter->presentCount; p++ )
+        {
+            if ( ( done >> p ) & 1 ) continue;
+            if ( queue == VK_NULL_HANDLE )
+                queue = submitter->presentQueues[ p ];
+            if ( submitter->presentQueues[ p ] != queue ) continue;
+            done |= 1u << p;
+            slots[ count ]        = p;
+            swapChains[ count ]   = submitter->swapChains[ p ];
+            imageIndices[ count ] = submitter->imageIndices[ p ];
+            results[ count ]      = VK_SUCCESS;
+            count++;
+            /* A binary semaphore is waited once, swapchains may share */
+            VkSemaphore wait = submitter->presentWaits[ p ];
+            uint32_t    w    = 0;
+            while ( w < waitCount && waits[ w ] != wait ) w++;
+            if ( wait && w == waitCount ) waits[ waitCount++ ] = wait;
+        }
+
+        VkPresentInfoKHR presentInfo   = {};
+        presentInfo.sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.waitSemaphoreCount = waitCount;
+        presentInfo.pWaitSemaphores    = waits;
+        presentInfo.swapchainCount     = count;
+        presentInfo.pSwapchains        = swapChains;
+        presentInfo.pImageIndices      = imageIndices;
+        presentInfo.pResults           = results;
+        VkResult opResult = vkQueuePresentKHR ( queue, &presentInfo );
+        submitter->presentCalls++;
+        for ( uint32_t i = 0; i < count; i++ )
+            submitter->presentResults[ slots[ i ] ] =
+                count == 1 ? opResult : results[ i ];
+    }
+    submitter->presentCount = 0;
+}
+
+VkResult
+cringedSubmitFlush ( CringedSubmitter * submitter )
+{
+    VkResult rcode = flushSubmissions ( submitter );
+    if ( rcode != VK_SUCCESS )
+    {
+        /* Their waits would never be signaled */
+        for ( uint32_t p = 0; p < submitter->presentCount; p++ )
+            submitter->presentResults[ p ] = rcode;
+        submitter->presentCount = 0;
+        return rcode;
+    }
+    flushPresents ( submitter );
+    return VK_SUCCESS;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#ifndef CRINGED_SUBMIT_H
+#define CRINGED_SUBMIT_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vulkan/vulkan.h>
+
+#ifndef NDEBUG
+#define _DEBUG_P( ... ) printf ( __VA_ARGS__ )
+#else
+#define _DEBUG_P( ... ) ( ( void ) 0 )
+#endif
+
+#define CRINGED_SUBMIT_QUEUES     4  /* distinct queues per flush */
+#define CRINGED_SUBMIT_BATCHES    32 /* submissions per flush */
+#define CRINGED_SUBMIT_ITEMS      64 /* of each: waits, buffers, signals */
+#define CRINGED_SUBMIT_PRESENTS   8  /* swapchains per flush */
+#define CRINGED_SUBMIT_NO_PRESENT UINT32_MAX
+
+/* One unit of GPU work on a queue, arrays are copied on submit */
+typedef struct
+{
+    const VkSemaphoreSubmitInfo * waits;
+    uint32_t                      waitCount;
+    const VkCommandBuffer *       commandBuffers;
+    uint32_t                      commandBufferCount;
+    const VkSemaphoreSubmitInfo * signals;
+    uint32_t                      signalCount;
+    VkFence                       fence; /* optional */
+} CringedSubmission;
+
+/* Recorded submission, ranges into the submitter's arrays */
+typedef struct
+{
+    uint32_t queue; /* into `queues` */
+    uint32_t waitFirst, waitCount;
+    uint32_t commandFirst, commandCount;
+    uint32_t signalFirst, signalCount;
+    VkFence  fence;
+} CringedSubmitBatch;
+
+/* Collects a frame's submissions and presents, then issues them with as
+ * few calls as ordering allows: one vkQueueSubmit2 per queue (per fence),
+ * adjacent batches merged into one VkSubmitInfo2 when the later waits on
+ * nothing and the earlier signals nothing, and one vkQueuePresentKHR per
+ * present queue. Queues signaling semaphores another queue waits on in
+ * the same flush are submitted first. Without synchronization2 the same
+ * batches go through vkQueueSubmit. Fixed storage, nothing allocates. */
+typedef struct
+{
+    uint8_t  synchronization2; /* set once the device exists */
+    uint32_t queueCount;
+    VkQueue  queues[ CRINGED_SUBMIT_QUEUES ];
+    uint32_t batchCount;
+    uint32_t waitCount, commandCount, signalCount;
+    CringedSubmitBatch        batches[ CRINGED_SUBMIT_BATCHES ];
+    VkSemaphoreSubmitInfo     waits[ CRINGED_SUBMIT_ITEMS ];
+    VkCommandBufferSubmitInfo commandBuffers[ CRINGED_SUBMIT_ITEMS ];
+    VkSemaphoreSubmitInfo     signals[ CRINGED_SUBMIT_ITEMS ];
+    /* Presents, issued after every submission */
+    uint32_t       presentCount;
+    VkQueue        presentQueues[ CRINGED_SUBMIT_PRESENTS ];
+    VkSwapchainKHR swapChains[ CRINGED_SUBMIT_PRESENTS ];
+    uint32_t       imageIndices[ CRINGED_SUBMIT_PRESENTS ];
+    VkSemaphore    presentWaits[ CRINGED_SUBMIT_PRESENTS ];
+    VkResult       presentResults[ CRINGED_SUBMIT_PRESENTS ]; /* by index */
+    /* Counters since creation */
+    uint64_t submitCalls;
+    uint64_t presentCalls;
+    uint64_t batchesSubmitted;
+} CringedSubmitter;
+
+CringedSubmitter *
+cringedCreateSubmitter ( void );
+
+void
+cringedDestroySubmitter ( CringedSubmitter * submitter );
+
+/* Queued until the next flush; flushes early when storage runs out */
+VkResult
+cringedSubmit ( CringedSubmitter *        submitter,
+                VkQueue                   queue,
+                const CringedSubmission * submission );
+
+/* Returns the index of `presentResults` set by the next flush, or
+ * CRINGED_SUBMIT_NO_PRESENT when full */
+uint32_t
+cringedSubmitPresent ( CringedSubmitter * submitter,
+                       VkQueue            queue,
+                       VkSwapchainKHR     swapChain,
+                       uint32_t           imageIndex,
+                       VkSemaphore        wait );
+
+/* Issues everything queued. Returns the first submit error; present
+ * outcomes are per swapchain in `presentResults`. */
+VkResult
+cringedSubmitFlush ( CringedSubmitter * submitter );
+
+#endif /* CRINGED_SUBMIT_H */
@@ -0,0 +1,174 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "trace.h"
+
+#include <time.h>
+
+uint8_t cringedTraceEnabled = 0;
+
+static _Atomic ( CringedTraceBuffer * ) traceBuffers = NULL;
+static atomic_uint                      traceNextTid = 1;
+static _Thread_local CringedTraceBuffer * traceLocal = NULL;
+static uint64_t                           traceStart = 0;
+static int64_t                            gpuOffset  = 0;
+
+uint64_t
+cringedTraceNow ( void )
+{
+    /* NOTE: CLOCK_MONOTONIC is also a calibrateable Vulkan time domain */
+    struct timespec ts;
+    clock_gettime ( CLOCK_MONOTONIC, &ts );
+    return ( uint64_t ) ts.tv_sec * 1000000000ull + ( uint64_t ) ts.tv_nsec;
+}
+
+void
+cringedTraceStart ( void )
+{
+    traceStart          = cringedTraceNow ();
+    cringedTraceEnabled = 1;
+}
+
+/* First event of a thread: allocate its buffer, push it lock-free */
+static CringedTraceBuffer *
+localBuffer ( void )
+{
+    if ( traceLocal ) return traceLocal;
+
+    CringedTraceBuffer * buffer =
+        ( CringedTraceBuffer * ) malloc ( sizeof ( CringedTraceBuffer ) );
+    if ( ! buffer ) return NULL;
+    buffer->tid     = atomic_fetch_add ( &traceNextTid, 1 );
+    buffer->name    = NULL;
+    buffer->dropped = 0;
+    atomic_init ( &buffer->count, 0 );
+
+    buffer->next = atomic_load ( &traceBuffers );
+    while ( ! atomic_compare_exchange_weak ( &traceBuffers,
+                                             &buffer->next,
+                                             buffer ) )
+        ;
+    traceLocal = buffer;
+    return buffer;
+}
+
+static void
+emit ( const char * name, uint64_t begin, uint64_t end, uint8_t gpu )
+{
+    CringedTraceBuffer * buffer = localBuffer ();
+    if ( ! buffer ) return;
+
+    uint32_t count = atomic_load_explicit ( &buffer->count,
+                                            memory_order_relaxed );
+    if ( count == CRINGED_TRACE_EVENTS )
+    {
+        buffer->dropped++;
+        return;
+    }
+    CringedTraceEvent * event = &buffer->events[ count ];
+    event->name               = name;
+    event->begin              = begin;
+    event->end                = end;
+    event->gpu                = gpu;
+    atomic_store_explicit ( &buffer->count, count + 1, memory_order_release );
+}
+
+void
+cringedTraceEmit ( const char * name, uint64_t begin, uint64_t end )
+{
+    emit ( name, begin, end, 0 );
+}
+
+void
+cringedTraceEmitGpu ( const char * name, uint64_t begin, uint64_t end )
+{
+    emit ( name, begin, end, 1 );
+}
+
+void
+cringedTraceGpuOffset ( int64_t offset )
+{
+    gpuOffset = offset;
+}
+
+void
+cringedTraceThreadName ( const char * name )
+{
+    if ( ! cringedTraceEnabled ) return;
+    CringedTraceBuffer * buffer = localBuffer ();
+    if ( buffer ) buffer->name = name;
+}
+
+/* Microseconds since cringedTraceStart, as trace-event timestamps */
+static double
+toMicros ( int64_t ns )
+{
+    return ( double ) ( ns - ( int64_t ) traceStart ) * 1e-3;
+}
+
+int
+cringedTraceWrite ( const char * path )
+{
+    if ( ! cringedTraceEnabled ) return 0;
+
+    FILE * file = fopen ( path, "w" );
+    if ( ! file )
+    {
+        _DEBUG_P ( "error: opening trace %s\n", path );
+        return 1;
+    }
+
+    fprintf ( file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+    fprintf ( file,
+              "{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\","
+              "\"args\":{\"name\":\"GPU graphics queue\"}}",
+              CRINGED_TRACE_GPU_TID );
+
+    uint32_t dropped = 0;
+    for ( CringedTraceBuffer * buffer = atomic_load ( &traceBuffers ); buffer;
+          buffer                      = buffer->next )
+    {
+        if ( buffer->name )
+            fprintf ( file,
+                      ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                      "\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}}",
+                      buffer->tid,
+                      buffer->name );
+
+        uint32_t count = atomic_load_explicit ( &buffer->count,
+                                                memory_order_acquire );
+        for ( uint32_t i = 0; i < count; i++ )
+        {
+            const CringedTraceEvent * event = &buffer->events[ i ];
+            int64_t shift = event->gpu ? gpuOffset : 0;
+            fprintf ( file,
+                      ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"name\":\"%s\","
+                      "\"ts\":%.3f,\"dur\":%.3f}",
+                      event->gpu ? CRINGED_TRACE_GPU_TID : buffer->tid,
+                      event->name,
+                      toMicros ( ( int64_t ) event->begin + shift ),
+                      ( double ) ( event->end - event->begin ) * 1e-3 );
+        }
+        dropped += buffer->dropped;
+    }
+    fprintf ( file, "\n]}\n" );
+    fclose ( file );
+
+    printf ( "trace: written to %s", path );
+    if ( dropped ) printf ( ", %u events dropped", dropped );
+    printf ( "\n" );
+    return 0;
+}
+
+void
+cringedTraceShutdown ( void )
+{
+    CringedTraceBuffer * buffer = atomic_exchange ( &traceBuffers, NULL );
+    while ( buffer )
+    {
+        CringedTraceBuffer * next = buffer->next;
+        free ( buffer );
+        buffer = next;
+    }
+    traceLocal          = NULL;
+    cringedTraceEnabled = 0;
+}
@@ -0,0 +1,118 @@
+#pragma once
+#ifndef CRINGED_TRACE_H
+#define CRINGED_TRACE_H
+
+#ifndef NDEBUG
+#define _DEBUG_P( ... ) printf ( __VA_ARGS__ )
+#else
+#define _DEBUG_P( ... ) ( ( void ) 0 )
+#endif
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CRINGED_TRACE_EVENTS  ( 1u << 16 ) /* per thread, later ones drop */
+#define CRINGED_TRACE_GPU_TID 0            /* track of the GPU zones */
+
+/* =============================================
+ *            CPU ZONES
+ * ============================================= */
+
+/* One complete zone, CLOCK_MONOTONIC nanoseconds (GPU zones: GPU time in
+ * nanoseconds, moved onto the CPU timeline on export) */
+typedef struct
+{
+    const char * name; /* static storage */
+    uint64_t     begin;
+    uint64_t     end;
+    uint8_t      gpu;
+} CringedTraceEvent;
+
+/* Written by its thread only; `count` publishes events to the exporter,
+ * so recording takes neither locks nor atomics beyond that store */
+typedef struct CringedTraceBuffer
+{
+    struct CringedTraceBuffer * next;
+    uint32_t                    tid;
+    const char *                name;
+    atomic_uint                 count;
+    uint32_t                    dropped;
+    CringedTraceEvent           events[ CRINGED_TRACE_EVENTS ];
+} CringedTraceBuffer;
+
+/* Set once by cringedTraceStart, before any other thread exists */
+extern uint8_t cringedTraceEnabled;
+
+void
+cringedTraceStart ( void );
+
+uint64_t
+cringedTraceNow ( void );
+
+void
+cringedTraceEmit ( const char * name, uint64_t begin, uint64_t end );
+
+/* Zone on the GPU track; `begin`/`end` in GPU nanoseconds */
+void
+cringedTraceEmitGpu ( const char * name, uint64_t begin, uint64_t end );
+
+/* CPU ns minus GPU ns, applied to GPU zones on export */
+void
+cringedTraceGpuOffset ( int64_t offset );
+
+/* Names the calling thread's track */
+void
+cringedTraceThreadName ( const char * name );
+
+/* Chrome trace-event JSON, loads in Perfetto and chrome://tracing.
+ * Call once every traced thread has stopped. */
+int
+cringedTraceWrite ( const char * path );
+
+void
+cringedTraceShutdown ( void );
+
+typedef struct
+{
+    const char * name;
+    uint64_t     begin; /* 0: tracing was off */
+} CringedZone;
+
+static inline CringedZone
+cringedZoneBegin ( const char * name )
+{
+    CringedZone zone = { name, cringedTraceEnabled ? cringedTraceNow () : 0 };
+    return zone;
+}
+
+static inline void
+cringedZoneEnd ( CringedZone * zone )
+{
+    if ( zone->begin )
+        cringedTraceEmit ( zone->name, zone->begin, cringedTraceNow () );
+}
+
+/* Scoped zone, ends with the enclosing block:
+ *   { CRINGED_ZONE ( "cull" ); ... }
+ * NOTE: not in functions that goto past it, use begin/end there.
+ * Define CRINGED_NO_TRACE to compile every zone out. */
+#define CRINGED_ZONE_CAT2( a, b ) a##b
+#define CRINGED_ZONE_CAT( a, b )  CRINGED_ZONE_CAT2 ( a, b )
+#ifndef CRINGED_NO_TRACE
+#define CRINGED_ZONE( name )                               \
+    CringedZone CRINGED_ZONE_CAT ( zone_, __LINE__ )       \
+        __attribute__ ( ( cleanup ( cringedZoneEnd ) ) ) = \
+            cringedZoneBegin ( name )
+#define CRINGED_ZONE_BEGIN( var, name ) \
+    CringedZone var = cringedZoneBegin ( name )
+#define CRINGED_ZONE_END( var ) cringedZoneEnd ( &var )
+#else
+#define CRINGED_ZONE( name )            ( ( void ) 0 )
+#define CRINGED_ZONE_BEGIN( var, name ) ( ( void ) 0 )
+#define CRINGED_ZONE_END( var )         ( ( void ) 0 )
+#endif
+
+#endif /* CRINGED_TRACE_H */
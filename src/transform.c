@@ -0,0 +1,427 @@
+#include "transform.h"
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define CRINGED_X86
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#ifndef NDEBUG
+#define _DEBUG_P( ... ) printf ( __VA_ARGS__ )
+#else
+#define _DEBUG_P( ... ) ( ( void ) 0 )
+#endif
+
+/* Elements per instance: world (16) + mvp (16) */
+#define INSTANCE_FLOATS ( sizeof ( CringedInstance ) / sizeof ( float ) )
+
+static CringedTransformKernel activeKernel = NULL;
+
+CringedTransforms *
+cringedCreateTransforms ( uint32_t capacity )
+{
+    CringedTransforms * t =
+        ( CringedTransforms * ) malloc ( sizeof ( CringedTransforms ) );
+    if ( ! t ) return NULL;
+
+    capacity = ( capacity + CRINGED_TRANSFORM_LANES - 1 ) &
+               ~( CRINGED_TRANSFORM_LANES - 1 );
+    if ( ! capacity ) capacity = CRINGED_TRANSFORM_LANES;
+
+    /* One block for all 12 streams, every stream stays 32-byte aligned */
+    size_t  blockSize = ( size_t ) capacity * 12 * sizeof ( float );
+    float * block     = ( float * ) aligned_alloc ( 32, blockSize );
+    if ( ! block )
+    {
+        free ( t );
+        return NULL;
+    }
+    memset ( block, 0, blockSize );
+
+    float ** streams[] = { &t->px, &t->py, &t->pz, &t->rx,
+                           &t->ry, &t->rz, &t->rw, &t->sx,
+                           &t->sy, &t->sz, &t->lr, &t->br };
+    for ( uint32_t i = 0; i < sizeof ( streams ) / sizeof ( streams[ 0 ] );
+          i++ )
+        *streams[ i ] = block + ( size_t ) i * capacity;
+
+    t->count    = 0;
+    t->capacity = capacity;
+    return t;
+}
+
+void
+cringedDestroyTransforms ( CringedTransforms * t )
+{
+    if ( ! t ) return;
+    free ( t->px ); /* block start */
+    free ( t );
+}
+
+void
+cringedTransformsSet ( CringedTransforms * t,
+                       uint32_t            idx,
+                       vec3                position,
+                       versor              rotation,
+                       vec3                scale )
+{
+    t->px[ idx ] = position[ 0 ];
+    t->py[ idx ] = position[ 1 ];
+    t->pz[ idx ] = position[ 2 ];
+    t->rx[ idx ] = rotation[ 0 ];
+    t->ry[ idx ] = rotation[ 1 ];
+    t->rz[ idx ] = rotation[ 2 ];
+    t->rw[ idx ] = rotation[ 3 ];
+    t->sx[ idx ] = scale[ 0 ];
+    t->sy[ idx ] = scale[ 1 ];
+    t->sz[ idx ] = scale[ 2 ];
+
+    float maxScale = fabsf ( scale[ 0 ] );
+    if ( fabsf ( scale[ 1 ] ) > maxScale ) maxScale = fabsf ( scale[ 1 ] );
+    if ( fabsf ( scale[ 2 ] ) > maxScale ) maxScale = fabsf ( scale[ 2 ] );
+    t->br[ idx ] = t->lr[ idx ] * maxScale;
+}
+
+void
+cringedTransformsSetRadius ( CringedTransforms * t,
+                             uint32_t            idx,
+                             float               radius )
+{
+    float maxScale = fabsf ( t->sx[ idx ] );
+    if ( fabsf ( t->sy[ idx ] ) > maxScale ) maxScale = fabsf ( t->sy[ idx ] );
+    if ( fabsf ( t->sz[ idx ] ) > maxScale ) maxScale = fabsf ( t->sz[ idx ] );
+    t->lr[ idx ] = radius;
+    t->br[ idx ] = radius * maxScale;
+}
+
+uint32_t
+cringedTransformsAdd ( CringedTransforms * t,
+                       vec3                position,
+                       versor              rotation,
+                       vec3                scale )
+{
+    if ( t->count >= t->capacity ) return UINT32_MAX;
+    t->lr[ t->count ] = 1.0f;
+    cringedTransformsSet ( t, t->count, position, rotation, scale );
+    return t->count++;
+}
+
+/* =============================================
+ *            SCALAR (cglm) KERNEL
+ * ============================================= */
+
+static void
+transformKernelScalar ( const CringedTransforms * t,
+                        uint32_t                  first,
+                        uint32_t                  count,
+                        mat4                      viewProj,
+                        CringedInstance *         dst )
+{
+    for ( uint32_t i = 0; i < count; i++ )
+    {
+        uint32_t j = first + i;
+        versor   q = { t->rx[ j ], t->ry[ j ], t->rz[ j ], t->rw[ j ] };
+        vec3     p = { t->px[ j ], t->py[ j ], t->pz[ j ] };
+        vec3     s = { t->sx[ j ], t->sy[ j ], t->sz[ j ] };
+
+        /* NOTE: build in cache, dst may be write-combined GPU memory */
+        CringedInstance instance;
+        mat4            rot, translate;
+        glm_quat_mat4 ( q, rot );
+        glm_translate_make ( translate, p );
+        glm_mat4_mul ( translate, rot, instance.world );
+        glm_scale ( instance.world, s );
+        glm_mat4_mul ( viewProj, instance.world, instance.mvp );
+
+        memcpy ( dst + i, &instance, sizeof ( instance ) );
+    }
+}
+
+#ifdef CRINGED_X86
+
+/* =============================================
+ *            SSE2 KERNEL: 4 objects / batch
+ * ============================================= */
+
+static void
+transformKernelSSE2 ( const CringedTransforms * t,
+                      uint32_t                  first,
+                      uint32_t                  count,
+                      mat4                      viewProj,
+                      CringedInstance *         dst )
+{
+    const __m128 one = _mm_set1_ps ( 1.0f );
+    const __m128 two = _mm_set1_ps ( 2.0f );
+
+    __m128 vp[ 16 ];
+    for ( uint32_t k = 0; k < 16; k++ )
+        vp[ k ] = _mm_set1_ps ( viewProj[ k / 4 ][ k % 4 ] );
+
+    uint32_t i = 0;
+    for ( ; i + 4 <= count; i += 4 )
+    {
+        uint32_t j = first + i;
+
+        __m128 x = _mm_loadu_ps ( t->rx + j );
+        __m128 y = _mm_loadu_ps ( t->ry + j );
+        __m128 z = _mm_loadu_ps ( t->rz + j );
+        __m128 w = _mm_loadu_ps ( t->rw + j );
+
+        __m128 xx = _mm_mul_ps ( x, x ), yy = _mm_mul_ps ( y, y ),
+               zz = _mm_mul_ps ( z, z );
+        __m128 xy = _mm_mul_ps ( x, y ), xz = _mm_mul_ps ( x, z ),
+               yz = _mm_mul_ps ( y, z );
+        __m128 wx = _mm_mul_ps ( w, x ), wy = _mm_mul_ps ( w, y ),
+               wz = _mm_mul_ps ( w, z );
+
+        __m128 sx = _mm_loadu_ps ( t->sx + j );
+        __m128 sy = _mm_loadu_ps ( t->sy + j );
+        __m128 sz = _mm_loadu_ps ( t->sz + j );
+
+        /* v[ 0..15 ]: world, column major; v[ 16..31 ]: mvp */
+        __m128 v[ 32 ];
+        v[ 0 ] = _mm_mul_ps (
+            _mm_sub_ps ( one, _mm_mul_ps ( two, _mm_add_ps ( yy, zz ) ) ),
+            sx );
+        v[ 1 ] = _mm_mul_ps ( _mm_mul_ps ( two, _mm_add_ps ( xy, wz ) ), sx );
+        v[ 2 ] = _mm_mul_ps ( _mm_mul_ps ( two, _mm_sub_ps ( xz, wy ) ), sx );
+        v[ 3 ] = _mm_setzero_ps ();
+        v[ 4 ] = _mm_mul_ps ( _mm_mul_ps ( two, _mm_sub_ps ( xy, wz ) ), sy );
+        v[ 5 ] = _mm_mul_ps (
+            _mm_sub_ps ( one, _mm_mul_ps ( two, _mm_add_ps ( xx, zz ) ) ),
+            sy );
+        v[ 6 ] = _mm_mul_ps ( _mm_mul_ps ( two, _mm_add_ps ( yz, wx ) ), sy );
+        v[ 7 ] = _mm_setzero_ps ();
+        v[ 8 ] = _mm_mul_ps ( _mm_mul_ps ( two, _mm_add_ps ( xz, wy ) ), sz );
+        v[ 9 ] = _mm_mul_ps ( _mm_mul_ps ( two, _mm_sub_ps ( yz, wx ) ), sz );
+        v[ 10 ] = _mm_mul_ps (
+            _mm_sub_ps ( one, _mm_mul_ps ( two, _mm_add_ps ( xx, yy ) ) ),
+            sz );
+        v[ 11 ] = _mm_setzero_ps ();
+        v[ 12 ] = _mm_loadu_ps ( t->px + j );
+        v[ 13 ] = _mm_loadu_ps ( t->py + j );
+        v[ 14 ] = _mm_loadu_ps ( t->pz + j );
+        v[ 15 ] = one;
+
+        /* mvp[ c ][ r ] = sum_k vp[ k ][ r ] * world[ c ][ k ] */
+        for ( uint32_t c = 0; c < 4; c++ )
+            for ( uint32_t r = 0; r < 4; r++ )
+            {
+                __m128 acc = _mm_mul_ps ( vp[ r ], v[ c * 4 ] );
+                acc        = _mm_add_ps (
+                    acc, _mm_mul_ps ( vp[ 4 + r ], v[ c * 4 + 1 ] ) );
+                acc = _mm_add_ps (
+                    acc, _mm_mul_ps ( vp[ 8 + r ], v[ c * 4 + 2 ] ) );
+                if ( c == 3 ) acc = _mm_add_ps ( acc, vp[ 12 + r ] );
+                v[ 16 + c * 4 + r ] = acc;
+            }
+
+        /* SoA -> AoS: 4x4 transposes, row `o` becomes object `o` */
+        float * out = ( float * ) ( dst + i );
+        for ( uint32_t g = 0; g < 32; g += 4 )
+        {
+            __m128 r0 = v[ g ], r1 = v[ g + 1 ], r2 = v[ g + 2 ],
+                   r3 = v[ g + 3 ];
+            _MM_TRANSPOSE4_PS ( r0, r1, r2, r3 );
+            _mm_storeu_ps ( out + 0 * INSTANCE_FLOATS + g, r0 );
+            _mm_storeu_ps ( out + 1 * INSTANCE_FLOATS + g, r1 );
+            _mm_storeu_ps ( out + 2 * INSTANCE_FLOATS + g, r2 );
+            _mm_storeu_ps ( out + 3 * INSTANCE_FLOATS + g, r3 );
+        }
+    }
+
+    if ( i < count )
+        transformKernelScalar ( t, first + i, count - i, viewProj, dst + i );
+}
+
+/* =============================================
+ *         AVX2 + FMA KERNEL: 8 objects / batch
+ * ============================================= */
+
+__attribute__ ( ( target ( "avx2,fma" ) ) ) static inline void
+transpose8x8 ( __m256 * r )
+{
+    __m256 t0 = _mm256_unpacklo_ps ( r[ 0 ], r[ 1 ] );
+    __m256 t1 = _mm256_unpackhi_ps ( r[ 0 ], r[ 1 ] );
+    __m256 t2 = _mm256_unpacklo_ps ( r[ 2 ], r[ 3 ] );
+    __m256 t3 = _mm256_unpackhi_ps ( r[ 2 ], r[ 3 ] );
+    __m256 t4 = _mm256_unpacklo_ps ( r[ 4 ], r[ 5 ] );
+    __m256 t5 = _mm256_unpackhi_ps ( r[ 4 ], r[ 5 ] );
+    __m256 t6 = _mm256_unpacklo_ps ( r[ 6 ], r[ 7 ] );
+    __m256 t7 = _mm256_unpackhi_ps ( r[ 6 ], r[ 7 ] );
+
+    __m256 s0 = _mm256_shuffle_ps ( t0, t2, _MM_SHUFFLE ( 1, 0, 1, 0 ) );
+    __m256 s1 = _mm256_shuffle_ps ( t0, t2, _MM_SHUFFLE ( 3, 2, 3, 2 ) );
+    __m256 s2 = _mm256_shuffle_ps ( t1, t3, _MM_SHUFFLE ( 1, 0, 1, 0 ) );
+    __m256 s3 = _mm256_shuffle_ps ( t1, t3, _MM_SHUFFLE ( 3, 2, 3, 2 ) );
+    __m256 s4 = _mm256_shuffle_ps ( t4, t6, _MM_SHUFFLE ( 1, 0, 1, 0 ) );
+    __m256 s5 = _mm256_shuffle_ps ( t4, t6, _MM_SHUFFLE ( 3, 2, 3, 2 ) );
+    __m256 s6 = _mm256_shuffle_ps ( t5, t7, _MM_SHUFFLE ( 1, 0, 1, 0 ) );
+    __m256 s7 = _mm256_shuffle_ps ( t5, t7, _MM_SHUFFLE ( 3, 2, 3, 2 ) );
+
+    r[ 0 ] = _mm256_permute2f128_ps ( s0, s4, 0x20 );
+    r[ 1 ] = _mm256_permute2f128_ps ( s1, s5, 0x20 );
+    r[ 2 ] = _mm256_permute2f128_ps ( s2, s6, 0x20 );
+    r[ 3 ] = _mm256_permute2f128_ps ( s3, s7, 0x20 );
+    r[ 4 ] = _mm256_permute2f128_ps ( s0, s4, 0x31 );
+    r[ 5 ] = _mm256_permute2f128_ps ( s1, s5, 0x31 );
+    r[ 6 ] = _mm256_permute2f128_ps ( s2, s6, 0x31 );
+    r[ 7 ] = _mm256_permute2f128_ps ( s3, s7, 0x31 );
+}
+
+__attribute__ ( ( target ( "avx2,fma" ) ) ) static void
+transformKernelAVX2 ( const CringedTransforms * t,
+                      uint32_t                  first,
+                      uint32_t                  count,
+                      mat4                      viewProj,
+                      CringedInstance *         dst )
+{
+    const __m256 one = _mm256_set1_ps ( 1.0f );
+    const __m256 two = _mm256_set1_ps ( 2.0f );
+
+    __m256 vp[ 16 ];
+    for ( uint32_t k = 0; k < 16; k++ )
+        vp[ k ] = _mm256_set1_ps ( viewProj[ k / 4 ][ k % 4 ] );
+
+    uint32_t i = 0;
+    for ( ; i + 8 <= count; i += 8 )
+    {
+        uint32_t j = first + i;
+
+        __m256 x = _mm256_loadu_ps ( t->rx + j );
+        __m256 y = _mm256_loadu_ps ( t->ry + j );
+        __m256 z = _mm256_loadu_ps ( t->rz + j );
+        __m256 w = _mm256_loadu_ps ( t->rw + j );
+
+        /* Pre-doubled terms: 2x^2, 2xy, ... */
+        __m256 x2 = _mm256_mul_ps ( x, two ), y2 = _mm256_mul_ps ( y, two ),
+               z2 = _mm256_mul_ps ( z, two );
+        __m256 xx = _mm256_mul_ps ( x, x2 ), yy = _mm256_mul_ps ( y, y2 ),
+               zz = _mm256_mul_ps ( z, z2 );
+        __m256 xy = _mm256_mul_ps ( x, y2 ), xz = _mm256_mul_ps ( x, z2 ),
+               yz = _mm256_mul_ps ( y, z2 );
+        __m256 wx = _mm256_mul_ps ( w, x2 ), wy = _mm256_mul_ps ( w, y2 ),
+               wz = _mm256_mul_ps ( w, z2 );
+
+        __m256 sx = _mm256_loadu_ps ( t->sx + j );
+        __m256 sy = _mm256_loadu_ps ( t->sy + j );
+        __m256 sz = _mm256_loadu_ps ( t->sz + j );
+
+        __m256 v[ 32 ];
+        v[ 0 ] = _mm256_mul_ps (
+            _mm256_sub_ps ( one, _mm256_add_ps ( yy, zz ) ), sx );
+        v[ 1 ]  = _mm256_mul_ps ( _mm256_add_ps ( xy, wz ), sx );
+        v[ 2 ]  = _mm256_mul_ps ( _mm256_sub_ps ( xz, wy ), sx );
+        v[ 3 ]  = _mm256_setzero_ps ();
+        v[ 4 ]  = _mm256_mul_ps ( _mm256_sub_ps ( xy, wz ), sy );
+        v[ 5 ]  = _mm256_mul_ps (
+            _mm256_sub_ps ( one, _mm256_add_ps ( xx, zz ) ), sy );
+        v[ 6 ]  = _mm256_mul_ps ( _mm256_add_ps ( yz, wx ), sy );
+        v[ 7 ]  = _mm256_setzero_ps ();
+        v[ 8 ]  = _mm256_mul_ps ( _mm256_add_ps ( xz, wy ), sz );
+        v[ 9 ]  = _mm256_mul_ps ( _mm256_sub_ps ( yz, wx ), sz );
+        v[ 10 ] = _mm256_mul_ps (
+            _mm256_sub_ps ( one, _mm256_add_ps ( xx, yy ) ), sz );
+        v[ 11 ] = _mm256_setzero_ps ();
+        v[ 12 ] = _mm256_loadu_ps ( t->px + j );
+        v[ 13 ] = _mm256_loadu_ps ( t->py + j );
+        v[ 14 ] = _mm256_loadu_ps ( t->pz + j );
+        v[ 15 ] = one;
+
+        for ( uint32_t c = 0; c < 4; c++ )
+            for ( uint32_t r = 0; r < 4; r++ )
+            {
+                __m256 acc = c == 3 ? vp[ 12 + r ] : _mm256_setzero_ps ();
+                acc = _mm256_fmadd_ps ( vp[ r ], v[ c * 4 ], acc );
+                acc = _mm256_fmadd_ps ( vp[ 4 + r ], v[ c * 4 + 1 ], acc );
+                acc = _mm256_fmadd_ps ( vp[ 8 + r ], v[ c * 4 + 2 ], acc );
+                v[ 16 + c * 4 + r ] = acc;
+            }
+
+        /* SoA -> AoS: four 8x8 transposes, row `o` becomes object `o` */
+        float * out = ( float * ) ( dst + i );
+        for ( uint32_t g = 0; g < 32; g += 8 )
+        {
+            transpose8x8 ( v + g );
+            for ( uint32_t o = 0; o < 8; o++ )
+                _mm256_storeu_ps ( out + o * INSTANCE_FLOATS + g, v[ g + o ] );
+        }
+    }
+
+    if ( i < count )
+        transformKernelSSE2 ( t, first + i, count - i, viewProj, dst + i );
+}
+
+#endif /* CRINGED_X86 */
+
+/* =============================================
+ *            RUNTIME DISPATCH
+ * ============================================= */
+
+CringedSimdLevel
+cringedDetectSimd ( void )
+{
+#ifdef CRINGED_X86
+    unsigned int eax, ebx, ecx, edx;
+    if ( ! __get_cpuid ( 1, &eax, &ebx, &ecx, &edx ) )
+        return CRINGED_SIMD_SCALAR;
+
+    CringedSimdLevel level =
+        ( edx & bit_SSE2 ) ? CRINGED_SIMD_SSE2 : CRINGED_SIMD_SCALAR;
+
+    /* AVX needs OS support for YMM state (XCR0 bits 1 and 2) */
+    if ( ! ( ecx & bit_OSXSAVE ) || ! ( ecx & bit_AVX ) ||
+         ! ( ecx & bit_FMA ) )
+        return level;
+
+    unsigned int xcr0Lo, xcr0Hi;
+    __asm__ volatile ( "xgetbv" : "=a"( xcr0Lo ), "=d"( xcr0Hi ) : "c"( 0 ) );
+    if ( ( xcr0Lo & 0x6 ) != 0x6 ) return level;
+
+    if ( __get_cpuid_max ( 0, NULL ) < 7 ) return level;
+    __cpuid_count ( 7, 0, eax, ebx, ecx, edx );
+    if ( ebx & bit_AVX2 ) level = CRINGED_SIMD_AVX2;
+
+    return level;
+#else
+    return CRINGED_SIMD_SCALAR;
+#endif
+}
+
+CringedTransformKernel
+cringedTransformKernel ( CringedSimdLevel level )
+{
+    switch ( level )
+    {
+#ifdef CRINGED_X86
+    case CRINGED_SIMD_AVX2: return transformKernelAVX2;
+    case CRINGED_SIMD_SSE2: return transformKernelSSE2;
+#endif
+    default: return transformKernelScalar;
+    }
+}
+
+const char *
+cringedSimdLevelName ( CringedSimdLevel level )
+{
+    switch ( level )
+    {
+    case CRINGED_SIMD_AVX2: return "avx2+fma";
+    case CRINGED_SIMD_SSE2: return "sse2";
+    default: return "scalar";
+    }
+}
+
+void
+cringedTransformsUpdate ( const CringedTransforms * t,
+                          mat4                      viewProj,
+                          CringedInstance *         dst )
+{
+    if ( ! activeKernel )
+    {
+        CringedSimdLevel level = cringedDetectSimd ();
+        activeKernel           = cringedTransformKernel ( level );
+        _DEBUG_P ( "Transform kernel: %s\n", cringedSimdLevelName ( level ) );
+    }
+    activeKernel ( t, 0, t->count, viewProj, dst );
+}
@@ -0,0 +1,91 @@
+#pragma once
+#ifndef CRINGED_TRANSFORM_H
+#define CRINGED_TRANSFORM_H
+
+#include <cglm/cglm.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* SoA lanes are padded to this many objects (one AVX2 register) */
+#define CRINGED_TRANSFORM_LANES 8
+
+/* std430 layout, matches `Instance` in Triangle_vert.glsl */
+typedef struct
+{
+    mat4 world;
+    mat4 mvp;
+} CringedInstance;
+
+/* Structure-of-arrays transforms: one float stream per component,
+ * 32-byte aligned so kernels can load 8 objects per instruction. */
+typedef struct
+{
+    uint32_t count;
+    uint32_t capacity;
+    float *  px, *py, *pz;      /* position */
+    float *  rx, *ry, *rz, *rw; /* rotation, unit quaternion (xyzw) */
+    float *  sx, *sy, *sz;      /* scale */
+    float *  lr;                /* bounding sphere radius, local space */
+    float *  br;                /* bounding sphere radius, scale applied */
+} CringedTransforms;
+
+typedef enum
+{
+    CRINGED_SIMD_SCALAR = 0,
+    CRINGED_SIMD_SSE2,
+    CRINGED_SIMD_AVX2,
+} CringedSimdLevel;
+
+/* Writes `count` instances starting at `first` into `dst[ 0 .. count )` */
+typedef void ( *CringedTransformKernel ) ( const CringedTransforms * t,
+                                           uint32_t                  first,
+                                           uint32_t                  count,
+                                           mat4                      viewProj,
+                                           CringedInstance *         dst );
+
+CringedTransforms *
+cringedCreateTransforms ( uint32_t capacity );
+
+void
+cringedDestroyTransforms ( CringedTransforms * t );
+
+/* Returns new index or UINT32_MAX when full */
+uint32_t
+cringedTransformsAdd ( CringedTransforms * t,
+                       vec3                position,
+                       versor              rotation,
+                       vec3                scale );
+
+void
+cringedTransformsSet ( CringedTransforms * t,
+                       uint32_t            idx,
+                       vec3                position,
+                       versor              rotation,
+                       vec3                scale );
+
+/* Local bounding sphere radius around the position (default 1) */
+void
+cringedTransformsSetRadius ( CringedTransforms * t,
+                             uint32_t            idx,
+                             float               radius );
+
+/* Highest level supported by CPU (CPUID) and OS (XGETBV) */
+CringedSimdLevel
+cringedDetectSimd ( void );
+
+CringedTransformKernel
+cringedTransformKernel ( CringedSimdLevel level );
+
+const char *
+cringedSimdLevelName ( CringedSimdLevel level );
+
+/* Computes world + MVP for all transforms with the best kernel for this
+ * CPU. `dst` is expected to be the mapped GPU instance buffer. */
+void
+cringedTransformsUpdate ( const CringedTransforms * t,
+                          mat4                      viewProj,
+                          CringedInstance *         dst );
+
+#endif /* CRINGED_TRANSFORM_H */
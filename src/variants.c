@@ -0,0 +1,83 @@
+#include "variants.h"
+
+const uint32_t cringedMaterialFeatures[ CRINGED_MATERIAL_COUNT ] = {
+    0,                   /* CRINGED_MATERIAL_DEFAULT */
+    CRINGED_FEATURE_LIT, /* CRINGED_MATERIAL_LIT */
+};
+
+void
+cringedSpecialize ( uint32_t features, CringedSpecialization * specialization )
+{
+    specialization->constants[ 0 ] = features & CRINGED_FEATURE_SOURCE_MASK;
+    specialization->constants[ 1 ] = ( features & CRINGED_FEATURE_LIT ) != 0;
+    specialization->constants[ 2 ] =
+        ( features & CRINGED_FEATURE_DEBUG_MASK ) >>
+        CRINGED_FEATURE_DEBUG_SHIFT;
+
+    /* constant_id n is constants[ n ], bool constants are 32-bit */
+    for ( uint32_t c = 0; c < 3; c++ )
+    {
+        specialization->entries[ c ].constantID = c;
+        specialization->entries[ c ].offset     = c * sizeof ( uint32_t );
+        specialization->entries[ c ].size       = sizeof ( uint32_t );
+    }
+    specialization->info.mapEntryCount = 3;
+    specialization->info.pMapEntries   = specialization->entries;
+    specialization->info.dataSize      = sizeof ( specialization->constants );
+    specialization->info.pData         = specialization->constants;
+}
+
+VkResult
+cringedCreatePipelineCache ( VkDevice          device,
+                             const char *      path,
+                             VkPipelineCache * cache )
+{
+    void * data = NULL;
+    long   size = 0;
+    FILE * file = path ? fopen ( path, "rb" ) : NULL;
+    if ( file )
+    {
+        if ( fseek ( file, 0, SEEK_END ) == 0 &&
+             ( size = ftell ( file ) ) > 0 &&
+             fseek ( file, 0, SEEK_SET ) == 0 &&
+             ( data = malloc ( size ) ) &&
+             fread ( data, 1, size, file ) != ( size_t ) size )
+        {
+            free ( data );
+            data = NULL;
+        }
+        fclose ( file );
+    }
+
+    VkPipelineCacheCreateInfo createInfo = {};
+    createInfo.sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = data ? ( size_t ) size : 0;
+    createInfo.pInitialData    = data;
+    VkResult opResult =
+        vkCreatePipelineCache ( device, &createInfo, NULL, cache );
+    free ( data );
+    return opResult;
+}
+
+void
+cringedDestroyPipelineCache ( VkDevice        device,
+                              VkPipelineCache cache,
+                              const char *    path )
+{
+    if ( cache == VK_NULL_HANDLE ) return;
+
+    size_t size = 0;
+    void * data = NULL;
+    if ( path &&
+         vkGetPipelineCacheData ( device, cache, &size, NULL ) == VK_SUCCESS &&
+         size && ( data = malloc ( size ) ) &&
+         vkGetPipelineCacheData ( device, cache, &size, data ) == VK_SUCCESS )
+    {
+        FILE * file = fopen ( path, "wb" );
+        if ( ! file || fwrite ( data, 1, size, file ) != size )
+            _DEBUG_P ( "warning: pipeline cache not writable: %s\n", path );
+        if ( file ) fclose ( file );
+    }
+    free ( data );
+    vkDestroyPipelineCache ( device, cache, NULL );
+}
@@ -0,0 +1,83 @@
+#pragma once
+#ifndef CRINGED_VARIANTS_H
+#define CRINGED_VARIANTS_H
+
+#include "bufferUtils.h"
+#include "renderQueue.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vulkan/vulkan.h>
+
+#ifndef NDEBUG
+#define _DEBUG_P( ... ) printf ( __VA_ARGS__ )
+#else
+#define _DEBUG_P( ... ) ( ( void ) 0 )
+#endif
+
+/* Feature word of the Triangle_* programs. Every field is a
+ * specialization constant: each variant is compiled with its features
+ * folded in, so no draw pays for a branch it never takes.
+ *   bits 0-1: CRINGED_DRAW_*, where instances come from (constant 0)
+ *   bit  2:   Lambert lighting from the world normal (constant 1)
+ *   bits 3-4: CRINGED_DEBUG_VIEW_*, replaces the shading (constant 2) */
+#define CRINGED_FEATURE_SOURCE_MASK 0x03u
+#define CRINGED_FEATURE_LIT         0x04u
+#define CRINGED_FEATURE_DEBUG_SHIFT 3
+#define CRINGED_FEATURE_DEBUG_MASK  0x18u
+#define CRINGED_FEATURE_COUNT       32 /* distinct feature words */
+
+#define CRINGED_DEBUG_VIEW_NONE     0
+#define CRINGED_DEBUG_VIEW_INSTANCE 1 /* a color per instance index */
+#define CRINGED_DEBUG_VIEW_DEPTH    2 /* window-space depth */
+
+/* One pipeline per pass and feature word */
+typedef enum
+{
+    CRINGED_VARIANT_COLOR,       /* LESS, writes depth */
+    CRINGED_VARIANT_DEPTH,       /* no fragment stage: source bits only */
+    CRINGED_VARIANT_DEPTH_EQUAL, /* after a depth pre-pass */
+    CRINGED_VARIANT_PASS_COUNT,
+} CringedVariantPass;
+
+/* Features each CRINGED_MATERIAL_* selects, source and debug bits are
+ * added by the renderer */
+extern const uint32_t cringedMaterialFeatures[ CRINGED_MATERIAL_COUNT ];
+
+/* Specialization data of one feature word, valid while it lives; the
+ * same info serves both stages, unused constants are ignored */
+typedef struct
+{
+    uint32_t                 constants[ 3 ]; /* source, lit, debug view */
+    VkSpecializationMapEntry entries[ 3 ];
+    VkSpecializationInfo     info;
+} CringedSpecialization;
+
+void
+cringedSpecialize ( uint32_t features, CringedSpecialization * specialization );
+
+/* Table slot of a variant: depth-only pipelines ignore shading bits */
+static inline uint32_t
+cringedVariantKey ( CringedVariantPass pass, uint32_t features )
+{
+    return pass == CRINGED_VARIANT_DEPTH
+               ? features & CRINGED_FEATURE_SOURCE_MASK
+               : features;
+}
+
+/* Seeded from `path` when it holds data of this driver and device, the
+ * driver rejects anything else. `path` may be NULL. */
+VkResult
+cringedCreatePipelineCache ( VkDevice          device,
+                             const char *      path,
+                             VkPipelineCache * cache );
+
+/* Writes the cache back to `path`, then destroys it */
+void
+cringedDestroyPipelineCache ( VkDevice        device,
+                              VkPipelineCache cache,
+                              const char *    path );
+
+#endif /* CRINGED_VARIANTS_H */
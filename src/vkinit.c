@@ -1,9 +1,5 @@
 #include "vkinit.h"
 
-/* Load GLSL -> compiled SPIR-V Shaders embedded with xxd */
-#include "resources/shaders/Triangle_frag.h"
-#include "resources/shaders/Triangle_vert.h"
-
 #ifndef NDEBUG
 #define free( ptr )                                                     \
     do {                                                                \
@@ -53,6 +49,18 @@ u_clamp ( uint32_t value, uint32_t min, uint32_t max )
     return value < min ? min : ( value > max ? max : value );
 }
 
+static VkSurfaceFormatKHR
+chooseSurfaceFormat ( const VkSurfaceFormatKHR * formats, uint32_t count )
+{
+    for ( uint32_t i = 0; i < count; i++ )
+    {
+        if ( formats[ i ].format == VK_FORMAT_B8G8R8A8_SRGB &&
+             formats[ i ].colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR )
+            return formats[ i ];
+    }
+    return formats[ 0 ];
+}
+
 static SwapChainConfig
 chooseBestSwapChainConfig ( const SwapChainSupportDetails * details,
                             uint32_t                        window_width,
@@ -60,17 +68,8 @@ chooseBestSwapChainConfig ( const SwapChainSupportDetails * details,
 {
     SwapChainConfig config;
 
-    config.surfaceFormat = details->formats[ 0 ];
-    for ( size_t i = 0; i < details->formatCount; i++ )
-    {
-        if ( details->formats[ i ].format == VK_FORMAT_B8G8R8A8_SRGB &&
-             details->formats[ i ].colorSpace ==
-                 VK_COLOR_SPACE_SRGB_NONLINEAR_KHR )
-        {
-            config.surfaceFormat = details->formats[ i ];
-            break;
-        }
-    }
+    config.surfaceFormat =
+        chooseSurfaceFormat ( details->formats, details->formatCount );
 
     config.presentMode = VK_PRESENT_MODE_FIFO_KHR;
     for ( size_t i = 0; i < details->modeCount; i++ )
@@ -108,19 +107,21 @@ chooseBestSwapChainConfig ( const SwapChainSupportDetails * details,
     return config;
 }
 
+/* Graphics and presentation to every window: one queue presents all */
 int32_t
 findGraphicsQueueFamily ( Engine * engine )
 {
 
-    VkBool32 presentSupport = false;
     for ( uint32_t i = 0; i < engine->queueFamilies->count; i++ )
     {
-        if ( vkGetPhysicalDeviceSurfaceSupportKHR ( //
-                 engine->physicalDevice,
-                 i,
-                 *engine->surface,
-                 &presentSupport ) )
-            continue;
+        VkBool32 presentSupport = true;
+        for ( uint32_t w = 0; w < engine->windowCount && presentSupport; w++ )
+            if ( vkGetPhysicalDeviceSurfaceSupportKHR ( //
+                     engine->physicalDevice,
+                     i,
+                     engine->windows[ w ].surface,
+                     &presentSupport ) )
+                presentSupport = false;
         if ( ( engine->queueFamilies->queues[ i ].queueFlags &
                VK_QUEUE_GRAPHICS_BIT ) &&
              presentSupport )
@@ -136,6 +137,8 @@ BasedVKInit ( Engine * engine )
     const char **             vkExtensionsFull = NULL;
     VkLayerProperties *       availableLayers  = NULL;
     VkPhysicalDevice *        devices          = NULL;
+    CringedDeviceCandidate *  candidates       = NULL;
+    const char **             deviceExtensions = NULL;
     VkQueueFamilyProperties * queues           = NULL;
 
     /* Debug logger instantiated */
@@ -287,19 +290,23 @@ BasedVKInit ( Engine * engine )
         }
     }
 
-    /* Create VK+GLFW Surface */
+    /* Create VK+GLFW Surfaces, one per window */
 
-    U_ALLOC ( engine->surface, VkSurfaceKHR, 1 );
-    if ( ( opResult = glfwCreateWindowSurface ( //
-               *engine->vkInstance,
-               engine->window,
-               NULL,
-               engine->surface ) ) != VK_SUCCESS )
+    for ( uint32_t w = 0; w < engine->windowCount; w++ )
     {
-        free ( engine->surface );
-        engine->surface = NULL;
-        _DEBUG_P ( "error: failed to create VK surface: %d\n", opResult );
-        goto defer_cleanup;
+        CringedWindow * window = &engine->windows[ w ];
+        if ( ( opResult = glfwCreateWindowSurface ( //
+                   *engine->vkInstance,
+                   window->window,
+                   NULL,
+                   &window->surface ) ) != VK_SUCCESS )
+        {
+            window->surface = VK_NULL_HANDLE;
+            _DEBUG_P ( "error: failed to create VK surface %u: %d\n",
+                       w,
+                       opResult );
+            goto defer_cleanup;
+        }
     }
 
     /* Physical Device Selection */
@@ -321,43 +328,80 @@ BasedVKInit ( Engine * engine )
         goto defer_cleanup;
     }
 
-    /* Iterate through devices and select suitable */
-
-    VkPhysicalDeviceProperties deviceProperties = {};
-    VkPhysicalDeviceFeatures   deviceFeatures   = {};
-
+    /* Rate every device, the best usable one wins: see deviceSelect.h;
+     * the queue family search below checks the other windows */
+    U_ALLOC ( candidates, CringedDeviceCandidate, deviceCount );
     for ( uint32_t i = 0; i < deviceCount; i++ )
-    {
-
-        vkGetPhysicalDeviceProperties ( devices[ i ], &deviceProperties );
-        vkGetPhysicalDeviceFeatures ( devices[ i ], &deviceFeatures );
-        _DEBUG_P ( "Device found: %s of type %d and %d\n",
-                   deviceProperties.deviceName,
-                   deviceProperties.deviceType,
-                   deviceFeatures.geometryShader );
-        // TODO: check extensions compability and support
-        if ( (
-#ifdef LLVM_MESA
-                 deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU
-#else
-                 deviceProperties.deviceType ==
-                     VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU ||
-                 deviceProperties.deviceType ==
-                     VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU
-#endif
-                 ) &&
-             deviceFeatures.geometryShader )
-        {
-            engine->physicalDevice = devices[ i ];
-            break;
-        }
-    }
-
-    if ( ! engine->physicalDevice )
+        cringedRateDevice ( devices[ i ],
+                            engine->windows[ 0 ].surface,
+                            engine->customDeviceExt.data,
+                            engine->customDeviceExt.size,
+                            &candidates[ i ] );
+
+    uint32_t selected = cringedSelectDevice ( candidates,
+                                              deviceCount,
+                                              engine->deviceBenchmark,
+                                              engine->deviceCachePath );
+    if ( selected == CRINGED_DEVICE_NONE )
     {
         _DEBUG_P ( "error: getting Physical Devices : no suitable found\n" );
         goto defer_cleanup;
     }
+    engine->physicalDevice = candidates[ selected ].device;
+
+    VkPhysicalDeviceProperties deviceProperties =
+        candidates[ selected ].properties;
+    /* Only what the renderer uses, each where the device supports it */
+    VkPhysicalDeviceFeatures supportedFeatures = {};
+    vkGetPhysicalDeviceFeatures ( engine->physicalDevice, &supportedFeatures );
+    VkPhysicalDeviceFeatures deviceFeatures = {};
+    /* Depth outside the viewport range is clamped; without it, clipped */
+    deviceFeatures.depthClamp = supportedFeatures.depthClamp;
+    /* Indirect draws whose instances start past 0 */
+    deviceFeatures.drawIndirectFirstInstance =
+        supportedFeatures.drawIndirectFirstInstance;
+    engine->depthClamp = deviceFeatures.depthClamp == VK_TRUE;
+    engine->drawIndirectFirstInstance =
+        deviceFeatures.drawIndirectFirstInstance == VK_TRUE;
+    _DEBUG_P ( "Depth clamp: %s, indirect first instance: %s\n",
+               engine->depthClamp ? "yes" : "no",
+               engine->drawIndirectFirstInstance ? "yes" : "no" );
+
+    /* Dynamic rendering (core 1.3): begin on image views, no render pass
+     * or framebuffer objects. Falls back to those when unsupported. */
+    VkPhysicalDeviceDynamicRenderingFeatures dynamicRenderingFeatures = {};
+    dynamicRenderingFeatures.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+    /* Synchronization2 (core 1.3): vkQueueSubmit2 for the submitter */
+    VkPhysicalDeviceSynchronization2Features synchronization2Features = {};
+    synchronization2Features.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES;
+    if ( deviceProperties.apiVersion >= VK_API_VERSION_1_3 )
+    {
+        VkPhysicalDeviceFeatures2 features2 = {};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &dynamicRenderingFeatures;
+        dynamicRenderingFeatures.pNext = &synchronization2Features;
+        vkGetPhysicalDeviceFeatures2 ( engine->physicalDevice, &features2 );
+    }
+    engine->dynamicRendering = dynamicRenderingFeatures.dynamicRendering;
+    engine->synchronization2 = synchronization2Features.synchronization2;
+    engine->submitter->synchronization2 = engine->synchronization2;
+    _DEBUG_P ( "Dynamic rendering: %s, synchronization2: %s\n",
+               engine->dynamicRendering ? "yes" : "no",
+               engine->synchronization2 ? "yes" : "no" );
+
+    /* Device creation chains the supported ones only */
+    void * enabledFeatures         = NULL;
+    synchronization2Features.pNext = NULL;
+    dynamicRenderingFeatures.pNext = NULL;
+    if ( engine->synchronization2 )
+        enabledFeatures = &synchronization2Features;
+    if ( engine->dynamicRendering )
+    {
+        dynamicRenderingFeatures.pNext = enabledFeatures;
+        enabledFeatures                = &dynamicRenderingFeatures;
+    }
 
     /* Get Queue Families for current device */
     uint32_t queueFamilyCount = 0;
@@ -407,8 +451,30 @@ BasedVKInit ( Engine * engine )
     logDeviceInfo.pQueueCreateInfos    = &queueCreateInfo;
     logDeviceInfo.queueCreateInfoCount = 1;
     logDeviceInfo.pEnabledFeatures     = &deviceFeatures;
-    logDeviceInfo.enabledExtensionCount   = engine->customDeviceExt.size;
-    logDeviceInfo.ppEnabledExtensionNames = engine->customDeviceExt.data;
+    logDeviceInfo.pNext                = enabledFeatures;
+    /* Optional extensions after the required ones */
+    U_ALLOC (
+        deviceExtensions, const char *, engine->customDeviceExt.size + 2 );
+    uint32_t deviceExtensionCount = engine->customDeviceExt.size;
+    memcpy ( deviceExtensions,
+             engine->customDeviceExt.data,
+             deviceExtensionCount * sizeof ( const char * ) );
+    const char * calibratedExt = VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME;
+    engine->calibratedTimestamps =
+        cringedTraceEnabled &&
+        cringedDeviceHasExtensions (
+            engine->physicalDevice, &calibratedExt, 1 );
+    if ( engine->calibratedTimestamps )
+        deviceExtensions[ deviceExtensionCount++ ] = calibratedExt;
+    /* Without it the residency budgets against the heap sizes */
+    const char * budgetExt = VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+    engine->memoryBudget   = cringedDeviceHasExtensions (
+        engine->physicalDevice, &budgetExt, 1 );
+    if ( engine->memoryBudget )
+        deviceExtensions[ deviceExtensionCount++ ] = budgetExt;
+
+    logDeviceInfo.enabledExtensionCount   = deviceExtensionCount;
+    logDeviceInfo.ppEnabledExtensionNames = deviceExtensions;
 
     if ( engine->validationLayers.size )
     {
@@ -429,6 +495,11 @@ BasedVKInit ( Engine * engine )
         _DEBUG_P ( "error: creating Logical Device : %d\n", opResult );
         goto defer_cleanup;
     }
+    engine->deletions->device = *engine->device;
+    cringedResidencyAttach (
+        engine->residency, engine->physicalDevice, engine->memoryBudget );
+    _DEBUG_P ( "Memory budget: %s\n",
+               engine->memoryBudget ? "VK_EXT_memory_budget" : "heap sizes" );
 
     /* Get Vk Queues */
 
@@ -446,6 +517,16 @@ defer_cleanup:
         free ( devices );
         devices = NULL;
     };
+    if ( candidates )
+    {
+        free ( candidates );
+        candidates = NULL;
+    }
+    if ( deviceExtensions )
+    {
+        free ( deviceExtensions );
+        deviceExtensions = NULL;
+    }
     if ( vkExtensionsFull )
     {
         free ( vkExtensionsFull );
@@ -502,6 +583,17 @@ CringedCommandBuffer ( Engine * engine )
         _DEBUG_P ( "error: creating commandBuffer: %d\n", opResult );
         goto defer_cleanup;
     }
+
+    /* Timestamps per frame in flight, while tracing or for the HUD */
+    if ( cringedTraceEnabled || engine->hud )
+        engine->gpuTrace = cringedCreateGpuTrace (
+            engine->physicalDevice,
+            *engine->device,
+            engine->queueFamilies->queues[ engine->graphicsQueueIdx ]
+                .timestampValidBits,
+            engine->MaxFramesInFlight,
+            engine->calibratedTimestamps );
+    engine->graph->gpuTrace = engine->gpuTrace;
     rcode = VK_SUCCESS;
 
 defer_cleanup:
@@ -512,6 +604,12 @@ defer_cleanup:
 VkResult
 CringedCommandBufferCleanup ( Engine * engine )
 {
+    if ( engine->gpuTrace )
+    {
+        engine->graph->gpuTrace = NULL;
+        cringedDestroyGpuTrace ( engine->gpuTrace );
+        engine->gpuTrace = NULL;
+    }
     if ( engine->commandBuffer )
     {
         vkFreeCommandBuffers ( *engine->device,
@@ -530,17 +628,64 @@ CringedCommandBufferCleanup ( Engine * engine )
     return VK_SUCCESS;
 }
 
-VkResult
-CringedSwapChain ( Engine * engine )
+/* Deferred: frames already submitted keep rendering into and presenting
+ * the old images, the handle stays valid as `oldSwapchain` meanwhile */
+static void
+destroySwapChain ( Engine * engine, CringedWindow * window )
+{
+    if ( window->details.formats )
+    {
+        free ( window->details.formats );
+        window->details.formats = NULL;
+    }
+    if ( window->details.modes )
+    {
+        free ( window->details.modes );
+        window->details.modes = NULL;
+    }
+
+    if ( window->images )
+    {
+        free ( window->images );
+        window->images = NULL;
+    }
+    if ( window->imageViews )
+    {
+        for ( size_t i = 0; i < window->imageCount; i++ )
+        {
+            VkImageView view = window->imageViews[ i ];
+            cringedDefer ( engine->deletions,
+                           ( CringedDeletion ) { CRINGED_DELETE_IMAGE_VIEW,
+                                                 .imageView = view } );
+        }
+        free ( window->imageViews );
+        window->imageViews = NULL;
+    }
+    if ( window->swapChain )
+    {
+        cringedDefer ( engine->deletions,
+                       ( CringedDeletion ) { CRINGED_DELETE_SWAPCHAIN,
+                                             .swapChain = window->swapChain } );
+        window->swapChain = VK_NULL_HANDLE;
+    }
+    window->imageCount = 0;
+}
+
+/* `oldSwapChain` (retired, may be VK_NULL_HANDLE) lets the presentation
+ * engine hand its resources over instead of starting from scratch */
+static VkResult
+createSwapChain ( Engine *        engine,
+                  CringedWindow * window,
+                  VkSwapchainKHR  oldSwapChain )
 {
     VkResult opResult, rcode = VK_INCOMPLETE;
 
     /* Get SwapChain Supported Params */
-    SwapChainSupportDetails * details = &engine->swapChainDetails;
+    SwapChainSupportDetails * details = &window->details;
 
     VkSurfaceCapabilitiesKHR capabilities;
     if ( ( opResult = vkGetPhysicalDeviceSurfaceCapabilitiesKHR (
-               engine->physicalDevice, *engine->surface, &capabilities ) ) !=
+               engine->physicalDevice, window->surface, &capabilities ) ) !=
          VK_SUCCESS )
     {
         _DEBUG_P ( "error: failed to query surface capabilities: %d\n",
@@ -552,7 +697,7 @@ CringedSwapChain ( Engine * engine )
     uint32_t formatCount = 0;
     if ( ( opResult =
                vkGetPhysicalDeviceSurfaceFormatsKHR ( engine->physicalDevice,
-                                                      *engine->surface,
+                                                      window->surface,
                                                       &formatCount,
                                                       NULL ) ) != VK_SUCCESS )
     {
@@ -566,7 +711,7 @@ CringedSwapChain ( Engine * engine )
         U_ALLOC ( details->formats, VkSurfaceFormatKHR, formatCount );
 
         if ( vkGetPhysicalDeviceSurfaceFormatsKHR ( engine->physicalDevice,
-                                                    *engine->surface,
+                                                    window->surface,
                                                     &formatCount,
                                                     details->formats ) !=
              VK_SUCCESS )
@@ -579,7 +724,7 @@ CringedSwapChain ( Engine * engine )
 
     uint32_t modeCount = 0;
     if ( vkGetPhysicalDeviceSurfacePresentModesKHR (
-             engine->physicalDevice, *engine->surface, &modeCount, NULL ) !=
+             engine->physicalDevice, window->surface, &modeCount, NULL ) !=
          VK_SUCCESS )
     {
         _DEBUG_P ( "error: failed to get present mode count\n" );
@@ -591,7 +736,7 @@ CringedSwapChain ( Engine * engine )
         U_ALLOC ( details->modes, VkPresentModeKHR, modeCount );
         if ( vkGetPhysicalDeviceSurfacePresentModesKHR (
                  engine->physicalDevice,
-                 *engine->surface,
+                 window->surface,
                  &modeCount,
                  details->modes ) != VK_SUCCESS )
         {
@@ -602,26 +747,42 @@ CringedSwapChain ( Engine * engine )
     details->modeCount = modeCount;
 
     int win_width, win_height;
-    glfwGetFramebufferSize ( engine->window, &win_width, &win_height );
+    cringedWindowExtent ( window, &win_width, &win_height );
 
-    engine->swapChainConfig = chooseBestSwapChainConfig (
-        &( engine->swapChainDetails ), win_width, win_height );
+    window->config = chooseBestSwapChainConfig (
+        &window->details, win_width, win_height );
+
+    /* Pipelines were built for `colorFormat`, keep it while offered */
+    if ( engine->colorFormat != VK_FORMAT_UNDEFINED &&
+         engine->colorFormat != window->config.surfaceFormat.format )
+    {
+        uint8_t found = 0;
+        for ( uint32_t i = 0; i < details->formatCount && ! found; i++ )
+        {
+            if ( details->formats[ i ].format != engine->colorFormat ) continue;
+            window->config.surfaceFormat = details->formats[ i ];
+            found                                 = 1;
+        }
+        if ( ! found )
+            _DEBUG_P ( "warning: surface dropped format %d\n",
+                       engine->colorFormat );
+    }
 
     VkSwapchainCreateInfoKHR createInfo = {};
     createInfo.sType         = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-    createInfo.surface       = *engine->surface;
-    createInfo.minImageCount = engine->swapChainConfig.imageCount;
-    createInfo.imageFormat   = engine->swapChainConfig.surfaceFormat.format;
+    createInfo.surface       = window->surface;
+    createInfo.minImageCount = window->config.imageCount;
+    createInfo.imageFormat   = window->config.surfaceFormat.format;
     createInfo.imageColorSpace =
-        engine->swapChainConfig.surfaceFormat.colorSpace;
-    createInfo.imageExtent      = engine->swapChainConfig.extent;
+        window->config.surfaceFormat.colorSpace;
+    createInfo.imageExtent      = window->config.extent;
     createInfo.imageArrayLayers = 1;
     createInfo.imageUsage       = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
     createInfo.preTransform =
-        engine->swapChainDetails.capabilities.currentTransform;
+        window->details.capabilities.currentTransform;
     createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-    createInfo.presentMode    = engine->swapChainConfig.presentMode;
-    createInfo.oldSwapchain   = VK_NULL_HANDLE;
+    createInfo.presentMode    = window->config.presentMode;
+    createInfo.oldSwapchain   = oldSwapChain;
 
     createInfo.clipped = VK_TRUE;
 
@@ -641,15 +802,13 @@ CringedSwapChain ( Engine * engine )
         createInfo.pQueueFamilyIndices   = NULL;
     }
 
-    U_ALLOC ( engine->swapChain, VkSwapchainKHR, 1 );
     if ( ( opResult = vkCreateSwapchainKHR ( //
                *engine->device,
                &createInfo,
                NULL,
-               engine->swapChain ) ) != VK_SUCCESS )
+               &window->swapChain ) ) != VK_SUCCESS )
     {
-        free ( engine->swapChain );
-        engine->swapChain = NULL;
+        window->swapChain = VK_NULL_HANDLE;
         _DEBUG_P ( "error: swapChain creation failed: %d", opResult );
         goto defer_cleanup;
     }
@@ -657,7 +816,7 @@ CringedSwapChain ( Engine * engine )
     uint32_t imageCount = 0;
     if ( ( opResult = vkGetSwapchainImagesKHR ( //
                *engine->device,
-               *( engine->swapChain ),
+               window->swapChain,
                &imageCount,
                NULL ) ) != VK_SUCCESS ||
          ( ! imageCount ) )
@@ -668,27 +827,27 @@ CringedSwapChain ( Engine * engine )
         goto defer_cleanup;
     }
 
-    U_ALLOC ( engine->swapChainImages, VkImage, imageCount );
+    U_ALLOC ( window->images, VkImage, imageCount );
     if ( ( opResult = vkGetSwapchainImagesKHR ( //
                *engine->device,
-               *( engine->swapChain ),
+               window->swapChain,
                &imageCount,
-               engine->swapChainImages ) ) != VK_SUCCESS )
+               window->images ) ) != VK_SUCCESS )
     {
         _DEBUG_P ( "error: retrieving VkImages: %d and count %d",
                    opResult,
                    imageCount );
         goto defer_cleanup;
     }
-    engine->swapChainImagesCount = imageCount;
+    window->imageCount = imageCount;
 
-    U_ALLOC ( engine->swapChainImageViews,
+    U_ALLOC ( window->imageViews,
               VkImageView,
-              engine->swapChainImagesCount );
+              window->imageCount );
     VkImageViewCreateInfo swIView_createinfo = {};
     swIView_createinfo.sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     swIView_createinfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-    swIView_createinfo.format = engine->swapChainConfig.surfaceFormat.format;
+    swIView_createinfo.format = window->config.surfaceFormat.format;
     swIView_createinfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
     swIView_createinfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
     swIView_createinfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -700,20 +859,20 @@ CringedSwapChain ( Engine * engine )
     swIView_createinfo.subresourceRange.baseArrayLayer = 0;
     swIView_createinfo.subresourceRange.layerCount     = 1;
 
-    for ( uint32_t i = 0; i < engine->swapChainImagesCount; i++ )
+    for ( uint32_t i = 0; i < window->imageCount; i++ )
     {
 
-        swIView_createinfo.image = engine->swapChainImages[ i ];
+        swIView_createinfo.image = window->images[ i ];
         if ( ( opResult = vkCreateImageView (
                               *engine->device,
                               &swIView_createinfo,
                               NULL,
-                              &( engine->swapChainImageViews[ i ] ) ) !=
+                              &( window->imageViews[ i ] ) ) !=
                           VK_SUCCESS ) )
         {
             /* Current one failed:
              * During cleanup need to vkDestroy + dealloc previous 'i' */
-            engine->swapChainImagesCount = i;
+            window->imageCount = i;
             _DEBUG_P ( "error: creating vkImageView for Image idx %d: %d",
                        i,
                        opResult );
@@ -723,7 +882,57 @@ CringedSwapChain ( Engine * engine )
 
     rcode = VK_SUCCESS;
 defer_cleanup:
-    if ( rcode ) CringedSwapChainCleanup ( engine );
+    if ( rcode ) destroySwapChain ( engine, window );
+    return rcode;
+}
+
+VkResult
+CringedSwapChain ( Engine * engine )
+{
+    VkResult opResult;
+    for ( uint32_t w = 0; w < engine->windowCount; w++ )
+        if ( ( opResult = createSwapChain (
+                   engine, &engine->windows[ w ], VK_NULL_HANDLE ) ) !=
+             VK_SUCCESS )
+            return opResult;
+    return VK_SUCCESS;
+}
+
+VkResult
+BasedSurfaceFormat ( Engine * engine )
+{
+    VkResult             opResult, rcode = VK_INCOMPLETE;
+    VkSurfaceFormatKHR * formats     = NULL;
+    uint32_t             formatCount = 0;
+
+    if ( ( opResult = vkGetPhysicalDeviceSurfaceFormatsKHR ( //
+               engine->physicalDevice,
+               engine->windows[ 0 ].surface,
+               &formatCount,
+               NULL ) ) != VK_SUCCESS ||
+         ! formatCount )
+    {
+        _DEBUG_P ( "error: failed to get surface format count: %d\n",
+                   opResult );
+        goto defer_cleanup;
+    }
+
+    U_ALLOC ( formats, VkSurfaceFormatKHR, formatCount );
+    if ( ( opResult = vkGetPhysicalDeviceSurfaceFormatsKHR ( //
+               engine->physicalDevice,
+               engine->windows[ 0 ].surface,
+               &formatCount,
+               formats ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: failed to get surface formats: %d\n", opResult );
+        goto defer_cleanup;
+    }
+    engine->colorFormat = chooseSurfaceFormat ( formats, formatCount ).format;
+
+    rcode = VK_SUCCESS;
+
+defer_cleanup:
+    if ( formats ) free ( formats );
     return rcode;
 }
 
@@ -789,7 +998,6 @@ BasedSyncSetup ( Engine * engine )
     for ( uint32_t m = 0; m < engine->MaxFramesInFlight; m++ )
     {
         VkSemaphore ** semaphores[] = {
-            &( engine->sync[ m ].imageAvailable ),
             &( engine->sync[ m ].renderFinished ) };
         VkFence ** fences[] = { &( engine->sync[ m ].inFlight ) };
 
@@ -858,10 +1066,37 @@ BasedSyncSetup ( Engine * engine )
     }
     engine->syncCount = engine->MaxFramesInFlight;
 
+    /* Acquires are per window: one semaphore per window and frame slot */
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    for ( uint32_t w = 0; w < engine->windowCount; w++ )
+    {
+        CringedWindow * window = &engine->windows[ w ];
+        U_ALLOC ( window->imageAvailable,
+                  VkSemaphore,
+                  engine->MaxFramesInFlight );
+        memset ( window->imageAvailable,
+                 0,
+                 engine->MaxFramesInFlight * sizeof ( VkSemaphore ) );
+        for ( uint32_t m = 0; m < engine->MaxFramesInFlight; m++ )
+            if ( ( opResult = vkCreateSemaphore ( //
+                       *engine->device,
+                       &semaphoreInfo,
+                       NULL,
+                       &window->imageAvailable[ m ] ) ) != VK_SUCCESS )
+            {
+                window->imageAvailable[ m ] = VK_NULL_HANDLE;
+                _DEBUG_P ( "error: creating acquire semaphore [%u]: %d\n",
+                           w,
+                           opResult );
+                goto defer_cleanup;
+            }
+    }
+
     rcode = VK_SUCCESS;
 
 defer_cleanup:
-    if ( rcode ) BasedGraphicsPipelineCleanup ( engine );
+    if ( rcode ) BasedSyncCleanup ( engine );
     return rcode;
 }
 
@@ -873,7 +1108,6 @@ BasedSyncCleanup ( Engine * engine )
         for ( uint32_t m = 0; m < engine->syncCount; m++ )
         {
             VkSemaphore ** semaphores[] = {
-                &( engine->sync[ m ].imageAvailable ),
                 &( engine->sync[ m ].renderFinished ) };
             VkFence ** fences[] = { &( engine->sync[ m ].inFlight ) };
             for ( uint32_t i = 0;
@@ -904,6 +1138,18 @@ BasedSyncCleanup ( Engine * engine )
             }
         }
 
+    for ( uint32_t w = 0; w < engine->windowCount; w++ )
+    {
+        CringedWindow * window = &engine->windows[ w ];
+        if ( ! window->imageAvailable ) continue;
+        for ( uint32_t m = 0; m < engine->MaxFramesInFlight; m++ )
+            if ( window->imageAvailable[ m ] )
+                vkDestroySemaphore (
+                    *engine->device, window->imageAvailable[ m ], NULL );
+        free ( window->imageAvailable );
+        window->imageAvailable = NULL;
+    }
+
     if ( engine->sync )
     {
         free ( engine->sync );
@@ -912,64 +1158,913 @@ BasedSyncCleanup ( Engine * engine )
     return VK_SUCCESS;
 }
 
-VkResult
-CringedFrameBuffers ( Engine * engine )
+/* =============================================
+ *            FRAME GRAPH
+ * ============================================= */
+
+/* Per-frame data the main pass records with, filled before execution */
+typedef struct
 {
-    VkResult opResult, rcode = VK_INCOMPLETE;
+    Engine *           engine;
+    VkExtent2D         extent;    /* of the window drawn into */
+    CringedVariantPass colorPass; /* chosen by declareFrameGraph */
+    VkPipeline         bound;     /* last variant bound, per pass */
+    uint32_t           dynamicOffsets[ 3 ];
+    const uint32_t *   visible;
+    uint32_t           visibleCount;
+    uint32_t           commandOffset; /* instances of the queued draws */
+    uint32_t           commandCount;
+    uint32_t           drawCalls; /* counted while recording, for the HUD */
+    /* Occlusion culling: `visible` become candidates, drawn indirectly */
+    uint8_t  occlusion;
+    uint32_t candidateOffset;
+    uint32_t depth; /* graph resource the pyramid is built from */
+    mat4     viewProj;
+} MainPassContext;
+
+/* Set 0 and the full-screen viewport; variants share the layout, so
+ * the set survives every pipeline switch */
+static void
+bindDraws ( VkCommandBuffer commandBuffer, MainPassContext * ctx )
+{
+    Engine * engine = ctx->engine;
+
+    ctx->bound = VK_NULL_HANDLE;
+    vkCmdBindDescriptorSets ( commandBuffer,
+                              VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              *engine->pipelineLayout,
+                              0,
+                              1,
+                              &engine->descriptorSet,
+                              3,
+                              ctx->dynamicOffsets );
+
+    VkViewport viewport = {};
+    viewport.width      = ( float ) ctx->extent.width;
+    viewport.height     = ( float ) ctx->extent.height;
+    viewport.maxDepth   = 1.0f;
+    VkRect2D scissor    = {};
+    scissor.extent      = ctx->extent;
+    vkCmdSetViewport ( commandBuffer, 0, 1, &viewport );
+    vkCmdSetScissor ( commandBuffer, 0, 1, &scissor );
+}
+
+/* The variant of `pass` for `material` drawn from `source`; FALSE when
+ * it was not built */
+static uint8_t
+bindVariant ( VkCommandBuffer    commandBuffer,
+              MainPassContext *  ctx,
+              CringedVariantPass pass,
+              uint32_t           material,
+              uint32_t           source )
+{
+    Engine * engine = ctx->engine;
+    if ( material >= CRINGED_MATERIAL_COUNT ) return 0;
 
-    engine->swapChainFrameBufferCount = engine->swapChainImagesCount;
-    U_ALLOC ( engine->swapChainFrameBuffers,
-              VkFramebuffer,
-              engine->swapChainFrameBufferCount );
-    for ( uint32_t i = 0; i < engine->swapChainFrameBufferCount; i++ )
+    uint32_t features =
+        cringedMaterialFeatures[ material ] | source | engine->debugView;
+    VkPipeline pipeline =
+        engine->variants[ pass ][ cringedVariantKey ( pass, features ) ];
+    if ( ! pipeline ) return 0;
+    if ( pipeline != ctx->bound )
     {
-        VkImageView attachments[] = { engine->swapChainImageViews[ i ] };
+        vkCmdBindPipeline (
+            commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline );
+        ctx->bound = pipeline;
+    }
+    return 1;
+}
 
-        VkFramebufferCreateInfo framebufferInfo = {};
-        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebufferInfo.renderPass      = *engine->renderPass;
-        framebufferInfo.attachmentCount = 1;
-        framebufferInfo.pAttachments    = attachments;
-        framebufferInfo.width  = engine->swapChainConfig.extent.width;
-        framebufferInfo.height = engine->swapChainConfig.extent.height;
-        framebufferInfo.layers = 1;
+/* What a culling phase let through: one indirect draw per level, so
+ * multiDrawIndirect is not required */
+static void
+recordCulledDraw ( VkCommandBuffer   commandBuffer,
+                   MainPassContext * ctx,
+                   uint32_t          phase )
+{
+    CringedOcclusion * occlusion = ctx->engine->occlusion;
+    for ( uint32_t l = 0; l < occlusion->mesh->count; l++ )
+    {
+        vkCmdDrawIndirect ( commandBuffer,
+                            occlusion->commands.buffer,
+                            cringedOcclusionDrawOffset ( phase, l ),
+                            1,
+                            sizeof ( VkDrawIndirectCommand ) );
+        ctx->drawCalls++;
+    }
+}
 
-        if ( ( opResult = vkCreateFramebuffer ( //
-                   *engine->device,
-                   &framebufferInfo,
-                   NULL,
-                   engine->swapChainFrameBuffers + i ) ) != VK_SUCCESS )
+/* Instance runs plus the scene, shared by the depth and color passes */
+static void
+recordDraws ( VkCommandBuffer    commandBuffer,
+              MainPassContext *  ctx,
+              CringedVariantPass pass )
+{
+    Engine * engine = ctx->engine;
+
+    bindDraws ( commandBuffer, ctx );
+    uint8_t runs = ! ctx->occlusion;
+    if ( ctx->occlusion &&
+         bindVariant ( commandBuffer,
+                       ctx,
+                       pass,
+                       CRINGED_MATERIAL_DEFAULT,
+                       CRINGED_DRAW_CULLED ) )
+        recordCulledDraw ( commandBuffer, ctx, CRINGED_OCCLUSION_EARLY );
+    else if ( runs )
+        runs = bindVariant ( commandBuffer,
+                             ctx,
+                             pass,
+                             CRINGED_MATERIAL_DEFAULT,
+                             CRINGED_DRAW_INSTANCES );
+
+    /* Runs of consecutive instances at the same level of detail */
+    const uint8_t *         current = engine->lods->current;
+    const CringedMeshLods * mesh =
+        &cringedBuiltinMeshes[ engine->instanceMesh ];
+    for ( uint32_t v = 0; runs && v < ctx->visibleCount; )
+    {
+        uint32_t first = ctx->visible[ v ], run = 1;
+        uint8_t  level = current[ first ];
+        while ( v + run < ctx->visibleCount &&
+                ctx->visible[ v + run ] == first + run &&
+                current[ first + run ] == level )
+            run++;
+        vkCmdDraw ( commandBuffer,
+                    mesh->vertexCount[ level ],
+                    run,
+                    mesh->firstVertex[ level ],
+                    first );
+        ctx->drawCalls++;
+        v += run;
+    }
+
+    if ( engine->scene->count && bindVariant ( commandBuffer,
+                                               ctx,
+                                               pass,
+                                               CRINGED_MATERIAL_DEFAULT,
+                                               CRINGED_DRAW_SCENE ) )
+    {
+        vkCmdDraw ( commandBuffer, 3, engine->scene->count, 0, 0 );
+        ctx->drawCalls++;
+    }
+
+    /* Queued draws, sorted: one draw per run of equal mesh and material,
+     * a pipeline switch only where the material's variant differs */
+    if ( ctx->commandCount )
+    {
+        uint32_t commandOffsets[ 3 ] = { ctx->dynamicOffsets[ 0 ],
+                                         ctx->dynamicOffsets[ 1 ],
+                                         ctx->commandOffset };
+        vkCmdBindDescriptorSets ( commandBuffer,
+                                  VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                  *engine->pipelineLayout,
+                                  0,
+                                  1,
+                                  &engine->descriptorSet,
+                                  3,
+                                  commandOffsets );
+        const CringedRenderCommand * commands = engine->renderQueue->commands;
+        for ( uint32_t c = 0; c < ctx->commandCount; )
         {
-            /* Processed prevous `i` framebuffers, need to destroy. */
-            engine->swapChainFrameBufferCount = i;
-            _DEBUG_P (
-                "error: creating frame buffer [%d]: code %d\n", i, opResult );
-            goto defer_cleanup;
+            uint32_t run = 1;
+            while ( c + run < ctx->commandCount &&
+                    commands[ c + run ].mesh == commands[ c ].mesh &&
+                    commands[ c + run ].material == commands[ c ].material )
+                run++;
+            /* No identity across frames to keep a level for: full detail */
+            if ( commands[ c ].mesh < CRINGED_MESH_COUNT &&
+                 bindVariant ( commandBuffer,
+                               ctx,
+                               pass,
+                               commands[ c ].material,
+                               CRINGED_DRAW_INSTANCES ) )
+            {
+                const CringedMeshLods * lods =
+                    &cringedBuiltinMeshes[ commands[ c ].mesh ];
+                vkCmdDraw ( commandBuffer,
+                            lods->vertexCount[ 0 ],
+                            run,
+                            lods->firstVertex[ 0 ],
+                            c );
+                ctx->drawCalls++;
+            }
+            c += run;
         }
     }
+}
+
+static void
+recordDepthPrePass ( VkCommandBuffer commandBuffer, void * userData )
+{
+    MainPassContext * ctx = ( MainPassContext * ) userData;
+    recordDraws ( commandBuffer, ctx, CRINGED_VARIANT_DEPTH );
+}
+
+/* Blended on top of the opaque draws: particles, then the sprites */
+static void
+recordOverlays ( VkCommandBuffer commandBuffer, MainPassContext * ctx )
+{
+    if ( ctx->engine->particles )
+    {
+        Engine * engine = ctx->engine;
+        uint32_t zone   = cringedGpuZoneBegin (
+            engine->gpuTrace, commandBuffer, "particles-draw" );
+        cringedParticlesRecordDraw ( engine->particles,
+                                     commandBuffer,
+                                     engine->view,
+                                     engine->proj,
+                                     ctx->extent );
+        cringedGpuZoneEnd ( engine->gpuTrace, commandBuffer, zone );
+        ctx->drawCalls++;
+    }
+    ctx->drawCalls += cringedSpriteRecord ( //
+        ctx->engine->sprites,
+        commandBuffer,
+        ctx->extent );
+}
+
+static void
+recordMainPass ( VkCommandBuffer commandBuffer, void * userData )
+{
+    MainPassContext * ctx = ( MainPassContext * ) userData;
+    recordDraws ( commandBuffer, ctx, ctx->colorPass );
+    if ( ! ctx->occlusion ) recordOverlays ( commandBuffer, ctx );
+}
+
+static void
+recordEarlyCull ( VkCommandBuffer commandBuffer, void * userData )
+{
+    MainPassContext * ctx = ( MainPassContext * ) userData;
+    cringedOcclusionRecordEarly ( ctx->engine->occlusion,
+                                  commandBuffer,
+                                  ctx->candidateOffset,
+                                  ctx->visibleCount );
+}
+
+static void
+recordDepthPyramid ( VkCommandBuffer commandBuffer, void * userData )
+{
+    MainPassContext * ctx    = ( MainPassContext * ) userData;
+    Engine *          engine = ctx->engine;
+    cringedOcclusionRecordLate (
+        engine->occlusion,
+        commandBuffer,
+        cringedGraphImageView ( engine->graph, ctx->depth ),
+        ctx->viewProj,
+        ctx->candidateOffset,
+        ctx->visibleCount );
+}
+
+/* Early rejects the new pyramid shows visible. The depth pre-pass
+ * pipeline has no color attachment, so these always go through the
+ * depth-writing color pipeline, EQUAL test or not. */
+static void
+recordLatePass ( VkCommandBuffer commandBuffer, void * userData )
+{
+    MainPassContext * ctx = ( MainPassContext * ) userData;
+    bindDraws ( commandBuffer, ctx );
+    if ( bindVariant ( commandBuffer,
+                       ctx,
+                       CRINGED_VARIANT_COLOR,
+                       CRINGED_MATERIAL_DEFAULT,
+                       CRINGED_DRAW_CULLED ) )
+        recordCulledDraw ( commandBuffer, ctx, CRINGED_OCCLUSION_LATE );
+    recordOverlays ( commandBuffer, ctx );
+}
+
+/* Every window after the first: the same draws at its own extent. With
+ * occlusion both phases of the first window are final by now. */
+static void
+recordMirrorPass ( VkCommandBuffer commandBuffer, void * userData )
+{
+    MainPassContext * ctx = ( MainPassContext * ) userData;
+    recordDraws ( commandBuffer, ctx, CRINGED_VARIANT_COLOR );
+    if ( ctx->occlusion )
+    {
+        bindDraws ( commandBuffer, ctx ); /* queued draws rebound set 0 */
+        if ( bindVariant ( commandBuffer,
+                           ctx,
+                           CRINGED_VARIANT_COLOR,
+                           CRINGED_MATERIAL_DEFAULT,
+                           CRINGED_DRAW_CULLED ) )
+            recordCulledDraw ( commandBuffer, ctx, CRINGED_OCCLUSION_LATE );
+    }
+    recordOverlays ( commandBuffer, ctx );
+}
+
+/* Drawn this frame: acquired, or with a swapchain when only compiling */
+static uint8_t
+windowShown ( const CringedWindow * window, uint8_t compileOnly )
+{
+    return compileOnly ? window->swapChain != VK_NULL_HANDLE
+                       : window->acquired;
+}
+
+/* Declares this frame's passes, one set per window drawn; `ctx` holds a
+ * context per window, or is NULL when only compiling */
+static void
+declareFrameGraph ( Engine * engine, MainPassContext * ctx )
+{
+    static const char * backbufferNames[ CRINGED_MAX_WINDOWS ] = {
+        "backbuffer", "backbuffer-1", "backbuffer-2", "backbuffer-3" };
+    static const char * depthNames[ CRINGED_MAX_WINDOWS ] = {
+        "depth", "depth-1", "depth-2", "depth-3" };
+    static const char * mirrorNames[ CRINGED_MAX_WINDOWS ] = {
+        "main", "main-1", "main-2", "main-3" };
+
+    CringedRenderGraph * graph = engine->graph;
+    cringedGraphReset ( graph );
+
+    /* Acquire is waited on at color output, old contents are discarded */
+    CringedGraphState acquired = {
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        0 };
+    VkClearValue clearColor = {
+        .color = { .float32 = { 0.0f, 0.0f, 0.0f, 1.0f } } };
+    VkClearValue clearDepth = { .depthStencil = { 1.0f, 0 } };
+
+    /* Occlusion: the early cull feeds the opaque passes; after them the
+     * pyramid is rebuilt from depth and a late pass adds the rejects that
+     * turned out visible. Last frame's late draws read both buffers. The
+     * pyramid is sized to the first window, so it needs that one drawn. */
+    CringedWindow * primary   = &engine->windows[ 0 ];
+    uint8_t         occlusion = cringedOcclusionReady ( engine->occlusion ) &&
+                        windowShown ( primary, ctx == NULL );
+    uint32_t lists = CRINGED_GRAPH_NONE, draws = CRINGED_GRAPH_NONE;
+    if ( occlusion )
+    {
+        CringedGraphState drawn = {
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+            0 };
+        lists = cringedGraphImportBuffer ( graph,
+                                           "occlusion-lists",
+                                           engine->occlusion->lists.buffer,
+                                           &drawn,
+                                           CRINGED_GRAPH_NONE );
+        draws = cringedGraphImportBuffer ( graph,
+                                           "occlusion-draws",
+                                           engine->occlusion->commands.buffer,
+                                           &drawn,
+                                           CRINGED_GRAPH_NONE );
+        uint32_t early = cringedGraphAddPass (
+            graph, "cull-early", recordEarlyCull, ctx );
+        cringedGraphWrite ( graph,
+                            early,
+                            lists,
+                            CRINGED_USAGE_STORAGE_WRITE,
+                            CRINGED_LOAD_DONT_CARE,
+                            NULL );
+        cringedGraphWrite ( graph,
+                            early,
+                            draws,
+                            CRINGED_USAGE_STORAGE_WRITE,
+                            CRINGED_LOAD_DONT_CARE,
+                            NULL );
+    }
+
+    for ( uint32_t w = 0; w < engine->windowCount; w++ )
+    {
+        CringedWindow *   window = &engine->windows[ w ];
+        MainPassContext * view   = ctx ? &ctx[ w ] : NULL;
+        if ( ! windowShown ( window, ctx == NULL ) ) continue;
+
+        uint32_t backbuffer = cringedGraphImportImage (
+            graph,
+            backbufferNames[ w ],
+            window->images[ ctx ? window->imageIndex : 0 ],
+            window->imageViews[ ctx ? window->imageIndex : 0 ],
+            window->config.surfaceFormat.format,
+            window->config.extent,
+            &acquired,
+            CRINGED_USAGE_PRESENT );
+
+        /* Never leaves the frame: the graph recreates it with the
+         * swapchain extent and never stores it */
+        uint32_t depth = cringedGraphCreateImage ( graph,
+                                                   depthNames[ w ],
+                                                   engine->depthFormat,
+                                                   window->config.extent );
+        if ( view )
+        {
+            view->occlusion = occlusion;
+            view->depth     = depth;
+            view->colorPass = CRINGED_VARIANT_COLOR;
+        }
+
+        /* The other windows draw what the first one culled, in one pass */
+        if ( w > 0 )
+        {
+            uint32_t mirror = cringedGraphAddPass (
+                graph, mirrorNames[ w ], recordMirrorPass, view );
+            cringedGraphWrite ( graph,
+                                mirror,
+                                backbuffer,
+                                CRINGED_USAGE_COLOR_WRITE,
+                                CRINGED_LOAD_CLEAR,
+                                &clearColor );
+            cringedGraphWrite ( graph,
+                                mirror,
+                                depth,
+                                CRINGED_USAGE_DEPTH_WRITE,
+                                CRINGED_LOAD_CLEAR,
+                                &clearDepth );
+            if ( occlusion )
+            {
+                cringedGraphRead (
+                    graph, mirror, lists, CRINGED_USAGE_VERTEX_READ );
+                cringedGraphRead (
+                    graph, mirror, draws, CRINGED_USAGE_INDIRECT_READ );
+            }
+            continue;
+        }
+
+        /* Pre-pass: rasterize depth only, then shade each pixel once with
+         * an EQUAL test. Pays off when fragments are expensive (lavapipe). */
+        uint8_t prePass = engine->scene->depthPrePass;
+        if ( view && prePass ) view->colorPass = CRINGED_VARIANT_DEPTH_EQUAL;
+
+        if ( prePass )
+        {
+            uint32_t pre = cringedGraphAddPass (
+                graph, "depth-pre", recordDepthPrePass, view );
+            cringedGraphWrite ( graph,
+                                pre,
+                                depth,
+                                CRINGED_USAGE_DEPTH_WRITE,
+                                CRINGED_LOAD_CLEAR,
+                                &clearDepth );
+            if ( occlusion )
+            {
+                cringedGraphRead (
+                    graph, pre, lists, CRINGED_USAGE_VERTEX_READ );
+                cringedGraphRead (
+                    graph, pre, draws, CRINGED_USAGE_INDIRECT_READ );
+            }
+        }
+
+        uint32_t main =
+            cringedGraphAddPass ( graph, "main", recordMainPass, view );
+        cringedGraphWrite ( graph,
+                            main,
+                            backbuffer,
+                            CRINGED_USAGE_COLOR_WRITE,
+                            CRINGED_LOAD_CLEAR,
+                            &clearColor );
+        if ( prePass )
+            cringedGraphRead ( graph, main, depth, CRINGED_USAGE_DEPTH_READ );
+        else
+            cringedGraphWrite ( graph,
+                                main,
+                                depth,
+                                CRINGED_USAGE_DEPTH_WRITE,
+                                CRINGED_LOAD_CLEAR,
+                                &clearDepth );
+        if ( ! occlusion ) continue;
+        cringedGraphRead ( graph, main, lists, CRINGED_USAGE_VERTEX_READ );
+        cringedGraphRead ( graph, main, draws, CRINGED_USAGE_INDIRECT_READ );
+
+        uint32_t pyramid =
+            cringedGraphAddPass ( graph, "hi-z", recordDepthPyramid, view );
+        cringedGraphRead ( graph, pyramid, depth, CRINGED_USAGE_SAMPLED );
+        cringedGraphWrite ( graph,
+                            pyramid,
+                            lists,
+                            CRINGED_USAGE_STORAGE_WRITE,
+                            CRINGED_LOAD_KEEP,
+                            NULL );
+        cringedGraphWrite ( graph,
+                            pyramid,
+                            draws,
+                            CRINGED_USAGE_STORAGE_WRITE,
+                            CRINGED_LOAD_KEEP,
+                            NULL );
+
+        uint32_t late =
+            cringedGraphAddPass ( graph, "main-late", recordLatePass, view );
+        cringedGraphWrite ( graph,
+                            late,
+                            backbuffer,
+                            CRINGED_USAGE_COLOR_WRITE,
+                            CRINGED_LOAD_KEEP,
+                            NULL );
+        cringedGraphWrite ( graph,
+                            late,
+                            depth,
+                            CRINGED_USAGE_DEPTH_WRITE,
+                            CRINGED_LOAD_KEEP,
+                            NULL );
+        cringedGraphRead ( graph, late, lists, CRINGED_USAGE_VERTEX_READ );
+        cringedGraphRead ( graph, late, draws, CRINGED_USAGE_INDIRECT_READ );
+    }
+}
+
+VkResult
+CringedFrameBuffers ( Engine * engine )
+{
+    VkResult opResult, rcode = VK_INCOMPLETE;
+
+    engine->graph->dynamicRendering = engine->dynamicRendering;
+
+    /* The depth pyramid follows the swapchain extent */
+    if ( engine->occlusion && engine->occlusion->device &&
+         ( opResult = cringedOcclusionResize (
+               engine->occlusion,
+               engine->windows[ 0 ].config.extent,
+               engine->deletions ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: depth pyramid: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    /* Framebuffers and transient attachments belong to the render graph:
+     * compile once against the new swapchain so they exist before the
+     * first frame and errors surface at init */
+    declareFrameGraph ( engine, NULL );
+    if ( ( opResult = cringedGraphCompile ( //
+               engine->graph,
+               engine->physicalDevice,
+               *engine->device ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: compiling frame graph: %d\n", opResult );
+        goto defer_cleanup;
+    }
 
     rcode = VK_SUCCESS;
 
 defer_cleanup:
-    if ( rcode ) BasedGraphicsPipelineCleanup ( engine );
+    if ( rcode ) CringedFrameBuffersCleanup ( engine );
     return rcode;
 }
 
 VkResult
 CringedFrameBuffersCleanup ( Engine * engine )
 {
-    if ( engine->swapChainFrameBuffers )
+    if ( engine->graph ) cringedGraphRelease ( engine->graph );
+    return VK_SUCCESS;
+}
+
+VkResult
+CringedSceneSetup ( Engine * engine )
+{
+    VkResult opResult, rcode = VK_INCOMPLETE;
+
+    /* World matrices live on the device, only changed ranges are copied in
+     * from the frame ring at record time */
+    if ( ( opResult = cringedSceneCreateBuffer ( //
+               engine->scene,
+               engine->physicalDevice,
+               *engine->device ) ) != VK_SUCCESS )
     {
+        _DEBUG_P ( "error: creating scene world buffer: %d\n", opResult );
+        goto defer_cleanup;
+    }
 
-        for ( size_t i = 0; i < engine->swapChainFrameBufferCount; i++ )
-        {
+    /* NOTE: new buffer holds garbage, push every node on the next frame */
+    cringedSceneFlatten ( engine->scene );
 
-            vkDestroyFramebuffer (
-                *engine->device, engine->swapChainFrameBuffers[ i ], NULL );
-        }
+    rcode = VK_SUCCESS;
+
+defer_cleanup:
+    if ( rcode ) CringedSceneCleanup ( engine );
+    return rcode;
+}
+
+VkResult
+CringedSceneCleanup ( Engine * engine )
+{
+    if ( engine->scene && engine->scene->worldBuffer.buffer )
+        cringedSceneDestroyBuffer ( engine->scene, *engine->device );
+    return VK_SUCCESS;
+}
+
+VkResult
+CringedSprites ( Engine * engine )
+{
+    VkResult opResult, rcode = VK_INCOMPLETE;
 
-        free ( engine->swapChainFrameBuffers );
-        engine->swapChainFrameBuffers = NULL;
+    /* Overlay quads, drawn at the end of the main pass: compatible with
+     * its render pass, or its formats under dynamic rendering */
+    if ( ( opResult = cringedSpriteCreateResources ( //
+               engine->sprites,
+               engine->physicalDevice,
+               *engine->device,
+               engine->MaxFramesInFlight,
+               engine->colorFormat,
+               engine->depthFormat,
+               engine->renderPass ? *engine->renderPass : VK_NULL_HANDLE,
+               engine->shaders,
+               engine->residency ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: creating sprite batch: %d\n", opResult );
+        goto defer_cleanup;
+    }
+    if ( engine->hud &&
+         ( opResult = cringedHudCreateAtlas ( //
+               engine->hud,
+               engine->sprites ) ) != VK_SUCCESS )
+        goto defer_cleanup;
+
+    rcode = VK_SUCCESS;
+
+defer_cleanup:
+    if ( rcode ) CringedSpritesCleanup ( engine );
+    return rcode;
+}
+
+VkResult
+CringedSpritesCleanup ( Engine * engine )
+{
+    if ( engine->sprites ) cringedSpriteDestroyResources ( engine->sprites );
+    if ( engine->hud ) engine->hud->atlas = CRINGED_SPRITE_NONE;
+    return VK_SUCCESS;
+}
+
+VkResult
+CringedParticlesSetup ( Engine * engine )
+{
+    VkResult opResult, rcode = VK_INCOMPLETE;
+    if ( engine->particles == NULL ) return VK_SUCCESS;
+
+    /* State buffers, simulation and draw pipelines; drawn in the main pass
+     * like the sprites */
+    if ( ( opResult = cringedParticlesCreateResources ( //
+               engine->particles,
+               engine->physicalDevice,
+               *engine->device,
+               engine->colorFormat,
+               engine->depthFormat,
+               engine->renderPass ? *engine->renderPass : VK_NULL_HANDLE,
+               engine->shaders ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: creating particle system: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    rcode = VK_SUCCESS;
+
+defer_cleanup:
+    if ( rcode ) CringedParticlesCleanup ( engine );
+    return rcode;
+}
+
+VkResult
+CringedParticlesCleanup ( Engine * engine )
+{
+    if ( engine->particles )
+        cringedParticlesDestroyResources ( engine->particles );
+    return VK_SUCCESS;
+}
+
+VkResult
+CringedOcclusionSetup ( Engine * engine )
+{
+    VkResult opResult, rcode = VK_INCOMPLETE;
+    if ( engine->occlusion == NULL ) return VK_SUCCESS;
+
+    /* The pyramid is reduced from the depth buffer: without a sampled,
+     * stencil-free depth format everything stays on the frustum path */
+    if ( ! cringedOcclusionSupports ( engine->physicalDevice,
+                                      engine->depthFormat ) )
+    {
+        printf ( "occlusion culling: depth format %d not sampleable, off\n",
+                 engine->depthFormat );
+        return VK_SUCCESS;
+    }
+    /* Each level's list starts at its indirect command's firstInstance */
+    if ( ! engine->drawIndirectFirstInstance )
+    {
+        printf ( "occlusion culling: no drawIndirectFirstInstance, off\n" );
+        return VK_SUCCESS;
+    }
+    if ( ( opResult = cringedOcclusionCreateResources ( //
+               engine->occlusion,
+               engine->physicalDevice,
+               *engine->device,
+               engine->MaxFramesInFlight,
+               engine->frameRing,
+               engine->shaders ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: creating occlusion culling: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    /* Binding 4 held a placeholder so far, see CringedFrameRing */
+    VkDescriptorBufferInfo listsInfo = {
+        engine->occlusion->lists.buffer, 0, VK_WHOLE_SIZE };
+    VkWriteDescriptorSet write = {};
+    write.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet               = engine->descriptorSet;
+    write.dstBinding           = 4;
+    write.descriptorCount      = 1;
+    write.descriptorType       = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo          = &listsInfo;
+    vkUpdateDescriptorSets ( *engine->device, 1, &write, 0, NULL );
+
+    rcode = VK_SUCCESS;
+
+defer_cleanup:
+    if ( rcode ) CringedOcclusionCleanup ( engine );
+    return rcode;
+}
+
+VkResult
+CringedOcclusionCleanup ( Engine * engine )
+{
+    if ( engine->occlusion )
+        cringedOcclusionDestroyResources ( engine->occlusion );
+    return VK_SUCCESS;
+}
+
+VkResult
+CringedStreamSetup ( Engine * engine )
+{
+    /* Asset reads land here, copies to the device are recorded from it */
+    return cringedStreamCreateResources ( //
+        engine->stream,
+        engine->physicalDevice,
+        *engine->device,
+        engine->streamStagingSize );
+}
+
+VkResult
+CringedStreamCleanup ( Engine * engine )
+{
+    if ( engine->stream )
+        cringedStreamDestroyResources ( engine->stream, *engine->device );
+    return VK_SUCCESS;
+}
+
+VkResult
+CringedFrameRing ( Engine * engine )
+{
+    VkResult opResult, rcode = VK_INCOMPLETE;
+
+    /* Persistently mapped ring, one partition per frame in flight */
+    U_ALLOC ( engine->frameRing, BasedRingBuffer, 1 );
+    if ( ( opResult = cringedCreateRingBuffer ( //
+               engine->physicalDevice,
+               *engine->device,
+               engine->frameRingSize,
+               engine->MaxFramesInFlight,
+               engine->maxInstances * sizeof ( CringedInstance ),
+               engine->frameRing ) ) != VK_SUCCESS )
+    {
+        free ( engine->frameRing );
+        engine->frameRing = NULL;
+        _DEBUG_P ( "error: creating frame ring buffer: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    /* Set 0: frame constants (binding 0), draw constants (binding 1) and
+     * instances (binding 2), all addressed with dynamic offsets into the
+     * ring, plus the device local scene world matrices (binding 3) and
+     * the instance lists of the occlusion culling (binding 4) */
+    VkDescriptorSetLayoutBinding bindings[ 5 ] = {};
+    bindings[ 0 ].binding         = 0;
+    bindings[ 0 ].descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    bindings[ 0 ].descriptorCount = 1;
+    bindings[ 0 ].stageFlags =
+        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    bindings[ 1 ].binding         = 1;
+    bindings[ 1 ].descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    bindings[ 1 ].descriptorCount = 1;
+    bindings[ 1 ].stageFlags      = VK_SHADER_STAGE_VERTEX_BIT;
+    bindings[ 2 ].binding         = 2;
+    bindings[ 2 ].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    bindings[ 2 ].descriptorCount = 1;
+    bindings[ 2 ].stageFlags      = VK_SHADER_STAGE_VERTEX_BIT;
+    bindings[ 3 ].binding         = 3;
+    bindings[ 3 ].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[ 3 ].descriptorCount = 1;
+    bindings[ 3 ].stageFlags      = VK_SHADER_STAGE_VERTEX_BIT;
+    bindings[ 4 ].binding         = 4;
+    bindings[ 4 ].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[ 4 ].descriptorCount = 1;
+    bindings[ 4 ].stageFlags      = VK_SHADER_STAGE_VERTEX_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = sizeof ( bindings ) / sizeof ( bindings[ 0 ] );
+    layoutInfo.pBindings    = bindings;
+
+    U_ALLOC ( engine->descriptorSetLayout, VkDescriptorSetLayout, 1 );
+    if ( ( opResult = vkCreateDescriptorSetLayout ( //
+               *engine->device,
+               &layoutInfo,
+               NULL,
+               engine->descriptorSetLayout ) ) != VK_SUCCESS )
+    {
+        free ( engine->descriptorSetLayout );
+        engine->descriptorSetLayout = NULL;
+        _DEBUG_P ( "error: creating DescriptorSetLayout: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    VkDescriptorPoolSize poolSizes[ 3 ] = {};
+    poolSizes[ 0 ].type            = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    poolSizes[ 0 ].descriptorCount = 2;
+    poolSizes[ 1 ].type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    poolSizes[ 1 ].descriptorCount = 1;
+    poolSizes[ 2 ].type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[ 2 ].descriptorCount = 2;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = sizeof ( poolSizes ) / sizeof ( poolSizes[ 0 ] );
+    poolInfo.pPoolSizes    = poolSizes;
+    poolInfo.maxSets       = 1;
+
+    U_ALLOC ( engine->descriptorPool, VkDescriptorPool, 1 );
+    if ( ( opResult = vkCreateDescriptorPool ( //
+               *engine->device,
+               &poolInfo,
+               NULL,
+               engine->descriptorPool ) ) != VK_SUCCESS )
+    {
+        free ( engine->descriptorPool );
+        engine->descriptorPool = NULL;
+        _DEBUG_P ( "error: creating DescriptorPool: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool     = *engine->descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts        = engine->descriptorSetLayout;
+
+    if ( ( opResult = vkAllocateDescriptorSets (
+               *engine->device, &allocInfo, &engine->descriptorSet ) ) !=
+         VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: allocating DescriptorSet: %d\n", opResult );
+        goto defer_cleanup;
+    }
+
+    /* NOTE: written once, per-draw data is selected by dynamic offsets */
+    VkDescriptorBufferInfo bufferInfos[ 5 ] = {};
+    bufferInfos[ 0 ].buffer = engine->frameRing->buffer.buffer;
+    bufferInfos[ 0 ].offset = 0;
+    bufferInfos[ 0 ].range  = sizeof ( CringedFrameConstants );
+    bufferInfos[ 1 ].buffer = engine->frameRing->buffer.buffer;
+    bufferInfos[ 1 ].offset = 0;
+    bufferInfos[ 1 ].range  = sizeof ( CringedDrawConstants );
+    bufferInfos[ 2 ].buffer = engine->frameRing->buffer.buffer;
+    bufferInfos[ 2 ].offset = 0;
+    bufferInfos[ 2 ].range  = engine->maxInstances * sizeof ( CringedInstance );
+    bufferInfos[ 3 ].buffer = engine->scene->worldBuffer.buffer;
+    bufferInfos[ 3 ].offset = 0;
+    bufferInfos[ 3 ].range  = VK_WHOLE_SIZE;
+    /* Placeholder until CringedOcclusionSetup, never read without it */
+    bufferInfos[ 4 ]        = bufferInfos[ 3 ];
+
+    VkWriteDescriptorSet writes[ 5 ] = {};
+    for ( uint32_t i = 0; i < 5; i++ )
+    {
+        writes[ i ].sType  = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[ i ].dstSet = engine->descriptorSet;
+        writes[ i ].dstBinding      = i;
+        writes[ i ].descriptorCount = 1;
+        writes[ i ].descriptorType  = bindings[ i ].descriptorType;
+        writes[ i ].pBufferInfo     = &bufferInfos[ i ];
+    }
+    vkUpdateDescriptorSets ( *engine->device, 5, writes, 0, NULL );
+
+    rcode = VK_SUCCESS;
+
+defer_cleanup:
+    if ( rcode ) CringedFrameRingCleanup ( engine );
+    return rcode;
+}
+
+VkResult
+CringedFrameRingCleanup ( Engine * engine )
+{
+    if ( engine->descriptorPool )
+    {
+        /* NOTE: frees descriptorSet as well */
+        vkDestroyDescriptorPool (
+            *engine->device, *engine->descriptorPool, NULL );
+        free ( engine->descriptorPool );
+        engine->descriptorPool = NULL;
+        engine->descriptorSet  = VK_NULL_HANDLE;
+    }
+    if ( engine->descriptorSetLayout )
+    {
+        vkDestroyDescriptorSetLayout (
+            *engine->device, *engine->descriptorSetLayout, NULL );
+        free ( engine->descriptorSetLayout );
+        engine->descriptorSetLayout = NULL;
+    }
+    if ( engine->frameRing )
+    {
+        cringedDestroyRingBuffer ( *engine->device, engine->frameRing );
+        free ( engine->frameRing );
+        engine->frameRing = NULL;
     }
     return VK_SUCCESS;
 }
@@ -979,18 +2074,15 @@ BasedGraphicsPipeline ( Engine * engine )
 {
     VkResult opResult, rcode = VK_INCOMPLETE;
 
-    engine->triVert = cringedCreateShader ( //
-        build_shaders_Triangle_vert_spv,
-        build_shaders_Triangle_vert_spv_len );
+    /* Both point into the mapped archive, which outlives the pipeline */
+    engine->triVert = cringedArchiveShader ( engine->shaders, "Triangle_vert" );
     if ( ! engine->triVert )
     {
         _DEBUG_P ( "error: failed to load shader Triangle_vert.spv\n" );
         goto defer_cleanup;
     }
 
-    engine->triFrag = cringedCreateShader ( //
-        build_shaders_Triangle_frag_spv,
-        build_shaders_Triangle_frag_spv_len );
+    engine->triFrag = cringedArchiveShader ( engine->shaders, "Triangle_frag" );
     if ( ! engine->triFrag )
     {
         _DEBUG_P ( "error: failed to load shader Triangle_frag.spv\n" );
@@ -1065,34 +2157,32 @@ BasedGraphicsPipeline ( Engine * engine )
     inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
     inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-    /* Viewport & Scissors Setup */
-    VkOffset2D scissorsOffset = { 0, 0 };
-
-    VkViewport viewport = {};
-    viewport.x          = 0.0f;
-    viewport.y          = 0.0f;
-    viewport.width      = ( float ) engine->swapChainConfig.extent.width;
-    viewport.height     = ( float ) engine->swapChainConfig.extent.height;
-    viewport.minDepth   = 0.0f;
-    viewport.maxDepth   = 1.0f;
-    VkRect2D scissor    = {};
-    scissor.offset      = scissorsOffset;
-    scissor.extent      = engine->swapChainConfig.extent;
+    /* Viewport and scissor follow the swapchain at record time, so a
+     * resize never rebuilds pipelines and nothing here waits for the
+     * swapchain to exist */
+    VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT,
+                                       VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicState = {};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount =
+        sizeof ( dynamicStates ) / sizeof ( dynamicStates[ 0 ] );
+    dynamicState.pDynamicStates = dynamicStates;
 
     VkPipelineViewportStateCreateInfo viewportState = {};
     viewportState.sType =
         VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
     viewportState.viewportCount = 1;
-    viewportState.pViewports    = &viewport;
+    viewportState.pViewports    = NULL; /* dynamic */
     viewportState.scissorCount  = 1;
-    viewportState.pScissors     = &scissor;
+    viewportState.pScissors     = NULL;
 
     /* Rasterizer */
 
     VkPipelineRasterizationStateCreateInfo rasterizer = {};
     rasterizer.sType =
         VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizer.depthClampEnable = VK_TRUE; /* clamp instead of discarding */
+    /* Clamp instead of discarding, where the device can */
+    rasterizer.depthClampEnable = engine->depthClamp ? VK_TRUE : VK_FALSE;
     rasterizer.rasterizerDiscardEnable = VK_FALSE;
     rasterizer.polygonMode             = VK_POLYGON_MODE_FILL;
     rasterizer.lineWidth               = 1.0f;
@@ -1140,12 +2230,33 @@ BasedGraphicsPipeline ( Engine * engine )
     colorBlending.blendConstants[ 2 ] = 0.0f;
     colorBlending.blendConstants[ 3 ] = 0.0f;
 
+    /* Depth: LESS with writes, or EQUAL without when a pre-pass already
+     * laid the depth down */
+    VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+    depthStencil.sType =
+        VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable       = VK_TRUE;
+    depthStencil.depthWriteEnable      = VK_TRUE;
+    depthStencil.depthCompareOp        = VK_COMPARE_OP_LESS;
+    depthStencil.depthBoundsTestEnable = VK_FALSE;
+    depthStencil.stencilTestEnable     = VK_FALSE;
+    depthStencil.minDepthBounds        = 0.0f;
+    depthStencil.maxDepthBounds        = 1.0f;
+
+    VkPipelineDepthStencilStateCreateInfo depthEqual = depthStencil;
+    depthEqual.depthWriteEnable = VK_FALSE;
+    depthEqual.depthCompareOp   = VK_COMPARE_OP_EQUAL;
+
+    VkPipelineColorBlendStateCreateInfo noColor = colorBlending;
+    noColor.attachmentCount = 0;
+    noColor.pAttachments    = NULL;
+
     /* Pipeline Layout */
     U_ALLOC ( engine->pipelineLayout, VkPipelineLayout, 1 );
     VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount         = 0;
-    pipelineLayoutInfo.pSetLayouts            = NULL;
+    pipelineLayoutInfo.setLayoutCount         = 1;
+    pipelineLayoutInfo.pSetLayouts            = engine->descriptorSetLayout;
     pipelineLayoutInfo.pushConstantRangeCount = 0;
     pipelineLayoutInfo.pPushConstantRanges    = NULL;
 
@@ -1161,58 +2272,65 @@ BasedGraphicsPipeline ( Engine * engine )
         goto defer_cleanup;
     }
 
-    /* Render Pass */
-
-    VkAttachmentDescription colorAttachment = {};
-    colorAttachment.format  = engine->swapChainConfig.surfaceFormat.format;
-    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    colorAttachment.loadOp  = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    colorAttachment.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachment.initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout    = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-    VkAttachmentReference colorAttachmentRef = {};
-    colorAttachmentRef.attachment            = 0;
-    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    VkSubpassDescription subpass = {};
-    subpass.pipelineBindPoint    = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments    = &colorAttachmentRef;
-
-    /* NOTE: dep to wait until image ready */
-    VkSubpassDependency dependency = {};
-    dependency.srcSubpass          = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass          = 0;
-    dependency.srcStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.srcAccessMask = 0;
-    dependency.dstStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-    VkRenderPassCreateInfo renderPassInfo = {};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassInfo.attachmentCount = 1;
-    renderPassInfo.pAttachments    = &colorAttachment;
-    renderPassInfo.subpassCount    = 1;
-    renderPassInfo.pSubpasses      = &subpass;
-    renderPassInfo.dependencyCount = 1;
-    renderPassInfo.pDependencies   = &dependency;
-
-    U_ALLOC ( engine->renderPass, VkRenderPass, 1 );
-    if ( ( opResult = vkCreateRenderPass ( //
-               *engine->device,
-               &renderPassInfo,
-               NULL,
-               engine->renderPass ) ) != VK_SUCCESS )
+    engine->depthFormat = cringedFindDepthFormat ( engine->physicalDevice );
+    if ( engine->depthFormat == VK_FORMAT_UNDEFINED )
     {
-        free ( engine->renderPass );
-        engine->renderPass = NULL;
-        _DEBUG_P ( "error: creating RenderPass: %d\n", opResult );
+        _DEBUG_P ( "error: no depth attachment format\n" );
         goto defer_cleanup;
     }
 
+    /* Attachment formats: baked into a compatible render pass, or passed
+     * straight to the pipeline with dynamic rendering */
+    VkFormat colorFormat = engine->colorFormat;
+
+    VkPipelineRenderingCreateInfo renderingInfo = {};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+    renderingInfo.colorAttachmentCount    = 1;
+    renderingInfo.pColorAttachmentFormats = &colorFormat;
+    renderingInfo.depthAttachmentFormat   = engine->depthFormat;
+    renderingInfo.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+
+    VkPipelineRenderingCreateInfo depthRenderingInfo = renderingInfo;
+    depthRenderingInfo.colorAttachmentCount    = 0;
+    depthRenderingInfo.pColorAttachmentFormats = NULL;
+
+    /* Render Pass: only for pipeline compatibility, the render graph
+     * creates the ones actually begun (same formats, graph-owned layouts).
+     * Layouts don't affect compatibility, so the EQUAL pipeline shares it
+     * with its read-only depth. */
+    if ( ! engine->dynamicRendering )
+    {
+        U_ALLOC ( engine->renderPass, VkRenderPass, 1 );
+        if ( ( opResult = cringedGraphCreateRenderPass ( //
+                   *engine->device,
+                   1,
+                   &colorFormat,
+                   engine->depthFormat,
+                   0,
+                   NULL,
+                   NULL,
+                   engine->renderPass ) ) != VK_SUCCESS )
+        {
+            free ( engine->renderPass );
+            engine->renderPass = NULL;
+            _DEBUG_P ( "error: creating RenderPass: %d\n", opResult );
+            goto defer_cleanup;
+        }
+        if ( ( opResult = cringedGraphCreateRenderPass ( //
+                   *engine->device,
+                   0,
+                   NULL,
+                   engine->depthFormat,
+                   0,
+                   NULL,
+                   NULL,
+                   &engine->depthRenderPass ) ) != VK_SUCCESS )
+        {
+            _DEBUG_P ( "error: creating depth RenderPass: %d\n", opResult );
+            goto defer_cleanup;
+        }
+    }
+
     /* GRAPHICS PIPELINE */
     VkGraphicsPipelineCreateInfo pipelineInfo = {};
     pipelineInfo.sType      = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -1223,30 +2341,101 @@ BasedGraphicsPipeline ( Engine * engine )
     pipelineInfo.pViewportState      = &viewportState;
     pipelineInfo.pRasterizationState = &rasterizer;
     pipelineInfo.pMultisampleState   = &multisampling;
-    pipelineInfo.pDepthStencilState  = NULL;
+    pipelineInfo.pDepthStencilState  = &depthStencil;
     pipelineInfo.pColorBlendState    = &colorBlending;
-    pipelineInfo.pDynamicState       = NULL;
+    pipelineInfo.pDynamicState       = &dynamicState;
     pipelineInfo.layout              = *engine->pipelineLayout;
-    pipelineInfo.renderPass          = *engine->renderPass;
+    pipelineInfo.pNext =
+        engine->dynamicRendering ? &renderingInfo : NULL;
+    pipelineInfo.renderPass =
+        engine->renderPass ? *engine->renderPass : VK_NULL_HANDLE;
     pipelineInfo.subpass             = 0;
     pipelineInfo.basePipelineHandle  = VK_NULL_HANDLE;
     pipelineInfo.basePipelineIndex   = -1;
 
-    U_ALLOC ( engine->pipeline, VkPipeline, 1 );
-    if ( ( opResult = vkCreateGraphicsPipelines ( //
+    /* Per pass: LESS color, vertex-only depth writer, EQUAL color */
+    VkGraphicsPipelineCreateInfo passInfos[ CRINGED_VARIANT_PASS_COUNT ] = {
+        pipelineInfo, pipelineInfo, pipelineInfo };
+    passInfos[ CRINGED_VARIANT_DEPTH ].stageCount       = 1;
+    passInfos[ CRINGED_VARIANT_DEPTH ].pColorBlendState = &noColor;
+    passInfos[ CRINGED_VARIANT_DEPTH ].renderPass = engine->depthRenderPass;
+    if ( engine->dynamicRendering )
+        passInfos[ CRINGED_VARIANT_DEPTH ].pNext = &depthRenderingInfo;
+    passInfos[ CRINGED_VARIANT_DEPTH_EQUAL ].pDepthStencilState = &depthEqual;
+
+    if ( ! engine->pipelineCache &&
+         ( opResult = cringedCreatePipelineCache ( //
                *engine->device,
-               VK_NULL_HANDLE,
-               1,
-               &pipelineInfo,
-               NULL,
-               engine->pipeline ) ) != VK_SUCCESS )
+               engine->pipelineCachePath,
+               &engine->pipelineCache ) ) != VK_SUCCESS )
     {
-        free ( engine->pipeline );
-        engine->pipeline = NULL;
-        _DEBUG_P ( "error: creating Graphics Pipeline: %d\n", opResult );
+        _DEBUG_P ( "error: creating pipeline cache: %d\n", opResult );
         goto defer_cleanup;
     }
 
+    /* Variants: every material, from every source, in every pass. Equal
+     * feature words share one pipeline, the cache shares the compiles. */
+    enum { VARIANT_MAX = CRINGED_VARIANT_PASS_COUNT * CRINGED_FEATURE_COUNT };
+    VkGraphicsPipelineCreateInfo    infos[ VARIANT_MAX ];
+    VkPipelineShaderStageCreateInfo stages[ VARIANT_MAX ][ 2 ];
+    CringedSpecialization           specializations[ VARIANT_MAX ];
+    uint32_t                        slots[ VARIANT_MAX ];
+    VkPipeline                      created[ VARIANT_MAX ];
+    uint8_t                         requested[ VARIANT_MAX ] = {};
+    uint32_t                        variantCount = 0;
+    for ( uint32_t m = 0; m < CRINGED_MATERIAL_COUNT; m++ )
+    {
+        for ( uint32_t source = 0; source < CRINGED_DRAW_SOURCE_COUNT;
+              source++ )
+        {
+            uint32_t features =
+                cringedMaterialFeatures[ m ] | source | engine->debugView;
+            for ( uint32_t pass = 0; pass < CRINGED_VARIANT_PASS_COUNT;
+                  pass++ )
+            {
+                uint32_t slot =
+                    pass * CRINGED_FEATURE_COUNT +
+                    cringedVariantKey ( ( CringedVariantPass ) pass,
+                                        features );
+                if ( requested[ slot ] ) continue;
+                requested[ slot ] = 1;
+
+                uint32_t v = variantCount++;
+                cringedSpecialize ( features, &specializations[ v ] );
+                stages[ v ][ 0 ] = vertShaderStageInfo;
+                stages[ v ][ 1 ] = fragShaderStageInfo;
+                stages[ v ][ 0 ].pSpecializationInfo =
+                    &specializations[ v ].info;
+                stages[ v ][ 1 ].pSpecializationInfo =
+                    &specializations[ v ].info;
+                infos[ v ]         = passInfos[ pass ];
+                infos[ v ].pStages = stages[ v ];
+                slots[ v ]         = slot;
+                created[ v ]       = VK_NULL_HANDLE;
+            }
+        }
+    }
+
+    /* Failed creations come back NULL, the rest is cleaned up as usual */
+    opResult = vkCreateGraphicsPipelines ( //
+        *engine->device,
+        engine->pipelineCache,
+        variantCount,
+        infos,
+        NULL,
+        created );
+    for ( uint32_t v = 0; v < variantCount; v++ )
+        engine->variants[ slots[ v ] / CRINGED_FEATURE_COUNT ]
+                        [ slots[ v ] % CRINGED_FEATURE_COUNT ] = created[ v ];
+    if ( opResult != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: creating %u pipeline variants: %d\n",
+                   variantCount,
+                   opResult );
+        goto defer_cleanup;
+    }
+    _DEBUG_P ( "built %u pipeline variants\n", variantCount );
+
     rcode = VK_SUCCESS;
 
 defer_cleanup:
@@ -1254,109 +2443,129 @@ defer_cleanup:
     return rcode;
 }
 
+/* Deferred: pipelines may be rebuilt with frames in flight */
 VkResult
 BasedGraphicsPipelineCleanup ( Engine * engine )
 {
-    if ( engine->pipeline )
+    CringedDeletionQueue * deletions = engine->deletions;
+    for ( uint32_t pass = 0; pass < CRINGED_VARIANT_PASS_COUNT; pass++ )
     {
-        vkDestroyPipeline ( *engine->device, *engine->pipeline, NULL );
-        free ( engine->pipeline );
-        engine->pipeline = NULL;
+        for ( uint32_t f = 0; f < CRINGED_FEATURE_COUNT; f++ )
+        {
+            if ( ! engine->variants[ pass ][ f ] ) continue;
+            cringedDefer ( deletions,
+                           ( CringedDeletion ) {
+                               CRINGED_DELETE_PIPELINE,
+                               .pipeline = engine->variants[ pass ][ f ] } );
+            engine->variants[ pass ][ f ] = VK_NULL_HANDLE;
+        }
+    }
+    if ( engine->depthRenderPass )
+    {
+        cringedDefer ( deletions,
+                       ( CringedDeletion ) {
+                           CRINGED_DELETE_RENDER_PASS,
+                           .renderPass = engine->depthRenderPass } );
+        engine->depthRenderPass = VK_NULL_HANDLE;
     }
     if ( engine->renderPass )
     {
-        vkDestroyRenderPass (
-            *engine->device, *( engine->renderPass ), NULL );
+        cringedDefer ( deletions,
+                       ( CringedDeletion ) {
+                           CRINGED_DELETE_RENDER_PASS,
+                           .renderPass = *engine->renderPass } );
         free ( engine->renderPass );
         engine->renderPass = NULL;
     }
+    /* Pipelines never reference their cache: saved and destroyed now */
+    if ( engine->pipelineCache )
+    {
+        cringedDestroyPipelineCache ( *engine->device,
+                                      engine->pipelineCache,
+                                      engine->pipelineCachePath );
+        engine->pipelineCache = VK_NULL_HANDLE;
+    }
     if ( engine->pipelineLayout )
     {
-        vkDestroyPipelineLayout (
-            *engine->device, *( engine->pipelineLayout ), NULL );
+        cringedDefer ( deletions,
+                       ( CringedDeletion ) {
+                           CRINGED_DELETE_PIPELINE_LAYOUT,
+                           .pipelineLayout = *engine->pipelineLayout } );
         free ( engine->pipelineLayout );
         engine->pipelineLayout = NULL;
     }
-    if ( engine->triFrag->s_module )
+    if ( engine->triFrag && engine->triFrag->s_module )
     {
-        vkDestroyShaderModule (
-            *engine->device, *( engine->triFrag->s_module ), NULL );
+        cringedDefer ( deletions,
+                       ( CringedDeletion ) {
+                           CRINGED_DELETE_SHADER_MODULE,
+                           .shaderModule = *engine->triFrag->s_module } );
         free ( engine->triFrag->s_module );
         engine->triFrag->s_module = NULL;
     }
-    if ( engine->triVert->s_module )
+    if ( engine->triVert && engine->triVert->s_module )
     {
-        vkDestroyShaderModule (
-            *engine->device, *( engine->triVert->s_module ), NULL );
+        cringedDefer ( deletions,
+                       ( CringedDeletion ) {
+                           CRINGED_DELETE_SHADER_MODULE,
+                           .shaderModule = *engine->triVert->s_module } );
         free ( engine->triVert->s_module );
         engine->triVert->s_module = NULL;
     }
     if ( engine->triFrag ) cringedDestroyShader ( engine->triFrag );
     if ( engine->triVert ) cringedDestroyShader ( engine->triVert );
+    engine->triFrag = NULL;
+    engine->triVert = NULL;
     return VK_SUCCESS;
 }
 
-void
-CringedSwapChainRecreate ( Engine * engine )
+VkResult
+CringedSwapChainCleanup ( Engine * engine )
 {
-    int width = 0, height = 0;
-    glfwGetFramebufferSize ( engine->window, &width, &height );
-    while ( width == 0 || height == 0 )
-    {
-        glfwGetFramebufferSize ( engine->window, &width, &height );
-        glfwWaitEvents ();
-    }
-    vkDeviceWaitIdle ( *engine->device );
-
-    /* Cleanup */
-    CringedFrameBuffersCleanup ( engine );
-    CringedSwapChainCleanup ( engine );
+    for ( uint32_t w = 0; w < engine->windowCount; w++ )
+        destroySwapChain ( engine, &engine->windows[ w ] );
+    return VK_SUCCESS;
+}
 
-    /* Recreate */
-    CringedSwapChain ( engine );
-    CringedFrameBuffers ( engine );
+void
+cringedWindowExtent ( CringedWindow * window, int * width, int * height )
+{
+    uint64_t extent = atomic_load_explicit ( &window->extent, //
+                                             memory_order_acquire );
+    *width          = ( int ) ( extent >> 32 );
+    *height         = ( int ) ( extent & 0xffffffffu );
 }
 
 VkResult
-CringedSwapChainCleanup ( Engine * engine )
+CringedSwapChainRecreate ( Engine * engine, CringedWindow * window )
 {
-    if ( engine->swapChainDetails.formats )
-    {
-        free ( engine->swapChainDetails.formats );
-        engine->swapChainDetails.formats = NULL;
-    }
-    if ( engine->swapChainDetails.modes )
-    {
-        free ( engine->swapChainDetails.modes );
-        engine->swapChainDetails.modes = NULL;
-    }
+    VkResult opResult;
+    int      width = 0, height = 0;
+    cringedWindowExtent ( window, &width, &height );
+    if ( width == 0 || height == 0 ) return VK_NOT_READY; /* minimized */
+
+    /* No device idle: old images, views and framebuffers go through the
+     * deletion queue, the old handle is still alive for the hand-over.
+     * The graph is shared, the other windows' framebuffers follow. */
+    VkSwapchainKHR oldSwapChain = window->swapChain;
+    CringedFrameBuffersCleanup ( engine );
+    destroySwapChain ( engine, window );
 
-    if ( engine->swapChainImages )
-    {
-        free ( engine->swapChainImages );
-        engine->swapChainImages = NULL;
-    }
-    if ( engine->swapChain )
-    {
-        vkDestroySwapchainKHR (
-            *engine->device, *( engine->swapChain ), NULL );
-        free ( engine->swapChain );
-        engine->swapChain = NULL;
-    }
-    if ( engine->swapChainImageViews )
+    if ( ( opResult = createSwapChain ( engine, window, oldSwapChain ) ) !=
+         VK_SUCCESS )
     {
-        for ( size_t i = 0; i < engine->swapChainImagesCount; i++ )
-            vkDestroyImageView (
-                *engine->device, engine->swapChainImageViews[ i ], NULL );
-        free ( engine->swapChainImageViews );
-        engine->swapChainImageViews = NULL;
+        _DEBUG_P ( "error: recreating swapchain: %d\n", opResult );
+        return opResult;
     }
-    return VK_SUCCESS;
+    return CringedFrameBuffers ( engine );
 }
 
 VkResult
 BasedVKCleanup ( Engine * engine )
 {
+    /* NOTE: the caller waited for idle, nothing deferred is in use; the
+     * swapchains must go before the surface */
+    if ( engine->device ) cringedDeletionFlush ( engine->deletions );
     if ( engine->debugMessenger )
     {
         PFN_vkDestroyDebugUtilsMessengerEXT func =
@@ -1376,11 +2585,12 @@ BasedVKCleanup ( Engine * engine )
         free ( engine->queueFamilies );
         engine->queueFamilies = NULL;
     }
-    if ( engine->surface )
+    for ( uint32_t w = 0; w < engine->windowCount; w++ )
     {
-        vkDestroySurfaceKHR ( *engine->vkInstance, *engine->surface, NULL );
-        free ( engine->surface );
-        engine->surface = NULL;
+        CringedWindow * window = &engine->windows[ w ];
+        if ( window->surface == VK_NULL_HANDLE ) continue;
+        vkDestroySurfaceKHR ( *engine->vkInstance, window->surface, NULL );
+        window->surface = VK_NULL_HANDLE;
     }
     if ( engine->device )
     {
@@ -1402,12 +2612,152 @@ BasedVKCleanup ( Engine * engine )
  * ============================================= */
 
 VkResult
-CringedRecordCommandBuffer ( Engine *          engine,
-                             VkCommandBuffer * commandBuffer,
-                             uint32_t          imageIndex )
+CringedRecordCommandBuffer ( Engine * engine, VkCommandBuffer * commandBuffer )
 {
     VkResult opResult, rcode = VK_INCOMPLETE;
 
+    /* Frame + draw constants: plain memcpy into the mapped ring */
+    double now = glfwGetTime ();
+
+    CringedFrameConstants frameConstants;
+    glm_mat4_copy ( engine->view, frameConstants.view );
+    glm_mat4_copy ( engine->proj, frameConstants.proj );
+    glm_mat4_mul ( engine->proj, engine->view, frameConstants.viewProj );
+    frameConstants.time[ 0 ] = ( float ) now;
+    frameConstants.time[ 1 ] = ( float ) ( now - engine->lastFrameTime );
+    frameConstants.time[ 2 ] = ( float ) engine->frameNumber;
+    frameConstants.time[ 3 ] = 0.0f;
+    engine->lastFrameTime    = now;
+
+    CringedDrawConstants drawConstants = {};
+    glm_mat4_identity ( drawConstants.model );
+    glm_mat4_mul (
+        frameConstants.viewProj, drawConstants.model, drawConstants.mvp );
+
+    /* NOTE: dynamic offsets are ordered by binding number */
+    MainPassContext ctx            = { .engine = engine };
+    uint32_t *      dynamicOffsets = ctx.dynamicOffsets;
+    if ( ! cringedRingPush ( engine->frameRing,
+                             &frameConstants,
+                             sizeof ( frameConstants ),
+                             &dynamicOffsets[ 0 ] ) ||
+         ! cringedRingPush ( engine->frameRing,
+                             &drawConstants,
+                             sizeof ( drawConstants ),
+                             &dynamicOffsets[ 1 ] ) )
+    {
+        _DEBUG_P ( "error: frame ring exhausted\n" );
+        goto abort;
+    }
+
+    /* Instances: SIMD kernels write straight into the mapped ring */
+    CRINGED_ZONE_BEGIN ( instancesZone, "instances" );
+    uint32_t          instanceCount = engine->transforms->count;
+    CringedInstance * instances     = cringedRingAlloc (
+        engine->frameRing,
+        instanceCount * sizeof ( CringedInstance ),
+        &dynamicOffsets[ 2 ] );
+    if ( ! instances || instanceCount > engine->maxInstances )
+    {
+        _DEBUG_P ( "error: no ring space for %u instances\n", instanceCount );
+        goto abort;
+    }
+    cringedTransformsUpdate (
+        engine->transforms, frameConstants.viewProj, instances );
+    CRINGED_ZONE_END ( instancesZone );
+
+    /* Frustum culling: ascending visible indices, drawn as instance runs */
+    CringedFrustum frustum;
+    cringedFrustumFromMatrix ( frameConstants.viewProj, &frustum );
+    CringedSpheres spheres = { engine->transforms->px,
+                               engine->transforms->py,
+                               engine->transforms->pz,
+                               engine->transforms->br,
+                               instanceCount };
+    CRINGED_ZONE_BEGIN ( cullZone, "cull" );
+    ctx.visibleCount =
+        cringedCullSpheres ( engine->culler, &frustum, &spheres );
+    CRINGED_ZONE_END ( cullZone );
+    ctx.visible = engine->culler->visible;
+
+    /* Levels of detail from the projected size, for either draw path;
+     * thresholds are in pixels of the first window */
+    CringedWindow * primary = &engine->windows[ 0 ];
+    CRINGED_ZONE_BEGIN ( lodZone, "lod" );
+    cringedLodSelect ( engine->lods,
+                       &cringedBuiltinMeshes[ engine->instanceMesh ],
+                       &spheres,
+                       ctx.visible,
+                       ctx.visibleCount,
+                       frameConstants.viewProj,
+                       fabsf ( frameConstants.proj[ 1 ][ 1 ] ) *
+                           ( float ) primary->config.extent.height );
+    CRINGED_ZONE_END ( lodZone );
+
+    /* Occlusion: frustum survivors become GPU candidates, drawn through
+     * binding 4 in the order the culling phases append them. Skipped
+     * while the first window, whose depth builds the pyramid, is not drawn */
+    if ( cringedOcclusionReady ( engine->occlusion ) && primary->acquired )
+    {
+        CRINGED_ZONE_BEGIN ( candidatesZone, "occlusion-candidates" );
+        cringedOcclusionBeginFrame ( engine->occlusion, engine->cFrame );
+        glm_mat4_copy ( frameConstants.viewProj, ctx.viewProj );
+        CringedOcclusionCandidate * candidates = cringedRingAlloc (
+            engine->frameRing,
+            ctx.visibleCount * sizeof ( CringedOcclusionCandidate ),
+            &ctx.candidateOffset );
+        if ( ctx.visibleCount && ! candidates )
+        {
+            _DEBUG_P ( "error: no ring space for %u occlusion candidates\n",
+                       ctx.visibleCount );
+            goto abort;
+        }
+        for ( uint32_t v = 0; v < ctx.visibleCount; v++ )
+        {
+            uint32_t i                    = ctx.visible[ v ];
+            candidates[ v ].sphere[ 0 ]   = spheres.x[ i ];
+            candidates[ v ].sphere[ 1 ]   = spheres.y[ i ];
+            candidates[ v ].sphere[ 2 ]   = spheres.z[ i ];
+            candidates[ v ].sphere[ 3 ]   = spheres.r[ i ];
+            candidates[ v ].instance[ 0 ] = i;
+            candidates[ v ].instance[ 1 ] = engine->lods->current[ i ];
+        }
+        CRINGED_ZONE_END ( candidatesZone );
+    }
+
+    /* Application draws: whatever producers published until now */
+    CRINGED_ZONE_BEGIN ( commandsZone, "render-queue" );
+    ctx.commandCount = cringedRenderQueueDrain ( engine->renderQueue );
+    if ( ctx.commandCount > engine->maxInstances )
+    {
+        _DEBUG_P ( "warning: %u queued draws over the instance limit\n",
+                   ctx.commandCount - engine->maxInstances );
+        ctx.commandCount = engine->maxInstances;
+    }
+    if ( ctx.commandCount )
+    {
+        CringedInstance * commandInstances = cringedRingAlloc (
+            engine->frameRing,
+            ctx.commandCount * sizeof ( CringedInstance ),
+            &ctx.commandOffset );
+        if ( ! commandInstances )
+        {
+            _DEBUG_P ( "error: no ring space for %u queued draws\n",
+                       ctx.commandCount );
+            goto abort;
+        }
+        for ( uint32_t i = 0; i < ctx.commandCount; i++ )
+        {
+            CringedRenderCommand * command =
+                &engine->renderQueue->commands[ i ];
+            glm_mat4_copy ( command->world, commandInstances[ i ].world );
+            glm_mat4_mul ( frameConstants.viewProj,
+                           command->world,
+                           commandInstances[ i ].mvp );
+        }
+    }
+    CRINGED_ZONE_END ( commandsZone );
+
     VkCommandBufferBeginInfo beginInfo = {};
     beginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     beginInfo.flags            = 0;
@@ -1419,25 +2769,88 @@ CringedRecordCommandBuffer ( Engine *          engine,
         goto abort;
     }
 
-    VkRenderPassBeginInfo renderPassInfo = {};
-    renderPassInfo.sType       = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass  = *engine->renderPass;
-    renderPassInfo.framebuffer = engine->swapChainFrameBuffers[ imageIndex ];
-    renderPassInfo.renderArea.offset.x = 0;
-    renderPassInfo.renderArea.offset.y = 0;
-    renderPassInfo.renderArea.extent   = engine->swapChainConfig.extent;
-    VkClearValue clearColor            = {
-                   .color = { .float32 = { 0.0f, 0.0f, 0.0f, 1.0f } } };
-    renderPassInfo.clearValueCount = 1;
-    renderPassInfo.pClearValues    = &clearColor;
-    vkCmdBeginRenderPass (
-        *commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE );
-    vkCmdBindPipeline (
-        *commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, *engine->pipeline );
-
-    /* NOTE: Viewport and Scissors are static. No need to set up. */
-    vkCmdDraw ( *commandBuffer, 3, 1, 0, 0 );
-    vkCmdEndRenderPass ( *commandBuffer );
+    cringedGpuTraceBeginFrame (
+        engine->gpuTrace, *commandBuffer, engine->cFrame );
+
+    /* Dirty subtrees only, then finished asset reads to their owners;
+     * copies must land before the render pass */
+    CRINGED_ZONE_BEGIN ( sceneZone, "scene" );
+    uint32_t uploadZone = cringedGpuZoneBegin (
+        engine->gpuTrace, *commandBuffer, "scene-upload" );
+    cringedScenePropagate ( engine->scene );
+    cringedSceneRecordUpload (
+        engine->scene, *commandBuffer, engine->frameRing );
+    cringedSpriteRecordUpload (
+        engine->sprites, *commandBuffer, engine->frameRing );
+    cringedStreamRecordUploads ( engine->stream, *commandBuffer );
+    cringedGpuZoneEnd ( engine->gpuTrace, *commandBuffer, uploadZone );
+    CRINGED_ZONE_END ( sceneZone );
+
+    /* One simulation step on the device, drawn in the main pass */
+    if ( engine->particles )
+    {
+        CRINGED_ZONE_BEGIN ( particleZone, "particles" );
+        uint32_t simZone = cringedGpuZoneBegin (
+            engine->gpuTrace, *commandBuffer, "particles-sim" );
+        cringedParticlesRecordSimulate (
+            engine->particles, *commandBuffer, frameConstants.time[ 1 ] );
+        cringedGpuZoneEnd ( engine->gpuTrace, *commandBuffer, simZone );
+        CRINGED_ZONE_END ( particleZone );
+    }
+
+    /* This frame's quads, sorted into its own vertex partition; the HUD
+     * goes in last, on top */
+    CRINGED_ZONE_BEGIN ( spriteZone, "sprites" );
+    CringedHudStats hudStats = {};
+    hudStats.extent          = primary->config.extent;
+    hudStats.presentMode     = primary->config.presentMode;
+    hudStats.framesInFlight  = engine->MaxFramesInFlight;
+    hudStats.swapchainImages = primary->imageCount;
+    hudStats.instances       = ctx.visibleCount + engine->scene->count;
+    hudStats.queued          = ctx.commandCount;
+    hudStats.sprites         = engine->sprites->count;
+    hudStats.triangles       = engine->lods->triangles;
+    hudStats.fullTriangles   = engine->lods->fullTriangles;
+    const CringedMemoryBudget * budget = &engine->residency->budget;
+    for ( uint32_t h = 0; h < budget->heapCount; h++ )
+        if ( budget->flags[ h ] & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT )
+        {
+            hudStats.deviceUsage += budget->usage[ h ];
+            hudStats.deviceBudget += budget->budget[ h ];
+        }
+    hudStats.budgetMeasured = budget->measured;
+    hudStats.evictions      = engine->residency->evictions;
+    cringedHudDraw ( engine->hud, engine->sprites, &hudStats );
+    cringedSpritePrepare ( engine->sprites, engine->cFrame );
+    CRINGED_ZONE_END ( spriteZone );
+
+    /* One context per window: the same draws, its own viewport */
+    MainPassContext views[ CRINGED_MAX_WINDOWS ];
+    for ( uint32_t w = 0; w < engine->windowCount; w++ )
+    {
+        views[ w ]        = ctx;
+        views[ w ].extent = engine->windows[ w ].config.extent;
+    }
+
+    /* Barriers, layout transitions and the render pass come from the graph */
+    CRINGED_ZONE_BEGIN ( graphZone, "frame-graph" );
+    declareFrameGraph ( engine, views );
+    if ( ( opResult = cringedGraphCompile ( //
+               engine->graph,
+               engine->physicalDevice,
+               *engine->device ) ) != VK_SUCCESS ||
+         ( opResult = cringedGraphExecute ( //
+               engine->graph,
+               *commandBuffer ) ) != VK_SUCCESS )
+    {
+        _DEBUG_P ( "error: frame graph: %d\n", opResult );
+        goto abort;
+    }
+    CRINGED_ZONE_END ( graphZone );
+    for ( uint32_t w = 1; w < engine->windowCount; w++ )
+        views[ 0 ].drawCalls += views[ w ].drawCalls;
+    if ( engine->hud ) engine->hud->draws = views[ 0 ].drawCalls;
+
     if ( ( opResult = vkEndCommandBuffer ( *commandBuffer ) ) != VK_SUCCESS )
     {
         _DEBUG_P ( "error: endCommandBuffer: %d\n", opResult );
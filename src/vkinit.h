@@ -2,9 +2,29 @@
 #ifndef BASED_CODE_VK_INIT_H
 #define BASED_CODE_VK_INIT_H
 
+#include "bufferUtils.h"
+#include "cull.h"
+#include "deletionQueue.h"
+#include "deviceSelect.h"
+#include "hud.h"
+#include "inputQueue.h"
+#include "lod.h"
+#include "occlusion.h"
+#include "particles.h"
+#include "renderGraph.h"
+#include "renderQueue.h"
+#include "residency.h"
+#include "scene.h"
 #include "shaderUtils.h"
+#include "sprite.h"
+#include "stream.h"
+#include "submit.h"
+#include "transform.h"
+#include "variants.h"
 
 #include <cglm/cglm.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -51,50 +71,138 @@ typedef struct
 
 typedef struct
 {
-    VkSemaphore * imageAvailable;
-    VkSemaphore * renderFinished;
+    VkSemaphore * renderFinished; /* waited once by every present */
     VkFence *     inFlight;
 } BasedSynchronization;
 
+#define CRINGED_MAX_WINDOWS 4 /* within CRINGED_SUBMIT_PRESENTS */
+
+/* One output: a surface with its swapchain. Device, pipelines, command
+ * buffers and the frame graph are shared by all windows, which show the
+ * same camera, each at its own extent. */
+typedef struct
+{
+    GLFWwindow *            window;
+    VkSurfaceKHR            surface;
+    VkSwapchainKHR          swapChain;
+    SwapChainSupportDetails details;
+    SwapChainConfig         config;
+    uint32_t                imageCount;
+    VkImage *               images;
+    VkImageView *           imageViews;
+    VkSemaphore *           imageAvailable; /* per frame in flight */
+    /* Event thread -> render thread: the resize flag and the framebuffer
+     * size (width << 32 | height) are handed over, a drag burst coalesces
+     * into one recreate */
+    atomic_uchar          resized;
+    atomic_uint_least64_t extent;
+    /* This frame: drawn and presented only once an image was acquired */
+    uint8_t  acquired;
+    uint32_t imageIndex;
+} CringedWindow;
+
 typedef struct
 {
     /* Frames & buffering */
     uint8_t  MaxFramesInFlight;
     uint32_t cFrame;
-    uint8_t  winResized;
+    uint64_t frameNumber;
+    double   lastFrameTime;
+    /* Event thread -> render thread: input of every window goes through
+     * the SPSC queue, resizes through each CringedWindow */
+    CringedInputQueue * input;
+    atomic_uchar        running; /* cleared by either side to stop */
+    pthread_t           renderThread;
+    /* Destroy requests waiting for the frames in flight to complete */
+    CringedDeletionQueue * deletions;
+    /* Memory budget per heap, evicts streamed resources past it */
+    CringedResidency * residency;
+    /* Asset reads into mapped staging, delivered with the uploads */
+    CringedStream * stream;
+    VkDeviceSize    streamStagingSize;
     /* MAIN + Platform EXT */
     VkInstance *     vkInstance;
-    GLFWwindow *     window;
-    VkSurfaceKHR *   surface;
     VkDevice *       device;
     VkPhysicalDevice physicalDevice;
+    uint8_t          deviceBenchmark; /* probe candidates, see deviceSelect.h */
+    const char *     deviceCachePath;
+    uint8_t          dynamicRendering; /* vkCmdBeginRendering supported */
+    uint8_t          calibratedTimestamps; /* trace: GPU clock calibration */
+    uint8_t          synchronization2;     /* vkQueueSubmit2 supported */
+    uint8_t          memoryBudget;         /* VK_EXT_memory_budget */
+    uint8_t          depthClamp;           /* rasterizer depth clamp */
+    uint8_t          drawIndirectFirstInstance; /* feature enabled */
     /* Queues */
     QueueFamilies * queueFamilies;
     uint32_t        graphicsQueueIdx;
     VkQueue         graphicsQueue;
     uint32_t        presentQueueIdx;
     VkQueue         presentQueue;
+    /* Batches every queue submission and present of a frame */
+    CringedSubmitter * submitter;
     /* Extensions & Validation & Debug */
     VkDebugUtilsMessengerEXT * debugMessenger;
     ConstParamArr              validationLayers;
     ConstParamArr              customInstanceExt;
     ConstParamArr              customDeviceExt;
-    /*Swap Chain*/
-    VkSwapchainKHR *        swapChain;
-    SwapChainSupportDetails swapChainDetails;
-    SwapChainConfig         swapChainConfig;
-    uint32_t                swapChainImagesCount;
-    VkImage *               swapChainImages;
-    VkImageView *           swapChainImageViews;
-    uint32_t                swapChainFrameBufferCount;
-    VkFramebuffer *         swapChainFrameBuffers;
+    /* Windows & Swap Chains: the first one sizes the depth pyramid and
+     * the level-of-detail thresholds */
+    uint32_t      windowCount;
+    CringedWindow windows[ CRINGED_MAX_WINDOWS ];
+    VkFormat      colorFormat; /* pipelines target, preferred */
     /* Pipeline */
+    /* Variants of the triangle program, [pass][feature word], only those
+     * a material can draw with exist; see variants.h */
+    VkPipeline      variants[ CRINGED_VARIANT_PASS_COUNT ]
+                            [ CRINGED_FEATURE_COUNT ];
+    uint32_t        debugView; /* feature bits added to every variant */
+    VkPipelineCache pipelineCache;
+    const char *    pipelineCachePath;
+    /* Every compiled program, see shaderArchive.h */
+    CringedShaderArchive * shaders;
     /* triangle GLSL compiled shaders */
-    VkPipeline *       pipeline;
     BasedShader *      triVert;
     BasedShader *      triFrag;
     VkPipelineLayout * pipelineLayout;
-    VkRenderPass *     renderPass;
+    VkRenderPass *     renderPass; /* compatibility only, NULL if dynamic */
+    /* Depth: graph transient sized to the swapchain, optional pre-pass */
+    VkFormat     depthFormat;
+    VkRenderPass depthRenderPass; /* depth-only compatibility pass */
+    /* Frame graph: passes, barriers, framebuffers, transient attachments */
+    CringedRenderGraph * graph;
+    /* Timestamp zones for the trace, NULL unless tracing */
+    CringedGpuTrace * gpuTrace;
+    /* Per-frame constants ring & descriptors */
+    VkDeviceSize            frameRingSize;
+    BasedRingBuffer *       frameRing;
+    VkDescriptorSetLayout * descriptorSetLayout;
+    VkDescriptorPool *      descriptorPool;
+    VkDescriptorSet         descriptorSet;
+    /* Camera */
+    mat4 view;
+    mat4 proj;
+    /* Instances: SoA transforms -> ring (set 0, binding 2) */
+    uint32_t            maxInstances;
+    CringedTransforms * transforms;
+    /* CPU frustum culling, feeds instance runs at record time */
+    CringedCuller * culler;
+    /* Instances are all drawn as one built-in mesh, at a per-instance
+     * level of detail picked after culling */
+    uint32_t             instanceMesh; /* CRINGED_MESH_* */
+    CringedLodSelector * lods;
+    /* GPU Hi-Z culling of the frustum survivors, NULL when disabled */
+    CringedOcclusion * occlusion;
+    /* Flattened scene hierarchy, world matrices at set 0 binding 3 */
+    CringedScene * scene;
+    /* Draw requests from application threads, drained at record time */
+    CringedRenderQueue * renderQueue;
+    /* Screen-space quads, streamed and batched per frame */
+    CringedSpriteBatch * sprites;
+    /* Frame statistics overlay, drawn through the sprite batch */
+    CringedHud * hud;
+    /* GPU simulated particles, NULL unless enabled */
+    CringedParticles * particles;
+    uint8_t            particleBench; /* PARTICLE_BENCH: scale, report */
     /* Command Pools & Buffers */
     VkCommandPool *   commandPool;
     uint32_t          commandBufferCount;
@@ -113,6 +221,11 @@ BasedVKCleanup ( Engine * engine );
 VkResult
 CringedSwapChainCleanup ( Engine * engine );
 
+/* Color format the swapchain will use, queried ahead of it so pipelines
+ * can be built concurrently */
+VkResult
+BasedSurfaceFormat ( Engine * engine );
+
 VkResult
 CringedSwapChain ( Engine * engine );
 
@@ -122,6 +235,42 @@ BasedGraphicsPipeline ( Engine * engine );
 VkResult
 BasedGraphicsPipelineCleanup ( Engine * engine );
 
+VkResult
+CringedSceneSetup ( Engine * engine );
+
+VkResult
+CringedSceneCleanup ( Engine * engine );
+
+VkResult
+CringedSprites ( Engine * engine );
+
+VkResult
+CringedSpritesCleanup ( Engine * engine );
+
+VkResult
+CringedParticlesSetup ( Engine * engine );
+
+VkResult
+CringedParticlesCleanup ( Engine * engine );
+
+VkResult
+CringedOcclusionSetup ( Engine * engine );
+
+VkResult
+CringedOcclusionCleanup ( Engine * engine );
+
+VkResult
+CringedStreamSetup ( Engine * engine );
+
+VkResult
+CringedStreamCleanup ( Engine * engine );
+
+VkResult
+CringedFrameRing ( Engine * engine );
+
+VkResult
+CringedFrameRingCleanup ( Engine * engine );
+
 VkResult
 CringedFrameBuffersCleanup ( Engine * engine );
 
@@ -140,12 +289,18 @@ BasedSyncCleanup ( Engine * engine );
 VkResult
 BasedSyncSetup ( Engine * engine );
 
+/* Draws into the image each window acquired this frame */
 VkResult
 CringedRecordCommandBuffer ( Engine *          engine,
-                             VkCommandBuffer * commandBuffer,
-                             uint32_t          imageIndex );
+                             VkCommandBuffer * commandBuffer );
 
+/* Framebuffer size last reported by the event thread */
 void
-CringedSwapChainRecreate ( Engine * engine );
+cringedWindowExtent ( CringedWindow * window, int * width, int * height );
+
+/* Non-blocking: hands the old swapchain over as `oldSwapchain` and defers
+ * its destruction; VK_NOT_READY while the window is minimized */
+VkResult
+CringedSwapChainRecreate ( Engine * engine, CringedWindow * window );
 
 #endif /* BASED_CODE_VK_INIT_H */